@@ -151,6 +151,54 @@ def get(flux_handle, key, namespace=None, _kvstxn=None):
     return get_dir(flux_handle, key, namespace=namespace, _kvstxn=_kvstxn)
 
 
+def get_batch(flux_handle, keys, namespace=None):
+    """Get many KVS values from one snapshot of the KVS
+
+    All keys are looked up against the same KVS root in a single request,
+    so the values returned are consistent with each other.
+
+    Args:
+        flux_handle: A Flux handle obtained from flux.Flux()
+        keys: list of keys to get
+        namespace: namespace to read from, defaults to None.  If namespace
+          is None, the namespace specified in the FLUX_KVS_NAMESPACE
+          environment variable will be used.  If FLUX_KVS_NAMESPACE is not
+          set, the primary namespace will be used.
+
+    Returns:
+        list: values in the same order as keys, decoded as by get().
+        The value of a key that does not exist is None.  A key that refers
+        to a directory raises OSError with errno EISDIR.
+    """
+    keys = list(keys)
+    keybufs = [ffi.new("char[]", key.encode("utf-8")) for key in keys]
+    future = RAW.flux_kvs_lookup_batch(
+        flux_handle, namespace, 0, ffi.new("char *[]", keybufs), len(keys)
+    )
+    valp = ffi.new("char *[1]")
+    values = []
+    try:
+        for _ in keys:
+            try:
+                RAW.flux_kvs_lookup_get(future, valp)
+                values.append(None if valp[0] == ffi.NULL else _get_value(valp))
+            except OSError as err:
+                if err.errno != errno.ENOENT:
+                    raise err
+                values.append(None)
+            RAW.flux_future_reset(future)
+    finally:
+        # consume responses up to the ENODATA that terminates the stream
+        try:
+            while True:
+                RAW.flux_rpc_get(future, ffi.NULL)
+                RAW.flux_future_reset(future)
+        except OSError:
+            pass
+        RAW.flux_future_destroy(future)
+    return values
+
+
 # convenience function to get RAW kvs txn object to use
 def _get_kvstxn(flux_handle, _kvstxn):
     # If _kvstxn is None, use the default txn stored in the flux
@@ -30,6 +30,7 @@
 
 struct modhash {
     zhash_t *zh_byuuid;
+    struct subtrie *subtrie;        // subscriptions of all modules
     flux_msg_handler_t **handlers;
     struct broker *ctx;
 };
@@ -290,6 +291,12 @@ int modhash_load (modhash_t *mh,
                              error)))
         goto error;
     modhash_add (mh, p);
+    if (module_set_subtrie (p, mh->subtrie) < 0) {
+        errprintf (error,
+                   "error tracking %s subscriptions",
+                   module_get_name (p));
+        goto module_remove;
+    }
     if (service_add (mh->ctx->services,
                      module_get_name (p),
                      module_get_uuid (p),
@@ -630,6 +637,8 @@ modhash_t *modhash_create (struct broker *ctx)
         errno = ENOMEM;
         goto error;
     }
+    if (!(mh->subtrie = subtrie_create ()))
+        goto error;
     return mh;
 error:
     modhash_destroy (mh);
@@ -655,6 +664,7 @@ int modhash_destroy (modhash_t *mh)
             }
             zhash_destroy (&mh->zh_byuuid);
         }
+        subtrie_destroy (mh->subtrie);
         flux_msg_handler_delvec (mh->handlers);
         free (mh);
     }
@@ -751,15 +761,36 @@ module_t *modhash_lookup_byname (modhash_t *mh, const char *name)
     return result;
 }
 
+struct mcast_ctx {
+    const flux_msg_t *msg;
+    int errnum;
+};
+
+// subtrie_match_f footprint
+static void mcast_send (void *peer_arg, void *arg)
+{
+    module_t *p = peer_arg;
+    struct mcast_ctx *mc = arg;
+
+    if (module_event_send (p, mc->msg) < 0 && mc->errnum == 0)
+        mc->errnum = errno;
+}
+
+/* Find all modules with a matching subscription in one pass over the
+ * subtrie, rather than checking each module's subscriptions in turn.
+ * Keep going if sending to a module fails, and report the first error.
+ */
 int modhash_event_mcast (modhash_t *mh, const flux_msg_t *msg)
 {
-    module_t *p;
+    struct mcast_ctx mc = { .msg = msg, .errnum = 0 };
+    const char *topic;
 
-    p = zhash_first (mh->zh_byuuid);
-    while (p) {
-        if (module_event_cast (p, msg) < 0)
-            return -1;
-        p = zhash_next (mh->zh_byuuid);
+    if (flux_msg_get_topic (msg, &topic) < 0
+        || subtrie_match (mh->subtrie, topic, mcast_send, &mc) < 0)
+        return -1;
+    if (mc.errnum != 0) {
+        errno = mc.errnum;
+        return -1;
     }
     return 0;
 }
@@ -35,6 +35,7 @@
 #include "src/common/libutil/errno_safe.h"
 #include "src/common/libutil/basename.h"
 #include "src/common/librouter/subhash.h"
+#include "src/common/librouter/subtrie.h"
 #include "ccan/str/str.h"
 
 #include "module.h"
@@ -82,6 +83,8 @@ struct broker_module {
 
     flux_t *h_module_end;   /* module end of interthread_channel */
     struct subhash *sub;
+    struct subtrie *subtrie;        /* subscriptions of all modules */
+    struct subtrie_peer *subpeer;   /* this module's entry in 'subtrie' */
 };
 
 static int setup_module_profiling (module_t *p)
@@ -527,6 +530,7 @@ void module_destroy (module_t *p)
     flux_msglist_destroy (p->deferred_messages);
     flux_msglist_destroy (p->trace_requests);
     subhash_destroy (p->sub);
+    subtrie_peer_remove (p->subtrie, p->subpeer);
     free (p);
     errno = saved_errno;
 }
@@ -664,29 +668,50 @@ const flux_msg_t *module_pop_insmod (module_t *p)
     return flux_msglist_pop (p->insmod_requests);
 }
 
+int module_set_subtrie (module_t *p, struct subtrie *st)
+{
+    if (p->subpeer) {
+        errno = EEXIST;
+        return -1;
+    }
+    if (!(p->subpeer = subtrie_peer_add (st, p)))
+        return -1;
+    p->subtrie = st;
+    return 0;
+}
+
 int module_subscribe (module_t *p, const char *topic)
 {
-    return subhash_subscribe (p->sub, topic);
+    if (subhash_subscribe (p->sub, topic) < 0)
+        return -1;
+    if (p->subpeer && subtrie_subscribe (p->subtrie, p->subpeer, topic) < 0) {
+        ERRNO_SAFE_WRAP (subhash_unsubscribe, p->sub, topic);
+        return -1;
+    }
+    return 0;
 }
 
 int module_unsubscribe (module_t *p, const char *topic)
 {
-    return subhash_unsubscribe (p->sub, topic);
+    if (subhash_unsubscribe (p->sub, topic) < 0)
+        return -1;
+    if (p->subpeer)
+        (void)subtrie_unsubscribe (p->subtrie, p->subpeer, topic);
+    return 0;
 }
 
-int module_event_cast (module_t *p, const flux_msg_t *msg)
+int module_event_send (module_t *p, const flux_msg_t *msg)
 {
-    const char *topic;
-
-    if (flux_msg_get_topic (msg, &topic) < 0)
+    /* Each module thread gets its own message, since the interthread
+     * connector and the module's handle modify it, but the copy
+     * shares the (immutable) payload with 'msg' rather than
+     * duplicating it.
+     */
+    flux_msg_t *cpy;
+    if (!(cpy = flux_msg_copy (msg, true))
+        || module_sendmsg_new (p, &cpy) < 0) {
+        flux_msg_decref (cpy);
         return -1;
-    if (subhash_topic_match (p->sub, topic)) {
-        flux_msg_t *cpy;
-        if (!(cpy = flux_msg_copy (msg, true))
-            || module_sendmsg_new (p, &cpy) < 0) {
-            flux_msg_decref (cpy);
-            return -1;
-        }
     }
     return 0;
 }
@@ -15,6 +15,7 @@
 #include <flux/core.h>
 
 #include "src/common/librouter/disconnect.h"
+#include "src/common/librouter/subtrie.h"
 
 typedef struct broker_module module_t;
 typedef void (*modpoller_cb_f)(module_t *p, void *arg);
@@ -91,10 +92,16 @@ void module_mute (module_t *p);
 int module_cancel (module_t *p, flux_error_t *error);
 
 /* Manage module subscriptions.
+ * Once module_set_subtrie() is called, subscriptions are also tracked in
+ * 'st', shared by all modules, so events can be matched in one pass.
  */
+int module_set_subtrie (module_t *p, struct subtrie *st);
 int module_subscribe (module_t *p, const char *topic);
 int module_unsubscribe (module_t *p, const char *topic);
-int module_event_cast (module_t *p, const flux_msg_t *msg);
+
+/* Send an event to module without checking its subscriptions.
+ */
+int module_event_send (module_t *p, const flux_msg_t *msg);
 
 ssize_t module_get_send_queue_count (module_t *p);
 ssize_t module_get_recv_queue_count (module_t *p);
@@ -19,8 +19,11 @@
 #include <unistd.h>
 #include <flux/core.h>
 #include <inttypes.h>
+#include <limits.h>
 #include <jansson.h>
 #include <uuid.h>
+#include <arpa/inet.h>
+#include <lz4.h>
 
 #include "src/common/libzmqutil/msg_zsock.h"
 #include "src/common/libzmqutil/sockopt.h"
@@ -28,6 +31,7 @@
 #include "src/common/libzmqutil/zap.h"
 #include "src/common/libzmqutil/cert.h"
 #include "src/common/libzmqutil/monitor.h"
+#include "src/common/libzmqutil/mpart.h"
 #include "src/common/libczmqcontainers/czmq_containers.h"
 #include "src/common/libutil/log.h"
 #include "src/common/libutil/cleanup.h"
@@ -68,6 +72,17 @@ static bool have_connect_timeout = false;
 
 #define FLUX_ZAP_DOMAIN "flux"
 
+/* Messages larger than this are sent on their own rather than batched.
+ * They gain little from sharing a send and would be copied into the batch.
+ */
+static const ssize_t batch_max_msgsize = 16384;
+
+/* With tbon.batch, a socket callback receives up to this many messages
+ * that are already waiting, so that messages relayed in the same reactor
+ * iteration can be batched.
+ */
+static const int batch_max_recv = 64;
+
 /* Numerical values for "subtree health" so we can send them in control
  * messages.  Textual values below will be used for communication with front
  * end diagnostic tool.
@@ -95,6 +110,18 @@ static const char *subtree_status_names[] = {
     NULL,
 };
 
+/* Per-peer compression state, see link_send().
+ */
+struct compress {
+    bool enabled;           // peer negotiated compression in overlay.hello
+    int count;              // messages compressed
+    int64_t bytes;          // bytes before compression
+    int64_t zbytes;         // bytes after compression
+    double seconds;         // time spent compressing
+    int dcount;             // messages decompressed
+    double dseconds;        // time spent decompressing
+};
+
 struct child {
     double lastseen;
     uint32_t rank;
@@ -104,6 +131,9 @@ struct child {
     bool torpid;
     struct rpc_track *tracker;
     flux_error_t error;
+    bool batch;             // peer negotiated batching in overlay.hello
+    struct flux_msglist *batch_queue;
+    struct compress compress;
 };
 
 struct parent {
@@ -116,6 +146,9 @@ struct parent {
     char uuid[UUID_STR_LEN];
     bool hello_error;
     bool hello_responded;
+    bool batch;             // peer negotiated batching in overlay.hello
+    struct flux_msglist *batch_queue;
+    struct compress compress;
     bool offline;           // set upon receipt of CONTROL_DISCONNECT
     bool goodbye_sent;
     flux_future_t *f_goodbye;
@@ -166,6 +199,11 @@ struct overlay {
     double tcp_user_timeout;
     double connect_timeout;
     int child_rcvhwm;
+    int batch;                  // tbon.batch: offer batching to peers
+    flux_watcher_t *batch_w;
+    int batch_count;            // batches sent
+    int batch_msg_count;        // messages sent in batches
+    int compress;               // tbon.compress: min payload size (0=off)
 
     struct parent parent;
 
@@ -198,6 +236,25 @@ static int overlay_control_parent (struct overlay *ov,
                                    enum control_type type,
                                    int status);
 static void overlay_health_respond_all (struct overlay *ov);
+static int batch_append (struct overlay *ov,
+                         struct flux_msglist **queue,
+                         const flux_msg_t *msg);
+static bool batch_accepts (const flux_msg_t *msg);
+static int batch_send (struct overlay *ov,
+                       void *zsock,
+                       struct flux_msglist *queue,
+                       const char *route,
+                       struct compress *zc,
+                       struct rpc_track *tracker);
+static int link_send (struct overlay *ov,
+                      void *zsock,
+                      const flux_msg_t *msg,
+                      const char *route,
+                      struct compress *zc);
+static int lz4_encode (const flux_msg_t *msg,
+                       struct compress *zc,
+                       flux_msg_t **zmsgp);
+static void batch_flush_child (struct overlay *ov, struct child *child);
 static struct child *child_lookup_byrank (struct overlay *ov, uint32_t rank);
 
 /* Convenience iterator for ov->children
@@ -512,7 +569,23 @@ static int overlay_sendmsg_parent (struct overlay *ov, const flux_msg_t *msg)
         errno = EHOSTUNREACH;
         goto done;
     }
-    rc = zmqutil_msg_send (ov->parent.zsock, msg);
+    if (ov->parent.batch && batch_accepts (msg))
+        rc = batch_append (ov, &ov->parent.batch_queue, msg);
+    else if (ov->parent.batch
+             && batch_send (ov,
+                            ov->parent.zsock,
+                            ov->parent.batch_queue,
+                            NULL,
+                            &ov->parent.compress,
+                            ov->parent.tracker) < 0)
+        rc = -1; // send what is queued first to keep messages in order
+    else {
+        rc = link_send (ov,
+                        ov->parent.zsock,
+                        msg,
+                        NULL,
+                        &ov->parent.compress);
+    }
     if (rc == 0) {
         ov->parent.lastsent = flux_reactor_now (ov->reactor);
         trace_overlay_msg (ov->h,
@@ -746,6 +819,21 @@ static void overlay_child_status_update (struct overlay *ov,
     if (child->status != status) {
         if (subtree_is_online (child->status)
             && !subtree_is_online (status)) {
+            /* Send anything still queued for the child, e.g. the
+             * overlay.goodbye response, but stop batching.
+             */
+            struct flux_msglist *queue = child->batch_queue;
+            child->batch_queue = NULL;
+            child->batch = false;
+            (void)batch_send (ov,
+                              ov->bind_zsock,
+                              queue,
+                              child->uuid,
+                              &child->compress,
+                              child->tracker);
+            flux_msglist_destroy (queue);
+            child->compress.enabled = false;
+
             zhashx_delete (ov->child_hash, child->uuid);
             rpc_track_purge (child->tracker, fail_child_rpcs, ov);
         }
@@ -786,32 +874,53 @@ static void log_lost_connection (struct overlay *ov,
               add);
 }
 
+/* Since ROUTER socket has ZMQ_ROUTER_MANDATORY set, EHOSTUNREACH on a
+ * connected peer signifies a disconnect.  See zmq_setsockopt(3).
+ */
+static void child_lost_connection (struct overlay *ov, struct child *child)
+{
+    int saved_errno = errno;
+
+    log_lost_connection (ov, child, "failed");
+    overlay_child_status_update (ov,
+                                 child,
+                                 SUBTREE_STATUS_LOST,
+                                 "lost connection");
+    errno = saved_errno;
+}
+
 static int overlay_sendmsg_child (struct overlay *ov, const flux_msg_t *msg)
 {
+    const char *uuid;
+    struct child *child = NULL;
     int rc = -1;
 
     if (!ov->bind_zsock) {
         errno = EHOSTUNREACH;
         goto done;
     }
-    rc = zmqutil_msg_send_ex (ov->bind_zsock, msg, true);
-    /* Since ROUTER socket has ZMQ_ROUTER_MANDATORY set, EHOSTUNREACH on a
-     * connected peer signifies a disconnect.  See zmq_setsockopt(3).
-     */
+    if ((ov->batch || ov->compress > 0)
+        && (uuid = flux_msg_route_last (msg)))
+        child = child_lookup_online (ov, uuid);
+    if (child && child->batch && batch_accepts (msg))
+        rc = batch_append (ov, &child->batch_queue, msg);
+    else if (child
+             && child->batch
+             && batch_send (ov,
+                            ov->bind_zsock,
+                            child->batch_queue,
+                            uuid,
+                            &child->compress,
+                            child->tracker) < 0)
+        rc = -1; // send what is queued first to keep messages in order
+    else if (child)
+        rc = link_send (ov, ov->bind_zsock, msg, uuid, &child->compress);
+    else
+        rc = zmqutil_msg_send_ex (ov->bind_zsock, msg, true);
     if (rc < 0 && errno == EHOSTUNREACH) {
-        int saved_errno = errno;
-        const char *uuid;
-        struct child *child;
-
         if ((uuid = flux_msg_route_last (msg))
-            && (child = child_lookup_online (ov, uuid))) {
-            log_lost_connection (ov, child, "failed");
-            overlay_child_status_update (ov,
-                                         child,
-                                         SUBTREE_STATUS_LOST,
-                                         "lost connection");
-        }
-        errno = saved_errno;
+            && (child = child_lookup_online (ov, uuid)))
+            child_lost_connection (ov, child);
     }
     if (rc == 0 && flux_msglist_count (ov->trace_requests) > 0) {
         const char *uuid;
@@ -833,29 +942,105 @@ done:
     return rc;
 }
 
-/* Push child->uuid onto the message, then pop it off again after sending.
+/* Send 'mpart', the message encoded once by overlay_mcast_child(), to
+ * 'child'.  Only the route frame is new, the rest are shared by
+ * reference with the messages sent to the other children.
  */
 static int overlay_mcast_child_one (struct overlay *ov,
-                                    flux_msg_t *msg,
+                                    zlist_t *mpart,
                                     struct child *child)
 {
-    if (flux_msg_route_push (msg, child->uuid) < 0)
+    int rc;
+
+    if (!ov->bind_zsock) {
+        errno = EHOSTUNREACH;
         return -1;
-    int rc = overlay_sendmsg_child (ov, msg);
-    (void)flux_msg_route_delete_last (msg);
+    }
+    /* Events are not batched, so send what is queued for the child
+     * first to keep messages in order.
+     */
+    batch_flush_child (ov, child);
+    if (!subtree_is_online (child->status)) {
+        errno = EHOSTUNREACH;
+        return -1;
+    }
+    rc = zmqutil_msg_send_routed (ov->bind_zsock, child->uuid, mpart, true);
+    if (rc < 0 && errno == EHOSTUNREACH)
+        child_lost_connection (ov, child);
     return rc;
 }
 
+/* Encode 'msg' once as an overlay.lz4 wrapper for the children that
+ * negotiated compression, as overlay_mcast_child() does for the others.
+ * Set '*zmpart' to NULL if the payload is below the threshold or doesn't
+ * shrink.  The cost of the one compression is left in 'zc'.
+ */
+static int mcast_lz4_encode (struct overlay *ov,
+                             const flux_msg_t *msg,
+                             struct compress *zc,
+                             zlist_t **zmpart)
+{
+    const void *payload;
+    size_t size;
+    flux_msg_t *zmsg = NULL;
+    zlist_t *mpart = NULL;
+
+    if (flux_msg_get_payload (msg, &payload, &size) == 0
+        && size >= (size_t)ov->compress) {
+        if (lz4_encode (msg, zc, &zmsg) < 0)
+            return -1;
+        if (zmsg && !(mpart = zmqutil_msg_encode (zmsg))) {
+            ERRNO_SAFE_WRAP (flux_msg_destroy, zmsg);
+            return -1;
+        }
+        flux_msg_destroy (zmsg);
+    }
+    *zmpart = mpart;
+    return 0;
+}
+
 static void overlay_mcast_child (struct overlay *ov, flux_msg_t *msg)
 {
     struct child *child;
+    zlist_t *mpart = NULL;
+    zlist_t *zmpart = NULL;
+    struct compress zc = { 0 };
+    bool zencoded = false;
     int count = 0;
 
     flux_msg_route_enable (msg);
 
     foreach_overlay_child (ov, child) {
         if (subtree_is_online (child->status)) {
-            if (overlay_mcast_child_one (ov, msg, child) < 0) {
+            zlist_t *part;
+
+            /* Encode on the first online child of each kind, so leaf
+             * brokers and brokers with no online children don't pay
+             * for it.  The compression time is charged to the first
+             * child with compression enabled.
+             */
+            if (child->compress.enabled && !zencoded) {
+                if (mcast_lz4_encode (ov, msg, &zc, &zmpart) < 0) {
+                    flux_log_error (ov->h, "mcast error compressing message");
+                    goto done;
+                }
+                child->compress.seconds += zc.seconds;
+                zencoded = true;
+            }
+            if (child->compress.enabled && zmpart) {
+                part = zmpart;
+                child->compress.count += zc.count;
+                child->compress.bytes += zc.bytes;
+                child->compress.zbytes += zc.zbytes;
+            }
+            else {
+                if (!mpart && !(mpart = zmqutil_msg_encode (msg))) {
+                    flux_log_error (ov->h, "mcast error encoding message");
+                    goto done;
+                }
+                part = mpart;
+            }
+            if (overlay_mcast_child_one (ov, part, child) < 0) {
                 if (errno != EHOSTUNREACH) {
                     flux_log_error (ov->h,
                                     "mcast error to child rank %lu",
@@ -866,6 +1051,9 @@ static void overlay_mcast_child (struct overlay *ov, flux_msg_t *msg)
                 count++;
         }
     }
+done:
+    mpart_destroy (mpart);
+    mpart_destroy (zmpart);
     if (count > 0) {
         trace_overlay_msg (ov->h,
                            "tx",
@@ -875,6 +1063,366 @@ static void overlay_mcast_child (struct overlay *ov, flux_msg_t *msg)
     }
 }
 
+/* When both ends of a link enable tbon.compress, a message whose payload
+ * is at least tbon.compress bytes is sent wrapped in an overlay.lz4 request.
+ * The wrapper payload is the size of the encoded message as a 32 bit integer
+ * in network byte order, followed by the LZ4 compressed encoded message.
+ * Set '*zmsgp' to NULL if compression doesn't reduce the size.
+ */
+static int lz4_encode (const flux_msg_t *msg,
+                       struct compress *zc,
+                       flux_msg_t **zmsgp)
+{
+    struct timespec t0;
+    ssize_t size;
+    int bound;
+    char *buf;
+    char *zbuf;
+    uint32_t nsize;
+    int zsize;
+    flux_msg_t *zmsg = NULL;
+
+    monotime (&t0);
+    if ((size = flux_msg_encode_size (msg)) < 0)
+        return -1;
+    if (size > LZ4_MAX_INPUT_SIZE) {
+        *zmsgp = NULL;
+        return 0;
+    }
+    bound = LZ4_compressBound (size);
+    if (!(buf = malloc (size + sizeof (nsize) + bound)))
+        return -1;
+    zbuf = buf + size;
+    if (flux_msg_encode (msg, buf, size) < 0)
+        goto error;
+    nsize = htonl (size);
+    memcpy (zbuf, &nsize, sizeof (nsize));
+    if ((zsize = LZ4_compress_default (buf,
+                                       zbuf + sizeof (nsize),
+                                       size,
+                                       bound)) == 0) {
+        errno = EINVAL;
+        goto error;
+    }
+    if (zsize + sizeof (nsize) < (size_t)size) {
+        if (!(zmsg = flux_request_encode_raw ("overlay.lz4",
+                                              zbuf,
+                                              zsize + sizeof (nsize))))
+            goto error;
+        flux_msg_route_enable (zmsg);
+        zc->count++;
+        zc->bytes += size;
+        zc->zbytes += zsize + sizeof (nsize);
+    }
+    zc->seconds += monotime_since (t0) / 1000.;
+    free (buf);
+    *zmsgp = zmsg;
+    return 0;
+error:
+    ERRNO_SAFE_WRAP (free, buf);
+    return -1;
+}
+
+static flux_msg_t *lz4_decode (const flux_msg_t *msg, struct compress *zc)
+{
+    struct timespec t0;
+    const void *data;
+    size_t zsize;
+    uint32_t size;
+    char *buf;
+    flux_msg_t *inner;
+
+    monotime (&t0);
+    if (flux_request_decode_raw (msg, NULL, &data, &zsize) < 0)
+        return NULL;
+    if (zsize < sizeof (size) || zsize - sizeof (size) > INT_MAX) {
+        errno = EPROTO;
+        return NULL;
+    }
+    memcpy (&size, data, sizeof (size));
+    size = ntohl (size);
+    if (size == 0 || size > LZ4_MAX_INPUT_SIZE) {
+        errno = EPROTO;
+        return NULL;
+    }
+    if (!(buf = malloc (size)))
+        return NULL;
+    if (LZ4_decompress_safe ((const char *)data + sizeof (size),
+                             buf,
+                             zsize - sizeof (size),
+                             size) != (int)size) {
+        free (buf);
+        errno = EPROTO;
+        return NULL;
+    }
+    inner = flux_msg_decode (buf, size);
+    ERRNO_SAFE_WRAP (free, buf);
+    zc->dcount++;
+    zc->dseconds += monotime_since (t0) / 1000.;
+    return inner;
+}
+
+/* Send 'msg' to a peer, compressed if negotiated with the peer and the
+ * payload is large enough.  If 'route' is non-NULL, the peer is a child,
+ * so push its uuid onto the wrapper message for the ROUTER socket and
+ * don't block, as in overlay_sendmsg_child().
+ */
+static int link_send (struct overlay *ov,
+                      void *zsock,
+                      const flux_msg_t *msg,
+                      const char *route,
+                      struct compress *zc)
+{
+    const void *payload;
+    size_t size;
+    flux_msg_t *zmsg = NULL;
+    int rc;
+
+    if (zc->enabled
+        && flux_msg_get_payload (msg, &payload, &size) == 0
+        && size >= (size_t)ov->compress) {
+        if (lz4_encode (msg, zc, &zmsg) < 0
+            || (zmsg && route && flux_msg_route_push (zmsg, route) < 0)) {
+            ERRNO_SAFE_WRAP (flux_msg_destroy, zmsg);
+            return -1;
+        }
+    }
+    rc = zmqutil_msg_send_ex (zsock, zmsg ? zmsg : msg, route != NULL);
+    ERRNO_SAFE_WRAP (flux_msg_destroy, zmsg);
+    return rc;
+}
+
+/* When both ends of a link enable tbon.batch, messages sent on the link
+ * are queued and sent together in one overlay.batch request just before
+ * the reactor blocks.  The batch payload is a sequence of encoded messages,
+ * each preceded by its size as a 32 bit integer in network byte order.
+ * Messages over batch_max_msgsize bypass the queue, after it is sent.
+ */
+static bool batch_accepts (const flux_msg_t *msg)
+{
+    ssize_t size = flux_msg_encode_size (msg);
+
+    return size >= 0 && size <= batch_max_msgsize;
+}
+
+static int batch_append (struct overlay *ov,
+                         struct flux_msglist **queue,
+                         const flux_msg_t *msg)
+{
+    if (!*queue && !(*queue = flux_msglist_create ()))
+        return -1;
+    if (flux_msglist_append (*queue, msg) < 0)
+        return -1;
+    flux_watcher_start (ov->batch_w);
+    return 0;
+}
+
+static flux_msg_t *batch_encode (struct flux_msglist *queue)
+{
+    const flux_msg_t *msg;
+    size_t size = 0;
+    char *buf;
+    char *cp;
+    flux_msg_t *batch;
+
+    msg = flux_msglist_first (queue);
+    while (msg) {
+        ssize_t len;
+        if ((len = flux_msg_encode_size (msg)) < 0)
+            return NULL;
+        if (len > UINT32_MAX) {
+            errno = EOVERFLOW;
+            return NULL;
+        }
+        size += sizeof (uint32_t) + len;
+        msg = flux_msglist_next (queue);
+    }
+    if (!(buf = malloc (size)))
+        return NULL;
+    cp = buf;
+    msg = flux_msglist_first (queue);
+    while (msg) {
+        ssize_t len = flux_msg_encode_size (msg);
+        uint32_t nlen = htonl (len);
+
+        memcpy (cp, &nlen, sizeof (nlen));
+        cp += sizeof (nlen);
+        if (flux_msg_encode (msg, cp, len) < 0) {
+            ERRNO_SAFE_WRAP (free, buf);
+            return NULL;
+        }
+        cp += len;
+        msg = flux_msglist_next (queue);
+    }
+    if (!(batch = flux_request_encode_raw ("overlay.batch", buf, size))) {
+        ERRNO_SAFE_WRAP (free, buf);
+        return NULL;
+    }
+    flux_msg_route_enable (batch);
+    free (buf);
+    return batch;
+}
+
+/* Decode the next message in a batch payload and advance past it.
+ */
+static flux_msg_t *batch_next (const char **buf, size_t *size)
+{
+    uint32_t len;
+    flux_msg_t *msg;
+
+    if (*size < sizeof (len)) {
+        errno = EPROTO;
+        return NULL;
+    }
+    memcpy (&len, *buf, sizeof (len));
+    len = ntohl (len);
+    if (*size - sizeof (len) < len) {
+        errno = EPROTO;
+        return NULL;
+    }
+    if (!(msg = flux_msg_decode (*buf + sizeof (len), len)))
+        return NULL;
+    *buf += sizeof (len) + len;
+    *size -= sizeof (len) + len;
+    return msg;
+}
+
+/* Respond with 'errnum' to the requests in 'queue', which could not be
+ * sent, so their senders don't wait forever, and stop tracking them.
+ * Requests sent downstream ('route' set) carry our uuid and the child's
+ * on the route stack, which the response must not.
+ */
+static void batch_fail_requests (struct overlay *ov,
+                                 struct flux_msglist *queue,
+                                 const char *route,
+                                 struct rpc_track *tracker,
+                                 int errnum)
+{
+    const flux_msg_t *msg;
+
+    msg = flux_msglist_first (queue);
+    while (msg) {
+        int type;
+        flux_msg_t *rep = NULL;
+
+        if (flux_msg_get_type (msg, &type) == 0
+            && type == FLUX_MSGTYPE_REQUEST
+            && !flux_msg_is_noresponse (msg)) {
+            if (!(rep = flux_response_derive (msg, errnum))
+                || (route && flux_msg_route_delete_last (rep) < 0)
+                || (route && flux_msg_route_delete_last (rep) < 0)
+                || flux_send (ov->h, rep, 0) < 0) {
+                const char *topic = "unknown";
+                (void)flux_msg_get_topic (msg, &topic);
+                flux_log_error (ov->h,
+                                "error responding to unsent %s request",
+                                topic);
+            }
+            else
+                rpc_track_update (tracker, rep);
+            flux_msg_destroy (rep);
+        }
+        msg = flux_msglist_next (queue);
+    }
+}
+
+/* Send and empty 'queue' with link_send().  A single message is sent as is.
+ * On failure, queued requests get error responses and all queued messages
+ * are dropped.
+ */
+static int batch_send (struct overlay *ov,
+                       void *zsock,
+                       struct flux_msglist *queue,
+                       const char *route,
+                       struct compress *zc,
+                       struct rpc_track *tracker)
+{
+    int count = flux_msglist_count (queue);
+    const flux_msg_t *msg;
+    flux_msg_t *batch = NULL;
+    int rc = -1;
+
+    if (count == 0)
+        return 0;
+    if (count == 1) {
+        if (link_send (ov, zsock, flux_msglist_first (queue), route, zc) < 0)
+            goto done;
+    }
+    else {
+        if (!(batch = batch_encode (queue))
+            || (route && flux_msg_route_push (batch, route) < 0)
+            || link_send (ov, zsock, batch, route, zc) < 0)
+            goto done;
+        ov->batch_count++;
+        ov->batch_msg_count += count;
+    }
+    rc = 0;
+done:
+    if (rc < 0) {
+        int saved_errno = errno;
+        batch_fail_requests (ov, queue, route, tracker, errno);
+        errno = saved_errno;
+    }
+    while ((msg = flux_msglist_pop (queue)))
+        ERRNO_SAFE_WRAP (flux_msg_decref, msg);
+    ERRNO_SAFE_WRAP (flux_msg_destroy, batch);
+    return rc;
+}
+
+static void batch_flush_child (struct overlay *ov, struct child *child)
+{
+    if (batch_send (ov,
+                    ov->bind_zsock,
+                    child->batch_queue,
+                    child->uuid,
+                    &child->compress,
+                    child->tracker) < 0) {
+        if (errno == EHOSTUNREACH)
+            child_lost_connection (ov, child);
+        else {
+            flux_log_error (ov->h,
+                            "error sending batch to child rank %lu",
+                            (unsigned long)child->rank);
+        }
+    }
+}
+
+/* Flush children first since a lost child may queue a status update
+ * for the parent.  Don't send to a parent that has disconnected us.
+ */
+static void overlay_batch_flush (struct overlay *ov)
+{
+    struct child *child;
+
+    foreach_overlay_child (ov, child)
+        batch_flush_child (ov, child);
+    if (ov->parent.zsock && !ov->parent.offline) {
+        if (batch_send (ov,
+                        ov->parent.zsock,
+                        ov->parent.batch_queue,
+                        NULL,
+                        &ov->parent.compress,
+                        ov->parent.tracker) < 0)
+            flux_log_error (ov->h, "error sending batch to parent");
+    }
+}
+
+static void batch_prepare_cb (flux_reactor_t *r,
+                              flux_watcher_t *w,
+                              int revents,
+                              void *arg)
+{
+    struct overlay *ov = arg;
+
+    /* Sending may cause more messages to be queued, which restarts
+     * the watcher.  Keep going so nothing is left behind while blocked.
+     */
+    do {
+        flux_watcher_stop (w);
+        overlay_batch_flush (ov);
+    } while (flux_watcher_is_active (w));
+}
+
 static void logdrop (struct overlay *ov,
                      overlay_where_t where,
                      const flux_msg_t *msg,
@@ -919,22 +1467,76 @@ static int clear_msg_role (flux_msg_t *msg, uint32_t role)
     return 0;
 }
 
+/* Flags for child_recv() and parent_recv() describing how a message was
+ * unpacked from the one read from the socket.
+ */
+enum {
+    RECV_BATCHED = 1,       // from an overlay.batch request
+    RECV_COMPRESSED = 2,    // from an overlay.lz4 request
+};
+
+static void child_recv (struct overlay *ov, flux_msg_t *msg, int flags);
+
+/* Handle each message in an overlay.batch request from 'child' as though
+ * it had been received from the ROUTER socket, which pushes the child uuid.
+ */
+static void child_recv_batch (struct overlay *ov,
+                              struct child *child,
+                              const flux_msg_t *msg,
+                              int flags)
+{
+    const void *data;
+    const char *buf;
+    size_t size;
+    flux_msg_t *inner;
+
+    if (flux_request_decode_raw (msg, NULL, &data, &size) < 0) {
+        logdrop (ov, OVERLAY_DOWNSTREAM, msg, "malformed batch");
+        return;
+    }
+    buf = data;
+    while (size > 0) {
+        if (!(inner = batch_next (&buf, &size))) {
+            logdrop (ov, OVERLAY_DOWNSTREAM, msg, "malformed batch");
+            return;
+        }
+        if (flux_msg_route_push (inner, child->uuid) < 0) {
+            logdrop (ov, OVERLAY_DOWNSTREAM, inner, "failed to push route");
+            flux_msg_decref (inner);
+            return;
+        }
+        child_recv (ov, inner, flags | RECV_BATCHED);
+    }
+}
+
+static void child_recv_lz4 (struct overlay *ov,
+                            struct child *child,
+                            const flux_msg_t *msg)
+{
+    flux_msg_t *inner;
+
+    if (!(inner = lz4_decode (msg, &child->compress))) {
+        logdrop (ov, OVERLAY_DOWNSTREAM, msg, "malformed compressed message");
+        return;
+    }
+    if (flux_msg_route_push (inner, child->uuid) < 0) {
+        logdrop (ov, OVERLAY_DOWNSTREAM, inner, "failed to push route");
+        flux_msg_decref (inner);
+        return;
+    }
+    child_recv (ov, inner, RECV_COMPRESSED);
+}
+
 /* Handle a message received from TBON child (downstream).
+ * 'flags' is zero for a message read from the socket.
  */
-static void child_cb (flux_reactor_t *r,
-                      flux_watcher_t *w,
-                      int revents,
-                      void *arg)
+static void child_recv (struct overlay *ov, flux_msg_t *msg, int flags)
 {
-    struct overlay *ov = arg;
-    flux_msg_t *msg;
     int type = -1;
     const char *topic = NULL;
     const char *uuid = NULL;
     struct child *child;
 
-    if (!(msg = zmqutil_msg_recv (ov->bind_zsock)))
-        return;
     if (clear_msg_role (msg, FLUX_ROLE_LOCAL) < 0) {
         logdrop (ov, OVERLAY_DOWNSTREAM, msg, "failed to clear local role");
         goto done;
@@ -953,7 +1555,8 @@ static void child_cb (flux_reactor_t *r,
          * we don't bother checking if we've seen this UUID before, which can
          * be slow given current design.  See flux-framework/flux-core#5864.
          */
-        if (type == FLUX_MSGTYPE_REQUEST
+        if (flags == 0
+            && type == FLUX_MSGTYPE_REQUEST
             && flux_msg_get_topic (msg, &topic) == 0
             && streq (topic, "overlay.hello")
             && !ov->shutdown_in_progress) {
@@ -1002,6 +1605,24 @@ static void child_cb (flux_reactor_t *r,
             goto done;
         }
         case FLUX_MSGTYPE_REQUEST:
+            if (child->batch
+                && flux_msg_get_topic (msg, &topic) == 0
+                && streq (topic, "overlay.batch")) {
+                if ((flags & RECV_BATCHED))
+                    logdrop (ov, OVERLAY_DOWNSTREAM, msg, "nested batch");
+                else
+                    child_recv_batch (ov, child, msg, flags);
+                goto done;
+            }
+            if (child->compress.enabled
+                && flux_msg_get_topic (msg, &topic) == 0
+                && streq (topic, "overlay.lz4")) {
+                if (flags != 0)
+                    logdrop (ov, OVERLAY_DOWNSTREAM, msg, "nested lz4");
+                else
+                    child_recv_lz4 (ov, child, msg);
+                goto done;
+            }
             break;
         case FLUX_MSGTYPE_RESPONSE:
             /* Response message traveling upstream requires special handling:
@@ -1024,6 +1645,33 @@ done:
     flux_msg_decref (msg);
 }
 
+static bool zsock_readable (void *zsock)
+{
+    int events;
+
+    if (!zsock || zgetsockopt_int (zsock, ZMQ_EVENTS, &events) < 0)
+        return false;
+    return (events & ZMQ_POLLIN);
+}
+
+static void child_cb (flux_reactor_t *r,
+                      flux_watcher_t *w,
+                      int revents,
+                      void *arg)
+{
+    struct overlay *ov = arg;
+    flux_msg_t *msg;
+    int count = 0;
+
+    do {
+        if (!(msg = zmqutil_msg_recv (ov->bind_zsock)))
+            return;
+        child_recv (ov, msg, 0);
+    } while (ov->batch
+             && ++count < batch_max_recv
+             && zsock_readable (ov->bind_zsock));
+}
+
 /* Parent endpoint disconnected, so any pending RPCs going that way
  * get EHOSTUNREACH responses so they can fail fast.
  */
@@ -1038,18 +1686,56 @@ static void fail_parent_rpc (const flux_msg_t *msg, void *arg)
         log_tracker_error (ov->h, msg, errno);
 }
 
-static void parent_cb (flux_reactor_t *r,
-                       flux_watcher_t *w,
-                       int revents,
-                       void *arg)
+static void parent_recv (struct overlay *ov, flux_msg_t *msg, int flags);
+
+/* Handle each message in an overlay.batch request from the parent as though
+ * it had been received from the DEALER socket, after the parent's ROUTER
+ * socket popped our uuid.
+ */
+static void parent_recv_batch (struct overlay *ov,
+                               const flux_msg_t *msg,
+                               int flags)
+{
+    const void *data;
+    const char *buf;
+    size_t size;
+    flux_msg_t *inner;
+
+    if (flux_request_decode_raw (msg, NULL, &data, &size) < 0) {
+        logdrop (ov, OVERLAY_UPSTREAM, msg, "malformed batch");
+        return;
+    }
+    buf = data;
+    while (size > 0) {
+        if (!(inner = batch_next (&buf, &size))) {
+            logdrop (ov, OVERLAY_UPSTREAM, msg, "malformed batch");
+            return;
+        }
+        (void)flux_msg_route_delete_last (inner);
+        parent_recv (ov, inner, flags | RECV_BATCHED);
+    }
+}
+
+static void parent_recv_lz4 (struct overlay *ov, const flux_msg_t *msg)
+{
+    flux_msg_t *inner;
+
+    if (!(inner = lz4_decode (msg, &ov->parent.compress))) {
+        logdrop (ov, OVERLAY_UPSTREAM, msg, "malformed compressed message");
+        return;
+    }
+    (void)flux_msg_route_delete_last (inner);
+    parent_recv (ov, inner, RECV_COMPRESSED);
+}
+
+/* Handle a message received from TBON parent (upstream).
+ * 'flags' is zero for a message read from the socket.
+ */
+static void parent_recv (struct overlay *ov, flux_msg_t *msg, int flags)
 {
-    struct overlay *ov = arg;
-    flux_msg_t *msg;
     int type;
     const char *topic = NULL;
 
-    if (!(msg = zmqutil_msg_recv (ov->parent.zsock)))
-        return;
     if (clear_msg_role (msg, FLUX_ROLE_LOCAL) < 0) {
         logdrop (ov, OVERLAY_UPSTREAM, msg, "failed to clear local role");
         goto done;
@@ -1073,6 +1759,26 @@ static void parent_cb (flux_reactor_t *r,
         }
     }
     switch (type) {
+        case FLUX_MSGTYPE_REQUEST:
+            if (ov->parent.batch
+                && flux_msg_get_topic (msg, &topic) == 0
+                && streq (topic, "overlay.batch")) {
+                if ((flags & RECV_BATCHED))
+                    logdrop (ov, OVERLAY_UPSTREAM, msg, "nested batch");
+                else
+                    parent_recv_batch (ov, msg, flags);
+                goto done;
+            }
+            if (ov->parent.compress.enabled
+                && flux_msg_get_topic (msg, &topic) == 0
+                && streq (topic, "overlay.lz4")) {
+                if (flags != 0)
+                    logdrop (ov, OVERLAY_UPSTREAM, msg, "nested lz4");
+                else
+                    parent_recv_lz4 (ov, msg);
+                goto done;
+            }
+            break;
         case FLUX_MSGTYPE_RESPONSE:
             rpc_track_update (ov->parent.tracker, msg);
             break;
@@ -1096,6 +1802,8 @@ static void parent_cb (flux_reactor_t *r,
                           (unsigned long)ov->parent.rank);
                 (void)zmq_disconnect (ov->parent.zsock, ov->parent.uri);
                 ov->parent.offline = true;
+                flux_msglist_destroy (ov->parent.batch_queue);
+                ov->parent.batch_queue = NULL;
                 rpc_track_purge (ov->parent.tracker, fail_parent_rpc, ov);
                 overlay_monitor_notify (ov, FLUX_NODEID_ANY);
             }
@@ -1114,6 +1822,24 @@ done:
     flux_msg_destroy (msg);
 }
 
+static void parent_cb (flux_reactor_t *r,
+                       flux_watcher_t *w,
+                       int revents,
+                       void *arg)
+{
+    struct overlay *ov = arg;
+    flux_msg_t *msg;
+    int count = 0;
+
+    do {
+        if (!(msg = zmqutil_msg_recv (ov->parent.zsock)))
+            return;
+        parent_recv (ov, msg, 0);
+    } while (ov->batch
+             && ++count < batch_max_recv
+             && zsock_readable (ov->parent.zsock));
+}
+
 
 #define V_MAJOR(v)  (((v) >> 16) & 0xff)
 #define V_MINOR(v)  (((v) >> 8) & 0xff)
@@ -1158,16 +1884,20 @@ static void hello_request_handler (struct overlay *ov, const flux_msg_t *msg)
     const char *uuid;
     int status;
     const char *hostname = NULL;
+    int batch = 0;
+    int compress = 0;
     int hello_log_level = LOG_DEBUG;
 
     if (flux_request_unpack (msg,
                              NULL,
-                             "{s:I s:i s:s s:i s?s}",
+                             "{s:I s:i s:s s:i s?s s?b s?b}",
                              "rank", &rank,
                              "version", &version,
                              "uuid", &uuid,
                              "status", &status,
-                             "hostname", &hostname) < 0)
+                             "hostname", &hostname,
+                             "batch", &batch,
+                             "compress", &compress) < 0)
         goto error; // EPROTO (unlikely)
 
     if (flux_msg_authorize (msg, FLUX_USERID_UNKNOWN) < 0) {
@@ -1243,11 +1973,22 @@ static void hello_request_handler (struct overlay *ov, const flux_msg_t *msg)
               (unsigned long)child->rank,
               subtree_status_str (child->status));
 
+    /* Batching and compression are enabled only if both ends offer them.
+     * Older brokers neither offer them nor look for them in the response.
+     */
+    batch = batch && ov->batch;
+    compress = compress && ov->compress > 0;
     if (!(response = flux_response_derive (msg, 0))
-        || flux_msg_pack (response, "{s:s}", "uuid", ov->uuid) < 0
+        || flux_msg_pack (response,
+                          "{s:s s:b s:b}",
+                          "uuid", ov->uuid,
+                          "batch", batch,
+                          "compress", compress) < 0
         || overlay_sendmsg_child (ov, response) < 0)
         flux_log_error (ov->h, "error responding to overlay.hello request");
     flux_msg_destroy (response);
+    child->batch = batch;
+    child->compress.enabled = compress;
     return;
 error:
     if (!(response = flux_response_derive (msg, errno))
@@ -1266,9 +2007,15 @@ static void hello_response_handler (struct overlay *ov, const flux_msg_t *msg)
 {
     const char *errstr = NULL;
     const char *uuid;
+    int batch = 0;
+    int compress = 0;
 
     if (flux_response_decode (msg, NULL, NULL) < 0
-        || flux_msg_unpack (msg, "{s:s}", "uuid", &uuid) < 0) {
+        || flux_msg_unpack (msg,
+                            "{s:s s?b s?b}",
+                            "uuid", &uuid,
+                            "batch", &batch,
+                            "compress", &compress) < 0) {
         int saved_errno = errno;
         (void)flux_msg_get_string (msg, &errstr);
         errno = saved_errno;
@@ -1280,6 +2027,8 @@ static void hello_response_handler (struct overlay *ov, const flux_msg_t *msg)
               (unsigned long)ov->parent.rank,
               uuid);
     snprintf (ov->parent.uuid, sizeof (ov->parent.uuid), "%s", uuid);
+    ov->parent.batch = batch && ov->batch;
+    ov->parent.compress.enabled = compress && ov->compress > 0;
     ov->parent.hello_responded = true;
     ov->parent.hello_error = false;
     overlay_monitor_notify (ov, FLUX_NODEID_ANY);
@@ -1301,12 +2050,14 @@ static int hello_request_send (struct overlay *ov,
 
     if (!(msg = flux_request_encode ("overlay.hello", NULL))
         || flux_msg_pack (msg,
-                          "{s:I s:i s:s s:i s:s}",
+                          "{s:I s:i s:s s:i s:s s:b s:b}",
                           "rank", rank,
                           "version", ov->version,
                           "uuid", ov->uuid,
                           "status", ov->status,
-                          "hostname", ov->hostname) < 0
+                          "hostname", ov->hostname,
+                          "batch", ov->batch,
+                          "compress", ov->compress > 0) < 0
         || flux_msg_set_rolemask (msg, FLUX_ROLE_OWNER) < 0
         || overlay_sendmsg_parent (ov, msg) < 0) {
         flux_msg_decref (msg);
@@ -1678,26 +2429,75 @@ static int child_rpc_track_count (struct overlay *ov)
     return count;
 }
 
+/* Append compression stats for peer 'rank' to 'array', if any.
+ */
+static int compress_stats_append (json_t *array,
+                                  uint32_t rank,
+                                  struct compress *zc)
+{
+    json_t *entry;
+
+    if (!zc->enabled && zc->count == 0 && zc->dcount == 0)
+        return 0;
+    if (!(entry = json_pack ("{s:i s:b s:i s:I s:I s:f s:f s:i s:f}",
+                             "rank", rank,
+                             "enabled", zc->enabled,
+                             "count", zc->count,
+                             "bytes", (json_int_t)zc->bytes,
+                             "zbytes", (json_int_t)zc->zbytes,
+                             "ratio", zc->zbytes > 0
+                                      ? (double)zc->bytes / zc->zbytes : 0.,
+                             "seconds", zc->seconds,
+                             "dcount", zc->dcount,
+                             "dseconds", zc->dseconds))
+        || json_array_append_new (array, entry) < 0) {
+        json_decref (entry);
+        errno = ENOMEM;
+        return -1;
+    }
+    return 0;
+}
+
 static void overlay_stats_get_cb (flux_t *h,
                                   flux_msg_handler_t *mh,
                                   const flux_msg_t *msg,
                                   void *arg)
 {
     struct overlay *ov = arg;
+    struct child *child;
+    json_t *compress = NULL;
 
     if (flux_request_decode (msg, NULL, NULL) < 0)
         goto error;
+    if (!(compress = json_array ())) {
+        errno = ENOMEM;
+        goto error;
+    }
+    if (ov->rank > 0
+        && compress_stats_append (compress,
+                                  ov->parent.rank,
+                                  &ov->parent.compress) < 0)
+        goto error;
+    foreach_overlay_child (ov, child) {
+        if (compress_stats_append (compress, child->rank, &child->compress) < 0)
+            goto error;
+    }
     if (flux_respond_pack (h,
                            msg,
-                           "{s:i s:i s:i s:i s:i}",
+                           "{s:i s:i s:i s:i s:i s:i s:i s:O}",
                            "child-count", ov->child_count,
                            "child-connected", overlay_get_child_peer_count (ov),
                            "parent-count", ov->rank > 0 ? 1 : 0,
                            "parent-rpc", rpc_track_count (ov->parent.tracker),
-                           "child-rpc", child_rpc_track_count (ov)) < 0)
+                           "child-rpc", child_rpc_track_count (ov),
+                           "batch-count", ov->batch_count,
+                           "batch-msg-count", ov->batch_msg_count,
+                           "compress", compress) < 0)
         flux_log_error (h, "error responding to overlay.stats-get");
+    json_decref (compress);
     return;
 error:
+    json_decref (compress);
     if (flux_respond_error (h, msg, errno, NULL) < 0)
         flux_log_error (h, "error responding to overlay.stats-get");
 }
@@ -2361,6 +3161,15 @@ void overlay_destroy (struct overlay *ov)
         flux_msg_handler_delvec (ov->handlers);
         ov->status = SUBTREE_STATUS_OFFLINE;
         overlay_control_parent (ov, CONTROL_STATUS, ov->status);
+        if (ov->parent.zsock && !ov->parent.offline)
+            (void)batch_send (ov,
+                              ov->parent.zsock,
+                              ov->parent.batch_queue,
+                              NULL,
+                              &ov->parent.compress,
+                              ov->parent.tracker);
+        flux_msglist_destroy (ov->parent.batch_queue);
+        flux_watcher_destroy (ov->batch_w);
         flux_future_destroy (ov->parent.f_goodbye);
 
         zmq_close (ov->parent.zsock);
@@ -2377,8 +3186,10 @@ void overlay_destroy (struct overlay *ov)
         zhashx_destroy (&ov->child_hash);
         if (ov->children) {
             int i;
-            for (i = 0; i < ov->child_count; i++)
+            for (i = 0; i < ov->child_count; i++) {
                 rpc_track_destroy (ov->children[i].tracker);
+                flux_msglist_destroy (ov->children[i].batch_queue);
+            }
             free (ov->children);
         }
         rpc_track_destroy (ov->parent.tracker);
@@ -2523,6 +3334,20 @@ struct overlay *overlay_create (flux_t *h,
         errno = EINVAL;
         goto error;
     }
+    if (overlay_configure_tbon_int (ov, "batch", &ov->batch, 0) < 0)
+        goto error;
+    if (ov->batch != 0 && ov->batch != 1) {
+        log_msg ("tbon.batch must be 0 or 1");
+        errno = EINVAL;
+        goto error;
+    }
+    if (overlay_configure_tbon_int (ov, "compress", &ov->compress, 0) < 0)
+        goto error;
+    if (ov->compress < 0) {
+        log_msg ("tbon.compress must be 0 (off) or a payload size in bytes");
+        errno = EINVAL;
+        goto error;
+    }
     if (overlay_configure_topo (ov) < 0)
         goto error;
     if (flux_msg_handler_addvec (h, htab, ov, &ov->handlers) < 0)
@@ -2537,6 +3362,10 @@ struct overlay *overlay_create (flux_t *h,
     if (!(ov->parent.f_goodbye = flux_future_create (NULL, NULL)))
         goto error;
     flux_future_set_flux (ov->parent.f_goodbye, h);
+    if (!(ov->batch_w = flux_prepare_watcher_create (ov->reactor,
+                                                     batch_prepare_cb,
+                                                     ov)))
+        goto error;
     return ov;
 nomem:
     errno = ENOMEM;
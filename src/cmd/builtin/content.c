@@ -14,6 +14,8 @@
 #include "builtin.h"
 
 #include <unistd.h>
+#include <inttypes.h>
+#include <jansson.h>
 
 #include "src/common/libutil/blobref.h"
 #include "src/common/libutil/read_all.h"
@@ -168,6 +170,39 @@ static int internal_content_dropcache (optparse_t *p, int ac, char *av[])
     return (0);
 }
 
+static int internal_content_gc (optparse_t *p, int ac, char *av[])
+{
+    flux_t *h;
+    flux_future_t *f = NULL;
+    int count;
+    json_int_t bytes;
+    int live;
+    double duration;
+
+    if (optparse_option_index (p) != ac) {
+        optparse_print_usage (p);
+        exit (1);
+    }
+    if (!(h = builtin_get_flux_handle (p)))
+        log_err_exit ("flux_open");
+    if (!(f = flux_rpc (h, "content.gc", NULL, 0, 0))
+        || flux_rpc_get_unpack (f,
+                                "{s:i s:I s:i s:f}",
+                                "count", &count,
+                                "bytes", &bytes,
+                                "live", &live,
+                                "duration", &duration) < 0)
+        log_msg_exit ("content.gc: %s", future_strerror (f, errno));
+    printf ("reclaimed %d blobs (%jd bytes), %d live, in %.3fs\n",
+            count,
+            (intmax_t)bytes,
+            live,
+            duration);
+    flux_future_destroy (f);
+    flux_close (h);
+    return (0);
+}
+
 int cmd_content (optparse_t *p, int ac, char *av[])
 {
     log_init ("flux-content");
@@ -220,6 +255,13 @@ static struct optparse_subcommand content_subcmds[] = {
       0,
       NULL,
     },
+    { "gc",
+      NULL,
+      "Remove unreferenced blobs from the content backing store",
+      internal_content_gc,
+      0,
+      NULL,
+    },
     OPTPARSE_SUBCMD_END
 };
 
@@ -34,6 +34,7 @@
 
 static void dump_treeobj (struct archive *ar,
                           flux_t *h,
+                          struct content_loader *ld,
                           const char *path,
                           json_t *treeobj);
 
@@ -47,6 +48,10 @@ static gid_t dump_gid;
 static uid_t dump_uid;
 static int keycount;
 
+/* Maximum number of blobs in flight per directory being dumped.
+ */
+static const int load_window = 64;
+
 static void read_verror (const char *fmt, va_list ap)
 {
     char buf[128];
@@ -143,8 +148,18 @@ static void dump_write_data (struct archive *ar, const void *data, int size)
                  "assuming non-fatal libarchive write size reporting error");
 }
 
+/* Discard the next 'count' blobs from the loader, e.g. the remaining
+ * blobs of a valref after one could not be read.
+ */
+static void skip_blobs (struct content_loader *ld, int count)
+{
+    while (count-- > 0)
+        (void)content_loader_next (ld, NULL, NULL, NULL);
+}
+
 static void dump_valref (struct archive *ar,
                          flux_t *h,
+                         struct content_loader *ld,
                          const char *path,
                          json_t *treeobj)
 {
@@ -158,36 +173,24 @@ static void dump_valref (struct archive *ar,
 
     /* We need the total size before we start writing archive data,
      * so make a first pass, saving the data for writing later.
-     */
-    /* N.B. first attempt was to save the futures in an array, but ran into:
-     *   flux: ev_epoll.c:134: epoll_modify: Assertion `("libev: I/O watcher
-     *    with invalid fd found in epoll_ctl", errno != EBADF && errno != ELOOP
-     *    && errno != EINVAL)' failed.
-     * while archiving a resource.eventlog with 781 entries.  Instead of
-     * retaining the futures for a second pass, just retain references to the
-     * content.load response messages.
+     * The blobs were queued on 'ld' by dump_dir().  Retain references
+     * to the content.load response messages rather than copying the data.
      */
     if (!(l = flux_msglist_create ()))
         log_err_exit ("could not create message list");
     for (int i = 0; i < count; i++) {
-        flux_future_t *f;
-        if (!(f = content_load_byblobref (h,
-                                          treeobj_get_blobref (treeobj, i),
-                                          content_flags))
-            || flux_future_get (f, (const void **)&msg) < 0
-            || flux_response_decode_raw (msg, NULL, &data, &len) < 0) {
+        if (content_loader_next (ld, &msg, NULL, &len) < 0) {
             read_error ("%s: missing blobref %d: %s",
                         path,
                         i,
-                        future_strerror (f, errno));
-            flux_future_destroy (f);
+                        content_loader_error (ld));
+            skip_blobs (ld, count - i - 1);
             flux_msglist_destroy (l);
             return;
         }
         if (flux_msglist_append (l, msg) < 0)
             log_err_exit ("could not stash load response message");
         total_size += len;
-        flux_future_destroy (f);
     }
     if (!(entry = archive_entry_new ()))
         log_msg_exit ("error creating archive entry");
@@ -215,6 +218,7 @@ static void dump_valref (struct archive *ar,
 
 static void dump_val (struct archive *ar,
                       flux_t *h,
+                      struct content_loader *ld,
                       const char *path,
                       json_t *treeobj)
 {
@@ -242,6 +246,7 @@ static void dump_val (struct archive *ar,
 
 static void dump_symlink (struct archive *ar,
                           flux_t *h,
+                          struct content_loader *ld,
                           const char *path,
                           json_t *treeobj)
 {
@@ -271,57 +276,127 @@ static void dump_symlink (struct archive *ar,
     archive_entry_free (entry);
 }
 
+/* Queue the blobs referenced by valref and dirref entries of 'treeobj'
+ * on a loader, in the order they will be visited, so they are fetched
+ * in a pipeline instead of one round trip at a time.
+ * If 'path' is NULL, 'treeobj' is the root directory.
+ */
 static void dump_dir (struct archive *ar,
                       flux_t *h,
                       const char *path,
                       json_t *treeobj)
 {
     json_t *dict = treeobj_get_data (treeobj);
+    struct content_loader *ld;
     const char *name;
     json_t *entry;
 
+    if (!(ld = content_loader_create (h, load_window, content_flags)))
+        log_err_exit ("error creating content loader");
+    json_object_foreach (dict, name, entry) {
+        if (treeobj_validate (entry) == 0
+            && (treeobj_is_valref (entry) || treeobj_is_dirref (entry))) {
+            int count = treeobj_get_count (entry);
+            for (int i = 0; i < count; i++) {
+                if (content_loader_push (ld,
+                                         treeobj_get_blobref (entry, i)) < 0)
+                    log_err_exit ("%s%s%s: error queuing blobref",
+                                  path ? path : "",
+                                  path ? "/" : "",
+                                  name);
+            }
+        }
+    }
     json_object_foreach (dict, name, entry) {
         char *newpath;
-        if (asprintf (&newpath, "%s/%s", path, name) < 0)
+        if (!path)
+            newpath = strdup (name);
+        else if (asprintf (&newpath, "%s/%s", path, name) < 0)
+            newpath = NULL;
+        if (!newpath)
             log_msg_exit ("out of memory");
-        dump_treeobj (ar, h, newpath, entry); // recurse
+        dump_treeobj (ar, h, ld, newpath, entry); // recurse
         free (newpath);
     }
+    content_loader_destroy (ld);
+}
+
+/* Dump the entries of each shard of hdir 'treeobj' as entries of 'path'.
+ */
+static void dump_hdir (struct archive *ar,
+                       flux_t *h,
+                       const char *path,
+                       json_t *treeobj)
+{
+    json_t *dict = treeobj_get_data (treeobj);
+    struct content_loader *ld;
+    const char *index;
+    json_t *shard;
+
+    if (!(ld = content_loader_create (h, load_window, content_flags)))
+        log_err_exit ("error creating content loader");
+    json_object_foreach (dict, index, shard) {
+        if (!treeobj_is_dirref (shard) || treeobj_get_count (shard) != 1)
+            log_msg_exit ("%s: invalid hdir shard", path);
+        if (content_loader_push (ld, treeobj_get_blobref (shard, 0)) < 0)
+            log_err_exit ("%s: error queuing blobref", path);
+    }
+    json_object_foreach (dict, index, shard) {
+        const void *buf;
+        size_t buflen;
+        json_t *treeobj_deref;
+
+        if (content_loader_next (ld, NULL, &buf, &buflen) < 0) {
+            read_error ("%s: missing blobref: %s",
+                        path,
+                        content_loader_error (ld));
+            continue;
+        }
+        if (!(treeobj_deref = treeobj_decodeb (buf, buflen)))
+            log_err_exit ("%s: could not decode directory shard", path);
+        if (treeobj_is_hdir (treeobj_deref))
+            dump_hdir (ar, h, path, treeobj_deref); // recurse
+        else if (treeobj_is_dir (treeobj_deref))
+            dump_dir (ar, h, path, treeobj_deref);
+        else
+            log_msg_exit ("%s: hdir shard references non-directory", path);
+        json_decref (treeobj_deref);
+    }
+    content_loader_destroy (ld);
 }
 
 static void dump_dirref (struct archive *ar,
                          flux_t *h,
+                         struct content_loader *ld,
                          const char *path,
                          json_t *treeobj)
 {
-    flux_future_t *f;
     const void *buf;
     size_t buflen;
     json_t *treeobj_deref = NULL;
 
     if (treeobj_get_count (treeobj) != 1)
         log_msg_exit ("%s: blobref count is not 1", path);
-    if (!(f = content_load_byblobref (h,
-                                      treeobj_get_blobref (treeobj, 0),
-                                      content_flags))
-        || content_load_get (f, &buf, &buflen) < 0) {
+    if (content_loader_next (ld, NULL, &buf, &buflen) < 0) {
         read_error ("%s: missing blobref: %s",
                     path,
-                    future_strerror (f, errno));
-        flux_future_destroy (f);
+                    content_loader_error (ld));
         return;
     }
     if (!(treeobj_deref = treeobj_decodeb (buf, buflen)))
         log_err_exit ("%s: could not decode directory", path);
-    if (!treeobj_is_dir (treeobj_deref))
+    if (treeobj_is_hdir (treeobj_deref))
+        dump_hdir (ar, h, path, treeobj_deref); // recurse
+    else if (treeobj_is_dir (treeobj_deref))
+        dump_dir (ar, h, path, treeobj_deref); // recurse
+    else
         log_msg_exit ("%s: dirref references non-directory", path);
-    dump_dir (ar, h, path, treeobj_deref); // recurse
     json_decref (treeobj_deref);
-    flux_future_destroy (f);
 }
 
 static void dump_treeobj (struct archive *ar,
                           flux_t *h,
+                          struct content_loader *ld,
                           const char *path,
                           json_t *treeobj)
 {
@@ -330,20 +405,20 @@ static void dump_treeobj (struct archive *ar,
     if (treeobj_is_symlink (treeobj)) {
         if (verbose)
             fprintf (stderr, "%s\n", path);
-        dump_symlink (ar, h, path, treeobj);
+        dump_symlink (ar, h, ld, path, treeobj);
     }
     else if (treeobj_is_val (treeobj)) {
         if (verbose)
             fprintf (stderr, "%s\n", path);
-        dump_val (ar, h, path, treeobj);
+        dump_val (ar, h, ld, path, treeobj);
     }
     else if (treeobj_is_valref (treeobj)) {
         if (verbose)
             fprintf (stderr, "%s\n", path);
-        dump_valref (ar, h, path, treeobj);
+        dump_valref (ar, h, ld, path, treeobj);
     }
     else if (treeobj_is_dirref (treeobj)) {
-        dump_dirref (ar, h, path, treeobj); // recurse
+        dump_dirref (ar, h, ld, path, treeobj); // recurse
     }
     else if (treeobj_is_dir (treeobj)) {
         dump_dir (ar, h, path, treeobj); // recurse
@@ -358,9 +433,6 @@ static void dump_blobref (struct archive *ar,
     const void *buf;
     size_t buflen;
     json_t *treeobj;
-    json_t *dict;
-    const char *key;
-    json_t *entry;
 
     if (!(f = content_load_byblobref (h, blobref, content_flags))
         || content_load_get (f, &buf, &buflen) < 0) {
@@ -376,10 +448,7 @@ static void dump_blobref (struct archive *ar,
     if (!treeobj_is_dir (treeobj))
         log_msg_exit ("root tree object is not a directory");
 
-    dict = treeobj_get_data (treeobj);
-    json_object_foreach (dict, key, entry) {
-        dump_treeobj (ar, h, key, entry);
-    }
+    dump_dir (ar, h, NULL, treeobj);
     json_decref (treeobj);
     flux_future_destroy (f);
 }
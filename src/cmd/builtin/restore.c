@@ -38,6 +38,14 @@
 
 #define BLOCKSIZE 10240 // taken from libarchive example
 
+/* Blobs are hashed locally and queued, then a batch is flushed by asking
+ * the content service which blobs it already has and storing only the
+ * rest.  This makes restoring onto a store that already holds most of
+ * the content (e.g. an incremental restore) mostly free of data transfer.
+ */
+#define QUEUE_MAX_BLOBS 256
+#define QUEUE_MAX_BYTES (16*1024*1024)
+
 static bool sd_notify_flag;
 static bool verbose;
 static bool quiet;
@@ -47,6 +55,17 @@ static int blobcount;
 static int keycount;
 static int blob_size_limit;
 
+struct blob {
+    void *data;
+    int size;
+    char hash[BLOBREF_MAX_DIGEST_SIZE];
+    int hash_size;
+};
+
+static struct blob queue[QUEUE_MAX_BLOBS];
+static int queue_count;
+static size_t queue_bytes;
+
 static void progress (int delta_blob, int delta_keys)
 {
     blobcount += delta_blob;
@@ -110,6 +129,99 @@ static void restore_destroy (struct archive *ar)
     archive_read_free (ar);
 }
 
+/* Send the queued blobs that the content service does not already have.
+ * If the service does not support the existence probe, store them all.
+ */
+static void flush_blobs (flux_t *h)
+{
+    char hashes[QUEUE_MAX_BLOBS * BLOBREF_MAX_DIGEST_SIZE];
+    const char *present = NULL;
+    flux_future_t *fs[QUEUE_MAX_BLOBS] = { NULL };
+    flux_future_t *f;
+    int hash_size;
+    int count;
+    int i;
+
+    if (queue_count == 0)
+        return;
+    hash_size = queue[0].hash_size;
+    for (i = 0; i < queue_count; i++)
+        memcpy (hashes + i * hash_size, queue[i].hash, hash_size);
+    if (!(f = content_has_byhash (h,
+                                  hashes,
+                                  queue_count * hash_size,
+                                  content_flags))
+        || content_has_get (f, &present, &count) < 0) {
+        if (errno != ENOSYS)
+            log_msg_exit ("error probing content store: %s",
+                          future_strerror (f, errno));
+        present = NULL;
+    }
+    else if (count != queue_count)
+        log_msg_exit ("error probing content store: %s", strerror (EPROTO));
+    for (i = 0; i < queue_count; i++) {
+        if (present && present[i])
+            continue;
+        if (!(fs[i] = content_store (h,
+                                     queue[i].data,
+                                     queue[i].size,
+                                     content_flags)))
+            log_err_exit ("error storing blob");
+    }
+    for (i = 0; i < queue_count; i++) {
+        const void *hash;
+        size_t size;
+
+        if (fs[i]) {
+            if (content_store_get_hash (fs[i], &hash, &size) < 0)
+                log_msg_exit ("error storing blob: %s",
+                              future_strerror (fs[i], errno));
+            if (size != queue[i].hash_size
+                || memcmp (hash, queue[i].hash, size) != 0)
+                log_msg_exit ("content store returned unexpected hash");
+            flux_future_destroy (fs[i]);
+        }
+        free (queue[i].data);
+    }
+    flux_future_destroy (f);
+    queue_count = 0;
+    queue_bytes = 0;
+}
+
+/* Hash blob locally, returning its blobref in 'blobref', and queue a copy
+ * to be stored.
+ */
+static void restore_blob (flux_t *h,
+                          const char *hash_type,
+                          const void *data,
+                          int size,
+                          char *blobref,
+                          size_t blobref_len)
+{
+    struct blob *blob = &queue[queue_count];
+
+    if ((blob->hash_size = blobref_hash_raw (hash_type,
+                                             data,
+                                             size,
+                                             blob->hash,
+                                             sizeof (blob->hash))) < 0
+        || blobref_hashtostr (hash_type,
+                              blob->hash,
+                              blob->hash_size,
+                              blobref,
+                              blobref_len) < 0)
+        log_err_exit ("error computing blobref");
+    if (!(blob->data = malloc (size > 0 ? size : 1)))
+        log_msg_exit ("out of memory");
+    memcpy (blob->data, data, size);
+    blob->size = size;
+    queue_count++;
+    queue_bytes += size;
+    progress (1, 0);
+    if (queue_count == QUEUE_MAX_BLOBS || queue_bytes >= QUEUE_MAX_BYTES)
+        flush_blobs (h);
+}
+
 static json_t *restore_dir (flux_t *h, const char *hash_type, json_t *dir)
 {
     json_t *data = treeobj_get_data (dir);
@@ -131,21 +243,15 @@ static json_t *restore_dir (flux_t *h, const char *hash_type, json_t *dir)
     }
 
     char *s;
-    flux_future_t *f;
-    const char *blobref;
+    char blobref[BLOBREF_MAX_STRING_SIZE];
     json_t *dirref;
 
     if (!(s = treeobj_encode (ndir)))
         log_msg_exit ("out of memory");
-    if (!(f = content_store (h, s, strlen (s), content_flags))
-        || content_store_get_blobref (f, hash_type, &blobref) < 0)
-        log_msg_exit ("error storing dirref blob: %s",
-                      future_strerror (f, errno));
-    progress (1, 0);
+    restore_blob (h, hash_type, s, strlen (s), blobref, sizeof (blobref));
     if (!(dirref = treeobj_create_dirref (blobref)))
         log_msg_exit ("out of memory");
     free (s);
-    flux_future_destroy (f);
     json_decref (ndir);
 
     return dirref;
@@ -233,18 +339,11 @@ static void restore_value (flux_t *h,
             log_err_exit ("error creating val object for %s", path);
     }
     else {
-        flux_future_t *f;
-        const char *blobref;
+        char blobref[BLOBREF_MAX_STRING_SIZE];
 
-        if (!(f = content_store (h, buf, size, content_flags))
-            || content_store_get_blobref (f, hash_type, &blobref) < 0)
-            log_msg_exit ("error storing blob for %s: %s",
-                          path,
-                          future_strerror (f, errno));
-        progress (1, 0);
+        restore_blob (h, hash_type, buf, size, blobref, sizeof (blobref));
         if (!(treeobj = treeobj_create_valref (blobref)))
             log_err_exit ("error creating valref object for %s", path);
-        flux_future_destroy (f);
     }
     restore_treeobj (root, path, treeobj);
     json_decref (treeobj);
@@ -327,6 +426,7 @@ static json_t *restore_snapshot (struct archive *ar,
     free (buf);
     rootref = restore_dir (h, hash_type, root);
     json_decref (root);
+    flush_blobs (h);
 
     return rootref;
 }
@@ -373,7 +473,7 @@ static int cmd_restore (optparse_t *p, int ac, char *av[])
     struct archive *ar;
     const char *infile;
     int kvs_checkpoint_flags = 0;
-    char *hash_type = "sha1";
+    const char *hash_type;
 
     log_init ("flux-restore");
 
@@ -397,6 +497,8 @@ static int cmd_restore (optparse_t *p, int ac, char *av[])
     const char *s;
     if ((s = flux_attr_get (h, "broker.sd-notify")) && !streq (s, "0"))
         sd_notify_flag = true;
+    if (!(hash_type = flux_attr_get (h, "content.hash")))
+        hash_type = "sha1";
 
     ar = restore_create (infile);
 
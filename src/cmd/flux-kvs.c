@@ -694,22 +694,8 @@ struct lookup_ctx {
 };
 
 
-void lookup_continuation (flux_future_t *f, void *arg)
+void lookup_print (flux_future_t *f, const char *key, struct lookup_ctx *ctx)
 {
-    struct lookup_ctx *ctx = arg;
-    const char *key = flux_kvs_lookup_get_key (f);
-
-    if ((optparse_hasopt (ctx->p, "watch")
-         || optparse_hasopt (ctx->p, "stream"))
-        && flux_rpc_get (f, NULL) < 0
-        && errno == ENODATA) {
-        if (optparse_hasopt (ctx->p, "stream")
-            && ctx->have_output)
-            printf ("\n");
-        flux_future_destroy (f);
-        return; // EOF
-    }
-
     if (optparse_hasopt (ctx->p, "treeobj")) {
         const char *treeobj;
         if (flux_kvs_lookup_get_treeobj (f, &treeobj) < 0)
@@ -743,6 +729,25 @@ void lookup_continuation (flux_future_t *f, void *arg)
         }
     }
     fflush (stdout);
+}
+
+void lookup_continuation (flux_future_t *f, void *arg)
+{
+    struct lookup_ctx *ctx = arg;
+    const char *key = flux_kvs_lookup_get_key (f);
+
+    if ((optparse_hasopt (ctx->p, "watch")
+         || optparse_hasopt (ctx->p, "stream"))
+        && flux_rpc_get (f, NULL) < 0
+        && errno == ENODATA) {
+        if (optparse_hasopt (ctx->p, "stream")
+            && ctx->have_output)
+            printf ("\n");
+        flux_future_destroy (f);
+        return; // EOF
+    }
+
+    lookup_print (f, key, ctx);
     if (optparse_hasopt (ctx->p, "watch")) {
         flux_future_reset (f);
         if (ctx->maxcount > 0 && ++ctx->count == ctx->maxcount) {
@@ -757,6 +762,7 @@ void lookup_continuation (flux_future_t *f, void *arg)
         flux_future_destroy (f);
 }
 
+
 void cmd_get_one (flux_t *h, const char *key, struct lookup_ctx *ctx)
 {
     flux_future_t *f;
@@ -794,6 +800,34 @@ void cmd_get_one (flux_t *h, const char *key, struct lookup_ctx *ctx)
     }
 }
 
+/* Look up several keys against one KVS snapshot with a single request.
+ * Responses arrive in key order.
+ */
+void cmd_get_batch (flux_t *h,
+                    int count,
+                    char **keys,
+                    struct lookup_ctx *ctx)
+{
+    flux_future_t *f;
+    int flags = 0;
+
+    if (optparse_hasopt (ctx->p, "treeobj"))
+        flags |= FLUX_KVS_TREEOBJ;
+    if (!(f = flux_kvs_lookup_batch (h,
+                                     ctx->ns,
+                                     flags,
+                                     (const char **)keys,
+                                     count)))
+        log_err_exit ("flux_kvs_lookup_batch");
+    for (int i = 0; i < count; i++) {
+        lookup_print (f, keys[i], ctx);
+        flux_future_reset (f);
+    }
+    if (flux_rpc_get (f, NULL) < 0 && errno != ENODATA)
+        log_err_exit ("flux_kvs_lookup_batch");
+    flux_future_destroy (f);
+}
+
 int cmd_get (optparse_t *p, int argc, char **argv)
 {
     flux_t *h;
@@ -814,6 +848,17 @@ int cmd_get (optparse_t *p, int argc, char **argv)
     if (!(h = flux_open (NULL, 0)))
         log_err_exit ("flux_open");
 
+    /* Multiple plain lookups are read from one snapshot in one request.
+     */
+    if (argc - optindex > 1
+        && !optparse_hasopt (p, "watch")
+        && !optparse_hasopt (p, "waitcreate")
+        && !optparse_hasopt (p, "stream")
+        && !optparse_hasopt (p, "at")) {
+        cmd_get_batch (h, argc - optindex, argv + optindex, &ctx);
+        flux_close (h);
+        return (0);
+    }
     for (i = optindex; i < argc; i++)
         cmd_get_one (h, argv[i], &ctx);
     /* Unless --watch is specified, cmd_get_one() starts the reactor and
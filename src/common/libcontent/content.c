@@ -13,13 +13,43 @@
 #endif
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 #include <errno.h>
 #include <flux/core.h>
 
 #include "content.h"
 
+#include "src/common/libccan/ccan/list/list.h"
 #include "src/common/libutil/blobref.h"
 #include "src/common/libutil/errno_safe.h"
+#include "src/common/libutil/errprintf.h"
+
+/* A loader 'unit' is one outstanding request for digests
+ * [start, start + count) of the loader's queue.
+ */
+struct loader_unit {
+    flux_future_t *f;
+    int start;
+    int count;
+    int received;
+    bool streaming;
+    struct list_node list;
+};
+
+struct content_loader {
+    flux_t *h;
+    int window;
+    int flags;
+    uint8_t *hashes;                // queued digests
+    int hash_size;
+    int alloc;
+    int count;                      // digests queued
+    int sent;                       // digests requested
+    int received;                   // digests returned by next()
+    struct list_head units;         // outstanding requests, in order
+    const flux_msg_t *msg;          // last response returned by next()
+    flux_error_t error;
+};
 
 flux_future_t *content_load_byhash (flux_t *h,
                                     const void *hash,
@@ -59,6 +89,297 @@ int content_load_get (flux_future_t *f, const void **buf, size_t *len)
     return flux_rpc_get_raw (f, buf, len);
 }
 
+flux_future_t *content_load_batch_byhash (flux_t *h,
+                                          const void *hashes,
+                                          size_t size,
+                                          int flags)
+{
+    uint32_t rank = FLUX_NODEID_ANY;
+
+    if (!h || !hashes || size == 0 || (flags & CONTENT_FLAG_CACHE_BYPASS)) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if ((flags & CONTENT_FLAG_UPSTREAM))
+        rank = FLUX_NODEID_UPSTREAM;
+    return flux_rpc_raw (h,
+                         "content.load-batch",
+                         hashes,
+                         size,
+                         rank,
+                         FLUX_RPC_STREAMING);
+}
+
+int content_load_batch_get (flux_future_t *f, const void **buf, size_t *len)
+{
+    return flux_rpc_get_raw (f, buf, len);
+}
+
+flux_future_t *content_has_byhash (flux_t *h,
+                                   const void *hashes,
+                                   size_t size,
+                                   int flags)
+{
+    const char *topic = "content.has";
+    uint32_t rank = FLUX_NODEID_ANY;
+
+    if (!h || !hashes || size == 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if ((flags & CONTENT_FLAG_UPSTREAM))
+        rank = FLUX_NODEID_UPSTREAM;
+    if ((flags & CONTENT_FLAG_CACHE_BYPASS)) {
+        topic = "content-backing.has";
+        rank = 0;
+    }
+    return flux_rpc_raw (h, topic, hashes, size, rank, 0);
+}
+
+int content_has_get (flux_future_t *f, const char **result, int *count)
+{
+    const void *buf;
+    size_t size;
+
+    if (flux_rpc_get_raw (f, &buf, &size) < 0)
+        return -1;
+    if (result)
+        *result = buf;
+    if (count)
+        *count = size;
+    return 0;
+}
+
+static void loader_unit_destroy (struct loader_unit *u)
+{
+    if (u) {
+        int saved_errno = errno;
+        list_del (&u->list);
+        flux_future_destroy (u->f);
+        free (u);
+        errno = saved_errno;
+    }
+}
+
+/* Request digests [start, start + count) and add the request to the
+ * head or tail of the unit list.
+ */
+static int loader_send (struct content_loader *ld,
+                        int start,
+                        int count,
+                        bool head)
+{
+    struct loader_unit *u;
+    const uint8_t *hash = ld->hashes + start * ld->hash_size;
+
+    if (!(u = calloc (1, sizeof (*u))))
+        return -1;
+    u->start = start;
+    u->count = count;
+    list_node_init (&u->list);
+    if ((ld->flags & CONTENT_FLAG_CACHE_BYPASS)) {
+        assert (count == 1);
+        u->f = content_load_byhash (ld->h, hash, ld->hash_size, ld->flags);
+    }
+    else {
+        u->f = content_load_batch_byhash (ld->h,
+                                          hash,
+                                          count * ld->hash_size,
+                                          ld->flags);
+        u->streaming = true;
+    }
+    if (!u->f) {
+        ERRNO_SAFE_WRAP (free, u);
+        return -1;
+    }
+    if (head)
+        list_add (&ld->units, &u->list);
+    else
+        list_add_tail (&ld->units, &u->list);
+    return 0;
+}
+
+/* Top up requests once half the window has been consumed.
+ */
+static int loader_fill (struct content_loader *ld)
+{
+    int outstanding = ld->sent - ld->received;
+    int n;
+
+    if (outstanding > ld->window / 2)
+        return 0;
+    n = ld->window - outstanding;
+    if (n > ld->count - ld->sent)
+        n = ld->count - ld->sent;
+    if (n == 0)
+        return 0;
+    if ((ld->flags & CONTENT_FLAG_CACHE_BYPASS)) {
+        for (int i = 0; i < n; i++) {
+            if (loader_send (ld, ld->sent, 1, false) < 0)
+                return -1;
+            ld->sent++;
+        }
+    }
+    else {
+        if (loader_send (ld, ld->sent, n, false) < 0)
+            return -1;
+        ld->sent += n;
+    }
+    return 0;
+}
+
+/* Return the oldest unit with responses still to come, retiring units
+ * that are complete.  A streaming unit is complete once its ENODATA
+ * response has been received.
+ */
+static struct loader_unit *loader_head (struct content_loader *ld)
+{
+    struct loader_unit *u;
+
+    while ((u = list_top (&ld->units, struct loader_unit, list))) {
+        if (u->received < u->count)
+            return u;
+        if (u->streaming) {
+            if (flux_future_get (u->f, NULL) == 0) {
+                errno = EPROTO;
+                return NULL;
+            }
+            if (errno != ENODATA)
+                return NULL;
+        }
+        loader_unit_destroy (u);
+    }
+    errno = ENODATA;
+    return NULL;
+}
+
+int content_loader_next (struct content_loader *ld,
+                         const flux_msg_t **msgp,
+                         const void **bufp,
+                         size_t *lenp)
+{
+    struct loader_unit *u;
+    const flux_msg_t *msg;
+    const void *buf;
+    size_t len;
+
+    if (!ld) {
+        errno = EINVAL;
+        return -1;
+    }
+    flux_msg_decref (ld->msg);
+    ld->msg = NULL;
+    if (ld->received == ld->count) {
+        errno = ENODATA;
+        return -1;
+    }
+    if (loader_fill (ld) < 0 || !(u = loader_head (ld))) {
+        errprintf (&ld->error, "%s", flux_strerror (errno));
+        return -1;
+    }
+    if (flux_future_get (u->f, (const void **)&msg) < 0
+        || flux_response_decode_raw (msg, NULL, &buf, &len) < 0) {
+        int start = u->start + u->received + 1;
+        int count = u->count - u->received - 1;
+        int saved_errno = errno;
+
+        errprintf (&ld->error, "%s", future_strerror (u->f, errno));
+        /* The error ended the stream, so request the remainder of it.
+         */
+        loader_unit_destroy (u);
+        ld->received++;
+        if (count > 0 && loader_send (ld, start, count, true) < 0)
+            return -1;
+        errno = saved_errno;
+        return -1;
+    }
+    ld->msg = flux_msg_incref (msg);
+    ld->received++;
+    if (++u->received == u->count && !u->streaming)
+        loader_unit_destroy (u);
+    else if (u->streaming)
+        flux_future_reset (u->f);
+    if (msgp)
+        *msgp = msg;
+    if (bufp)
+        *bufp = buf;
+    if (lenp)
+        *lenp = len;
+    return 0;
+}
+
+int content_loader_push (struct content_loader *ld, const char *blobref)
+{
+    uint8_t hash[BLOBREF_MAX_DIGEST_SIZE];
+    ssize_t hash_size;
+
+    if (!ld || !blobref) {
+        errno = EINVAL;
+        return -1;
+    }
+    if ((hash_size = blobref_strtohash (blobref, hash, sizeof (hash))) < 0)
+        return -1;
+    /* Everything has been consumed, so start over at the front.
+     */
+    if (ld->received == ld->count && list_empty (&ld->units)) {
+        ld->count = ld->sent = ld->received = 0;
+        ld->hash_size = hash_size;
+    }
+    if (hash_size != ld->hash_size) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (ld->count == ld->alloc) {
+        int alloc = ld->alloc ? ld->alloc * 2 : ld->window;
+        uint8_t *hashes;
+
+        if (!(hashes = realloc (ld->hashes, alloc * ld->hash_size)))
+            return -1;
+        ld->hashes = hashes;
+        ld->alloc = alloc;
+    }
+    memcpy (ld->hashes + ld->count * ld->hash_size, hash, hash_size);
+    ld->count++;
+    return 0;
+}
+
+const char *content_loader_error (struct content_loader *ld)
+{
+    return ld ? ld->error.text : "";
+}
+
+void content_loader_destroy (struct content_loader *ld)
+{
+    if (ld) {
+        int saved_errno = errno;
+        struct loader_unit *u;
+
+        while ((u = list_top (&ld->units, struct loader_unit, list)))
+            loader_unit_destroy (u);
+        flux_msg_decref (ld->msg);
+        free (ld->hashes);
+        free (ld);
+        errno = saved_errno;
+    }
+}
+
+struct content_loader *content_loader_create (flux_t *h, int window, int flags)
+{
+    struct content_loader *ld;
+
+    if (!h || window < 1) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(ld = calloc (1, sizeof (*ld))))
+        return NULL;
+    ld->h = h;
+    ld->window = window;
+    ld->flags = flags;
+    list_head_init (&ld->units);
+    return ld;
+}
+
 flux_future_t *content_store (flux_t *h, const void *buf, size_t len, int flags)
 {
     const char *topic = "content.store";
@@ -34,6 +34,67 @@ flux_future_t *content_load_byblobref (flux_t *h,
  */
 int content_load_get (flux_future_t *f, const void **buf, size_t *len);
 
+/* Send streaming request to load the blobs whose hash digests are
+ * concatenated in 'hashes', of total size 'size'.  One response is
+ * received per digest, in order, then the stream is terminated with ENODATA.
+ * An error loading any blob terminates the stream with that error.
+ * CONTENT_FLAG_CACHE_BYPASS is not supported.
+ */
+flux_future_t *content_load_batch_byhash (flux_t *h,
+                                          const void *hashes,
+                                          size_t size,
+                                          int flags);
+
+/* Get next blob from a batch load request.
+ * Call flux_future_reset() after each successful response.
+ * Storage for 'buf' belongs to 'f' and is valid until 'f' is reset.
+ * Returns 0 on success, -1 on failure with errno set (ENODATA at end).
+ */
+int content_load_batch_get (flux_future_t *f, const void **buf, size_t *len);
+
+/* Send request to find out which of the blobs whose hash digests are
+ * concatenated in 'hashes', of total size 'size', are already stored.
+ * Blobs that are only held in memory and are not destined for the backing
+ * store (e.g. mmapped files) are reported as missing.
+ */
+flux_future_t *content_has_byhash (flux_t *h,
+                                   const void *hashes,
+                                   size_t size,
+                                   int flags);
+
+/* Get result of has request: an array of 'count' bytes in digest order,
+ * each set to 1 if the blob is present or 0 if it is not.
+ * Storage belongs to 'f' and is valid until 'f' is destroyed.
+ * Returns 0 on success, -1 on failure with errno set.
+ */
+int content_has_get (flux_future_t *f, const char **result, int *count);
+
+/* Pipelined loader.
+ * Blobrefs are queued with content_loader_push() and their contents
+ * are retrieved in the same order with content_loader_next(), which blocks
+ * until the next blob is available.  Up to 'window' blobs are kept in flight,
+ * using content.load-batch, or with CONTENT_FLAG_CACHE_BYPASS, individual
+ * backing store load requests.
+ */
+struct content_loader *content_loader_create (flux_t *h, int window, int flags);
+void content_loader_destroy (struct content_loader *ld);
+
+int content_loader_push (struct content_loader *ld, const char *blobref);
+
+/* Get the next blob.  Any of 'msg', 'buf', and 'len' may be NULL.
+ * The response message 'msg' and 'buf', which points into it, are valid
+ * until the next call (take a reference on 'msg' to keep them longer).
+ * A failure affects only the current blob: the next call moves on to the
+ * following one.  Returns 0 on success, or -1 on failure with errno set
+ * and an error string available from content_loader_error().
+ * If there are no more queued blobrefs, fail with ENODATA.
+ */
+int content_loader_next (struct content_loader *ld,
+                         const flux_msg_t **msg,
+                         const void **buf,
+                         size_t *len);
+const char *content_loader_error (struct content_loader *ld);
+
 /* Send request to store blob.
  */
 flux_future_t *content_store (flux_t *h,
@@ -69,36 +69,53 @@ static const char *fixup_archive_error_string (struct archive *archive)
     return errstr;
 }
 
-static int extract_blob (flux_t *h,
+/* Maximum number of blobs in flight while extracting a file.
+ */
+static const int load_window = 64;
+
+struct blobvec_entry {
+    json_int_t offset;
+    json_int_t size;
+    const char *blobref;
+};
+
+static int decode_blobvec_entry (const char *path,
+                                 json_t *o,
+                                 struct blobvec_entry *entry,
+                                 flux_error_t *errp)
+{
+    if (json_unpack (o,
+                     "[I,I,s]",
+                     &entry->offset,
+                     &entry->size,
+                     &entry->blobref) < 0)
+        return errprintf (errp, "%s: error decoding blobvec entry", path);
+    return 0;
+}
+
+/* Write the next blob from loader 'ld', which must correspond to
+ * blobvec entry 'o'.
+ */
+static int extract_blob (struct content_loader *ld,
                          struct archive *archive,
                          const char *path,
                          json_t *o,
                          flux_error_t *errp)
 {
-    struct {
-        json_int_t offset;
-        json_int_t size;
-        const char *blobref;
-    } entry;
-    flux_future_t *f;
+    struct blobvec_entry entry;
     const void *buf;
     size_t size;
 
-    if (json_unpack (o,
-                     "[I,I,s]",
-                     &entry.offset,
-                     &entry.size,
-                     &entry.blobref) < 0)
-        return errprintf (errp, "%s: error decoding blobvec entry", path);
-    if (!(f = content_load_byblobref (h, entry.blobref, 0))
-        || content_load_get (f, &buf, &size) < 0) {
+    if (decode_blobvec_entry (path, o, &entry, errp) < 0)
+        return -1;
+    if (content_loader_next (ld, NULL, &buf, &size) < 0) {
         return errprintf (errp,
                           "%s: error loading offset=%ju size=%ju from %s: %s",
                           path,
                           (uintmax_t)entry.offset,
                           (uintmax_t)entry.size,
                           entry.blobref,
-                          future_strerror (f, errno));
+                          content_loader_error (ld));
     }
     if (size != entry.size) {
         return errprintf (errp,
@@ -119,7 +136,6 @@ static int extract_blob (flux_t *h,
                           path,
                           fixup_archive_error_string (archive));
     }
-    flux_future_destroy (f);
     return 0;
 }
 
@@ -127,7 +143,7 @@ static int extract_blob (flux_t *h,
  *  libarchive object 'archive' and using 'path' as the default path
  *  if no path is encoded in 'fileref'.
  */
-static int extract_file (flux_t *h,
+static int extract_file (struct content_loader *ld,
                          struct archive *archive,
                          const char *path,
                          json_t *fileref,
@@ -236,8 +252,22 @@ static int extract_file (flux_t *h,
             free (buf);
         }
         else if (streq (encoding, "blobvec")) {
+            /* Queue all the blobs first so they are fetched in a pipeline.
+             */
+            json_array_foreach (data, index, o) {
+                struct blobvec_entry entry;
+
+                if (decode_blobvec_entry (path, o, &entry, errp) < 0)
+                    return -1;
+                if (content_loader_push (ld, entry.blobref) < 0)
+                    return errprintf (errp,
+                                      "%s: error queuing %s: %s",
+                                      path,
+                                      entry.blobref,
+                                      strerror (errno));
+            }
             json_array_foreach (data, index, o) {
-                if (extract_blob (h, archive, path, o, errp) < 0)
+                if (extract_blob (ld, archive, path, o, errp) < 0)
                     return -1;
             }
         }
@@ -279,9 +309,14 @@ int filemap_extract (flux_t *h,
     const char *key;
     size_t index;
     json_t *entry;
-    struct archive *archive;
+    struct archive *archive = NULL;
+    struct content_loader *ld;
     int rc = -1;
 
+    if (!(ld = content_loader_create (h, load_window, 0))) {
+        errprintf (errp, "error creating content loader");
+        goto out;
+    }
     if (!(archive = archive_write_disk_new ())
         || archive_write_disk_set_options (archive,
                                            libarchive_flags) != ARCHIVE_OK) {
@@ -291,7 +326,7 @@ int filemap_extract (flux_t *h,
 
     if (json_is_array (files)) {
         json_array_foreach (files, index, entry) {
-            if (extract_file (h,
+            if (extract_file (ld,
                               archive,
                               NULL,
                               entry,
@@ -302,7 +337,7 @@ int filemap_extract (flux_t *h,
         }
     } else {
         json_object_foreach (files, key, entry) {
-            if (extract_file (h,
+            if (extract_file (ld,
                               archive,
                               key,
                               entry,
@@ -316,6 +351,7 @@ int filemap_extract (flux_t *h,
 out:
     if (archive)
         archive_write_free (archive);
+    content_loader_destroy (ld);
     return rc;
 }
 
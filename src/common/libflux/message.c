@@ -29,6 +29,8 @@
 #endif
 #include <errno.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 #include <arpa/inet.h>
 #include <assert.h>
@@ -47,6 +49,54 @@
 #include "message_route.h"
 #include "message_proto.h"
 
+/* A payload buffer is preceded by a reference count so that copies of a
+ * message made with flux_msg_copy() can share it, for example when an event
+ * is delivered to many broker modules.  The payload is copied on write.
+ * The count is updated atomically, since copies may be destroyed by
+ * different threads.
+ */
+struct payload {
+    int refcount;
+    long double data[]; // aligned like malloc(3) memory
+};
+
+static struct payload *payload_hdr (void *buf)
+{
+    return (struct payload *)((char *)buf - offsetof (struct payload, data));
+}
+
+void *msg_payload_alloc (size_t size)
+{
+    struct payload *p;
+
+    if (!(p = malloc (sizeof (*p) + size)))
+        return NULL;
+    p->refcount = 1;
+    return p->data;
+}
+
+void msg_payload_free (void *buf)
+{
+    if (buf) {
+        struct payload *p = payload_hdr (buf);
+        if (__atomic_sub_fetch (&p->refcount, 1, __ATOMIC_ACQ_REL) == 0)
+            free (p);
+    }
+}
+
+static void *payload_incref (void *buf)
+{
+    struct payload *p = payload_hdr (buf);
+    __atomic_add_fetch (&p->refcount, 1, __ATOMIC_RELAXED);
+    return buf;
+}
+
+static bool payload_is_shared (void *buf)
+{
+    struct payload *p = payload_hdr (buf);
+    return __atomic_load_n (&p->refcount, __ATOMIC_ACQUIRE) > 1;
+}
+
 static int msg_validate (const flux_msg_t *msg)
 {
     if (!msg || msg->refcount <= 0) {
@@ -114,7 +164,7 @@ void flux_msg_destroy (flux_msg_t *msg)
         if (msg_has_route (msg))
             msg_route_clear (msg);
         free (msg->topic);
-        free (msg->payload);
+        msg_payload_free (msg->payload);
         json_decref (msg->json);
         aux_destroy (&msg->aux);
         free (msg->lasterr);
@@ -860,21 +910,24 @@ int flux_msg_set_payload (flux_msg_t *msg, const void *buf, size_t size)
                 return -1;
             }
         }
-        if (size > msg->payload_size) {
+        if (size > msg->payload_size || payload_is_shared (msg->payload)) {
             void *ptr;
-            if (!(ptr = realloc (msg->payload, size))) {
+            if (!(ptr = msg_payload_alloc (size))) {
                 errno = ENOMEM;
                 return -1;
             }
+            memcpy (ptr, buf, size);
+            msg_payload_free (msg->payload);
             msg->payload = ptr;
-            msg->payload_size = size;
         }
-        memcpy (msg->payload, buf, size);
+        else
+            memmove (msg->payload, buf, size);
+        msg->payload_size = size;
     /* Case #2: add payload.
      */
     } else if (!msg_has_payload (msg) && (buf != NULL && size > 0)) {
         assert (!msg->payload);
-        if (!(msg->payload = malloc (size)))
+        if (!(msg->payload = msg_payload_alloc (size)))
             return -1;
         msg->payload_size = size;
         memcpy (msg->payload, buf, size);
@@ -883,7 +936,7 @@ int flux_msg_set_payload (flux_msg_t *msg, const void *buf, size_t size)
      */
     } else if (msg_has_payload (msg) && (buf == NULL || size == 0)) {
         assert (msg->payload);
-        free (msg->payload);
+        msg_payload_free (msg->payload);
         msg->payload = NULL;
         msg->payload_size = 0;
         msg_clear_flag (msg, FLUX_MSGFLAG_PAYLOAD);
@@ -1157,9 +1210,7 @@ flux_msg_t *flux_msg_copy (const flux_msg_t *msg, bool payload)
     if (msg->payload) {
         if (payload) {
             cpy->payload_size = msg->payload_size;
-            if (!(cpy->payload = malloc (cpy->payload_size)))
-                goto error;
-            memcpy (cpy->payload, msg->payload, msg->payload_size);
+            cpy->payload = payload_incref (msg->payload);
         }
         else
             msg_clear_flag (cpy, FLUX_MSGFLAG_PAYLOAD);
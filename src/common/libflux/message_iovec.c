@@ -81,7 +81,7 @@ flux_msg_t *iovec_to_msg (struct msg_iovec *iov, int iovcnt)
             goto error;
         }
         msg->payload_size = iov[index].size;
-        if (!(msg->payload = malloc (msg->payload_size)))
+        if (!(msg->payload = msg_payload_alloc (msg->payload_size)))
             goto error;
         memcpy (msg->payload, iov[index].data, msg->payload_size);
         if (index < iovcnt)
@@ -42,6 +42,11 @@ struct flux_msg {
 
 flux_msg_t *msg_create (void);
 
+/* Allocate/release a payload buffer that flux_msg_copy() can share.
+ */
+void *msg_payload_alloc (size_t size);
+void msg_payload_free (void *buf);
+
 int msg_frames (const flux_msg_t *msg);
 
 #define msgtype_is_valid(tp) \
@@ -1064,6 +1064,56 @@ void check_copy (void)
     flux_msg_destroy (msg);
 }
 
+/* Copies share the payload until one of them sets a new one.
+ */
+void check_copy_shared_payload (void)
+{
+    flux_msg_t *msg, *cpy, *cpy2;
+    const char buf[] = "shared payload";
+    const void *msgbuf, *cpybuf, *cpy2buf;
+    size_t len;
+    const char *s;
+
+    if (!(msg = flux_msg_create (FLUX_MSGTYPE_EVENT))
+        || flux_msg_set_topic (msg, "foo") < 0
+        || flux_msg_set_payload (msg, buf, sizeof (buf)) < 0)
+        BAIL_OUT ("could not create test event");
+    if (!(cpy = flux_msg_copy (msg, true))
+        || !(cpy2 = flux_msg_copy (cpy, true)))
+        BAIL_OUT ("could not copy test event");
+    ok (flux_msg_get_payload (msg, &msgbuf, &len) == 0
+        && flux_msg_get_payload (cpy, &cpybuf, &len) == 0
+        && flux_msg_get_payload (cpy2, &cpy2buf, &len) == 0
+        && msgbuf == cpybuf && cpybuf == cpy2buf,
+        "copies share the original payload buffer");
+
+    ok (flux_msg_set_string (cpy, "changed") == 0,
+        "flux_msg_set_string on first copy works");
+    ok (flux_msg_get_string (cpy, &s) == 0 && streq (s, "changed"),
+        "first copy has new payload");
+    ok (flux_msg_get_payload (msg, &msgbuf, &len) == 0
+        && len == sizeof (buf) && memcmp (msgbuf, buf, len) == 0,
+        "original payload is unchanged");
+    ok (flux_msg_get_payload (cpy2, &cpy2buf, &len) == 0
+        && cpy2buf == msgbuf,
+        "second copy still shares original payload");
+
+    flux_msg_destroy (msg);
+    ok (flux_msg_get_payload (cpy2, &cpy2buf, &len) == 0
+        && len == sizeof (buf) && memcmp (cpy2buf, buf, len) == 0,
+        "second copy payload is intact after original is destroyed");
+    ok (flux_msg_set_payload (cpy2, "xyz", 3) == 0
+        && flux_msg_get_payload (cpy2, &cpy2buf, &len) == 0
+        && len == 3 && memcmp (cpy2buf, "xyz", 3) == 0,
+        "unshared payload can be replaced with a smaller one");
+    ok (flux_msg_set_payload (cpy2, NULL, 0) == 0
+        && !flux_msg_has_payload (cpy2),
+        "unshared payload can be removed");
+
+    flux_msg_destroy (cpy2);
+    flux_msg_destroy (cpy);
+}
+
 void check_print (void)
 {
     flux_msg_t *msg;
@@ -1405,6 +1455,7 @@ int main (int argc, char *argv[])
     check_security ();
     check_aux ();
     check_copy ();
+    check_copy_shared_payload ();
     check_flags ();
 
     check_cmp ();
@@ -27,6 +27,7 @@ struct lookup_ctx {
     char *key;
     char *atref;
     int flags;
+    bool batch;
 
     json_t *treeobj;
     char *treeobj_str; // json_dumps of tree object returned from lookup
@@ -207,6 +208,107 @@ flux_future_t *flux_kvs_lookupat (flux_t *h,
     return f;
 }
 
+flux_future_t *flux_kvs_lookup_batch (flux_t *h,
+                                      const char *ns,
+                                      int flags,
+                                      const char **keys,
+                                      int count)
+{
+    struct lookup_ctx *ctx;
+    flux_future_t *f;
+    json_t *array;
+
+    if (!h
+        || (!keys && count > 0)
+        || count < 0
+        || validate_lookup_flags (flags, false) < 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!ns) {
+        if (!(ns = kvs_get_namespace ()))
+            return NULL;
+    }
+    if (!(array = json_array ()))
+        goto nomem;
+    for (int i = 0; i < count; i++) {
+        json_t *o;
+        if (!keys[i] || strlen (keys[i]) == 0) {
+            json_decref (array);
+            errno = EINVAL;
+            return NULL;
+        }
+        if (!(o = json_string (keys[i]))
+            || json_array_append_new (array, o) < 0) {
+            json_decref (o);
+            json_decref (array);
+            goto nomem;
+        }
+    }
+    /* N.B. ctx->key is updated as each response is parsed */
+    if (!(ctx = alloc_ctx (h, flags, count > 0 ? keys[0] : ""))) {
+        json_decref (array);
+        return NULL;
+    }
+    ctx->batch = true;
+    if (!(f = flux_rpc_pack (h,
+                             "kvs.lookup-batch",
+                             FLUX_NODEID_ANY,
+                             FLUX_RPC_STREAMING,
+                             "{s:O s:s s:i}",
+                             "keys", array,
+                             "namespace", ns,
+                             "flags", flags))) {
+        free_ctx (ctx);
+        json_decref (array);
+        return NULL;
+    }
+    json_decref (array);
+    if (flux_future_aux_set (f, auxkey, ctx, (flux_free_f)free_ctx) < 0) {
+        free_ctx (ctx);
+        flux_future_destroy (f);
+        return NULL;
+    }
+    return f;
+nomem:
+    errno = ENOMEM;
+    return NULL;
+}
+
+/* A batch response names the key it refers to.  A key that could not
+ * be looked up is reported with an error number instead of a value.
+ * Keep ctx->key in sync with the current response.
+ */
+static int decode_batch_key (flux_future_t *f,
+                             struct lookup_ctx *ctx,
+                             bool *changed)
+{
+    const char *key;
+    int errnum = 0;
+
+    if (flux_rpc_get_unpack (f,
+                             "{s:s s?i}",
+                             "key", &key,
+                             "errno", &errnum) < 0)
+        return -1;
+    if (changed)
+        *changed = false;
+    if (strcmp (ctx->key, key) != 0) {
+        char *cpy;
+        if (!(cpy = strdup (key)))
+            return -1;
+        free (ctx->key);
+        ctx->key = cpy;
+        if (changed)
+            *changed = true;
+    }
+    if (errnum) {
+        errno = errnum;
+        return -1;
+    }
+    return 0;
+}
+
 static int decode_treeobj (flux_future_t *f, json_t **treeobj)
 {
     json_t *obj;
@@ -240,10 +342,15 @@ static struct lookup_ctx *get_lookup_ctx (flux_future_t *f)
 static int parse_response (flux_future_t *f, struct lookup_ctx *ctx)
 {
     json_t *treeobj2;
+    bool key_changed = false;
 
+    if (ctx->batch && decode_batch_key (f, ctx, &key_changed) < 0)
+        return -1;
     if (decode_treeobj (f, &treeobj2) < 0)
         return -1;
-    if (!ctx->treeobj || !json_equal (ctx->treeobj, treeobj2)) {
+    if (!ctx->treeobj
+        || key_changed
+        || !json_equal (ctx->treeobj, treeobj2)) {
         json_decref (ctx->treeobj);
         ctx->treeobj = json_incref (treeobj2);
         if (ctx->treeobj_str) {
@@ -411,6 +518,12 @@ const char *flux_kvs_lookup_get_key (flux_future_t *f)
 
     if (!(ctx = get_lookup_ctx (f)))
         return NULL;
+    if (ctx->batch) {
+        /* N.B. a key that failed lookup is still named in its response */
+        if (flux_rpc_get (f, NULL) < 0)
+            return NULL;
+        (void)decode_batch_key (f, ctx, NULL);
+    }
     return ctx->key;
 }
 
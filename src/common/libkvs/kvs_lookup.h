@@ -24,6 +24,18 @@ flux_future_t *flux_kvs_lookupat (flux_t *h,
                                   const char *key,
                                   const char *treeobj);
 
+/* Look up 'count' keys against one root snapshot of namespace 'ns'.
+ * One response per key is returned, in order.  Use the accessors below
+ * and flux_kvs_lookup_get_key() on each, then flux_future_reset() to
+ * advance.  The stream ends with an ENODATA error, which should be
+ * received before the future is destroyed.
+ */
+flux_future_t *flux_kvs_lookup_batch (flux_t *h,
+                                      const char *ns,
+                                      int flags,
+                                      const char **keys,
+                                      int count);
+
 int flux_kvs_lookup_get (flux_future_t *f, const char **value);
 int flux_kvs_lookup_get_unpack (flux_future_t *f, const char *fmt, ...);
 int flux_kvs_lookup_get_raw (flux_future_t *f, const void **data, size_t *len);
@@ -31,6 +31,16 @@ void errors (void)
     ok (flux_kvs_lookupat (NULL, 0, NULL, NULL) == NULL && errno == EINVAL,
         "flux_kvs_lookupat fails on bad input");
 
+    errno = 0;
+    ok (flux_kvs_lookup_batch (NULL, NULL, 0, NULL, 0) == NULL
+        && errno == EINVAL,
+        "flux_kvs_lookup_batch h=NULL fails with EINVAL");
+
+    errno = 0;
+    ok (flux_kvs_lookup_batch (NULL, NULL, 0, NULL, 1) == NULL
+        && errno == EINVAL,
+        "flux_kvs_lookup_batch keys=NULL count=1 fails with EINVAL");
+
     errno = 0;
     ok (flux_kvs_lookup_get (NULL, NULL) < 0 && errno == EINVAL,
         "flux_kvs_lookup_get fails on bad input");
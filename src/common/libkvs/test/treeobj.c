@@ -389,6 +389,124 @@ void test_dir (void)
     json_decref (dir);
 }
 
+void test_hdir (void)
+{
+    const char *blobref = "sha1-fbedb4eb241948f6f802bf47d95ec932e9d4deaf";
+    json_t *hdir, *shard, *dir, *dirref, *val;
+    json_t *large;
+    const char *name;
+    json_t *entry;
+    bool placed;
+    int index = 0;
+
+    val = treeobj_create_val ("foo", 4);
+    dir = treeobj_create_dir ();
+    dirref = treeobj_create_dirref (blobref);
+    if (!val || !dir || !dirref)
+        BAIL_OUT ("can't continue without test values");
+
+    ok ((hdir = treeobj_create_hdir ()) != NULL,
+        "treeobj_create_hdir works");
+    ok (treeobj_validate (hdir) == 0,
+        "treeobj_validate likes empty hdir");
+    ok (treeobj_is_hdir (hdir) && !treeobj_is_dir (hdir),
+        "treeobj_is_hdir returns true, treeobj_is_dir returns false");
+    ok (treeobj_get_count (hdir) == 0,
+        "treeobj_get_count returns 0");
+
+    ok (treeobj_hdir_index ("foo", 0) >= 0
+        && treeobj_hdir_index ("foo", 0) < TREEOBJ_HDIR_FANOUT
+        && treeobj_hdir_index ("foo", 0) == treeobj_hdir_index ("foo", 0),
+        "treeobj_hdir_index returns a stable index in range");
+    errno = 0;
+    ok (treeobj_hdir_index ("foo", TREEOBJ_HDIR_MAXLEVEL) < 0
+        && errno == EINVAL,
+        "treeobj_hdir_index fails with EINVAL on level out of range");
+    errno = 0;
+    ok (treeobj_hdir_index (NULL, 0) < 0 && errno == EINVAL,
+        "treeobj_hdir_index fails with EINVAL on NULL name");
+
+    ok (treeobj_insert_shard (hdir, 3, dir) == 0
+        && treeobj_insert_shard (hdir, 7, dirref) == 0
+        && treeobj_get_count (hdir) == 2,
+        "treeobj_insert_shard works");
+    ok (treeobj_get_shard (hdir, 3) == dir
+        && treeobj_peek_shard (hdir, 7) == dirref,
+        "treeobj_get_shard and treeobj_peek_shard work");
+    ok (treeobj_validate (hdir) == 0,
+        "treeobj_validate likes populated hdir");
+    errno = 0;
+    ok (treeobj_get_shard (hdir, 4) == NULL && errno == ENOENT,
+        "treeobj_get_shard fails with ENOENT on missing shard");
+    errno = 0;
+    ok (treeobj_get_shard (hdir, TREEOBJ_HDIR_FANOUT) == NULL
+        && errno == EINVAL,
+        "treeobj_get_shard fails with EINVAL on index out of range");
+    errno = 0;
+    ok (treeobj_get_shard (dir, 0) == NULL && errno == EINVAL,
+        "treeobj_get_shard fails with EINVAL on non-hdir treeobj");
+    errno = 0;
+    ok (treeobj_insert_shard (hdir, 1, val) < 0 && errno == EINVAL,
+        "treeobj_insert_shard fails with EINVAL on val shard");
+    errno = 0;
+    ok (treeobj_insert_shard (hdir, -1, dir) < 0 && errno == EINVAL,
+        "treeobj_insert_shard fails with EINVAL on negative index");
+    errno = 0;
+    ok (treeobj_insert_entry (hdir, "foo", val) < 0 && errno == EINVAL,
+        "treeobj_insert_entry fails with EINVAL on hdir");
+    json_decref (hdir);
+
+    errno = 0;
+    ok (treeobj_decode ("{\"ver\":1,\"type\":\"hdir\",\"data\":"
+                        "{\"32\":{\"ver\":1,\"type\":\"dir\",\"data\":{}}}}")
+            == NULL
+        && errno == EPROTO,
+        "treeobj_decode rejects hdir with shard index out of range");
+    errno = 0;
+    ok (treeobj_decode ("{\"ver\":1,\"type\":\"hdir\",\"data\":"
+                        "{\"0\":{\"ver\":1,\"type\":\"val\",\"data\":\"\"}}}")
+            == NULL
+        && errno == EPROTO,
+        "treeobj_decode rejects hdir with val shard");
+
+    if (!(large = create_large_dir ()))
+        BAIL_OUT ("could not create %d-entry dir", large_dir_entries);
+    ok ((hdir = treeobj_hdir_split (large, 1)) != NULL,
+        "treeobj_hdir_split works");
+    ok (treeobj_validate (hdir) == 0 && treeobj_is_hdir (hdir),
+        "treeobj_hdir_split returned a valid hdir");
+    placed = true;
+    json_object_foreach (treeobj_get_data (large), name, entry) {
+        index = treeobj_hdir_index (name, 1);
+        if (!(shard = treeobj_get_shard (hdir, index))
+            || treeobj_get_entry (shard, name) != entry) {
+            diag ("%s not found in shard %d", name, index);
+            placed = false;
+        }
+    }
+    ok (placed,
+        "every entry was placed in its shard");
+    ok ((shard = treeobj_copy (hdir)) != NULL
+        && treeobj_is_hdir (shard)
+        && json_equal (shard, hdir)
+        && treeobj_get_shard (shard, index) == treeobj_get_shard (hdir, index),
+        "treeobj_copy of hdir shares shards");
+    json_decref (shard);
+    errno = 0;
+    ok (treeobj_hdir_split (val, 0) == NULL && errno == EINVAL,
+        "treeobj_hdir_split fails with EINVAL on non-dir");
+    errno = 0;
+    ok (treeobj_hdir_split (large, TREEOBJ_HDIR_MAXLEVEL) == NULL
+        && errno == EINVAL,
+        "treeobj_hdir_split fails with EINVAL on level out of range");
+    json_decref (hdir);
+    json_decref (large);
+
+    json_decref (val);
+    json_decref (dir);
+    json_decref (dirref);
+}
+
 void test_dir_peek (void)
 {
     json_t *dir;
@@ -809,16 +927,18 @@ void test_corner_cases (void)
 
 void test_type_name (void)
 {
-    json_t *val, *valref, *dir, *dirref, *symlink, *notatreeobj;
+    json_t *val, *valref, *dir, *dirref, *hdir, *symlink, *notatreeobj;
     const char *s;
 
     val = treeobj_create_val ("a", 1);
     valref = treeobj_create_valref (NULL);
     dir = treeobj_create_dir ();
     dirref = treeobj_create_dirref (NULL);
+    hdir = treeobj_create_hdir ();
     symlink = treeobj_create_symlink (NULL, "some-string");
     notatreeobj = json_object ();
-    if (!val || !valref || !dir || !dirref || !symlink || !notatreeobj)
+    if (!val || !valref || !dir || !dirref || !hdir || !symlink
+        || !notatreeobj)
         BAIL_OUT ("can't continue without test value");
 
     s = treeobj_type_name (val);
@@ -829,6 +949,8 @@ void test_type_name (void)
     ok (streq (s, "dir"), "treeobj_type_name returns dir correctly");
     s = treeobj_type_name (dirref);
     ok (streq (s, "dirref"), "treeobj_type_name returns dirref correctly");
+    s = treeobj_type_name (hdir);
+    ok (streq (s, "hdir"), "treeobj_type_name returns hdir correctly");
     s = treeobj_type_name (symlink);
     ok (streq (s, "symlink"), "treeobj_type_name returns symlink correctly");
     s = treeobj_type_name (notatreeobj);
@@ -842,10 +964,158 @@ void test_type_name (void)
     json_decref (valref);
     json_decref (dir);
     json_decref (dirref);
+    json_decref (hdir);
     json_decref (symlink);
     json_decref (notatreeobj);
 }
 
+/* Check that treeobj_encode_update() of 'cpy', a modified copy of
+ * 'prevobj', matches treeobj_encode().
+ */
+bool encode_update_matches (const char *prev,
+                            const json_t *prevobj,
+                            const json_t *cpy)
+{
+    char *s1 = treeobj_encode_update (prev, strlen (prev), prevobj, cpy);
+    char *s2 = treeobj_encode (cpy);
+    bool match = s1 && s2 && streq (s1, s2);
+
+    if (!match)
+        diag ("update: %s\nencode: %s", s1 ? s1 : "NULL", s2 ? s2 : "NULL");
+    free (s1);
+    free (s2);
+    return match;
+}
+
+void test_encode_update (void)
+{
+    json_t *dir = create_large_dir ();
+    json_t *prevobj, *cpy, *val, *empty;
+    char *prev, *s;
+    json_t *ent;
+    char name[256];
+    int i;
+
+    if (!dir)
+        BAIL_OUT ("could not create %d-entry dir", large_dir_entries);
+    if (!(prev = treeobj_encode (dir))
+        || !(prevobj = treeobj_decode (prev)))
+        BAIL_OUT ("could not encode/decode large dir");
+    if (!(val = treeobj_create_val ("foo", 3)))
+        BAIL_OUT ("treeobj_create_val failed");
+
+    if (!(cpy = treeobj_copy (prevobj)))
+        BAIL_OUT ("treeobj_copy failed");
+    ok (encode_update_matches (prev, prevobj, cpy),
+        "treeobj_encode_update works on unmodified dir");
+
+    snprintf (name, sizeof (name), "entry-%.10d", 2500);
+    ok (treeobj_insert_entry (cpy, name, val) == 0
+        && encode_update_matches (prev, prevobj, cpy),
+        "treeobj_encode_update works with one changed entry");
+
+    ok (treeobj_insert_entry (cpy, "a", val) == 0
+        && treeobj_insert_entry (cpy, "entry-0000001234x", val) == 0
+        && treeobj_insert_entry (cpy, "entry-00000012345", val) == 0
+        && treeobj_insert_entry (cpy, "z", val) == 0
+        && encode_update_matches (prev, prevobj, cpy),
+        "treeobj_encode_update works with added entries");
+
+    snprintf (name, sizeof (name), "entry-%.10d", 0);
+    ok (treeobj_delete_entry (cpy, name) == 0
+        && treeobj_delete_entry (cpy, "a") == 0
+        && encode_update_matches (prev, prevobj, cpy),
+        "treeobj_encode_update works with removed entries");
+
+    ok (treeobj_insert_entry (cpy, "quote\"d", val) == 0
+        && treeobj_insert_entry (cpy, "tést", val) == 0
+        && encode_update_matches (prev, prevobj, cpy),
+        "treeobj_encode_update works with added names that need escaping");
+
+    if (!(ent = treeobj_create_dir ()))
+        BAIL_OUT ("treeobj_create_dir failed");
+    ok (treeobj_insert_entry (ent, "x", val) == 0
+        && treeobj_insert_entry (cpy, "entry-0000000007", ent) == 0
+        && encode_update_matches (prev, prevobj, cpy),
+        "treeobj_encode_update works with nested dir entry");
+    json_decref (ent);
+
+    for (i = 0; i < large_dir_entries; i++) {
+        snprintf (name, sizeof (name), "entry-%.10d", i);
+        (void)treeobj_delete_entry (cpy, name);
+    }
+    ok (encode_update_matches (prev, prevobj, cpy),
+        "treeobj_encode_update works with most entries removed");
+    json_decref (cpy);
+
+    if (!(empty = treeobj_create_dir ()))
+        BAIL_OUT ("treeobj_create_dir failed");
+    ok (encode_update_matches (prev, prevobj, empty),
+        "treeobj_encode_update works with all entries removed");
+    free (prev);
+    json_decref (prevobj);
+    if (!(prev = treeobj_encode (empty))
+        || !(prevobj = treeobj_decode (prev)))
+        BAIL_OUT ("could not encode/decode empty dir");
+    ok (encode_update_matches (prev, prevobj, dir),
+        "treeobj_encode_update works on empty previous dir");
+    json_decref (empty);
+    free (prev);
+    json_decref (prevobj);
+
+    /* previous dir with a key that is escaped, or not canonical */
+    if (!(cpy = treeobj_create_dir ())
+        || treeobj_insert_entry (cpy, "b\"c", val) < 0
+        || !(prev = treeobj_encode (cpy))
+        || !(prevobj = treeobj_decode (prev)))
+        BAIL_OUT ("could not create dir with escaped key");
+    errno = 0;
+    ok (treeobj_encode_update (prev, strlen (prev), prevobj, prevobj) == NULL
+        && errno == EINVAL,
+        "treeobj_encode_update fails with EINVAL on escaped key");
+    free (prev);
+    json_decref (prevobj);
+    json_decref (cpy);
+
+    if (!(cpy = treeobj_create_dir ())
+        || treeobj_insert_entry (cpy, "b", val) < 0
+        || !(prev = json_dumps (cpy, JSON_INDENT (1)|JSON_SORT_KEYS))
+        || !(prevobj = treeobj_decode (prev)))
+        BAIL_OUT ("could not create indented dir");
+    errno = 0;
+    ok (treeobj_encode_update (prev, strlen (prev), prevobj, prevobj) == NULL
+        && errno == EINVAL,
+        "treeobj_encode_update fails with EINVAL on non-compact encoding");
+    free (prev);
+    json_decref (prevobj);
+    json_decref (cpy);
+
+    if (!(cpy = treeobj_create_dir ())
+        || treeobj_insert_entry (cpy, "b", val) < 0
+        || treeobj_insert_entry (cpy, "a", val) < 0
+        || !(prev = json_dumps (cpy, JSON_COMPACT))
+        || !(prevobj = treeobj_decode (prev)))
+        BAIL_OUT ("could not create unsorted dir");
+    errno = 0;
+    s = treeobj_encode_update (prev, strlen (prev), prevobj, prevobj);
+    ok (s == NULL && errno == EINVAL,
+        "treeobj_encode_update fails with EINVAL on unsorted keys");
+    free (s);
+    free (prev);
+    json_decref (prevobj);
+    json_decref (cpy);
+
+    errno = 0;
+    ok (treeobj_encode_update (NULL, 0, dir, dir) == NULL && errno == EINVAL,
+        "treeobj_encode_update fails with EINVAL on NULL input");
+    errno = 0;
+    ok (treeobj_encode_update ("{}", 2, val, val) == NULL && errno == EINVAL,
+        "treeobj_encode_update fails with EINVAL on non-dir");
+
+    json_decref (val);
+    json_decref (dir);
+}
+
 int main(int argc, char** argv)
 {
     plan (NO_PLAN);
@@ -855,6 +1125,7 @@ int main(int argc, char** argv)
     test_dirref ();
     test_dir ();
     test_dir_peek ();
+    test_hdir ();
     test_copy ();
     test_deep_copy ();
     test_symlink ();
@@ -862,6 +1133,7 @@ int main(int argc, char** argv)
     test_type_name ();
 
     test_codec ();
+    test_encode_update ();
 
     done_testing();
 }
@@ -15,6 +15,9 @@
 #endif
 #include <errno.h>
 #include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
 #include <assert.h>
 #include <stdbool.h>
 #include <jansson.h>
@@ -27,6 +30,25 @@
 
 static const int treeobj_version = 1;
 
+/* Parse hdir shard key, e.g. "17".
+ * Return index on success, -1 on failure.
+ */
+static int hdir_key_to_index (const char *key)
+{
+    char *endptr;
+    long index;
+
+    errno = 0;
+    index = strtol (key, &endptr, 10);
+    if (errno != 0
+        || endptr == key
+        || *endptr != '\0'
+        || index < 0
+        || index >= TREEOBJ_HDIR_FANOUT)
+        return -1;
+    return index;
+}
+
 static int treeobj_unpack (json_t *obj, const char **typep, json_t **datap)
 {
     json_t *data;
@@ -109,6 +131,21 @@ int treeobj_validate (const json_t *obj)
                 goto inval;
         }
     }
+    else if (streq (type, "hdir")) {
+        const char *key;
+        if (!json_is_object (data))
+            goto inval;
+        json_object_foreach ((json_t *)data, key, o) {
+            const char *t;
+            if (hdir_key_to_index (key) < 0
+                || !(t = treeobj_get_type (o))
+                || (!streq (t, "dir")
+                    && !streq (t, "dirref")
+                    && !streq (t, "hdir"))
+                || treeobj_validate (o) < 0)
+                goto inval;
+        }
+    }
     else if (streq (type, "symlink")) {
         json_t *o;
         if (!json_is_object (data))
@@ -174,6 +211,12 @@ bool treeobj_is_dirref (const json_t *obj)
     return type && streq (type, "dirref");
 }
 
+bool treeobj_is_hdir (const json_t *obj)
+{
+    const char *type = treeobj_get_type (obj);
+    return type && streq (type, "hdir");
+}
+
 json_t *treeobj_get_data (json_t *obj)
 {
     json_t *data;
@@ -268,7 +311,7 @@ int treeobj_get_count (const json_t *obj)
     if (streq (type, "valref") || streq (type, "dirref")) {
         count = json_array_size (data);
     }
-    else if (streq (type, "dir")) {
+    else if (streq (type, "dir") || streq (type, "hdir")) {
         count = json_object_size (data);
     }
     else if (streq (type, "symlink") || streq (type, "val")) {
@@ -387,10 +430,11 @@ json_t *treeobj_copy (json_t *obj)
         return NULL;
     }
     /* shallow copy of treeobj data and deep copy of treeobj is
-     * identical except for dir object.
+     * identical except for dir and hdir objects.
      */
-    if (treeobj_is_dir (obj)) {
-        if (!(cpy = treeobj_create_dir ()))
+    if (treeobj_is_dir (obj) || treeobj_is_hdir (obj)) {
+        if (!(cpy = treeobj_is_dir (obj) ? treeobj_create_dir ()
+                                          : treeobj_create_hdir ()))
             return NULL;
 
         if (!(datacpy = json_copy (data))) {
@@ -419,6 +463,122 @@ json_t *treeobj_deep_copy (const json_t *obj)
     return json_deep_copy (obj);
 }
 
+/* 32-bit FNV-1a, so that shard placement does not depend on the
+ * content store hash type.
+ */
+static uint32_t hdir_hash (const char *name)
+{
+    uint32_t hash = 2166136261U;
+
+    while (*name) {
+        hash ^= (uint8_t)*name++;
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+int treeobj_hdir_index (const char *name, int level)
+{
+    if (!name || level < 0 || level >= TREEOBJ_HDIR_MAXLEVEL) {
+        errno = EINVAL;
+        return -1;
+    }
+    return (hdir_hash (name) >> (level * TREEOBJ_HDIR_BITS))
+           & (TREEOBJ_HDIR_FANOUT - 1);
+}
+
+json_t *treeobj_get_shard (json_t *obj, int index)
+{
+    const char *type;
+    json_t *data, *obj2;
+    char key[16];
+
+    if (treeobj_unpack (obj, &type, &data) < 0
+        || !streq (type, "hdir")
+        || index < 0
+        || index >= TREEOBJ_HDIR_FANOUT) {
+        errno = EINVAL;
+        return NULL;
+    }
+    snprintf (key, sizeof (key), "%d", index);
+    if (!(obj2 = json_object_get (data, key))) {
+        errno = ENOENT;
+        return NULL;
+    }
+    return obj2;
+}
+
+const json_t *treeobj_peek_shard (const json_t *obj, int index)
+{
+    /* N.B. it should be safe to cast away const on 'obj' as long as
+     * the returned shard is not modified.
+     */
+    return treeobj_get_shard ((json_t *)obj, index);
+}
+
+int treeobj_insert_shard (json_t *obj, int index, json_t *obj2)
+{
+    const char *type;
+    json_t *data;
+    char key[16];
+
+    if (!obj2
+        || treeobj_unpack (obj, &type, &data) < 0
+        || !streq (type, "hdir")
+        || index < 0
+        || index >= TREEOBJ_HDIR_FANOUT
+        || (!treeobj_is_dir (obj2)
+            && !treeobj_is_dirref (obj2)
+            && !treeobj_is_hdir (obj2))) {
+        errno = EINVAL;
+        return -1;
+    }
+    snprintf (key, sizeof (key), "%d", index);
+    if (json_object_set (data, key, obj2) < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+json_t *treeobj_hdir_split (json_t *dir, int level)
+{
+    json_t *data;
+    json_t *hdir;
+    json_t *shards[TREEOBJ_HDIR_FANOUT] = { NULL };
+    const char *name;
+    json_t *entry;
+    int saved_errno;
+
+    if (!(data = treeobj_get_data (dir))
+        || !treeobj_is_dir (dir)
+        || level < 0
+        || level >= TREEOBJ_HDIR_MAXLEVEL) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(hdir = treeobj_create_hdir ()))
+        return NULL;
+    json_object_foreach (data, name, entry) {
+        int index = treeobj_hdir_index (name, level);
+
+        if (!shards[index]) {
+            if (!(shards[index] = treeobj_create_dir ())
+                || treeobj_insert_shard (hdir, index, shards[index]) < 0)
+                goto error;
+            json_decref (shards[index]); // hdir holds the reference
+        }
+        if (treeobj_insert_entry_novalidate (shards[index], name, entry) < 0)
+            goto error;
+    }
+    return hdir;
+error:
+    saved_errno = errno;
+    json_decref (hdir);
+    errno = saved_errno;
+    return NULL;
+}
+
 int treeobj_append_blobref (json_t *obj, const char *blobref)
 {
     const char *type;
@@ -480,6 +640,20 @@ json_t *treeobj_create_dir (void)
     return obj;
 }
 
+json_t *treeobj_create_hdir (void)
+{
+    json_t *obj;
+
+    if (!(obj = json_pack ("{s:i s:s s:{}}",
+                           "ver", treeobj_version,
+                           "type", "hdir",
+                           "data"))) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return obj;
+}
+
 json_t *treeobj_create_symlink (const char *ns, const char *target)
 {
     json_t *data, *obj;
@@ -648,6 +822,267 @@ char *treeobj_encode (const json_t *obj)
     return json_dumps (obj, JSON_COMPACT|JSON_SORT_KEYS);
 }
 
+struct encbuf {
+    char *data;
+    size_t len;
+    size_t size;
+};
+
+static int encbuf_append (struct encbuf *b, const char *s, size_t len)
+{
+    if (b->len + len + 1 > b->size) {
+        size_t size = b->size ? b->size : 256;
+        char *data;
+
+        while (b->len + len + 1 > size)
+            size *= 2;
+        if (!(data = realloc (b->data, size)))
+            return -1;
+        b->data = data;
+        b->size = size;
+    }
+    memcpy (b->data + b->len, s, len);
+    b->len += len;
+    b->data[b->len] = '\0';
+    return 0;
+}
+
+/* Skip the JSON value at 'p', which must be in compact form.
+ * Return a pointer to the character following it, or NULL if the
+ * value is malformed or not compact.
+ */
+static const char *skip_value (const char *p, const char *end)
+{
+    int depth = 0;
+
+    while (p < end) {
+        switch (*p) {
+            case '"':
+                for (p++; p < end && *p != '"'; p++) {
+                    if (*p == '\\')
+                        p++;
+                }
+                if (p >= end)
+                    return NULL;
+                p++;
+                break;
+            case '{':
+            case '[':
+                depth++;
+                p++;
+                break;
+            case '}':
+            case ']':
+                if (depth == 0)
+                    return p;
+                depth--;
+                p++;
+                break;
+            case ',':
+                if (depth == 0)
+                    return p;
+                p++;
+                break;
+            case ' ':
+            case '\t':
+            case '\n':
+            case '\r':
+                return NULL;
+            default:
+                p++;
+                break;
+        }
+        if (depth == 0 && p < end && (*p == ',' || *p == '}' || *p == ']'))
+            return p;
+    }
+    return NULL;
+}
+
+/* Compare entry 'name' to the unescaped key of 'len' bytes at 'key'
+ * in the same order as JSON_SORT_KEYS.
+ */
+static int keycmp (const char *name, const char *key, size_t len)
+{
+    int rc = strncmp (name, key, len);
+
+    if (rc == 0 && name[len] != '\0')
+        rc = 1;
+    return rc;
+}
+
+static int strcmp_ptr (const void *a, const void *b)
+{
+    return strcmp (*(const char **)a, *(const char **)b);
+}
+
+/* Append the encoding of entry 'name' of 'data' to 'b', if present.
+ */
+static int encode_entry (struct encbuf *b,
+                         const json_t *data,
+                         const char *name,
+                         bool *first)
+{
+    json_t *val;
+    json_t *key = NULL;
+    char *s = NULL;
+    int rc = -1;
+
+    if (!(val = json_object_get (data, name)))
+        return 0;
+    if (!*first && encbuf_append (b, ",", 1) < 0)
+        return -1;
+    if (!(key = json_string (name))
+        || !(s = json_dumps (key, JSON_COMPACT|JSON_ENCODE_ANY))
+        || encbuf_append (b, s, strlen (s)) < 0
+        || encbuf_append (b, ":", 1) < 0)
+        goto done;
+    free (s);
+    if (!(s = json_dumps (val, JSON_COMPACT|JSON_SORT_KEYS|JSON_ENCODE_ANY))
+        || encbuf_append (b, s, strlen (s)) < 0)
+        goto done;
+    *first = false;
+    rc = 0;
+done:
+    free (s);
+    json_decref (key);
+    return rc;
+}
+
+char *treeobj_encode_update (const char *prev,
+                             size_t prevlen,
+                             const json_t *prevobj,
+                             const json_t *obj)
+{
+    const char head[] = "{\"data\":{";
+    char tail[64];
+    const char *p = prev;
+    const char *end = prev + prevlen;
+    const char *lastkey = NULL;
+    size_t lastlen = 0;
+    json_t *prevdata;
+    json_t *data;
+    const char **names = NULL;
+    size_t count = 0;
+    size_t i = 0;
+    size_t added = 0;
+    const char *name;
+    json_t *val;
+    struct encbuf b = { 0 };
+    bool first = true;
+    int saved_errno;
+
+    if (!prev
+        || !treeobj_is_dir (prevobj)
+        || !treeobj_is_dir (obj)
+        || !(prevdata = treeobj_get_data ((json_t *)prevobj))
+        || !(data = treeobj_get_data ((json_t *)obj))) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    /* Entries of 'obj' that are the same object as in 'prevobj' are
+     * unchanged, and are copied from 'prev' below.  Collect the names
+     * of the others, and of entries that were removed, in sort order.
+     */
+    if (!(names = malloc ((json_object_size (data)
+                           + json_object_size (prevdata)
+                           + 1) * sizeof (names[0]))))
+        goto error;
+    json_object_foreach ((json_t *)data, name, val) {
+        json_t *prevval = json_object_get (prevdata, name);
+        if (prevval != val) {
+            names[count++] = name;
+            if (!prevval)
+                added++;
+        }
+    }
+    if (json_object_size (prevdata) + added > json_object_size (data)) {
+        json_object_foreach (prevdata, name, val) {
+            if (!json_object_get (data, name))
+                names[count++] = name;
+        }
+    }
+    qsort (names, count, sizeof (names[0]), strcmp_ptr);
+
+    /* 'prev' must have been encoded by treeobj_encode(), so that copying
+     * the unchanged entries yields the same result.
+     */
+    snprintf (tail,
+              sizeof (tail),
+              ",\"type\":\"dir\",\"ver\":%d}",
+              treeobj_version);
+    if (prevlen < strlen (head) || strncmp (prev, head, strlen (head)) != 0)
+        goto inval;
+    if (encbuf_append (&b, head, strlen (head)) < 0)
+        goto error;
+    p += strlen (head);
+    while (p < end && *p != '}') {
+        const char *entry;
+        const char *key;
+        size_t keylen;
+
+        if (lastkey) {
+            if (*p != ',')
+                goto inval;
+            p++;
+        }
+        entry = p;
+        if (p >= end || *p++ != '"')
+            goto inval;
+        key = p;
+        while (p < end && *p != '"' && *p != '\\')
+            p++;
+        if (p >= end || *p != '"') // escaped keys are not handled
+            goto inval;
+        keylen = p++ - key;
+        if (lastkey) {
+            int rc = memcmp (lastkey, key, keylen < lastlen ? keylen : lastlen);
+            if (rc > 0 || (rc == 0 && lastlen >= keylen))
+                goto inval;
+        }
+        lastkey = key;
+        lastlen = keylen;
+        if (p >= end || *p++ != ':' || !(p = skip_value (p, end)))
+            goto inval;
+
+        while (i < count && keycmp (names[i], key, keylen) < 0) {
+            if (encode_entry (&b, data, names[i++], &first) < 0)
+                goto error;
+        }
+        if (i < count && keycmp (names[i], key, keylen) == 0) {
+            if (encode_entry (&b, data, names[i++], &first) < 0)
+                goto error;
+        }
+        else {
+            if ((!first && encbuf_append (&b, ",", 1) < 0)
+                || encbuf_append (&b, entry, p - entry) < 0)
+                goto error;
+            first = false;
+        }
+    }
+    if (p >= end || end - p - 1 != strlen (tail) || strncmp (p + 1,
+                                                            tail,
+                                                            strlen (tail)) != 0)
+        goto inval;
+    while (i < count) {
+        if (encode_entry (&b, data, names[i++], &first) < 0)
+            goto error;
+    }
+    if (encbuf_append (&b, "}", 1) < 0
+        || encbuf_append (&b, tail, strlen (tail)) < 0)
+        goto error;
+    free (names);
+    return b.data;
+inval:
+    errno = EINVAL;
+error:
+    saved_errno = errno;
+    free (names);
+    free (b.data);
+    errno = saved_errno;
+    return NULL;
+}
+
 const char *treeobj_type_name (const json_t *obj)
 {
     if (treeobj_is_symlink (obj))
@@ -660,6 +1095,8 @@ const char *treeobj_type_name (const json_t *obj)
         return "dir";
     else if (treeobj_is_dirref (obj))
         return "dirref";
+    else if (treeobj_is_hdir (obj))
+        return "hdir";
     return "unknown";
 }
 
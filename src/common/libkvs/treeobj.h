@@ -28,6 +28,7 @@ json_t *treeobj_create_val (const void *data, size_t len);
 json_t *treeobj_create_valref (const char *blobref);
 json_t *treeobj_create_dir (void);
 json_t *treeobj_create_dirref (const char *blobref);
+json_t *treeobj_create_hdir (void);
 
 /* Validate treeobj, recursively.
  * Return 0 if valid, -1 with errno = EINVAL if invalid.
@@ -45,10 +46,12 @@ bool treeobj_is_val (const json_t *obj);
 bool treeobj_is_valref (const json_t *obj);
 bool treeobj_is_dir (const json_t *obj);
 bool treeobj_is_dirref (const json_t *obj);
+bool treeobj_is_hdir (const json_t *obj);
 
 /* get type-specific value.
  * For dirref/valref, this is an array of blobrefs.
  * For directory, this is dictionary of treeobjs
+ * For hdir, this is a dictionary of shard index to treeobj
  * For symlink, this is an object with optinoal namespace and target.
  * For val this is string containing base64-encoded data.
  * Return JSON object on success, NULL on error with errno = EINVAL.
@@ -72,6 +75,7 @@ int treeobj_decode_val (const json_t *obj, void **data, size_t *len);
 /* get type-specific count.
  * For dirref/valref, this is the number of blobrefs.
  * For directory, this is number of entries
+ * For hdir, this is the number of shards
  * For symlink or val, this is 1.
  * Return count on success, -1 on error with errno = EINVAL.
  */
@@ -111,6 +115,37 @@ json_t *treeobj_copy (json_t *obj);
 /* Deep copy a treeobj */
 json_t *treeobj_deep_copy (const json_t *obj);
 
+/* Hashed directories.
+ * An hdir splits a large directory into up to TREEOBJ_HDIR_FANOUT shards,
+ * so that a lookup or update only touches the shard holding the entry.
+ * Each shard is a dir, a dirref, or another hdir one level down.
+ * Entry 'name' of an hdir at 'level' (0 for the top hdir of a directory)
+ * lives in shard treeobj_hdir_index (name, level).
+ */
+#define TREEOBJ_HDIR_BITS       5
+#define TREEOBJ_HDIR_FANOUT     (1 << TREEOBJ_HDIR_BITS)
+#define TREEOBJ_HDIR_MAXLEVEL   (32 / TREEOBJ_HDIR_BITS)
+
+/* Return shard index of 'name' at 'level', or -1 with errno = EINVAL.
+ */
+int treeobj_hdir_index (const char *name, int level);
+
+/* get/add shard of an hdir.
+ * Get returns JSON object (owned by 'obj', do not destroy), NULL on error
+ * with errno = ENOENT if the shard does not exist.
+ * insert takes a reference on 'obj2' (caller retains ownership), which
+ * must be a dir, dirref, or hdir.
+ */
+json_t *treeobj_get_shard (json_t *obj, int index);
+const json_t *treeobj_peek_shard (const json_t *obj, int index);
+int treeobj_insert_shard (json_t *obj, int index, json_t *obj2);
+
+/* Distribute the entries of 'dir' over the shards of a new hdir at
+ * 'level'.  The shards are dir objects and share entries with 'dir'.
+ * Return hdir on success, NULL on failure with errno set.
+ */
+json_t *treeobj_hdir_split (json_t *dir, int level);
+
 /* add blobref to dirref,valref object.
  * Return 0 on success, -1 on failure with errno set.
  */
@@ -138,9 +173,22 @@ json_t *treeobj_decode (const char *buf);
 json_t *treeobj_decodeb (const char *buf, size_t buflen);
 char *treeobj_encode (const json_t *obj);
 
+/* Encode dir 'obj' like treeobj_encode(), given 'prev', the encoding
+ * of 'prevobj' by treeobj_encode().  Entries of 'obj' that are the same
+ * json_t as the entry of the same name in 'prevobj' are copied from 'prev'
+ * rather than encoded again, so an update to a few entries of a large
+ * dir is cheap.  Returns NULL with errno = EINVAL if 'prev' was not
+ * encoded by treeobj_encode() or has keys with escaped characters.
+ * The return value must be destroyed with free().
+ */
+char *treeobj_encode_update (const char *prev,
+                             size_t prevlen,
+                             const json_t *prevobj,
+                             const json_t *obj);
+
 /* Get treeobj type name
- * Returns "symlink", "val", "valref", "dir", "dirref" or NULL if
- * invalid treeobj.
+ * Returns "symlink", "val", "valref", "dir", "dirref", "hdir" or NULL
+ * if invalid treeobj.
  */
 const char *treeobj_type_name (const json_t *obj);
 
@@ -20,6 +20,7 @@
 
 #include "router.h"
 #include "subhash.h"
+#include "subtrie.h"
 #include "servhash.h"
 #include "disconnect.h"
 
@@ -29,6 +30,7 @@ struct router_entry {
     void *arg;
     struct router *rtr;
     struct subhash *subscriptions;  // client's subscriber hash
+    struct subtrie_peer *subpeer;   // client's subscriptions in rtr->subtrie
     struct disconnect *dcon;
 };
 
@@ -37,6 +39,7 @@ struct router {
     zhashx_t *routes;               // uuid => 'struct router_entry'
     void *arg;
     struct subhash *subscriptions;  // router's subscriber hash
+    struct subtrie *subtrie;        // all clients' subscriptions, for matching
     struct servhash *services;
     flux_msg_handler_t **handlers;
     bool mute;
@@ -103,6 +106,10 @@ static void local_sub_request (struct router_entry *entry, flux_msg_t *msg)
         goto error;
     if (subhash_subscribe (entry->subscriptions, topic) < 0)
         goto error;
+    if (subtrie_subscribe (entry->rtr->subtrie, entry->subpeer, topic) < 0) {
+        ERRNO_SAFE_WRAP (subhash_unsubscribe, entry->subscriptions, topic);
+        goto error;
+    }
     router_entry_respond (entry, msg, 0);
     return;
 error:
@@ -119,6 +126,7 @@ static void local_unsub_request (struct router_entry *entry, flux_msg_t *msg)
         goto error;
     if (subhash_unsubscribe (entry->subscriptions, topic) < 0)
         goto error;
+    (void)subtrie_unsubscribe (entry->rtr->subtrie, entry->subpeer, topic);
     router_entry_respond (entry, msg, 0);
     return;
 error:
@@ -266,6 +274,8 @@ static void router_entry_destroy (struct router_entry *entry)
         struct router *rtr = entry->rtr;
 
         disconnect_destroy (entry->dcon);
+        if (entry->subpeer)
+            subtrie_peer_remove (rtr->subtrie, entry->subpeer);
         servhash_disconnect (rtr->services, entry->uuid);
         subhash_destroy (entry->subscriptions);
         ERRNO_SAFE_WRAP (free, entry->uuid);
@@ -328,6 +338,11 @@ struct router_entry *router_entry_add (struct router *rtr,
         return NULL;
     }
     entry->rtr = rtr;
+    if (!(entry->subpeer = subtrie_peer_add (rtr->subtrie, entry))) {
+        zhashx_delete (rtr->routes, uuid);
+        errno = ENOMEM;
+        return NULL;
+    }
     return entry;
 }
 
@@ -398,6 +413,19 @@ error:
     return;
 }
 
+// subtrie_match_f footprint
+static void event_send (void *peer_arg, void *arg)
+{
+    struct router_entry *entry = peer_arg;
+    const flux_msg_t *msg = arg;
+
+    if (entry->send (msg, entry->arg) < 0) {
+        flux_log_error (entry->rtr->h,
+                        "router: event > client=%.5s",
+                        entry->uuid);
+    }
+}
+
 /* Receive event from broker.
  * Distribute to all router entries with matching subscriptions.
  */
@@ -407,22 +435,13 @@ static void event_cb (flux_t *h,
                       void *arg)
 {
     struct router *rtr = arg;
-    struct router_entry *entry;
     const char *topic;
 
     if (flux_msg_get_topic (msg, &topic) < 0) {
         flux_log_error (h, "router: event > client");
         return;
     }
-
-    entry = zhashx_first (rtr->routes);
-    while ((entry)) {
-        if (subhash_topic_match (entry->subscriptions, topic)) {
-            if (entry->send (msg, entry->arg) < 0)
-                flux_log_error (h, "router: event > client=%.5s", entry->uuid);
-        }
-        entry = zhashx_next (rtr->routes);
-    }
+    (void)subtrie_match (rtr->subtrie, topic, event_send, (void *)msg);
 }
 
 static const struct flux_msg_handler_spec htab[] = {
@@ -448,6 +467,9 @@ struct router *router_create (flux_t *h)
         goto error;
     zhashx_set_destructor (rtr->routes, router_entry_destructor);
 
+    if (!(rtr->subtrie = subtrie_create ()))
+        goto error;
+
     if (!(rtr->subscriptions = subhash_create ()))
         goto error;
     subhash_set_subscribe (rtr->subscriptions, broker_subscribe, rtr);
@@ -472,6 +494,7 @@ void router_destroy (struct router *rtr)
         subhash_destroy (rtr->subscriptions);
         servhash_destroy (rtr->services);
         ERRNO_SAFE_WRAP (zhashx_destroy, &rtr->routes);
+        subtrie_destroy (rtr->subtrie);
         ERRNO_SAFE_WRAP (free, rtr);
     }
 }
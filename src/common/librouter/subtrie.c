@@ -0,0 +1,317 @@
+/************************************************************\
+ * Copyright 2026 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* subtrie.c - match event topics against the subscriptions of many peers
+ *
+ * Subscription topics of all peers are stored in one trie keyed by topic
+ * character, with each node listing the peers subscribed to the topic
+ * spelled by the path to it.  Since a subscription matches any topic it is
+ * a prefix of, subtrie_match() finds every interested peer by walking the
+ * trie once along the event topic, at a cost proportional to the topic
+ * length plus the number of matches.  Calling subhash_topic_match() on
+ * each peer instead costs the total number of subscriptions of all peers.
+ *
+ * A peer with several matching subscriptions (e.g. "" and "job-state")
+ * is reported once, by stamping it with a per-match generation number.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <errno.h>
+#include <flux/core.h>
+
+#include "src/common/libutil/errno_safe.h"
+#include "ccan/list/list.h"
+
+#include "subtrie.h"
+
+struct subtrie_node {
+    struct subtrie_node *parent;
+    struct subtrie_node *child;     // first child
+    struct subtrie_node *next;      // next sibling
+    struct list_head refs;          // peers subscribed to this node's topic
+    char c;
+};
+
+struct subtrie_peer {
+    void *arg;
+    unsigned int gen;               // last match that reported this peer
+    struct list_head refs;          // this peer's subscriptions
+    struct list_node link;          // in st->peers
+};
+
+/* A subscription of 'peer' to the topic of 'node'.
+ */
+struct subtrie_ref {
+    struct subtrie_peer *peer;
+    struct subtrie_node *node;
+    int refcount;
+    struct list_node node_link;     // in node->refs
+    struct list_node peer_link;     // in peer->refs
+};
+
+struct subtrie {
+    struct subtrie_node root;       // topic ""
+    struct list_head peers;
+    unsigned int gen;
+};
+
+static struct subtrie_node *node_child (struct subtrie_node *node, char c)
+{
+    struct subtrie_node *child;
+
+    for (child = node->child; child != NULL; child = child->next) {
+        if (child->c == c)
+            return child;
+    }
+    return NULL;
+}
+
+static struct subtrie_node *node_child_create (struct subtrie_node *node,
+                                               char c)
+{
+    struct subtrie_node *child;
+
+    if (!(child = calloc (1, sizeof (*child))))
+        return NULL;
+    child->c = c;
+    list_head_init (&child->refs);
+    child->parent = node;
+    child->next = node->child;
+    node->child = child;
+    return child;
+}
+
+/* Free 'node' and its ancestors for as long as they have no subscriptions
+ * and no children.
+ */
+static void node_prune (struct subtrie_node *node)
+{
+    while (node->parent
+           && list_empty (&node->refs)
+           && node->child == NULL) {
+        struct subtrie_node *parent = node->parent;
+        struct subtrie_node **np = &parent->child;
+
+        while (*np != node)
+            np = &(*np)->next;
+        *np = node->next;
+        free (node);
+        node = parent;
+    }
+}
+
+static struct subtrie_node *node_lookup (struct subtrie *st,
+                                         const char *topic,
+                                         bool create)
+{
+    struct subtrie_node *node = &st->root;
+    struct subtrie_node *child;
+    const char *cp;
+
+    for (cp = topic; *cp != '\0'; cp++) {
+        if (!(child = node_child (node, *cp))) {
+            if (!create) {
+                errno = ENOENT;
+                return NULL;
+            }
+            if (!(child = node_child_create (node, *cp))) {
+                node_prune (node);
+                return NULL;
+            }
+        }
+        node = child;
+    }
+    return node;
+}
+
+static struct subtrie_ref *peer_ref_find (struct subtrie_peer *peer,
+                                          struct subtrie_node *node)
+{
+    struct subtrie_ref *ref;
+
+    list_for_each (&peer->refs, ref, peer_link) {
+        if (ref->node == node)
+            return ref;
+    }
+    return NULL;
+}
+
+static void ref_destroy (struct subtrie_ref *ref)
+{
+    struct subtrie_node *node = ref->node;
+
+    list_del (&ref->node_link);
+    list_del (&ref->peer_link);
+    free (ref);
+    node_prune (node);
+}
+
+int subtrie_subscribe (struct subtrie *st,
+                       struct subtrie_peer *peer,
+                       const char *topic)
+{
+    struct subtrie_node *node;
+    struct subtrie_ref *ref;
+
+    if (!st || !peer || !topic) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(node = node_lookup (st, topic, true)))
+        return -1;
+    if ((ref = peer_ref_find (peer, node))) {
+        ref->refcount++;
+        return 0;
+    }
+    if (!(ref = calloc (1, sizeof (*ref)))) {
+        node_prune (node);
+        return -1;
+    }
+    ref->peer = peer;
+    ref->node = node;
+    ref->refcount = 1;
+    list_add_tail (&node->refs, &ref->node_link);
+    list_add_tail (&peer->refs, &ref->peer_link);
+    return 0;
+}
+
+int subtrie_unsubscribe (struct subtrie *st,
+                         struct subtrie_peer *peer,
+                         const char *topic)
+{
+    struct subtrie_node *node;
+    struct subtrie_ref *ref;
+
+    if (!st || !peer || !topic) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(node = node_lookup (st, topic, false)))
+        return -1;
+    if (!(ref = peer_ref_find (peer, node))) {
+        errno = ENOENT;
+        return -1;
+    }
+    if (--ref->refcount == 0)
+        ref_destroy (ref);
+    return 0;
+}
+
+static int node_match (struct subtrie *st,
+                       struct subtrie_node *node,
+                       subtrie_match_f cb,
+                       void *arg)
+{
+    struct subtrie_ref *ref;
+    int count = 0;
+
+    list_for_each (&node->refs, ref, node_link) {
+        if (ref->peer->gen != st->gen) {
+            ref->peer->gen = st->gen;
+            if (cb)
+                cb (ref->peer->arg, arg);
+            count++;
+        }
+    }
+    return count;
+}
+
+int subtrie_match (struct subtrie *st,
+                   const char *topic,
+                   subtrie_match_f cb,
+                   void *arg)
+{
+    struct subtrie_node *node;
+    const char *cp;
+    int count;
+
+    if (!st || !topic) {
+        errno = EINVAL;
+        return -1;
+    }
+    /* On wraparound, reset peer stamps so none appears already reported.
+     */
+    if (++st->gen == 0) {
+        struct subtrie_peer *peer;
+
+        list_for_each (&st->peers, peer, link)
+            peer->gen = 0;
+        st->gen = 1;
+    }
+    node = &st->root;
+    count = node_match (st, node, cb, arg);
+    for (cp = topic; *cp != '\0'; cp++) {
+        if (!(node = node_child (node, *cp)))
+            break;
+        count += node_match (st, node, cb, arg);
+    }
+    return count;
+}
+
+struct subtrie_peer *subtrie_peer_add (struct subtrie *st, void *peer_arg)
+{
+    struct subtrie_peer *peer;
+
+    if (!st) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(peer = calloc (1, sizeof (*peer))))
+        return NULL;
+    peer->arg = peer_arg;
+    list_head_init (&peer->refs);
+    list_add_tail (&st->peers, &peer->link);
+    return peer;
+}
+
+void subtrie_peer_remove (struct subtrie *st, struct subtrie_peer *peer)
+{
+    if (st && peer) {
+        int saved_errno = errno;
+        struct subtrie_ref *ref;
+
+        while ((ref = list_top (&peer->refs, struct subtrie_ref, peer_link)))
+            ref_destroy (ref);
+        list_del (&peer->link);
+        free (peer);
+        errno = saved_errno;
+    }
+}
+
+void subtrie_destroy (struct subtrie *st)
+{
+    if (st) {
+        int saved_errno = errno;
+        struct subtrie_peer *peer;
+
+        while ((peer = list_top (&st->peers, struct subtrie_peer, link)))
+            subtrie_peer_remove (st, peer);
+        free (st);
+        errno = saved_errno;
+    }
+}
+
+struct subtrie *subtrie_create (void)
+{
+    struct subtrie *st;
+
+    if (!(st = calloc (1, sizeof (*st))))
+        return NULL;
+    list_head_init (&st->root.refs);
+    list_head_init (&st->peers);
+    return st;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
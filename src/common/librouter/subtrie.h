@@ -0,0 +1,51 @@
+/************************************************************\
+ * Copyright 2026 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _ROUTER_SUBTRIE_H
+#define _ROUTER_SUBTRIE_H
+
+/* Called once for each peer with a subscription matching a topic.
+ * 'peer_arg' is the argument passed to subtrie_peer_add().
+ */
+typedef void (*subtrie_match_f)(void *peer_arg, void *arg);
+
+struct subtrie *subtrie_create (void);
+void subtrie_destroy (struct subtrie *st);
+
+/* Register a peer (e.g. a client or module) that may subscribe to topics.
+ * Removing a peer drops all of its subscriptions.
+ */
+struct subtrie_peer *subtrie_peer_add (struct subtrie *st, void *peer_arg);
+void subtrie_peer_remove (struct subtrie *st, struct subtrie_peer *peer);
+
+/* Subscriptions are reference counted per peer and topic.
+ * Unsubscribing from a topic the peer is not subscribed to fails with ENOENT.
+ */
+int subtrie_subscribe (struct subtrie *st,
+                       struct subtrie_peer *peer,
+                       const char *topic);
+int subtrie_unsubscribe (struct subtrie *st,
+                         struct subtrie_peer *peer,
+                         const char *topic);
+
+/* Call 'cb' once for each peer holding a subscription that is a prefix
+ * of 'topic', as in subhash_topic_match().  Return the number of peers.
+ * 'cb' must not modify the subtrie.
+ */
+int subtrie_match (struct subtrie *st,
+                   const char *topic,
+                   subtrie_match_f cb,
+                   void *arg);
+
+#endif /* !_ROUTER_SUBTRIE_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
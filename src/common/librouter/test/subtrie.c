@@ -0,0 +1,227 @@
+/************************************************************\
+ * Copyright 2026 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <errno.h>
+#include <flux/core.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/librouter/subtrie.h"
+
+#define NPEERS 3
+
+struct peer {
+    struct subtrie_peer *sp;
+    int hits;
+};
+
+static void hit_cb (void *peer_arg, void *arg)
+{
+    struct peer *peer = peer_arg;
+    int *calls = arg;
+
+    peer->hits++;
+    (*calls)++;
+}
+
+/* Match 'topic' and return a bitmask of the peers that were called back.
+ * Fail the test if any peer is called more than once.
+ */
+static int match (struct subtrie *st, struct peer *peers, const char *topic)
+{
+    int calls = 0;
+    int count;
+    int mask = 0;
+
+    for (int i = 0; i < NPEERS; i++)
+        peers[i].hits = 0;
+    count = subtrie_match (st, topic, hit_cb, &calls);
+    for (int i = 0; i < NPEERS; i++) {
+        if (peers[i].hits > 1)
+            diag ("peer %d called %d times for %s", i, peers[i].hits, topic);
+        if (peers[i].hits > 0)
+            mask |= 1 << i;
+    }
+    if (count != calls)
+        diag ("subtrie_match returned %d but made %d calls", count, calls);
+    return mask;
+}
+
+void test_match (void)
+{
+    struct subtrie *st;
+    struct peer peers[NPEERS];
+
+    st = subtrie_create ();
+    ok (st != NULL,
+        "subtrie_create works");
+    for (int i = 0; i < NPEERS; i++) {
+        if (!(peers[i].sp = subtrie_peer_add (st, &peers[i])))
+            BAIL_OUT ("subtrie_peer_add failed");
+    }
+
+    ok (match (st, peers, "foo") == 0,
+        "foo matches no peers with no subscriptions");
+
+    ok (subtrie_subscribe (st, peers[0].sp, "foo") == 0
+        && subtrie_subscribe (st, peers[1].sp, "foo.bar") == 0
+        && subtrie_subscribe (st, peers[2].sp, "baz") == 0,
+        "subscribed peer0=foo peer1=foo.bar peer2=baz");
+
+    ok (match (st, peers, "foo") == 0x1,
+        "foo matches peer0");
+    ok (match (st, peers, "foo.bar") == 0x3,
+        "foo.bar matches peer0 and peer1");
+    ok (match (st, peers, "foo.bar.baz") == 0x3,
+        "foo.bar.baz matches peer0 and peer1");
+    ok (match (st, peers, "foobar") == 0x1,
+        "foobar matches peer0");
+    ok (match (st, peers, "fo") == 0,
+        "fo matches no peers");
+    ok (match (st, peers, "baz") == 0x4,
+        "baz matches peer2");
+    ok (match (st, peers, "") == 0,
+        "empty topic matches no peers");
+
+    ok (subtrie_subscribe (st, peers[2].sp, "") == 0,
+        "subscribed peer2 to all topics");
+    ok (match (st, peers, "foo.bar") == 0x7,
+        "foo.bar matches all peers");
+    ok (match (st, peers, "baz") == 0x4,
+        "baz matches peer2 once despite two matching subscriptions");
+    ok (subtrie_unsubscribe (st, peers[2].sp, "") == 0,
+        "unsubscribed peer2 from all topics");
+    ok (match (st, peers, "foo") == 0x1,
+        "foo matches peer0");
+
+    ok (subtrie_subscribe (st, peers[1].sp, "fo") == 0,
+        "subscribed peer1 to fo");
+    ok (match (st, peers, "foo") == 0x3,
+        "foo matches peer0 and peer1");
+    ok (subtrie_unsubscribe (st, peers[1].sp, "fo") == 0,
+        "unsubscribed peer1 from fo");
+    ok (match (st, peers, "foo") == 0x1
+        && match (st, peers, "foo.bar") == 0x3,
+        "interior subscription removed without affecting descendants");
+
+    subtrie_peer_remove (st, peers[0].sp);
+    ok (match (st, peers, "foo.bar") == 0x2,
+        "foo.bar matches peer1 after peer0 is removed");
+
+    subtrie_destroy (st);
+}
+
+void test_refcount (void)
+{
+    struct subtrie *st;
+    struct peer peers[NPEERS];
+
+    if (!(st = subtrie_create ()))
+        BAIL_OUT ("subtrie_create failed");
+    for (int i = 0; i < NPEERS; i++) {
+        if (!(peers[i].sp = subtrie_peer_add (st, &peers[i])))
+            BAIL_OUT ("subtrie_peer_add failed");
+    }
+
+    ok (subtrie_subscribe (st, peers[0].sp, "foo") == 0
+        && subtrie_subscribe (st, peers[0].sp, "foo") == 0,
+        "subscribed peer0 to foo twice");
+    ok (subtrie_subscribe (st, peers[1].sp, "foo") == 0,
+        "subscribed peer1 to foo");
+
+    ok (subtrie_unsubscribe (st, peers[0].sp, "foo") == 0,
+        "unsubscribed peer0 from foo");
+    ok (match (st, peers, "foo") == 0x3,
+        "foo still matches peer0 and peer1");
+    ok (subtrie_unsubscribe (st, peers[0].sp, "foo") == 0,
+        "unsubscribed peer0 from foo again");
+    ok (match (st, peers, "foo") == 0x2,
+        "foo matches peer1");
+
+    errno = 0;
+    ok (subtrie_unsubscribe (st, peers[0].sp, "foo") < 0 && errno == ENOENT,
+        "unsubscribing peer0 from foo a third time fails with ENOENT");
+    errno = 0;
+    ok (subtrie_unsubscribe (st, peers[1].sp, "bar") < 0 && errno == ENOENT,
+        "unsubscribing from unknown topic fails with ENOENT");
+
+    ok (subtrie_unsubscribe (st, peers[1].sp, "foo") == 0,
+        "unsubscribed peer1 from foo");
+    ok (match (st, peers, "foo") == 0,
+        "foo matches no peers");
+
+    /* leave some subscriptions behind for subtrie_destroy() to clean up */
+    ok (subtrie_subscribe (st, peers[2].sp, "a.b.c") == 0
+        && subtrie_subscribe (st, peers[2].sp, "a.b") == 0,
+        "subscribed peer2 to a.b.c and a.b");
+
+    subtrie_destroy (st);
+}
+
+void test_inval (void)
+{
+    struct subtrie *st;
+    struct subtrie_peer *sp;
+
+    if (!(st = subtrie_create ()))
+        BAIL_OUT ("subtrie_create failed");
+    if (!(sp = subtrie_peer_add (st, NULL)))
+        BAIL_OUT ("subtrie_peer_add failed");
+
+    errno = 0;
+    ok (subtrie_peer_add (NULL, NULL) == NULL && errno == EINVAL,
+        "subtrie_peer_add st=NULL fails with EINVAL");
+    errno = 0;
+    ok (subtrie_subscribe (NULL, sp, "foo") < 0 && errno == EINVAL,
+        "subtrie_subscribe st=NULL fails with EINVAL");
+    errno = 0;
+    ok (subtrie_subscribe (st, NULL, "foo") < 0 && errno == EINVAL,
+        "subtrie_subscribe peer=NULL fails with EINVAL");
+    errno = 0;
+    ok (subtrie_subscribe (st, sp, NULL) < 0 && errno == EINVAL,
+        "subtrie_subscribe topic=NULL fails with EINVAL");
+    errno = 0;
+    ok (subtrie_unsubscribe (st, sp, NULL) < 0 && errno == EINVAL,
+        "subtrie_unsubscribe topic=NULL fails with EINVAL");
+    errno = 0;
+    ok (subtrie_match (NULL, "foo", NULL, NULL) < 0 && errno == EINVAL,
+        "subtrie_match st=NULL fails with EINVAL");
+    errno = 0;
+    ok (subtrie_match (st, NULL, NULL, NULL) < 0 && errno == EINVAL,
+        "subtrie_match topic=NULL fails with EINVAL");
+
+    ok (subtrie_subscribe (st, sp, "foo") == 0
+        && subtrie_match (st, "foo", NULL, NULL) == 1,
+        "subtrie_match cb=NULL counts matching peers");
+
+    lives_ok ({subtrie_peer_remove (st, NULL);},
+        "subtrie_peer_remove peer=NULL doesn't crash");
+    lives_ok ({subtrie_destroy (NULL);},
+        "subtrie_destroy st=NULL doesn't crash");
+
+    subtrie_destroy (st);
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_match ();
+    test_refcount ();
+    test_inval ();
+
+    done_testing ();
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
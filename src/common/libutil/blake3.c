@@ -0,0 +1,774 @@
+/************************************************************\
+ * Copyright 2026 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* blake3.c - BLAKE3 hash function
+ *
+ * This follows the structure of the BLAKE3 team's reference C
+ * implementation (CC0/Apache-2.0).  Input is split into 1K chunks which
+ * form the leaves of a binary tree.  When a large buffer is passed to
+ * blake3_update(), whole subtrees are hashed at once, and the chunks and
+ * parent nodes at each level of a subtree are compressed in parallel by the
+ * selected hash_many kernel.  Chunks that straddle blake3_update() calls
+ * and the final root node are compressed one block at a time by the
+ * portable code below.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <pthread.h>
+#include <errno.h>
+#include <assert.h>
+
+#include "ccan/str/str.h"
+
+#include "blake3_impl.h"
+
+struct blake3_impl {
+    const char *name;
+    size_t degree;
+    blake3_hash_many_f hash_many;
+    bool (*supported)(void);
+};
+
+static bool portable_supported (void)
+{
+    return true;
+}
+
+#ifdef BLAKE3_X86
+static bool sse41_supported (void)
+{
+    __builtin_cpu_init ();
+    return __builtin_cpu_supports ("sse4.1");
+}
+
+static bool avx2_supported (void)
+{
+    __builtin_cpu_init ();
+    return __builtin_cpu_supports ("avx2") && sse41_supported ();
+}
+
+static bool avx512_supported (void)
+{
+    __builtin_cpu_init ();
+    return __builtin_cpu_supports ("avx512f") && avx2_supported ();
+}
+#endif
+
+/* Ordered from most to least preferred.
+ */
+static const struct blake3_impl impltab[] = {
+#ifdef BLAKE3_X86
+    { "avx512", 16, blake3_hash_many_avx512, avx512_supported },
+    { "avx2", 8, blake3_hash_many_avx2, avx2_supported },
+    { "sse41", 4, blake3_hash_many_sse41, sse41_supported },
+#endif
+    { "portable", 1, blake3_hash_many_portable, portable_supported },
+};
+
+static const struct blake3_impl *impl;
+static pthread_once_t impl_once = PTHREAD_ONCE_INIT;
+
+static void impl_select (void)
+{
+    for (int i = 0; i < sizeof (impltab) / sizeof (impltab[0]); i++) {
+        if (impltab[i].supported ()) {
+            impl = &impltab[i];
+            break;
+        }
+    }
+}
+
+static const struct blake3_impl *get_impl (void)
+{
+    pthread_once (&impl_once, impl_select);
+    return impl;
+}
+
+const char *blake3_get_impl (void)
+{
+    return get_impl ()->name;
+}
+
+int blake3_set_impl (const char *name)
+{
+    (void)get_impl ();
+    for (int i = 0; i < sizeof (impltab) / sizeof (impltab[0]); i++) {
+        if (streq (impltab[i].name, name) && impltab[i].supported ()) {
+            impl = &impltab[i];
+            return 0;
+        }
+    }
+    errno = ENOENT;
+    return -1;
+}
+
+/* Portable compression function
+ */
+
+static inline uint32_t rotr32 (uint32_t w, uint32_t c)
+{
+    return (w >> c) | (w << (32 - c));
+}
+
+static inline void g (uint32_t *state,
+                      size_t a,
+                      size_t b,
+                      size_t c,
+                      size_t d,
+                      uint32_t x,
+                      uint32_t y)
+{
+    state[a] = state[a] + state[b] + x;
+    state[d] = rotr32 (state[d] ^ state[a], 16);
+    state[c] = state[c] + state[d];
+    state[b] = rotr32 (state[b] ^ state[c], 12);
+    state[a] = state[a] + state[b] + y;
+    state[d] = rotr32 (state[d] ^ state[a], 8);
+    state[c] = state[c] + state[d];
+    state[b] = rotr32 (state[b] ^ state[c], 7);
+}
+
+static inline void round_fn (uint32_t state[16], const uint32_t *msg, size_t r)
+{
+    const uint8_t *s = blake3_msg_schedule[r];
+
+    g (state, 0, 4, 8, 12, msg[s[0]], msg[s[1]]);
+    g (state, 1, 5, 9, 13, msg[s[2]], msg[s[3]]);
+    g (state, 2, 6, 10, 14, msg[s[4]], msg[s[5]]);
+    g (state, 3, 7, 11, 15, msg[s[6]], msg[s[7]]);
+    g (state, 0, 5, 10, 15, msg[s[8]], msg[s[9]]);
+    g (state, 1, 6, 11, 12, msg[s[10]], msg[s[11]]);
+    g (state, 2, 7, 8, 13, msg[s[12]], msg[s[13]]);
+    g (state, 3, 4, 9, 14, msg[s[14]], msg[s[15]]);
+}
+
+void blake3_compress_in_place_portable (uint32_t cv[8],
+                                        const uint8_t block[BLAKE3_BLOCK_LEN],
+                                        uint8_t block_len,
+                                        uint64_t counter,
+                                        uint8_t flags)
+{
+    uint32_t msg[16];
+    uint32_t state[16];
+
+    for (int i = 0; i < 16; i++)
+        msg[i] = blake3_load32 (block + 4 * i);
+    for (int i = 0; i < 8; i++)
+        state[i] = cv[i];
+    for (int i = 0; i < 4; i++)
+        state[8 + i] = blake3_iv[i];
+    state[12] = blake3_counter_low (counter);
+    state[13] = blake3_counter_high (counter);
+    state[14] = block_len;
+    state[15] = flags;
+
+    for (int r = 0; r < 7; r++)
+        round_fn (state, msg, r);
+
+    for (int i = 0; i < 8; i++)
+        cv[i] = state[i] ^ state[i + 8];
+}
+
+static void store_cv_words (uint8_t out[BLAKE3_OUT_LEN], const uint32_t cv[8])
+{
+    for (int i = 0; i < 8; i++)
+        blake3_store32 (out + 4 * i, cv[i]);
+}
+
+static void hash_one_portable (const uint8_t *input,
+                               size_t blocks,
+                               const uint32_t key[8],
+                               uint64_t counter,
+                               uint8_t flags,
+                               uint8_t flags_start,
+                               uint8_t flags_end,
+                               uint8_t out[BLAKE3_OUT_LEN])
+{
+    uint32_t cv[8];
+    uint8_t block_flags = flags | flags_start;
+
+    memcpy (cv, key, BLAKE3_OUT_LEN);
+    while (blocks > 0) {
+        if (blocks == 1)
+            block_flags |= flags_end;
+        blake3_compress_in_place_portable (cv,
+                                           input,
+                                           BLAKE3_BLOCK_LEN,
+                                           counter,
+                                           block_flags);
+        input += BLAKE3_BLOCK_LEN;
+        blocks--;
+        block_flags = flags;
+    }
+    store_cv_words (out, cv);
+}
+
+void blake3_hash_many_portable (const uint8_t *const *inputs,
+                                size_t num_inputs,
+                                size_t blocks,
+                                const uint32_t key[8],
+                                uint64_t counter,
+                                bool increment_counter,
+                                uint8_t flags,
+                                uint8_t flags_start,
+                                uint8_t flags_end,
+                                uint8_t *out)
+{
+    while (num_inputs > 0) {
+        hash_one_portable (inputs[0],
+                           blocks,
+                           key,
+                           counter,
+                           flags,
+                           flags_start,
+                           flags_end,
+                           out);
+        if (increment_counter)
+            counter++;
+        inputs++;
+        num_inputs--;
+        out += BLAKE3_OUT_LEN;
+    }
+}
+
+/* Chunk state
+ */
+
+struct output {
+    uint32_t input_cv[8];
+    uint64_t counter;
+    uint8_t block[BLAKE3_BLOCK_LEN];
+    uint8_t block_len;
+    uint8_t flags;
+};
+
+static void chunk_state_init (struct blake3_chunk_state *self,
+                              const uint32_t key[8],
+                              uint8_t flags)
+{
+    memcpy (self->cv, key, BLAKE3_OUT_LEN);
+    self->chunk_counter = 0;
+    memset (self->buf, 0, BLAKE3_BLOCK_LEN);
+    self->buf_len = 0;
+    self->blocks_compressed = 0;
+    self->flags = flags;
+}
+
+static void chunk_state_reset (struct blake3_chunk_state *self,
+                               const uint32_t key[8],
+                               uint64_t chunk_counter)
+{
+    memcpy (self->cv, key, BLAKE3_OUT_LEN);
+    self->chunk_counter = chunk_counter;
+    self->blocks_compressed = 0;
+    memset (self->buf, 0, BLAKE3_BLOCK_LEN);
+    self->buf_len = 0;
+}
+
+static size_t chunk_state_len (const struct blake3_chunk_state *self)
+{
+    return BLAKE3_BLOCK_LEN * (size_t)self->blocks_compressed
+           + (size_t)self->buf_len;
+}
+
+static size_t chunk_state_fill_buf (struct blake3_chunk_state *self,
+                                    const uint8_t *input,
+                                    size_t input_len)
+{
+    size_t take = BLAKE3_BLOCK_LEN - (size_t)self->buf_len;
+
+    if (take > input_len)
+        take = input_len;
+    memcpy (self->buf + self->buf_len, input, take);
+    self->buf_len += (uint8_t)take;
+    return take;
+}
+
+static uint8_t chunk_state_maybe_start_flag (const struct blake3_chunk_state *self)
+{
+    return self->blocks_compressed == 0 ? CHUNK_START : 0;
+}
+
+static void chunk_state_update (struct blake3_chunk_state *self,
+                                const uint8_t *input,
+                                size_t input_len)
+{
+    if (self->buf_len > 0) {
+        size_t take = chunk_state_fill_buf (self, input, input_len);
+        input += take;
+        input_len -= take;
+        if (input_len > 0) {
+            blake3_compress_in_place_portable (
+                                self->cv,
+                                self->buf,
+                                BLAKE3_BLOCK_LEN,
+                                self->chunk_counter,
+                                self->flags
+                                | chunk_state_maybe_start_flag (self));
+            self->blocks_compressed++;
+            self->buf_len = 0;
+            memset (self->buf, 0, BLAKE3_BLOCK_LEN);
+        }
+    }
+    while (input_len > BLAKE3_BLOCK_LEN) {
+        blake3_compress_in_place_portable (
+                                self->cv,
+                                input,
+                                BLAKE3_BLOCK_LEN,
+                                self->chunk_counter,
+                                self->flags
+                                | chunk_state_maybe_start_flag (self));
+        self->blocks_compressed++;
+        input += BLAKE3_BLOCK_LEN;
+        input_len -= BLAKE3_BLOCK_LEN;
+    }
+    (void)chunk_state_fill_buf (self, input, input_len);
+}
+
+static struct output make_output (const uint32_t input_cv[8],
+                                  const uint8_t block[BLAKE3_BLOCK_LEN],
+                                  uint8_t block_len,
+                                  uint64_t counter,
+                                  uint8_t flags)
+{
+    struct output ret;
+
+    memcpy (ret.input_cv, input_cv, BLAKE3_OUT_LEN);
+    memcpy (ret.block, block, BLAKE3_BLOCK_LEN);
+    ret.block_len = block_len;
+    ret.counter = counter;
+    ret.flags = flags;
+    return ret;
+}
+
+static struct output chunk_state_output (const struct blake3_chunk_state *self)
+{
+    uint8_t block_flags = self->flags
+                          | chunk_state_maybe_start_flag (self)
+                          | CHUNK_END;
+    return make_output (self->cv,
+                        self->buf,
+                        self->buf_len,
+                        self->chunk_counter,
+                        block_flags);
+}
+
+static struct output parent_output (const uint8_t block[BLAKE3_BLOCK_LEN],
+                                    const uint32_t key[8],
+                                    uint8_t flags)
+{
+    return make_output (key, block, BLAKE3_BLOCK_LEN, 0, flags | PARENT);
+}
+
+static void output_chaining_value (const struct output *self,
+                                   uint8_t cv[BLAKE3_OUT_LEN])
+{
+    uint32_t cv_words[8];
+
+    memcpy (cv_words, self->input_cv, BLAKE3_OUT_LEN);
+    blake3_compress_in_place_portable (cv_words,
+                                       self->block,
+                                       self->block_len,
+                                       self->counter,
+                                       self->flags);
+    store_cv_words (cv, cv_words);
+}
+
+static void output_root_bytes (const struct output *self,
+                               uint8_t out[BLAKE3_OUT_LEN])
+{
+    uint32_t cv_words[8];
+
+    memcpy (cv_words, self->input_cv, BLAKE3_OUT_LEN);
+    blake3_compress_in_place_portable (cv_words,
+                                       self->block,
+                                       self->block_len,
+                                       0,
+                                       self->flags | ROOT);
+    store_cv_words (out, cv_words);
+}
+
+/* Subtree hashing
+ */
+
+static unsigned int highest_one (uint64_t x)
+{
+    return 63 ^ (unsigned int)__builtin_clzll (x);
+}
+
+static uint64_t round_down_to_power_of_2 (uint64_t x)
+{
+    return 1ULL << highest_one (x | 1);
+}
+
+/* Given some input larger than one chunk, return the number of bytes that
+ * should go in the left subtree.  This is the largest power-of-2 number of
+ * chunks that leaves at least 1 byte for the right subtree.
+ */
+static size_t left_len (size_t content_len)
+{
+    size_t full_chunks = (content_len - 1) / BLAKE3_CHUNK_LEN;
+    return round_down_to_power_of_2 (full_chunks) * BLAKE3_CHUNK_LEN;
+}
+
+/* Compress up to 'degree' chunks in parallel.  The last chunk may be
+ * partial.  Returns the number of chaining values written to 'out'.
+ */
+static size_t compress_chunks_parallel (const struct blake3_impl *im,
+                                        const uint8_t *input,
+                                        size_t input_len,
+                                        const uint32_t key[8],
+                                        uint64_t chunk_counter,
+                                        uint8_t flags,
+                                        uint8_t *out)
+{
+    const uint8_t *chunks_array[BLAKE3_MAX_SIMD_DEGREE];
+    size_t input_position = 0;
+    size_t chunks_array_len = 0;
+
+    assert (0 < input_len && input_len <= im->degree * BLAKE3_CHUNK_LEN);
+
+    while (input_len - input_position >= BLAKE3_CHUNK_LEN) {
+        chunks_array[chunks_array_len++] = input + input_position;
+        input_position += BLAKE3_CHUNK_LEN;
+    }
+    im->hash_many (chunks_array,
+                   chunks_array_len,
+                   BLAKE3_CHUNK_LEN / BLAKE3_BLOCK_LEN,
+                   key,
+                   chunk_counter,
+                   true,
+                   flags,
+                   CHUNK_START,
+                   CHUNK_END,
+                   out);
+    if (input_len > input_position) {
+        struct blake3_chunk_state chunk_state;
+        struct output output;
+
+        chunk_state_init (&chunk_state, key, flags);
+        chunk_state.chunk_counter = chunk_counter + chunks_array_len;
+        chunk_state_update (&chunk_state,
+                            input + input_position,
+                            input_len - input_position);
+        output = chunk_state_output (&chunk_state);
+        output_chaining_value (&output,
+                               out + chunks_array_len * BLAKE3_OUT_LEN);
+        return chunks_array_len + 1;
+    }
+    return chunks_array_len;
+}
+
+/* Compress pairs of chaining values into parent nodes in parallel.
+ * An odd chaining value at the end is copied through.
+ * Returns the number of chaining values written to 'out'.
+ */
+static size_t compress_parents_parallel (const struct blake3_impl *im,
+                                         const uint8_t *child_chaining_values,
+                                         size_t num_chaining_values,
+                                         const uint32_t key[8],
+                                         uint8_t flags,
+                                         uint8_t *out)
+{
+    const uint8_t *parents_array[BLAKE3_MAX_SIMD_DEGREE];
+    size_t parents_array_len = 0;
+
+    assert (2 <= num_chaining_values);
+    assert (num_chaining_values <= 2 * BLAKE3_MAX_SIMD_DEGREE);
+
+    while (num_chaining_values - (2 * parents_array_len) >= 2) {
+        parents_array[parents_array_len] = child_chaining_values
+                                           + 2 * parents_array_len
+                                           * BLAKE3_OUT_LEN;
+        parents_array_len++;
+    }
+    im->hash_many (parents_array,
+                   parents_array_len,
+                   1,
+                   key,
+                   0,
+                   false,
+                   flags | PARENT,
+                   0,
+                   0,
+                   out);
+    if (num_chaining_values > 2 * parents_array_len) {
+        memcpy (out + parents_array_len * BLAKE3_OUT_LEN,
+                child_chaining_values + 2 * parents_array_len * BLAKE3_OUT_LEN,
+                BLAKE3_OUT_LEN);
+        return parents_array_len + 1;
+    }
+    return parents_array_len;
+}
+
+/* Hash a subtree, stopping when at most 'degree' (or 2) chaining values
+ * remain, so that the caller can combine them with other subtrees in
+ * parallel.  Returns the number of chaining values written to 'out'.
+ */
+static size_t compress_subtree_wide (const struct blake3_impl *im,
+                                     const uint8_t *input,
+                                     size_t input_len,
+                                     const uint32_t key[8],
+                                     uint64_t chunk_counter,
+                                     uint8_t flags,
+                                     uint8_t *out)
+{
+    uint8_t cv_array[2 * BLAKE3_MAX_SIMD_DEGREE * BLAKE3_OUT_LEN];
+    size_t left_input_len;
+    size_t degree = im->degree;
+    size_t left_n;
+    size_t right_n;
+    uint8_t *right_cvs;
+
+    if (input_len <= im->degree * BLAKE3_CHUNK_LEN) {
+        return compress_chunks_parallel (im,
+                                         input,
+                                         input_len,
+                                         key,
+                                         chunk_counter,
+                                         flags,
+                                         out);
+    }
+    left_input_len = left_len (input_len);
+
+    /* With the portable kernel, the left subtree must still return at
+     * least two chaining values, or the tree would never shrink.
+     */
+    if (left_input_len > BLAKE3_CHUNK_LEN && degree == 1)
+        degree = 2;
+    right_cvs = cv_array + degree * BLAKE3_OUT_LEN;
+
+    left_n = compress_subtree_wide (im,
+                                    input,
+                                    left_input_len,
+                                    key,
+                                    chunk_counter,
+                                    flags,
+                                    cv_array);
+    right_n = compress_subtree_wide (im,
+                                     input + left_input_len,
+                                     input_len - left_input_len,
+                                     key,
+                                     chunk_counter
+                                     + left_input_len / BLAKE3_CHUNK_LEN,
+                                     flags,
+                                     right_cvs);
+    /* The only time left_n is 1 is with the portable kernel and both
+     * sides one chunk.  Return the two chaining values as they are.
+     */
+    if (left_n == 1) {
+        memcpy (out, cv_array, 2 * BLAKE3_OUT_LEN);
+        return 2;
+    }
+    return compress_parents_parallel (im,
+                                      cv_array,
+                                      left_n + right_n,
+                                      key,
+                                      flags,
+                                      out);
+}
+
+/* Hash a subtree of more than one chunk down to the two chaining values
+ * of its root node.
+ */
+static void compress_subtree_to_parent_node (const struct blake3_impl *im,
+                                             const uint8_t *input,
+                                             size_t input_len,
+                                             const uint32_t key[8],
+                                             uint64_t chunk_counter,
+                                             uint8_t flags,
+                                             uint8_t out[2 * BLAKE3_OUT_LEN])
+{
+    uint8_t cv_array[BLAKE3_MAX_SIMD_DEGREE * BLAKE3_OUT_LEN];
+    uint8_t out_array[BLAKE3_MAX_SIMD_DEGREE * BLAKE3_OUT_LEN / 2];
+    size_t num_cvs;
+
+    assert (input_len > BLAKE3_CHUNK_LEN);
+
+    num_cvs = compress_subtree_wide (im,
+                                     input,
+                                     input_len,
+                                     key,
+                                     chunk_counter,
+                                     flags,
+                                     cv_array);
+    while (num_cvs > 2) {
+        num_cvs = compress_parents_parallel (im,
+                                             cv_array,
+                                             num_cvs,
+                                             key,
+                                             flags,
+                                             out_array);
+        memcpy (cv_array, out_array, num_cvs * BLAKE3_OUT_LEN);
+    }
+    memcpy (out, cv_array, 2 * BLAKE3_OUT_LEN);
+}
+
+/* Hasher
+ */
+
+void blake3_init (BLAKE3_CTX *ctx)
+{
+    memcpy (ctx->key, blake3_iv, BLAKE3_OUT_LEN);
+    chunk_state_init (&ctx->chunk, ctx->key, 0);
+    ctx->cv_stack_len = 0;
+}
+
+/* Merge completed subtrees on the chaining value stack.  After 'total_len'
+ * chunks, the stack holds one entry per 1 bit in 'total_len'.
+ * N.B. merging is deferred until more input arrives, so that the last
+ * node is not merged before it is known whether it is the root.
+ */
+static void merge_cv_stack (BLAKE3_CTX *ctx, uint64_t total_len)
+{
+    size_t post_merge_stack_len = (size_t)__builtin_popcountll (total_len);
+
+    while (ctx->cv_stack_len > post_merge_stack_len) {
+        uint8_t *parent_node = ctx->cv_stack
+                               + (ctx->cv_stack_len - 2) * BLAKE3_OUT_LEN;
+        struct output output = parent_output (parent_node,
+                                              ctx->key,
+                                              ctx->chunk.flags);
+        output_chaining_value (&output, parent_node);
+        ctx->cv_stack_len--;
+    }
+}
+
+static void push_cv (BLAKE3_CTX *ctx,
+                     uint8_t new_cv[BLAKE3_OUT_LEN],
+                     uint64_t chunk_counter)
+{
+    merge_cv_stack (ctx, chunk_counter);
+    memcpy (ctx->cv_stack + ctx->cv_stack_len * BLAKE3_OUT_LEN,
+            new_cv,
+            BLAKE3_OUT_LEN);
+    ctx->cv_stack_len++;
+}
+
+void blake3_update (BLAKE3_CTX *ctx, const void *data, size_t len)
+{
+    const struct blake3_impl *im = get_impl ();
+    const uint8_t *input = data;
+
+    if (len == 0)
+        return;
+
+    /* Finish a partial chunk left by a previous call.
+     */
+    if (chunk_state_len (&ctx->chunk) > 0) {
+        size_t take = BLAKE3_CHUNK_LEN - chunk_state_len (&ctx->chunk);
+        if (take > len)
+            take = len;
+        chunk_state_update (&ctx->chunk, input, take);
+        input += take;
+        len -= take;
+        if (len == 0)
+            return;
+        struct output output = chunk_state_output (&ctx->chunk);
+        uint8_t chunk_cv[BLAKE3_OUT_LEN];
+        output_chaining_value (&output, chunk_cv);
+        push_cv (ctx, chunk_cv, ctx->chunk.chunk_counter);
+        chunk_state_reset (&ctx->chunk,
+                           ctx->key,
+                           ctx->chunk.chunk_counter + 1);
+    }
+
+    /* Hash the largest whole subtrees possible.  A subtree must be aligned
+     * to its size within the input, and at least one byte is held back for
+     * the chunk state, since the last chunk might be the root.
+     */
+    while (len > BLAKE3_CHUNK_LEN) {
+        uint64_t subtree_len = round_down_to_power_of_2 (len);
+        uint64_t count_so_far = ctx->chunk.chunk_counter * BLAKE3_CHUNK_LEN;
+        uint64_t subtree_chunks;
+
+        while (((subtree_len - 1) & count_so_far) != 0)
+            subtree_len /= 2;
+        subtree_chunks = subtree_len / BLAKE3_CHUNK_LEN;
+        if (subtree_len <= BLAKE3_CHUNK_LEN) {
+            struct blake3_chunk_state chunk_state;
+            struct output output;
+            uint8_t cv[BLAKE3_OUT_LEN];
+
+            chunk_state_init (&chunk_state, ctx->key, ctx->chunk.flags);
+            chunk_state.chunk_counter = ctx->chunk.chunk_counter;
+            chunk_state_update (&chunk_state, input, (size_t)subtree_len);
+            output = chunk_state_output (&chunk_state);
+            output_chaining_value (&output, cv);
+            push_cv (ctx, cv, chunk_state.chunk_counter);
+        }
+        else {
+            uint8_t cv_pair[2 * BLAKE3_OUT_LEN];
+
+            compress_subtree_to_parent_node (im,
+                                             input,
+                                             (size_t)subtree_len,
+                                             ctx->key,
+                                             ctx->chunk.chunk_counter,
+                                             ctx->chunk.flags,
+                                             cv_pair);
+            push_cv (ctx, cv_pair, ctx->chunk.chunk_counter);
+            push_cv (ctx,
+                     cv_pair + BLAKE3_OUT_LEN,
+                     ctx->chunk.chunk_counter + subtree_chunks / 2);
+        }
+        ctx->chunk.chunk_counter += subtree_chunks;
+        input += subtree_len;
+        len -= subtree_len;
+    }
+
+    if (len > 0) {
+        chunk_state_update (&ctx->chunk, input, len);
+        merge_cv_stack (ctx, ctx->chunk.chunk_counter);
+    }
+}
+
+void blake3_final (BLAKE3_CTX *ctx, uint8_t hash[BLAKE3_OUT_LEN])
+{
+    struct output output;
+    size_t cvs_remaining;
+
+    if (ctx->cv_stack_len == 0) {
+        output = chunk_state_output (&ctx->chunk);
+        output_root_bytes (&output, hash);
+        return;
+    }
+    /* If there are bytes in the chunk state, they form the rightmost
+     * leaf.  Otherwise the last two stack entries were held back from
+     * merging and form the rightmost parent.
+     */
+    if (chunk_state_len (&ctx->chunk) > 0) {
+        cvs_remaining = ctx->cv_stack_len;
+        output = chunk_state_output (&ctx->chunk);
+    }
+    else {
+        cvs_remaining = ctx->cv_stack_len - 2;
+        output = parent_output (ctx->cv_stack + cvs_remaining * BLAKE3_OUT_LEN,
+                                ctx->key,
+                                ctx->chunk.flags);
+    }
+    while (cvs_remaining > 0) {
+        uint8_t parent_block[BLAKE3_BLOCK_LEN];
+
+        cvs_remaining--;
+        memcpy (parent_block,
+                ctx->cv_stack + cvs_remaining * BLAKE3_OUT_LEN,
+                BLAKE3_OUT_LEN);
+        output_chaining_value (&output, parent_block + BLAKE3_OUT_LEN);
+        output = parent_output (parent_block, ctx->key, ctx->chunk.flags);
+    }
+    output_root_bytes (&output, hash);
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
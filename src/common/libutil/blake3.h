@@ -0,0 +1,65 @@
+/************************************************************\
+ * Copyright 2026 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _UTIL_BLAKE3_H
+#define _UTIL_BLAKE3_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* BLAKE3 hash function (unkeyed, 32 byte output).
+ * See https://github.com/BLAKE3-team/BLAKE3-specs
+ *
+ * Chunks are compressed several at a time with SSE4.1, AVX2, or AVX-512
+ * kernels when the CPU supports them.  The best available kernel is
+ * selected at runtime on first use.
+ */
+
+#define BLAKE3_OUT_LEN      32
+#define BLAKE3_BLOCK_LEN    64
+#define BLAKE3_CHUNK_LEN    1024
+#define BLAKE3_MAX_DEPTH    54
+
+struct blake3_chunk_state {
+    uint32_t cv[8];
+    uint64_t chunk_counter;
+    uint8_t buf[BLAKE3_BLOCK_LEN];
+    uint8_t buf_len;
+    uint8_t blocks_compressed;
+    uint8_t flags;
+};
+
+typedef struct {
+    uint32_t key[8];
+    struct blake3_chunk_state chunk;
+    uint8_t cv_stack_len;
+    uint8_t cv_stack[(BLAKE3_MAX_DEPTH + 1) * BLAKE3_OUT_LEN];
+} BLAKE3_CTX;
+
+void blake3_init (BLAKE3_CTX *ctx);
+void blake3_update (BLAKE3_CTX *ctx, const void *data, size_t len);
+void blake3_final (BLAKE3_CTX *ctx, uint8_t hash[BLAKE3_OUT_LEN]);
+
+/* Get the name of the kernel in use: "portable", "sse41", "avx2", or
+ * "avx512".
+ */
+const char *blake3_get_impl (void);
+
+/* Select a kernel by name (for testing and benchmarking).
+ * Returns 0 on success, or -1 with errno set to ENOENT if the kernel
+ * is unknown or not supported by this CPU.
+ */
+int blake3_set_impl (const char *name);
+
+#endif /* !_UTIL_BLAKE3_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
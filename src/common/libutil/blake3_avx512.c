@@ -0,0 +1,339 @@
+/************************************************************\
+ * Copyright 2026 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* blake3_avx512.c - hash 16 inputs at once with AVX-512
+ *
+ * Same layout as blake3_sse41.c, with 512-bit vectors and native rotates.
+ * Message blocks are transposed in two groups of 8 with AVX2 and then
+ * combined.  Inputs left over after groups of 16 are passed to the AVX2
+ * kernel.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "blake3_impl.h"
+
+#ifdef BLAKE3_X86
+#include <immintrin.h>
+
+#define TARGET __attribute__ ((target ("avx512f,avx2")))
+#define DEGREE 16
+
+TARGET static inline __m512i addv (__m512i a, __m512i b)
+{
+    return _mm512_add_epi32 (a, b);
+}
+
+TARGET static inline __m512i xorv (__m512i a, __m512i b)
+{
+    return _mm512_xor_si512 (a, b);
+}
+
+TARGET static inline __m512i set1 (uint32_t x)
+{
+    return _mm512_set1_epi32 ((int32_t)x);
+}
+
+TARGET static inline __m512i rot16 (__m512i x)
+{
+    return _mm512_ror_epi32 (x, 16);
+}
+
+TARGET static inline __m512i rot12 (__m512i x)
+{
+    return _mm512_ror_epi32 (x, 12);
+}
+
+TARGET static inline __m512i rot8 (__m512i x)
+{
+    return _mm512_ror_epi32 (x, 8);
+}
+
+TARGET static inline __m512i rot7 (__m512i x)
+{
+    return _mm512_ror_epi32 (x, 7);
+}
+
+TARGET static inline void round_fn (__m512i v[16], __m512i m[16], size_t r)
+{
+    const uint8_t *s = blake3_msg_schedule[r];
+
+    /* columns */
+    v[0] = addv (v[0], m[s[0]]);
+    v[1] = addv (v[1], m[s[2]]);
+    v[2] = addv (v[2], m[s[4]]);
+    v[3] = addv (v[3], m[s[6]]);
+    v[0] = addv (v[0], v[4]);
+    v[1] = addv (v[1], v[5]);
+    v[2] = addv (v[2], v[6]);
+    v[3] = addv (v[3], v[7]);
+    v[12] = rot16 (xorv (v[12], v[0]));
+    v[13] = rot16 (xorv (v[13], v[1]));
+    v[14] = rot16 (xorv (v[14], v[2]));
+    v[15] = rot16 (xorv (v[15], v[3]));
+    v[8] = addv (v[8], v[12]);
+    v[9] = addv (v[9], v[13]);
+    v[10] = addv (v[10], v[14]);
+    v[11] = addv (v[11], v[15]);
+    v[4] = rot12 (xorv (v[4], v[8]));
+    v[5] = rot12 (xorv (v[5], v[9]));
+    v[6] = rot12 (xorv (v[6], v[10]));
+    v[7] = rot12 (xorv (v[7], v[11]));
+    v[0] = addv (v[0], m[s[1]]);
+    v[1] = addv (v[1], m[s[3]]);
+    v[2] = addv (v[2], m[s[5]]);
+    v[3] = addv (v[3], m[s[7]]);
+    v[0] = addv (v[0], v[4]);
+    v[1] = addv (v[1], v[5]);
+    v[2] = addv (v[2], v[6]);
+    v[3] = addv (v[3], v[7]);
+    v[12] = rot8 (xorv (v[12], v[0]));
+    v[13] = rot8 (xorv (v[13], v[1]));
+    v[14] = rot8 (xorv (v[14], v[2]));
+    v[15] = rot8 (xorv (v[15], v[3]));
+    v[8] = addv (v[8], v[12]);
+    v[9] = addv (v[9], v[13]);
+    v[10] = addv (v[10], v[14]);
+    v[11] = addv (v[11], v[15]);
+    v[4] = rot7 (xorv (v[4], v[8]));
+    v[5] = rot7 (xorv (v[5], v[9]));
+    v[6] = rot7 (xorv (v[6], v[10]));
+    v[7] = rot7 (xorv (v[7], v[11]));
+
+    /* diagonals */
+    v[0] = addv (v[0], m[s[8]]);
+    v[1] = addv (v[1], m[s[10]]);
+    v[2] = addv (v[2], m[s[12]]);
+    v[3] = addv (v[3], m[s[14]]);
+    v[0] = addv (v[0], v[5]);
+    v[1] = addv (v[1], v[6]);
+    v[2] = addv (v[2], v[7]);
+    v[3] = addv (v[3], v[4]);
+    v[15] = rot16 (xorv (v[15], v[0]));
+    v[12] = rot16 (xorv (v[12], v[1]));
+    v[13] = rot16 (xorv (v[13], v[2]));
+    v[14] = rot16 (xorv (v[14], v[3]));
+    v[10] = addv (v[10], v[15]);
+    v[11] = addv (v[11], v[12]);
+    v[8] = addv (v[8], v[13]);
+    v[9] = addv (v[9], v[14]);
+    v[5] = rot12 (xorv (v[5], v[10]));
+    v[6] = rot12 (xorv (v[6], v[11]));
+    v[7] = rot12 (xorv (v[7], v[8]));
+    v[4] = rot12 (xorv (v[4], v[9]));
+    v[0] = addv (v[0], m[s[9]]);
+    v[1] = addv (v[1], m[s[11]]);
+    v[2] = addv (v[2], m[s[13]]);
+    v[3] = addv (v[3], m[s[15]]);
+    v[0] = addv (v[0], v[5]);
+    v[1] = addv (v[1], v[6]);
+    v[2] = addv (v[2], v[7]);
+    v[3] = addv (v[3], v[4]);
+    v[15] = rot8 (xorv (v[15], v[0]));
+    v[12] = rot8 (xorv (v[12], v[1]));
+    v[13] = rot8 (xorv (v[13], v[2]));
+    v[14] = rot8 (xorv (v[14], v[3]));
+    v[10] = addv (v[10], v[15]);
+    v[11] = addv (v[11], v[12]);
+    v[8] = addv (v[8], v[13]);
+    v[9] = addv (v[9], v[14]);
+    v[5] = rot7 (xorv (v[5], v[10]));
+    v[6] = rot7 (xorv (v[6], v[11]));
+    v[7] = rot7 (xorv (v[7], v[8]));
+    v[4] = rot7 (xorv (v[4], v[9]));
+}
+
+/* Transpose an 8x8 matrix of 32-bit words held in 8 vectors.
+ * The unpacks work within 128-bit lanes, so the final step swaps lanes.
+ */
+TARGET static inline void transpose_vecs8 (__m256i vecs[8])
+{
+    __m256i ab_0145 = _mm256_unpacklo_epi32 (vecs[0], vecs[1]);
+    __m256i ab_2367 = _mm256_unpackhi_epi32 (vecs[0], vecs[1]);
+    __m256i cd_0145 = _mm256_unpacklo_epi32 (vecs[2], vecs[3]);
+    __m256i cd_2367 = _mm256_unpackhi_epi32 (vecs[2], vecs[3]);
+    __m256i ef_0145 = _mm256_unpacklo_epi32 (vecs[4], vecs[5]);
+    __m256i ef_2367 = _mm256_unpackhi_epi32 (vecs[4], vecs[5]);
+    __m256i gh_0145 = _mm256_unpacklo_epi32 (vecs[6], vecs[7]);
+    __m256i gh_2367 = _mm256_unpackhi_epi32 (vecs[6], vecs[7]);
+
+    __m256i abcd_04 = _mm256_unpacklo_epi64 (ab_0145, cd_0145);
+    __m256i abcd_15 = _mm256_unpackhi_epi64 (ab_0145, cd_0145);
+    __m256i abcd_26 = _mm256_unpacklo_epi64 (ab_2367, cd_2367);
+    __m256i abcd_37 = _mm256_unpackhi_epi64 (ab_2367, cd_2367);
+    __m256i efgh_04 = _mm256_unpacklo_epi64 (ef_0145, gh_0145);
+    __m256i efgh_15 = _mm256_unpackhi_epi64 (ef_0145, gh_0145);
+    __m256i efgh_26 = _mm256_unpacklo_epi64 (ef_2367, gh_2367);
+    __m256i efgh_37 = _mm256_unpackhi_epi64 (ef_2367, gh_2367);
+
+    vecs[0] = _mm256_permute2x128_si256 (abcd_04, efgh_04, 0x20);
+    vecs[1] = _mm256_permute2x128_si256 (abcd_15, efgh_15, 0x20);
+    vecs[2] = _mm256_permute2x128_si256 (abcd_26, efgh_26, 0x20);
+    vecs[3] = _mm256_permute2x128_si256 (abcd_37, efgh_37, 0x20);
+    vecs[4] = _mm256_permute2x128_si256 (abcd_04, efgh_04, 0x31);
+    vecs[5] = _mm256_permute2x128_si256 (abcd_15, efgh_15, 0x31);
+    vecs[6] = _mm256_permute2x128_si256 (abcd_26, efgh_26, 0x31);
+    vecs[7] = _mm256_permute2x128_si256 (abcd_37, efgh_37, 0x31);
+}
+
+/* Load one block from each input so that out[i] holds message word i
+ * of all 16 inputs.  Inputs 0-7 go in the low half of each vector and
+ * inputs 8-15 in the high half.
+ */
+TARGET static inline void transpose_msg_vecs (const uint8_t *const *inputs,
+                                              size_t block_offset,
+                                              __m512i out[16])
+{
+    __m256i lo[16];
+    __m256i hi[16];
+
+    for (int i = 0; i < 8; i++) {
+        const uint8_t *p = inputs[i] + block_offset;
+        const uint8_t *q = inputs[8 + i] + block_offset;
+        lo[0 + i] = _mm256_loadu_si256 ((const __m256i *)p);
+        lo[8 + i] = _mm256_loadu_si256 ((const __m256i *)(p + 32));
+        hi[0 + i] = _mm256_loadu_si256 ((const __m256i *)q);
+        hi[8 + i] = _mm256_loadu_si256 ((const __m256i *)(q + 32));
+    }
+    transpose_vecs8 (&lo[0]);
+    transpose_vecs8 (&lo[8]);
+    transpose_vecs8 (&hi[0]);
+    transpose_vecs8 (&hi[8]);
+    for (int i = 0; i < 16; i++)
+        out[i] = _mm512_inserti64x4 (_mm512_castsi256_si512 (lo[i]), hi[i], 1);
+}
+
+TARGET static inline void load_counters (uint64_t counter,
+                                         bool increment_counter,
+                                         __m512i *out_lo,
+                                         __m512i *out_hi)
+{
+    uint32_t lo[DEGREE];
+    uint32_t hi[DEGREE];
+
+    for (int i = 0; i < DEGREE; i++) {
+        uint64_t c = counter + (increment_counter ? i : 0);
+        lo[i] = blake3_counter_low (c);
+        hi[i] = blake3_counter_high (c);
+    }
+    *out_lo = _mm512_loadu_si512 (lo);
+    *out_hi = _mm512_loadu_si512 (hi);
+}
+
+TARGET static void hash16 (const uint8_t *const *inputs,
+                           size_t blocks,
+                           const uint32_t key[8],
+                           uint64_t counter,
+                           bool increment_counter,
+                           uint8_t flags,
+                           uint8_t flags_start,
+                           uint8_t flags_end,
+                           uint8_t *out)
+{
+    __m512i h_vecs[8];
+    __m512i counter_low_vec;
+    __m512i counter_high_vec;
+    uint8_t block_flags = flags | flags_start;
+
+    for (int i = 0; i < 8; i++)
+        h_vecs[i] = set1 (key[i]);
+    load_counters (counter,
+                   increment_counter,
+                   &counter_low_vec,
+                   &counter_high_vec);
+
+    for (size_t block = 0; block < blocks; block++) {
+        __m512i msg_vecs[16];
+        __m512i v[16];
+
+        if (block + 1 == blocks)
+            block_flags |= flags_end;
+        transpose_msg_vecs (inputs, block * BLAKE3_BLOCK_LEN, msg_vecs);
+
+        for (int i = 0; i < 8; i++)
+            v[i] = h_vecs[i];
+        for (int i = 0; i < 4; i++)
+            v[8 + i] = set1 (blake3_iv[i]);
+        v[12] = counter_low_vec;
+        v[13] = counter_high_vec;
+        v[14] = set1 (BLAKE3_BLOCK_LEN);
+        v[15] = set1 (block_flags);
+
+        for (int r = 0; r < 7; r++)
+            round_fn (v, msg_vecs, r);
+
+        for (int i = 0; i < 8; i++)
+            h_vecs[i] = xorv (v[i], v[i + 8]);
+        block_flags = flags;
+    }
+
+    /* Transpose back so that each input's chaining value is contiguous.
+     */
+    __m256i lo[8];
+    __m256i hi[8];
+    for (int i = 0; i < 8; i++) {
+        lo[i] = _mm512_castsi512_si256 (h_vecs[i]);
+        hi[i] = _mm512_extracti64x4_epi64 (h_vecs[i], 1);
+    }
+    transpose_vecs8 (lo);
+    transpose_vecs8 (hi);
+    for (int i = 0; i < 8; i++) {
+        _mm256_storeu_si256 ((__m256i *)(out + i * BLAKE3_OUT_LEN), lo[i]);
+        _mm256_storeu_si256 ((__m256i *)(out + (8 + i) * BLAKE3_OUT_LEN),
+                             hi[i]);
+    }
+}
+
+void blake3_hash_many_avx512 (const uint8_t *const *inputs,
+                              size_t num_inputs,
+                              size_t blocks,
+                              const uint32_t key[8],
+                              uint64_t counter,
+                              bool increment_counter,
+                              uint8_t flags,
+                              uint8_t flags_start,
+                              uint8_t flags_end,
+                              uint8_t *out)
+{
+    while (num_inputs >= DEGREE) {
+        hash16 (inputs,
+                blocks,
+                key,
+                counter,
+                increment_counter,
+                flags,
+                flags_start,
+                flags_end,
+                out);
+        if (increment_counter)
+            counter += DEGREE;
+        inputs += DEGREE;
+        num_inputs -= DEGREE;
+        out += DEGREE * BLAKE3_OUT_LEN;
+    }
+    blake3_hash_many_avx2 (inputs,
+                           num_inputs,
+                           blocks,
+                           key,
+                           counter,
+                           increment_counter,
+                           flags,
+                           flags_start,
+                           flags_end,
+                           out);
+}
+
+#endif /* BLAKE3_X86 */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,152 @@
+/************************************************************\
+ * Copyright 2026 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* Internal interfaces shared by blake3.c and the SIMD kernels.
+ */
+
+#ifndef _UTIL_BLAKE3_IMPL_H
+#define _UTIL_BLAKE3_IMPL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "blake3.h"
+
+enum blake3_flags {
+    CHUNK_START         = 1 << 0,
+    CHUNK_END           = 1 << 1,
+    PARENT              = 1 << 2,
+    ROOT                = 1 << 3,
+};
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define BLAKE3_X86 1
+#endif
+
+/* Largest number of inputs any kernel hashes in parallel.
+ */
+#define BLAKE3_MAX_SIMD_DEGREE 16
+
+static const uint32_t blake3_iv[8] = {
+    0x6A09E667UL, 0xBB67AE85UL, 0x3C6EF372UL, 0xA54FF53AUL,
+    0x510E527FUL, 0x9B05688CUL, 0x1F83D9ABUL, 0x5BE0CD19UL,
+};
+
+static const uint8_t blake3_msg_schedule[7][16] = {
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+    {2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8},
+    {3, 4, 10, 12, 13, 2, 7, 14, 6, 5, 9, 0, 11, 15, 8, 1},
+    {10, 7, 12, 9, 14, 3, 13, 15, 4, 0, 11, 2, 5, 8, 1, 6},
+    {12, 13, 9, 11, 15, 10, 14, 8, 7, 2, 5, 3, 0, 1, 6, 4},
+    {9, 14, 11, 5, 8, 12, 15, 1, 13, 3, 0, 10, 2, 6, 4, 7},
+    {11, 15, 5, 0, 1, 9, 8, 6, 14, 10, 2, 12, 3, 4, 7, 13},
+};
+
+static inline uint32_t blake3_counter_low (uint64_t counter)
+{
+    return (uint32_t)counter;
+}
+
+static inline uint32_t blake3_counter_high (uint64_t counter)
+{
+    return (uint32_t)(counter >> 32);
+}
+
+static inline uint32_t blake3_load32 (const void *src)
+{
+    const uint8_t *p = src;
+    return ((uint32_t)p[0] << 0) | ((uint32_t)p[1] << 8)
+         | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void blake3_store32 (void *dst, uint32_t w)
+{
+    uint8_t *p = dst;
+    p[0] = (uint8_t)(w >> 0);
+    p[1] = (uint8_t)(w >> 8);
+    p[2] = (uint8_t)(w >> 16);
+    p[3] = (uint8_t)(w >> 24);
+}
+
+/* Hash 'num_inputs' inputs of 'blocks' blocks each, writing one chaining
+ * value per input to 'out'.  The first block of each input gets
+ * 'flags_start', the last gets 'flags_end'.  If 'increment_counter' is
+ * true, the counter of input i is counter + i.
+ */
+typedef void (*blake3_hash_many_f)(const uint8_t *const *inputs,
+                                   size_t num_inputs,
+                                   size_t blocks,
+                                   const uint32_t key[8],
+                                   uint64_t counter,
+                                   bool increment_counter,
+                                   uint8_t flags,
+                                   uint8_t flags_start,
+                                   uint8_t flags_end,
+                                   uint8_t *out);
+
+void blake3_compress_in_place_portable (uint32_t cv[8],
+                                        const uint8_t block[BLAKE3_BLOCK_LEN],
+                                        uint8_t block_len,
+                                        uint64_t counter,
+                                        uint8_t flags);
+
+void blake3_hash_many_portable (const uint8_t *const *inputs,
+                                size_t num_inputs,
+                                size_t blocks,
+                                const uint32_t key[8],
+                                uint64_t counter,
+                                bool increment_counter,
+                                uint8_t flags,
+                                uint8_t flags_start,
+                                uint8_t flags_end,
+                                uint8_t *out);
+
+#ifdef BLAKE3_X86
+void blake3_hash_many_sse41 (const uint8_t *const *inputs,
+                             size_t num_inputs,
+                             size_t blocks,
+                             const uint32_t key[8],
+                             uint64_t counter,
+                             bool increment_counter,
+                             uint8_t flags,
+                             uint8_t flags_start,
+                             uint8_t flags_end,
+                             uint8_t *out);
+
+void blake3_hash_many_avx2 (const uint8_t *const *inputs,
+                            size_t num_inputs,
+                            size_t blocks,
+                            const uint32_t key[8],
+                            uint64_t counter,
+                            bool increment_counter,
+                            uint8_t flags,
+                            uint8_t flags_start,
+                            uint8_t flags_end,
+                            uint8_t *out);
+
+void blake3_hash_many_avx512 (const uint8_t *const *inputs,
+                              size_t num_inputs,
+                              size_t blocks,
+                              const uint32_t key[8],
+                              uint64_t counter,
+                              bool increment_counter,
+                              uint8_t flags,
+                              uint8_t flags_start,
+                              uint8_t flags_end,
+                              uint8_t *out);
+#endif
+
+#endif /* !_UTIL_BLAKE3_IMPL_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
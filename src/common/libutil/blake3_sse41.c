@@ -0,0 +1,319 @@
+/************************************************************\
+ * Copyright 2026 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* blake3_sse41.c - hash 4 inputs at once with SSE4.1
+ *
+ * Each 128-bit vector holds the same state word for 4 inputs.  Message
+ * blocks are transposed into that layout as they are loaded.  Functions
+ * carry a target attribute so this file may be compiled without -msse4.1;
+ * blake3.c only calls in after checking the CPU supports it.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "blake3_impl.h"
+
+#ifdef BLAKE3_X86
+#include <immintrin.h>
+
+#define TARGET __attribute__ ((target ("sse4.1")))
+#define DEGREE 4
+
+TARGET static inline __m128i loadu (const uint8_t src[16])
+{
+    return _mm_loadu_si128 ((const __m128i *)src);
+}
+
+TARGET static inline void storeu (__m128i src, uint8_t dest[16])
+{
+    _mm_storeu_si128 ((__m128i *)dest, src);
+}
+
+TARGET static inline __m128i addv (__m128i a, __m128i b)
+{
+    return _mm_add_epi32 (a, b);
+}
+
+TARGET static inline __m128i xorv (__m128i a, __m128i b)
+{
+    return _mm_xor_si128 (a, b);
+}
+
+TARGET static inline __m128i set1 (uint32_t x)
+{
+    return _mm_set1_epi32 ((int32_t)x);
+}
+
+TARGET static inline __m128i rot16 (__m128i x)
+{
+    return _mm_shuffle_epi8 (x, _mm_set_epi8 (13, 12, 15, 14, 9, 8, 11, 10,
+                                              5, 4, 7, 6, 1, 0, 3, 2));
+}
+
+TARGET static inline __m128i rot12 (__m128i x)
+{
+    return xorv (_mm_srli_epi32 (x, 12), _mm_slli_epi32 (x, 32 - 12));
+}
+
+TARGET static inline __m128i rot8 (__m128i x)
+{
+    return _mm_shuffle_epi8 (x, _mm_set_epi8 (12, 15, 14, 13, 8, 11, 10, 9,
+                                              4, 7, 6, 5, 0, 3, 2, 1));
+}
+
+TARGET static inline __m128i rot7 (__m128i x)
+{
+    return xorv (_mm_srli_epi32 (x, 7), _mm_slli_epi32 (x, 32 - 7));
+}
+
+TARGET static inline void round_fn (__m128i v[16], __m128i m[16], size_t r)
+{
+    const uint8_t *s = blake3_msg_schedule[r];
+
+    /* columns */
+    v[0] = addv (v[0], m[s[0]]);
+    v[1] = addv (v[1], m[s[2]]);
+    v[2] = addv (v[2], m[s[4]]);
+    v[3] = addv (v[3], m[s[6]]);
+    v[0] = addv (v[0], v[4]);
+    v[1] = addv (v[1], v[5]);
+    v[2] = addv (v[2], v[6]);
+    v[3] = addv (v[3], v[7]);
+    v[12] = rot16 (xorv (v[12], v[0]));
+    v[13] = rot16 (xorv (v[13], v[1]));
+    v[14] = rot16 (xorv (v[14], v[2]));
+    v[15] = rot16 (xorv (v[15], v[3]));
+    v[8] = addv (v[8], v[12]);
+    v[9] = addv (v[9], v[13]);
+    v[10] = addv (v[10], v[14]);
+    v[11] = addv (v[11], v[15]);
+    v[4] = rot12 (xorv (v[4], v[8]));
+    v[5] = rot12 (xorv (v[5], v[9]));
+    v[6] = rot12 (xorv (v[6], v[10]));
+    v[7] = rot12 (xorv (v[7], v[11]));
+    v[0] = addv (v[0], m[s[1]]);
+    v[1] = addv (v[1], m[s[3]]);
+    v[2] = addv (v[2], m[s[5]]);
+    v[3] = addv (v[3], m[s[7]]);
+    v[0] = addv (v[0], v[4]);
+    v[1] = addv (v[1], v[5]);
+    v[2] = addv (v[2], v[6]);
+    v[3] = addv (v[3], v[7]);
+    v[12] = rot8 (xorv (v[12], v[0]));
+    v[13] = rot8 (xorv (v[13], v[1]));
+    v[14] = rot8 (xorv (v[14], v[2]));
+    v[15] = rot8 (xorv (v[15], v[3]));
+    v[8] = addv (v[8], v[12]);
+    v[9] = addv (v[9], v[13]);
+    v[10] = addv (v[10], v[14]);
+    v[11] = addv (v[11], v[15]);
+    v[4] = rot7 (xorv (v[4], v[8]));
+    v[5] = rot7 (xorv (v[5], v[9]));
+    v[6] = rot7 (xorv (v[6], v[10]));
+    v[7] = rot7 (xorv (v[7], v[11]));
+
+    /* diagonals */
+    v[0] = addv (v[0], m[s[8]]);
+    v[1] = addv (v[1], m[s[10]]);
+    v[2] = addv (v[2], m[s[12]]);
+    v[3] = addv (v[3], m[s[14]]);
+    v[0] = addv (v[0], v[5]);
+    v[1] = addv (v[1], v[6]);
+    v[2] = addv (v[2], v[7]);
+    v[3] = addv (v[3], v[4]);
+    v[15] = rot16 (xorv (v[15], v[0]));
+    v[12] = rot16 (xorv (v[12], v[1]));
+    v[13] = rot16 (xorv (v[13], v[2]));
+    v[14] = rot16 (xorv (v[14], v[3]));
+    v[10] = addv (v[10], v[15]);
+    v[11] = addv (v[11], v[12]);
+    v[8] = addv (v[8], v[13]);
+    v[9] = addv (v[9], v[14]);
+    v[5] = rot12 (xorv (v[5], v[10]));
+    v[6] = rot12 (xorv (v[6], v[11]));
+    v[7] = rot12 (xorv (v[7], v[8]));
+    v[4] = rot12 (xorv (v[4], v[9]));
+    v[0] = addv (v[0], m[s[9]]);
+    v[1] = addv (v[1], m[s[11]]);
+    v[2] = addv (v[2], m[s[13]]);
+    v[3] = addv (v[3], m[s[15]]);
+    v[0] = addv (v[0], v[5]);
+    v[1] = addv (v[1], v[6]);
+    v[2] = addv (v[2], v[7]);
+    v[3] = addv (v[3], v[4]);
+    v[15] = rot8 (xorv (v[15], v[0]));
+    v[12] = rot8 (xorv (v[12], v[1]));
+    v[13] = rot8 (xorv (v[13], v[2]));
+    v[14] = rot8 (xorv (v[14], v[3]));
+    v[10] = addv (v[10], v[15]);
+    v[11] = addv (v[11], v[12]);
+    v[8] = addv (v[8], v[13]);
+    v[9] = addv (v[9], v[14]);
+    v[5] = rot7 (xorv (v[5], v[10]));
+    v[6] = rot7 (xorv (v[6], v[11]));
+    v[7] = rot7 (xorv (v[7], v[8]));
+    v[4] = rot7 (xorv (v[4], v[9]));
+}
+
+/* Transpose a 4x4 matrix of 32-bit words held in 4 vectors.
+ */
+TARGET static inline void transpose_vecs (__m128i vecs[4])
+{
+    __m128i ab_01 = _mm_unpacklo_epi32 (vecs[0], vecs[1]);
+    __m128i ab_23 = _mm_unpackhi_epi32 (vecs[0], vecs[1]);
+    __m128i cd_01 = _mm_unpacklo_epi32 (vecs[2], vecs[3]);
+    __m128i cd_23 = _mm_unpackhi_epi32 (vecs[2], vecs[3]);
+
+    vecs[0] = _mm_unpacklo_epi64 (ab_01, cd_01);
+    vecs[1] = _mm_unpackhi_epi64 (ab_01, cd_01);
+    vecs[2] = _mm_unpacklo_epi64 (ab_23, cd_23);
+    vecs[3] = _mm_unpackhi_epi64 (ab_23, cd_23);
+}
+
+/* Load one block from each input so that out[i] holds message word i
+ * of all 4 inputs.
+ */
+TARGET static inline void transpose_msg_vecs (const uint8_t *const *inputs,
+                                              size_t block_offset,
+                                              __m128i out[16])
+{
+    for (int i = 0; i < DEGREE; i++) {
+        const uint8_t *p = inputs[i] + block_offset;
+        out[0 + i] = loadu (p + 0 * 16);
+        out[4 + i] = loadu (p + 1 * 16);
+        out[8 + i] = loadu (p + 2 * 16);
+        out[12 + i] = loadu (p + 3 * 16);
+    }
+    transpose_vecs (&out[0]);
+    transpose_vecs (&out[4]);
+    transpose_vecs (&out[8]);
+    transpose_vecs (&out[12]);
+}
+
+TARGET static inline void load_counters (uint64_t counter,
+                                         bool increment_counter,
+                                         __m128i *out_lo,
+                                         __m128i *out_hi)
+{
+    uint32_t lo[DEGREE];
+    uint32_t hi[DEGREE];
+
+    for (int i = 0; i < DEGREE; i++) {
+        uint64_t c = counter + (increment_counter ? i : 0);
+        lo[i] = blake3_counter_low (c);
+        hi[i] = blake3_counter_high (c);
+    }
+    *out_lo = _mm_loadu_si128 ((const __m128i *)lo);
+    *out_hi = _mm_loadu_si128 ((const __m128i *)hi);
+}
+
+TARGET static void hash4 (const uint8_t *const *inputs,
+                          size_t blocks,
+                          const uint32_t key[8],
+                          uint64_t counter,
+                          bool increment_counter,
+                          uint8_t flags,
+                          uint8_t flags_start,
+                          uint8_t flags_end,
+                          uint8_t *out)
+{
+    __m128i h_vecs[8];
+    __m128i counter_low_vec;
+    __m128i counter_high_vec;
+    uint8_t block_flags = flags | flags_start;
+
+    for (int i = 0; i < 8; i++)
+        h_vecs[i] = set1 (key[i]);
+    load_counters (counter,
+                   increment_counter,
+                   &counter_low_vec,
+                   &counter_high_vec);
+
+    for (size_t block = 0; block < blocks; block++) {
+        __m128i msg_vecs[16];
+        __m128i v[16];
+
+        if (block + 1 == blocks)
+            block_flags |= flags_end;
+        transpose_msg_vecs (inputs, block * BLAKE3_BLOCK_LEN, msg_vecs);
+
+        for (int i = 0; i < 8; i++)
+            v[i] = h_vecs[i];
+        for (int i = 0; i < 4; i++)
+            v[8 + i] = set1 (blake3_iv[i]);
+        v[12] = counter_low_vec;
+        v[13] = counter_high_vec;
+        v[14] = set1 (BLAKE3_BLOCK_LEN);
+        v[15] = set1 (block_flags);
+
+        for (int r = 0; r < 7; r++)
+            round_fn (v, msg_vecs, r);
+
+        for (int i = 0; i < 8; i++)
+            h_vecs[i] = xorv (v[i], v[i + 8]);
+        block_flags = flags;
+    }
+
+    /* Transpose back so that each input's chaining value is contiguous.
+     */
+    transpose_vecs (&h_vecs[0]);
+    transpose_vecs (&h_vecs[4]);
+    for (int i = 0; i < DEGREE; i++) {
+        storeu (h_vecs[i], out + i * BLAKE3_OUT_LEN);
+        storeu (h_vecs[4 + i], out + i * BLAKE3_OUT_LEN + 16);
+    }
+}
+
+void blake3_hash_many_sse41 (const uint8_t *const *inputs,
+                             size_t num_inputs,
+                             size_t blocks,
+                             const uint32_t key[8],
+                             uint64_t counter,
+                             bool increment_counter,
+                             uint8_t flags,
+                             uint8_t flags_start,
+                             uint8_t flags_end,
+                             uint8_t *out)
+{
+    while (num_inputs >= DEGREE) {
+        hash4 (inputs,
+               blocks,
+               key,
+               counter,
+               increment_counter,
+               flags,
+               flags_start,
+               flags_end,
+               out);
+        if (increment_counter)
+            counter += DEGREE;
+        inputs += DEGREE;
+        num_inputs -= DEGREE;
+        out += DEGREE * BLAKE3_OUT_LEN;
+    }
+    blake3_hash_many_portable (inputs,
+                               num_inputs,
+                               blocks,
+                               key,
+                               counter,
+                               increment_counter,
+                               flags,
+                               flags_start,
+                               flags_end,
+                               out);
+}
+
+#endif /* BLAKE3_X86 */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -24,6 +24,7 @@
 #include "blobref.h"
 #include "sha1.h"
 #include "sha256.h"
+#include "blake3.h"
 
 #define SHA1_PREFIX_STRING  "sha1-"
 #define SHA1_PREFIX_LENGTH  5
@@ -33,6 +34,10 @@
 #define SHA256_PREFIX_LENGTH  7
 #define SHA256_STRING_SIZE    (SHA256_BLOCK_SIZE*2 + SHA256_PREFIX_LENGTH + 1)
 
+#define BLAKE3_PREFIX_STRING  "blake3-"
+#define BLAKE3_PREFIX_LENGTH  7
+#define BLAKE3_STRING_SIZE    (BLAKE3_OUT_LEN*2 + BLAKE3_PREFIX_LENGTH + 1)
+
 #if BLOBREF_MAX_STRING_SIZE < SHA1_STRING_SIZE
 #error BLOBREF_MAX_STRING_SIZE is too small
 #endif
@@ -45,6 +50,12 @@
 #if BLOBREF_MAX_DIGEST_SIZE < SHA256_BLOCK_SIZE
 #error BLOBREF_MAX_DIGEST_SIZE is too small
 #endif
+#if BLOBREF_MAX_STRING_SIZE < BLAKE3_STRING_SIZE
+#error BLOBREF_MAX_STRING_SIZE is too small
+#endif
+#if BLOBREF_MAX_DIGEST_SIZE < BLAKE3_OUT_LEN
+#error BLOBREF_MAX_DIGEST_SIZE is too small
+#endif
 
 static void sha1_hash (const void *data,
                        size_t data_len,
@@ -54,6 +65,10 @@ static void sha256_hash (const void *data,
                          size_t data_len,
                          void *hash,
                          size_t hash_len);
+static void blake3_hash (const void *data,
+                         size_t data_len,
+                         void *hash,
+                         size_t hash_len);
 
 struct blobhash {
     char *name;
@@ -73,6 +88,10 @@ static struct blobhash blobtab[] = {
       .hashlen = SHA256_BLOCK_SIZE,
       .hashfun = sha256_hash,
     },
+    { .name = "blake3",
+      .hashlen = BLAKE3_OUT_LEN,
+      .hashfun = blake3_hash,
+    },
     { NULL, 0, 0 },
 };
 
@@ -102,6 +121,19 @@ static void sha256_hash (const void *data,
     sha256_final (&ctx, hash);
 }
 
+static void blake3_hash (const void *data,
+                         size_t data_len,
+                         void *hash,
+                         size_t hash_len)
+{
+    BLAKE3_CTX ctx;
+
+    assert (hash_len == BLAKE3_OUT_LEN);
+    blake3_init (&ctx);
+    blake3_update (&ctx, data, data_len);
+    blake3_final (&ctx, hash);
+}
+
 /* true if s1 contains "s2-" prefix
  */
 static bool prefixmatch (const char *s1, const char *s2)
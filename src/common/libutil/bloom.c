@@ -0,0 +1,137 @@
+/************************************************************\
+ * Copyright 2026 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* bloom.c - bloom filter
+ *
+ * The k bit positions for a key are derived from two 64-bit FNV-1a hashes
+ * of the key with the Kirsch-Mitzenmacher construction:
+ *   g_i(x) = h1(x) + i * h2(x)  mod m
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <math.h>
+
+#include "bloom.h"
+
+struct bloom {
+    uint8_t *bits;
+    uint64_t nbits;
+    int nhashes;
+    size_t capacity;
+    size_t count;
+};
+
+static uint64_t fnv1a (const void *key, size_t len, uint64_t seed)
+{
+    const uint8_t *p = key;
+    uint64_t h = 0xcbf29ce484222325ULL ^ seed;
+
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static void bloom_hash (const void *key,
+                        size_t len,
+                        uint64_t *h1,
+                        uint64_t *h2)
+{
+    *h1 = fnv1a (key, len, 0);
+    *h2 = fnv1a (key, len, 0x9e3779b97f4a7c15ULL) | 1; // odd, so never 0
+}
+
+void bloom_add (struct bloom *b, const void *key, size_t len)
+{
+    uint64_t h1, h2;
+
+    if (!b)
+        return;
+    bloom_hash (key, len, &h1, &h2);
+    for (int i = 0; i < b->nhashes; i++) {
+        uint64_t bit = (h1 + i * h2) % b->nbits;
+        b->bits[bit / 8] |= 1 << (bit % 8);
+    }
+    b->count++;
+}
+
+bool bloom_test (struct bloom *b, const void *key, size_t len)
+{
+    uint64_t h1, h2;
+
+    if (!b)
+        return true;
+    bloom_hash (key, len, &h1, &h2);
+    for (int i = 0; i < b->nhashes; i++) {
+        uint64_t bit = (h1 + i * h2) % b->nbits;
+        if (!(b->bits[bit / 8] & (1 << (bit % 8))))
+            return false;
+    }
+    return true;
+}
+
+size_t bloom_count (struct bloom *b)
+{
+    return b ? b->count : 0;
+}
+
+size_t bloom_capacity (struct bloom *b)
+{
+    return b ? b->capacity : 0;
+}
+
+size_t bloom_size (struct bloom *b)
+{
+    return b ? (b->nbits + 7) / 8 : 0;
+}
+
+void bloom_destroy (struct bloom *b)
+{
+    if (b) {
+        int saved_errno = errno;
+        free (b->bits);
+        free (b);
+        errno = saved_errno;
+    }
+}
+
+struct bloom *bloom_create (size_t capacity, double fp_rate)
+{
+    struct bloom *b;
+    double nbits;
+
+    if (capacity == 0 || !(fp_rate > 0 && fp_rate < 1)) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(b = calloc (1, sizeof (*b))))
+        return NULL;
+    /* Optimal m = -n ln(p) / ln(2)^2 and k = (m / n) ln(2).
+     */
+    nbits = ceil (-(double)capacity * log (fp_rate) / (M_LN2 * M_LN2));
+    b->nbits = nbits < 64 ? 64 : (uint64_t)nbits;
+    b->nhashes = (int)round ((double)b->nbits / capacity * M_LN2);
+    if (b->nhashes < 1)
+        b->nhashes = 1;
+    b->capacity = capacity;
+    if (!(b->bits = calloc (1, (b->nbits + 7) / 8))) {
+        bloom_destroy (b);
+        return NULL;
+    }
+    return b;
+}
+
+// vi:ts=4 sw=4 expandtab
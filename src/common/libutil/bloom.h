@@ -0,0 +1,43 @@
+/************************************************************\
+ * Copyright 2026 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _UTIL_BLOOM_H
+#define _UTIL_BLOOM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Bloom filter - a compact set that may report false positives but
+ * never false negatives.  The filter is sized for 'capacity' keys with a
+ * false positive rate of 'fp_rate' (0 < fp_rate < 1).  Adding more than
+ * 'capacity' keys is allowed, but the false positive rate rises.
+ * Returns filter on success, or NULL on failure with errno set.
+ */
+struct bloom *bloom_create (size_t capacity, double fp_rate);
+void bloom_destroy (struct bloom *b);
+
+void bloom_add (struct bloom *b, const void *key, size_t len);
+
+/* Return false if 'key' was definitely not added, true if it might have been.
+ */
+bool bloom_test (struct bloom *b, const void *key, size_t len);
+
+/* Number of keys added and filter capacity.
+ */
+size_t bloom_count (struct bloom *b);
+size_t bloom_capacity (struct bloom *b);
+
+/* Size of the bit array in bytes.
+ */
+size_t bloom_size (struct bloom *b);
+
+#endif /* !_UTIL_BLOOM_H */
+
+// vi:ts=4 sw=4 expandtab
@@ -0,0 +1,108 @@
+/************************************************************\
+ * Copyright 2026 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdint.h>
+#include <math.h>
+
+#include "hist.h"
+
+/* Bucket b < HIST_SUB_BUCKETS holds the value b.  Above that, each
+ * power of two [2^m, 2^(m+1)) is split into HIST_SUB_BUCKETS buckets
+ * of equal width, selected by the HIST_SUB_BITS bits below the most
+ * significant bit.
+ */
+static int bucket_index (uint32_t x)
+{
+    int msb;
+
+    if (x < HIST_SUB_BUCKETS)
+        return x;
+    msb = 31 - __builtin_clz (x);
+    return (msb - HIST_SUB_BITS + 1) * HIST_SUB_BUCKETS
+           + ((x >> (msb - HIST_SUB_BITS)) & (HIST_SUB_BUCKETS - 1));
+}
+
+/* Return the largest value counted in bucket 'b'.
+ */
+static uint32_t bucket_max (int b)
+{
+    int shift;
+    uint64_t low;
+
+    if (b < HIST_SUB_BUCKETS)
+        return b;
+    shift = b / HIST_SUB_BUCKETS - 1;
+    low = (uint64_t)(HIST_SUB_BUCKETS + b % HIST_SUB_BUCKETS) << shift;
+    return low + (1ULL << shift) - 1;
+}
+
+void hist_push (hist_t *h, uint64_t x)
+{
+    uint32_t v = x > UINT32_MAX ? UINT32_MAX : x;
+
+    if (h->n == 0 || v < h->min)
+        h->min = v;
+    if (h->n == 0 || v > h->max)
+        h->max = v;
+    h->n++;
+    h->sum += v;
+    h->counts[bucket_index (v)]++;
+}
+
+uint64_t hist_count (hist_t *h)
+{
+    return h->n;
+}
+
+uint32_t hist_min (hist_t *h)
+{
+    return h->min;
+}
+
+uint32_t hist_max (hist_t *h)
+{
+    return h->max;
+}
+
+double hist_mean (hist_t *h)
+{
+    return h->n > 0 ? (double)h->sum / h->n : 0.;
+}
+
+uint32_t hist_percentile (hist_t *h, double p)
+{
+    uint64_t rank;
+    uint64_t seen = 0;
+
+    if (h->n == 0)
+        return 0;
+    if (p <= 0.)
+        return h->min;
+    /* Round up, so the values at or below the returned one are at least
+     * p percent of the total, e.g. p84 of 10 values is the 9th.
+     */
+    rank = p >= 100. ? h->n : (uint64_t)ceil (p * h->n / 100.);
+    if (rank == 0)
+        rank = 1;
+    for (int b = 0; b < HIST_BUCKETS; b++) {
+        if ((seen += h->counts[b]) >= rank) {
+            uint32_t v = bucket_max (b);
+            return v < h->max ? v : h->max;
+        }
+    }
+    return h->max;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,50 @@
+/************************************************************\
+ * Copyright 2026 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _UTIL_HIST_H
+#define _UTIL_HIST_H
+
+#include <stdint.h>
+
+/* Log-linear histogram of non-negative integers, in the style of
+ * HdrHistogram.  Values below HIST_SUB_BUCKETS are counted exactly.
+ * Larger values are counted in HIST_SUB_BUCKETS buckets per power of
+ * two, so a percentile is reported to within 1/HIST_SUB_BUCKETS of the
+ * true value.  Values larger than UINT32_MAX are counted as UINT32_MAX.
+ *
+ * Like tstat_t, a hist_t needs no allocation, and is reset by zeroing.
+ */
+#define HIST_SUB_BITS       3
+#define HIST_SUB_BUCKETS    (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS        ((32 - HIST_SUB_BITS + 1) * HIST_SUB_BUCKETS)
+
+typedef struct {
+    uint32_t counts[HIST_BUCKETS];
+    uint64_t n;
+    uint64_t sum;
+    uint32_t min, max;
+} hist_t;
+
+void hist_push (hist_t *h, uint64_t x);
+uint64_t hist_count (hist_t *h);
+uint32_t hist_min (hist_t *h);
+uint32_t hist_max (hist_t *h);
+double hist_mean (hist_t *h);
+
+/* Return the smallest value v such that at least 'p' percent of the
+ * values pushed are <= v, rounded up to the end of the bucket holding
+ * v (but no more than hist_max()).  Returns 0 if the histogram is empty.
+ */
+uint32_t hist_percentile (hist_t *h, double p);
+
+#endif /* !_UTIL_HIST_H */
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,169 @@
+/************************************************************\
+ * Copyright 2026 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/libutil/blake3.h"
+
+#define INPUT_MAX (1024*1024 + 1)
+
+/* Known answers from the BLAKE3 test vectors, where the input is
+ * a repeating sequence of bytes 0..250.
+ */
+struct vector {
+    size_t len;
+    const char *hash;
+} vectors[] = {
+    { 0,
+      "af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262" },
+    { 1,
+      "2d3adedff11b61f14c886e35afa036736dcd87a74d27b5c1510225d0f592e213" },
+    { 1024,
+      "42214739f095a406f3fc83deb889744ac00df831c10daa55189b5d121c855af7" },
+    { 1025,
+      "d00278ae47eb27b34faecf67b4fe263f82d5412916c1ffd97c8cb7fb814b8444" },
+    { 102400,
+      "bc3e3d41a1146b069abffad3c0d44860cf664390afce4d9661f7902e7943e085" },
+};
+
+/* Lengths around block, chunk, and subtree boundaries.
+ */
+size_t lengths[] = {
+    0, 1, 63, 64, 65, 1023, 1024, 1025, 2048, 2049, 3072, 3073, 4096, 4097,
+    8192, 8193, 16384, 16385, 31744, 65537, 102400, INPUT_MAX,
+};
+
+const char *impls[] = { "portable", "sse41", "avx2", "avx512" };
+
+static uint8_t *input;
+
+static void tohex (const uint8_t *hash, char *s)
+{
+    for (int i = 0; i < BLAKE3_OUT_LEN; i++)
+        sprintf (s + i * 2, "%02x", hash[i]);
+}
+
+static void hash_buf (const void *data, size_t len, uint8_t *hash)
+{
+    BLAKE3_CTX ctx;
+
+    blake3_init (&ctx);
+    blake3_update (&ctx, data, len);
+    blake3_final (&ctx, hash);
+}
+
+/* Hash in pieces of 'step' bytes to exercise the chunk state paths.
+ */
+static void hash_steps (const uint8_t *data,
+                        size_t len,
+                        size_t step,
+                        uint8_t *hash)
+{
+    BLAKE3_CTX ctx;
+
+    blake3_init (&ctx);
+    while (len > 0) {
+        size_t n = len < step ? len : step;
+        blake3_update (&ctx, data, n);
+        data += n;
+        len -= n;
+    }
+    blake3_final (&ctx, hash);
+}
+
+void test_vectors (void)
+{
+    uint8_t hash[BLAKE3_OUT_LEN];
+    char s[BLAKE3_OUT_LEN * 2 + 1];
+
+    for (int i = 0; i < sizeof (vectors) / sizeof (vectors[0]); i++) {
+        hash_buf (input, vectors[i].len, hash);
+        tohex (hash, s);
+        ok (strcmp (s, vectors[i].hash) == 0,
+            "%s: %zu byte input has expected hash",
+            blake3_get_impl (),
+            vectors[i].len);
+    }
+    hash_buf ("abc", 3, hash);
+    tohex (hash, s);
+    is (s, "6437b3ac38465133ffb63b75273a8db548c558465d79db03fd359c6cd5bd9d85",
+        "%s: abc has expected hash",
+        blake3_get_impl ());
+}
+
+/* Compare each kernel to the portable one, hashing all at once and
+ * in odd sized pieces.
+ */
+void test_impls (void)
+{
+    for (int i = 0; i < sizeof (impls) / sizeof (impls[0]); i++) {
+        bool match = true;
+
+        if (blake3_set_impl (impls[i]) < 0) {
+            diag ("%s is not supported on this CPU", impls[i]);
+            continue;
+        }
+        for (int j = 0; j < sizeof (lengths) / sizeof (lengths[0]); j++) {
+            uint8_t ref[BLAKE3_OUT_LEN];
+            uint8_t hash[BLAKE3_OUT_LEN];
+            uint8_t hash2[BLAKE3_OUT_LEN];
+
+            if (blake3_set_impl ("portable") < 0)
+                BAIL_OUT ("could not select portable implementation");
+            hash_steps (input, lengths[j], 7, ref);
+            if (blake3_set_impl (impls[i]) < 0)
+                BAIL_OUT ("could not select %s implementation", impls[i]);
+            hash_buf (input, lengths[j], hash);
+            hash_steps (input, lengths[j], 1000, hash2);
+            if (memcmp (hash, ref, BLAKE3_OUT_LEN) != 0
+                || memcmp (hash2, ref, BLAKE3_OUT_LEN) != 0) {
+                diag ("%s: %zu byte input hash mismatch", impls[i], lengths[j]);
+                match = false;
+            }
+        }
+        ok (match,
+            "%s: hashes match portable implementation", impls[i]);
+        test_vectors ();
+    }
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    if (!(input = malloc (INPUT_MAX)))
+        BAIL_OUT ("out of memory");
+    for (size_t i = 0; i < INPUT_MAX; i++)
+        input[i] = i % 251;
+
+    diag ("default implementation is %s", blake3_get_impl ());
+    test_vectors ();
+    test_impls ();
+
+    errno = 0;
+    ok (blake3_set_impl ("nerf") < 0 && errno == ENOENT,
+        "blake3_set_impl nerf fails with ENOENT");
+
+    free (input);
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,91 @@
+/************************************************************\
+ * Copyright 2026 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/libutil/bloom.h"
+
+void test_badargs (void)
+{
+    errno = 0;
+    ok (bloom_create (0, 0.01) == NULL && errno == EINVAL,
+        "bloom_create capacity=0 fails with EINVAL");
+    errno = 0;
+    ok (bloom_create (100, 0) == NULL && errno == EINVAL,
+        "bloom_create fp_rate=0 fails with EINVAL");
+    errno = 0;
+    ok (bloom_create (100, 1) == NULL && errno == EINVAL,
+        "bloom_create fp_rate=1 fails with EINVAL");
+    ok (bloom_test (NULL, "a", 1) == true,
+        "bloom_test b=NULL returns true");
+    lives_ok ({bloom_add (NULL, "a", 1);},
+        "bloom_add b=NULL doesn't crash");
+    lives_ok ({bloom_destroy (NULL);},
+        "bloom_destroy b=NULL doesn't crash");
+}
+
+void test_basic (void)
+{
+    const int n = 10000;
+    struct bloom *b;
+    char key[32];
+    int missing = 0;
+    int fp = 0;
+
+    b = bloom_create (n, 0.01);
+    ok (b != NULL,
+        "bloom_create capacity=%d fp_rate=0.01 works", n);
+    ok (bloom_capacity (b) == n,
+        "bloom_capacity returns %d", n);
+    ok (bloom_size (b) > 0 && bloom_size (b) < n * 2,
+        "bloom_size is %zu bytes", bloom_size (b));
+    for (int i = 0; i < n; i++) {
+        snprintf (key, sizeof (key), "key-%d", i);
+        bloom_add (b, key, strlen (key));
+    }
+    ok (bloom_count (b) == n,
+        "bloom_count returns %d", n);
+    for (int i = 0; i < n; i++) {
+        snprintf (key, sizeof (key), "key-%d", i);
+        if (!bloom_test (b, key, strlen (key)))
+            missing++;
+    }
+    ok (missing == 0,
+        "all added keys test positive");
+    for (int i = 0; i < n; i++) {
+        snprintf (key, sizeof (key), "nokey-%d", i);
+        if (bloom_test (b, key, strlen (key)))
+            fp++;
+    }
+    diag ("false positives: %d of %d", fp, n);
+    ok (fp < n * 0.02,
+        "false positive rate is near the configured rate");
+    bloom_destroy (b);
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_badargs ();
+    test_basic ();
+
+    done_testing ();
+    return 0;
+}
+
+// vi:ts=4 sw=4 expandtab
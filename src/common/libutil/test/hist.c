@@ -0,0 +1,127 @@
+/************************************************************\
+ * Copyright 2026 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/libutil/hist.h"
+
+void test_empty (void)
+{
+    hist_t h;
+
+    memset (&h, 0, sizeof (h));
+    ok (hist_count (&h) == 0,
+        "empty histogram has count 0");
+    ok (hist_percentile (&h, 50) == 0 && hist_percentile (&h, 100) == 0,
+        "empty histogram percentiles are 0");
+    ok (hist_mean (&h) == 0.,
+        "empty histogram mean is 0");
+}
+
+void test_small (void)
+{
+    hist_t h;
+
+    /* values below HIST_SUB_BUCKETS are exact */
+    memset (&h, 0, sizeof (h));
+    for (int i = 1; i <= 4; i++)
+        hist_push (&h, i);
+    ok (hist_count (&h) == 4,
+        "count is 4");
+    ok (hist_min (&h) == 1 && hist_max (&h) == 4,
+        "min and max are correct");
+    ok (hist_mean (&h) == 2.5,
+        "mean is 2.5");
+    ok (hist_percentile (&h, 25) == 1,
+        "p25 is 1");
+    ok (hist_percentile (&h, 50) == 2,
+        "p50 is 2");
+    ok (hist_percentile (&h, 100) == 4,
+        "p100 is 4");
+    ok (hist_percentile (&h, 0) == 1,
+        "p0 is the min");
+
+    /* p84 of 1..10 must cover 9 values, not the nearest rank 8 */
+    memset (&h, 0, sizeof (h));
+    for (int i = 1; i <= 10; i++)
+        hist_push (&h, i);
+    ok (hist_percentile (&h, 84) == 9,
+        "p84 of 1..10 is 9");
+    ok (hist_percentile (&h, 80) == 8,
+        "p80 of 1..10 is 8");
+    ok (hist_percentile (&h, 7) == 1,
+        "p7 of 1..10 is 1");
+}
+
+void test_range (void)
+{
+    hist_t h;
+    uint32_t p;
+    bool accurate = true;
+
+    /* 1..100000, each percentile is within 1/HIST_SUB_BUCKETS */
+    memset (&h, 0, sizeof (h));
+    for (int i = 1; i <= 100000; i++)
+        hist_push (&h, i);
+    for (int pct = 1; pct <= 100; pct++) {
+        uint32_t expected = pct * 1000;
+
+        p = hist_percentile (&h, pct);
+        if (p < expected || p > expected + expected / HIST_SUB_BUCKETS) {
+            diag ("p%d is %u, expected %u", pct, p, expected);
+            accurate = false;
+        }
+    }
+    ok (accurate,
+        "percentiles are accurate to within 1/%d", HIST_SUB_BUCKETS);
+    ok (hist_percentile (&h, 100) == 100000,
+        "p100 is the max");
+    ok (hist_mean (&h) == 50000.5,
+        "mean is correct");
+}
+
+void test_limits (void)
+{
+    hist_t h;
+
+    memset (&h, 0, sizeof (h));
+    hist_push (&h, UINT32_MAX);
+    hist_push (&h, (uint64_t)UINT32_MAX + 100);
+    ok (hist_max (&h) == UINT32_MAX,
+        "values above UINT32_MAX are counted as UINT32_MAX");
+    ok (hist_percentile (&h, 50) == UINT32_MAX,
+        "p50 of the largest values is UINT32_MAX");
+    hist_push (&h, 0);
+    ok (hist_min (&h) == 0 && hist_percentile (&h, 10) == 0,
+        "0 is counted");
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_empty ();
+    test_small ();
+    test_range ();
+    test_limits ();
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
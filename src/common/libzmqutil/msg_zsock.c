@@ -24,6 +24,7 @@
 #include "src/common/libutil/errno_safe.h"
 
 #include "sockopt.h"
+#include "mpart.h"
 #include "msg_zsock.h"
 
 int zmqutil_msg_send_ex (void *sock, const flux_msg_t *msg, bool nonblock)
@@ -67,6 +68,67 @@ int zmqutil_msg_send (void *sock, const flux_msg_t *msg)
     return zmqutil_msg_send_ex (sock, msg, false);
 }
 
+zlist_t *zmqutil_msg_encode (const flux_msg_t *msg)
+{
+    struct msg_iovec *iov = NULL;
+    int iovcnt;
+    uint8_t proto[PROTO_SIZE];
+    zlist_t *mpart = NULL;
+
+    if (!msg) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (msg_to_iovec (msg, proto, PROTO_SIZE, &iov, &iovcnt) < 0)
+        goto error;
+    if (!(mpart = mpart_create ()))
+        goto error;
+    for (int i = 0; i < iovcnt; i++) {
+        if (mpart_addmem (mpart, iov[i].data, iov[i].size) < 0)
+            goto error;
+    }
+    free (iov);
+    return mpart;
+error:
+    ERRNO_SAFE_WRAP (free, iov);
+    mpart_destroy (mpart);
+    return NULL;
+}
+
+int zmqutil_msg_send_routed (void *sock,
+                             const char *route,
+                             zlist_t *mpart,
+                             bool nonblock)
+{
+    int flags = nonblock ? ZMQ_DONTWAIT : 0;
+    zmq_msg_t *part;
+
+    if (!sock || !route || !mpart) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (zmq_send (sock, route, strlen (route), flags | ZMQ_SNDMORE) < 0)
+        return -1;
+    part = zlist_first (mpart);
+    while (part) {
+        zmq_msg_t *next = zlist_next (mpart);
+        int partflags = next ? flags | ZMQ_SNDMORE : flags;
+        zmq_msg_t copy;
+
+        /* zmq_msg_copy() shares the content of 'part' by reference,
+         * and zmq_msg_send() takes ownership of 'copy' on success.
+         */
+        (void)zmq_msg_init (&copy); // documented as always returning 0
+        if (zmq_msg_copy (&copy, part) < 0
+            || zmq_msg_send (&copy, sock, partflags) < 0) {
+            ERRNO_SAFE_WRAP (zmq_msg_close, &copy);
+            return -1;
+        }
+        part = next;
+    }
+    return 0;
+}
+
 flux_msg_t *zmqutil_msg_recv (void *sock)
 {
     struct msg_iovec *iov = NULL;
@@ -15,6 +15,7 @@
 #include <stdlib.h>
 
 #include "src/common/libflux/message.h"
+#include "src/common/libczmqcontainers/czmq_containers.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -26,6 +27,24 @@ extern "C" {
 int zmqutil_msg_send (void *dest, const flux_msg_t *msg);
 int zmqutil_msg_send_ex (void *dest, const flux_msg_t *msg, bool nonblock);
 
+/* Encode message once, as a multi-part message (see mpart.h) that may
+ * be sent to any number of ROUTER socket peers with
+ * zmqutil_msg_send_routed().  Destroy with mpart_destroy().
+ * Returns multi-part message on success, NULL on failure with errno set.
+ */
+zlist_t *zmqutil_msg_encode (const flux_msg_t *msg);
+
+/* Send multi-part message from zmqutil_msg_encode() to the ROUTER socket
+ * peer 'route', as if 'route' had been pushed onto the encoded message.
+ * The frames are shared with zeromq by reference rather than copied, and
+ * 'mpart' is unchanged, so it may be sent again to another peer.
+ * Returns 0 on success, -1 on failure with errno set.
+ */
+int zmqutil_msg_send_routed (void *dest,
+                             const char *route,
+                             zlist_t *mpart,
+                             bool nonblock);
+
 /* Receive a message from zeromq socket.
  * Returns message on success, NULL on failure with errno set.
  */
@@ -15,9 +15,11 @@
 #include <zmq.h>
 #include <errno.h>
 #include <stdio.h>
+#include <string.h>
 #include <flux/core.h>
 
 #include "src/common/libzmqutil/msg_zsock.h"
+#include "src/common/libzmqutil/mpart.h"
 #include "src/common/libtap/tap.h"
 #include "ccan/str/str.h"
 
@@ -84,6 +86,80 @@ void check_sendzsock (void)
     zmq_close (zsock[1]);
 }
 
+void check_send_routed (void)
+{
+    void *router;
+    void *dealer[2];
+    const char *id[2] = { "peer0", "peer1" };
+    const char *uri = "inproc://test-routed";
+    flux_msg_t *msg, *msg2;
+    zlist_t *mpart;
+    const char *topic;
+    const char *s;
+    int type;
+
+    ok ((router = zmq_socket (zctx, ZMQ_ROUTER)) != NULL
+        && zsetsockopt_int (router, ZMQ_LINGER, 5) == 0
+        && zsetsockopt_int (router, ZMQ_ROUTER_MANDATORY, 1) == 0
+        && zmq_bind (router, uri) == 0,
+        "bound inproc ROUTER socket");
+    for (int i = 0; i < 2; i++) {
+        if (!(dealer[i] = zmq_socket (zctx, ZMQ_DEALER))
+            || zsetsockopt_int (dealer[i], ZMQ_LINGER, 5) < 0
+            || zsetsockopt_str (dealer[i], ZMQ_IDENTITY, id[i]) < 0
+            || zmq_connect (dealer[i], uri) < 0)
+            BAIL_OUT ("could not connect DEALER socket");
+    }
+
+    ok ((msg = flux_msg_create (FLUX_MSGTYPE_EVENT)) != NULL
+            && flux_msg_set_topic (msg, "foo.bar") == 0
+            && flux_msg_set_string (msg, "baz") == 0,
+        "created test message");
+    flux_msg_route_enable (msg);
+
+    ok (zmqutil_msg_encode (NULL) == NULL && errno == EINVAL,
+        "zmqutil_msg_encode msg=NULL fails with EINVAL");
+    ok ((mpart = zmqutil_msg_encode (msg)) != NULL,
+        "zmqutil_msg_encode works");
+    errno = 0;
+    ok (zmqutil_msg_send_routed (NULL, id[0], mpart, false) < 0
+        && errno == EINVAL,
+        "zmqutil_msg_send_routed dest=NULL fails with EINVAL");
+    errno = 0;
+    ok (zmqutil_msg_send_routed (router, NULL, mpart, false) < 0
+        && errno == EINVAL,
+        "zmqutil_msg_send_routed route=NULL fails with EINVAL");
+    errno = 0;
+    ok (zmqutil_msg_send_routed (router, id[0], NULL, false) < 0
+        && errno == EINVAL,
+        "zmqutil_msg_send_routed mpart=NULL fails with EINVAL");
+
+    for (int i = 0; i < 2; i++) {
+        ok (zmqutil_msg_send_routed (router, id[i], mpart, false) == 0,
+            "zmqutil_msg_send_routed to %s works", id[i]);
+        ok ((msg2 = zmqutil_msg_recv (dealer[i])) != NULL,
+            "%s received the message", id[i]);
+        ok (flux_msg_get_type (msg2, &type) == 0
+            && type == FLUX_MSGTYPE_EVENT
+            && flux_msg_get_topic (msg2, &topic) == 0
+            && streq (topic, "foo.bar")
+            && flux_msg_get_string (msg2, &s) == 0
+            && streq (s, "baz"),
+            "%s: decoded message looks like what was sent", id[i]);
+        flux_msg_destroy (msg2);
+    }
+    ok (zmqutil_msg_send_routed (router, "nopeer", mpart, false) < 0
+        && errno == EHOSTUNREACH,
+        "zmqutil_msg_send_routed to unknown peer fails with EHOSTUNREACH");
+
+    mpart_destroy (mpart);
+    flux_msg_destroy (msg);
+
+    zmq_close (dealer[0]);
+    zmq_close (dealer[1]);
+    zmq_close (router);
+}
+
 int main (int argc, char *argv[])
 {
     plan (NO_PLAN);
@@ -92,6 +168,7 @@ int main (int argc, char *argv[])
         BAIL_OUT ("could not create zeromq context");
 
     check_sendzsock ();
+    check_send_routed ();
 
     zmq_ctx_term (zctx);
 
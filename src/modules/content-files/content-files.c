@@ -23,6 +23,9 @@
  * content-backing.store:
  * Given a blob, store it and return its hash
  *
+ * (Also content-backing.has, .list and .remove, used by flux-restore(1)
+ * and the content garbage collector.)
+ *
  * content-backing.checkpoint-get:
  * Given a string key, lookup string value and return it or a "not found" error.
  *
@@ -47,11 +50,19 @@
  *
  * Once loaded this module can also be exercised directly using
  * flux-content(1) with the --bypass-cache option.
+ *
+ * With the "pack" module option, blobs are instead appended to a small
+ * number of large segment files under content.files/pack (see packdb.c),
+ * which avoids the per-blob inode and open/close overhead.  Segments with
+ * little live data are compacted periodically.  Checkpoints remain
+ * individual files in either mode.
  */
 
 #if HAVE_CONFIG_H
 #include "config.h"
 #endif
+#include <sys/types.h>
+#include <dirent.h>
 #include <flux/core.h>
 #include <jansson.h>
 
@@ -59,11 +70,27 @@
 #include "src/common/libutil/log.h"
 #include "src/common/libutil/dirwalk.h"
 #include "src/common/libutil/unlink_recursive.h"
+#include "src/common/libutil/parse_size.h"
 #include "ccan/str/str.h"
 
 #include "src/common/libcontent/content-util.h"
 
 #include "filedb.h"
+#include "packdb.h"
+
+static const char *default_segment_size = "256M";
+
+/* Look for a sparse segment to compact once per timer period.  While a
+ * segment is being compacted, copy a limited number of records per
+ * reactor loop iteration so requests are not held up behind it.
+ */
+static const double compact_period = 10.;
+static const double compact_min_live_ratio = 0.5;
+static const int compact_max_records = 64;
+
+/* Maximum number of hashes returned by one content-backing.list request.
+ */
+static const int list_limit = 1024;
 
 struct content_files {
     flux_msg_handler_t **handlers;
@@ -71,8 +98,14 @@ struct content_files {
     flux_t *h;
     char *hashfun;
     int hash_size;
+    struct packdb *pack;
+    flux_watcher_t *compact_w;
+    uint8_t *list;              // sorted digests for content-backing.list
+    int list_count;
 };
 
+static int list_hash_size;
+
 static int file_count_cb (dirwalk_t *d, void *arg)
 {
     int *count = arg;
@@ -98,6 +131,22 @@ static void stats_get_cb (flux_t *h,
     struct content_files *ctx = arg;
     int count;
 
+    if (ctx->pack) {
+        struct packdb_stats stats;
+
+        packdb_get_stats (ctx->pack, &stats);
+        if (flux_respond_pack (h,
+                               msg,
+                               "{s:i s:{s:i s:I s:I s:i}}",
+                               "object_count", stats.object_count,
+                               "pack",
+                                 "segment_count", stats.segment_count,
+                                 "total_bytes", (json_int_t)stats.total_bytes,
+                                 "live_bytes", (json_int_t)stats.live_bytes,
+                                 "compactions", stats.compactions) < 0)
+            flux_log_error (h, "error responding to stats-get request");
+        return;
+    }
     if ((count = get_object_count (ctx->dbpath)) < 0)
         goto error;
 
@@ -134,6 +183,11 @@ static void load_cb (flux_t *h,
         errno = EPROTO;
         goto error;
     }
+    if (ctx->pack) {
+        if (packdb_get (ctx->pack, hash, hash_size, &data, &size) < 0)
+            goto error;
+        goto done;
+    }
     if (blobref_hashtostr (ctx->hashfun,
                            hash,
                            hash_size,
@@ -142,6 +196,7 @@ static void load_cb (flux_t *h,
         goto error;
     if (filedb_get (ctx->dbpath, blobref, &data, &size, &errstr) < 0)
         goto error;
+done:
     if (flux_respond_raw (h, msg, data, size) < 0)
         flux_log_error (h, "error responding to load request");
     free (data);
@@ -152,6 +207,244 @@ error:
     free (data);
 }
 
+/* Handle a content-backing.has request from the rank 0 broker's
+ * content-cache service.  The raw request payload is an array of hash
+ * digests.  The raw response payload is an array of bytes, one per digest,
+ * set to 1 if the blob is stored, or 0 if it is not.
+ */
+static void has_cb (flux_t *h,
+                    flux_msg_handler_t *mh,
+                    const flux_msg_t *msg,
+                    void *arg)
+{
+    struct content_files *ctx = arg;
+    const uint8_t *hashes;
+    size_t size;
+    char blobref[BLOBREF_MAX_STRING_SIZE];
+    char *result = NULL;
+    int count;
+    int i;
+    const char *errstr = NULL;
+
+    if (flux_request_decode_raw (msg, NULL, (const void **)&hashes, &size) < 0)
+        goto error;
+    if (size == 0 || size % ctx->hash_size != 0) {
+        errno = EPROTO;
+        goto error;
+    }
+    count = size / ctx->hash_size;
+    if (!(result = calloc (1, count)))
+        goto error;
+    for (i = 0; i < count; i++) {
+        const uint8_t *hash = hashes + i * ctx->hash_size;
+        int rc;
+
+        if (ctx->pack)
+            rc = packdb_has (ctx->pack, hash, ctx->hash_size);
+        else if (blobref_hashtostr (ctx->hashfun,
+                                    hash,
+                                    ctx->hash_size,
+                                    blobref,
+                                    sizeof (blobref)) < 0)
+            rc = -1;
+        else
+            rc = filedb_has (ctx->dbpath, blobref, &errstr);
+        if (rc < 0)
+            goto error;
+        result[i] = rc;
+    }
+    if (flux_respond_raw (h, msg, result, count) < 0)
+        flux_log_error (h, "error responding to has request");
+    free (result);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, errstr) < 0)
+        flux_log_error (h, "error responding to has request");
+    free (result);
+}
+
+static int hash_compare (const void *a, const void *b)
+{
+    return memcmp (a, b, list_hash_size);
+}
+
+/* Take a sorted snapshot of the digests of all stored blobs.
+ */
+static int list_snapshot (struct content_files *ctx)
+{
+    void *hashes = NULL;
+    int count = 0;
+
+    if (ctx->pack) {
+        if (packdb_hashes (ctx->pack, &hashes, &count) < 0)
+            return -1;
+    }
+    else {
+        DIR *dir;
+        struct dirent *ent;
+        int alloc = 0;
+        uint8_t hash[BLOBREF_MAX_DIGEST_SIZE];
+
+        if (!(dir = opendir (ctx->dbpath)))
+            return -1;
+        while ((ent = readdir (dir))) {
+            if (blobref_strtohash (ent->d_name,
+                                   hash,
+                                   sizeof (hash)) != ctx->hash_size)
+                continue; // e.g. checkpoint files
+            if (count == alloc) {
+                void *new;
+                alloc = alloc ? alloc * 2 : 1024;
+                if (!(new = realloc (hashes, alloc * ctx->hash_size))) {
+                    free (hashes);
+                    closedir (dir);
+                    return -1;
+                }
+                hashes = new;
+            }
+            memcpy ((uint8_t *)hashes + count++ * ctx->hash_size,
+                    hash,
+                    ctx->hash_size);
+        }
+        closedir (dir);
+    }
+    list_hash_size = ctx->hash_size;
+    qsort (hashes, count, ctx->hash_size, hash_compare);
+    free (ctx->list);
+    ctx->list = hashes;
+    ctx->list_count = count;
+    return 0;
+}
+
+/* Handle a content-backing.list request from the content garbage collector.
+ * The raw request payload is a hash digest cursor, or empty to start from
+ * the beginning.  The raw response payload is the digests of up to
+ * 'list_limit' stored blobs that follow the cursor in sorted order,
+ * or empty when there are no more.  The listing is taken from a snapshot
+ * made when the cursor is empty.
+ */
+static void list_cb (flux_t *h,
+                     flux_msg_handler_t *mh,
+                     const flux_msg_t *msg,
+                     void *arg)
+{
+    struct content_files *ctx = arg;
+    const void *cursor;
+    size_t cursor_size;
+    int lo = 0;
+    int count;
+
+    if (flux_request_decode_raw (msg, NULL, &cursor, &cursor_size) < 0)
+        goto error;
+    if (cursor_size != 0 && cursor_size != ctx->hash_size) {
+        errno = EPROTO;
+        goto error;
+    }
+    if (cursor_size == 0 || !ctx->list) {
+        if (list_snapshot (ctx) < 0)
+            goto error;
+    }
+    if (cursor_size > 0) { // find first digest > cursor
+        int hi = ctx->list_count;
+        while (lo < hi) {
+            int mid = lo + (hi - lo) / 2;
+            if (memcmp (ctx->list + mid * ctx->hash_size,
+                        cursor,
+                        ctx->hash_size) <= 0)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+    }
+    count = ctx->list_count - lo;
+    if (count > list_limit)
+        count = list_limit;
+    if (flux_respond_raw (h,
+                          msg,
+                          ctx->list + lo * ctx->hash_size,
+                          count * ctx->hash_size) < 0)
+        flux_log_error (h, "error responding to list request");
+    if (count == 0) {
+        free (ctx->list);
+        ctx->list = NULL;
+        ctx->list_count = 0;
+    }
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "error responding to list request");
+}
+
+/* Handle a content-backing.remove request from the content garbage
+ * collector.  The raw request payload is an array of hash digests.
+ * The response reports the number of blobs and bytes that were removed.
+ * In pack mode, space is reclaimed later by segment compaction.
+ */
+static void remove_cb (flux_t *h,
+                       flux_msg_handler_t *mh,
+                       const flux_msg_t *msg,
+                       void *arg)
+{
+    struct content_files *ctx = arg;
+    const uint8_t *hashes;
+    size_t size;
+    char blobref[BLOBREF_MAX_STRING_SIZE];
+    int count = 0;
+    json_int_t total = 0;
+    int i;
+    const char *errstr = NULL;
+
+    if (flux_request_decode_raw (msg, NULL, (const void **)&hashes, &size) < 0)
+        goto error;
+    if (size % ctx->hash_size != 0) {
+        errno = EPROTO;
+        goto error;
+    }
+    for (i = 0; i < size / ctx->hash_size; i++) {
+        const uint8_t *hash = hashes + i * ctx->hash_size;
+        size_t bytes;
+
+        if (ctx->pack) {
+            struct packdb_stats before;
+            struct packdb_stats after;
+
+            packdb_get_stats (ctx->pack, &before);
+            if (packdb_delete (ctx->pack, hash, ctx->hash_size) < 0) {
+                if (errno == ENOENT)
+                    continue;
+                goto error;
+            }
+            packdb_get_stats (ctx->pack, &after);
+            bytes = before.live_bytes - after.live_bytes;
+        }
+        else {
+            if (blobref_hashtostr (ctx->hashfun,
+                                   hash,
+                                   ctx->hash_size,
+                                   blobref,
+                                   sizeof (blobref)) < 0)
+                goto error;
+            if (filedb_remove (ctx->dbpath, blobref, &bytes, &errstr) < 0) {
+                if (errno == ENOENT)
+                    continue;
+                goto error;
+            }
+        }
+        count++;
+        total += bytes;
+    }
+    if (flux_respond_pack (h,
+                           msg,
+                           "{s:i s:I}",
+                           "count", count,
+                           "bytes", total) < 0)
+        flux_log_error (h, "error responding to remove request");
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, errstr) < 0)
+        flux_log_error (h, "error responding to remove request");
+}
+
 /* Handle a content-backing.store request from the rank 0 broker's
  * content-cache service.  The raw request payload is the blob content.
  * The raw response payload is hash digest.
@@ -178,6 +471,11 @@ void store_cb (flux_t *h,
                                        hash,
                                        sizeof (hash))) < 0)
         goto error;
+    if (ctx->pack) {
+        if (packdb_put (ctx->pack, hash, hash_size, data, size) < 0)
+            goto error;
+        goto done;
+    }
     if (blobref_hashtostr (ctx->hashfun,
                            hash,
                            hash_size,
@@ -186,6 +484,7 @@ void store_cb (flux_t *h,
         goto error;
     if (filedb_put (ctx->dbpath, blobref, data, size, &errstr) < 0)
         goto error;
+done:
     if (flux_respond_raw (h, msg, hash, hash_size) < 0)
         flux_log_error (h, "error responding to store request");
     return;
@@ -279,6 +578,23 @@ error:
     free (value);
 }
 
+static void compact_cb (flux_reactor_t *r,
+                        flux_watcher_t *w,
+                        int revents,
+                        void *arg)
+{
+    struct content_files *ctx = arg;
+    int rc;
+
+    if ((rc = packdb_compact (ctx->pack,
+                              compact_min_live_ratio,
+                              compact_max_records)) < 0)
+        flux_log_error (ctx->h, "error compacting pack segment");
+    flux_watcher_stop (w);
+    flux_timer_watcher_reset (w, rc > 0 ? 0. : compact_period, 0.);
+    flux_watcher_start (w);
+}
+
 /* Destroy module context.
  */
 static void content_files_destroy (struct content_files *ctx)
@@ -286,6 +602,9 @@ static void content_files_destroy (struct content_files *ctx)
     if (ctx) {
         int saved_errno = errno;
         flux_msg_handler_delvec (ctx->handlers);
+        flux_watcher_destroy (ctx->compact_w);
+        packdb_close (ctx->pack);
+        free (ctx->list);
         free (ctx->dbpath);
         free (ctx->hashfun);
         free (ctx);
@@ -299,6 +618,9 @@ static void content_files_destroy (struct content_files *ctx)
 static const struct flux_msg_handler_spec htab[] = {
     { FLUX_MSGTYPE_REQUEST, "content-backing.load",    load_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "content-backing.store",   store_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "content-backing.has",     has_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "content-backing.list",    list_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "content-backing.remove",  remove_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "content-backing.checkpoint-get", checkpoint_get_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "content-backing.checkpoint-put", checkpoint_put_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "content-files.stats-get",
@@ -308,7 +630,10 @@ static const struct flux_msg_handler_spec htab[] = {
 
 /* Create module context and perform some initialization.
  */
-static struct content_files *content_files_create (flux_t *h, bool truncate)
+static struct content_files *content_files_create (flux_t *h,
+                                                   bool truncate,
+                                                   bool pack,
+                                                   uint64_t segment_size)
 {
     struct content_files *ctx;
     const char *dbdir;
@@ -347,6 +672,26 @@ static struct content_files *content_files_create (flux_t *h, bool truncate)
         flux_log_error (h, "could not create %s", ctx->dbpath);
         goto error;
     }
+    if (pack) {
+        char path[1024];
+
+        if (snprintf (path, sizeof (path), "%s/pack", ctx->dbpath)
+            >= sizeof (path)) {
+            errno = EOVERFLOW;
+            goto error;
+        }
+        if (!(ctx->pack = packdb_open (path, ctx->hash_size, segment_size))) {
+            flux_log_error (h, "could not open %s", path);
+            goto error;
+        }
+        if (!(ctx->compact_w = flux_timer_watcher_create (flux_get_reactor (h),
+                                                          compact_period,
+                                                          0.,
+                                                          compact_cb,
+                                                          ctx)))
+            goto error;
+        flux_watcher_start (ctx->compact_w);
+    }
     if (flux_msg_handler_addvec (h, htab, ctx, &ctx->handlers) < 0)
         goto error;
     return ctx;
@@ -359,7 +704,9 @@ static int parse_args (flux_t *h,
                        int argc,
                        char **argv,
                        bool *testing,
-                       bool *truncate)
+                       bool *truncate,
+                       bool *pack,
+                       uint64_t *segment_size)
 {
     int i;
     for (i = 0; i < argc; i++) {
@@ -367,6 +714,16 @@ static int parse_args (flux_t *h,
             *testing = true;
         else if (streq (argv[i], "truncate"))
             *truncate = true;
+        else if (streq (argv[i], "pack"))
+            *pack = true;
+        else if (strstarts (argv[i], "segment-size=")) {
+            if (parse_size (argv[i] + 13, segment_size) < 0
+                || *segment_size == 0) {
+                flux_log (h, LOG_ERR, "Invalid segment-size: %s", argv[i]);
+                errno = EINVAL;
+                return -1;
+            }
+        }
         else {
             flux_log (h, LOG_ERR, "Unknown module option: %s", argv[i]);
             errno = EINVAL;
@@ -393,11 +750,21 @@ int mod_main (flux_t *h, int argc, char **argv)
     struct content_files *ctx;
     bool testing = false;
     bool truncate = false;
+    bool pack = false;
+    uint64_t segment_size;
     int rc = -1;
 
-    if (parse_args (h, argc, argv, &testing, &truncate) < 0)
+    if (parse_size (default_segment_size, &segment_size) < 0)
+        return -1;
+    if (parse_args (h,
+                    argc,
+                    argv,
+                    &testing,
+                    &truncate,
+                    &pack,
+                    &segment_size) < 0)
         return -1;
-    if (!(ctx = content_files_create (h, truncate))) {
+    if (!(ctx = content_files_create (h, truncate, pack, segment_size))) {
         flux_log_error (h, "content_files_create failed");
         return -1;
     }
@@ -66,6 +66,59 @@ int filedb_get (const char *dbpath,
     return 0;
 }
 
+int filedb_has (const char *dbpath, const char *key, const char **errstr)
+{
+    char path[1024];
+
+    if (strlen (key) == 0 || strchr (key, '/') || streq (key, "..")
+                          || streq (key, ".")) {
+        errno = EINVAL;
+        if (errstr)
+            *errstr = "invalid key name";
+        return -1;
+    }
+    if (snprintf (path, sizeof (path), "%s/%s", dbpath, key) >= sizeof (path)) {
+        errno = EOVERFLOW;
+        if (errstr)
+            *errstr = "key name too long for internal buffer";
+        return -1;
+    }
+    if (access (path, F_OK) < 0) {
+        if (errno == ENOENT)
+            return 0;
+        return -1;
+    }
+    return 1;
+}
+
+int filedb_remove (const char *dbpath,
+                   const char *key,
+                   size_t *sizep,
+                   const char **errstr)
+{
+    char path[1024];
+    struct stat sb;
+
+    if (strlen (key) == 0 || strchr (key, '/') || streq (key, "..")
+                          || streq (key, ".")) {
+        errno = EINVAL;
+        if (errstr)
+            *errstr = "invalid key name";
+        return -1;
+    }
+    if (snprintf (path, sizeof (path), "%s/%s", dbpath, key) >= sizeof (path)) {
+        errno = EOVERFLOW;
+        if (errstr)
+            *errstr = "key name too long for internal buffer";
+        return -1;
+    }
+    if (stat (path, &sb) < 0 || unlink (path) < 0)
+        return -1;
+    if (sizep)
+        *sizep = sb.st_size;
+    return 0;
+}
+
 int filedb_put (const char *dbpath,
                 const char *key,
                 const void *data,
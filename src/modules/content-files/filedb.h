@@ -24,6 +24,19 @@ int filedb_get (const char *dbpath,
                 size_t *sizep,
                 const char **errstr);
 
+/* Check whether file named 'key' exists in the dbpath directory.
+ * Returns 1 if it exists, 0 if not, or -1 on failure with errno set.
+ */
+int filedb_has (const char *dbpath, const char *key, const char **errstr);
+
+/* Remove file named 'key' from the dbpath directory.  On success, 'sizep'
+ * (if non-NULL) is assigned the size of the removed file and 0 is returned.
+ * On failure, -1 is returned with errno set (ENOENT if not found).
+ */
+int filedb_remove (const char *dbpath,
+                   const char *key,
+                   size_t *sizep,
+                   const char **errstr);
 
 /* Put file named 'key' with content 'data' and length 'size' to the
  * dbpath directory.  On success, 0 is returned.
@@ -0,0 +1,982 @@
+/************************************************************\
+ * Copyright 2026 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* packdb.c - log-structured blob store
+ *
+ * Blobs are appended to large segment files named <id>.pack, where <id>
+ * is an 8 digit hex number that increases as segments are added.
+ * Only the segment with the highest id (the active segment) is appended to.
+ * Each record consists of a fixed size header, the hash digest, and the
+ * blob data.  A deletion is recorded by appending a header with type
+ * PACK_RECORD_DELETE and no data.
+ *
+ * An in-memory hash maps digests to (segment, offset, size).  It is rebuilt
+ * at open time by replaying segments in id order.  To avoid reading every
+ * record header of a large store, an index file named <id>.idx is written
+ * when a segment is sealed (a new active segment is started) and when
+ * the store is closed.  The index covers a prefix of the segment, and any
+ * segment content beyond that prefix is scanned.
+ *
+ * Live bytes are tracked per segment.  packdb_compact() copies the live
+ * records of a sparse sealed segment into the active segment, a bounded
+ * number of records per call so the caller is not blocked for the time it
+ * takes to rewrite a whole segment.  Deletion records are carried forward
+ * if the blob is still absent, since a copy of it may remain in an older
+ * segment.  Once the last record has been copied, the segments written to
+ * are flushed to disk along with their index files and the directory, and
+ * only then is the compacted segment unlinked.  If the store is interrupted
+ * during compaction, the duplicate records that result are harmless: the
+ * one replayed last wins.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "src/common/libczmqcontainers/czmq_containers.h"
+#include "src/common/libutil/blobref.h"
+#include "src/common/libutil/errno_safe.h"
+#include "ccan/str/str.h"
+
+#include "packdb.h"
+
+#define PACK_RECORD_MAGIC   0x706b7263  // "pkrc"
+#define PACK_INDEX_MAGIC    0x706b6978  // "pkix"
+#define PACK_INDEX_VERSION  1
+
+enum {
+    PACK_RECORD_BLOB = 1,
+    PACK_RECORD_DELETE = 2,
+};
+
+struct pack_record_hdr {
+    uint32_t magic;
+    uint32_t type;
+    uint32_t hash_size;
+    uint32_t size;
+};
+
+struct pack_index_hdr {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t hash_size;
+    uint32_t count;
+    uint64_t covered;           // segment bytes described by the index
+};
+
+struct pack_index_entry {
+    uint32_t type;
+    uint32_t size;
+    uint64_t offset;
+    /* followed by hash digest */
+};
+
+struct segment {
+    uint32_t id;
+    int fd;
+    uint64_t size;
+    uint64_t live;              // bytes in live blob records
+};
+
+struct pack_entry {
+    uint8_t hash[BLOBREF_MAX_DIGEST_SIZE]; // zero padded zhashx key
+    struct segment *seg;
+    uint64_t offset;
+    uint32_t size;
+};
+
+struct packdb {
+    char *path;
+    int hash_size;
+    uint64_t segment_size;
+    struct segment **segs;      // sorted by id, last is active
+    int nsegs;
+    zhashx_t *index;            // hash => struct pack_entry
+    int compactions;
+    struct segment *compact_seg;    // segment being compacted, if any
+    uint64_t compact_offset;        // next record of compact_seg to copy
+    uint32_t compact_dest_id;       // first segment copied into
+};
+
+static size_t pack_entry_hasher (const void *key)
+{
+    size_t h;
+    memcpy (&h, key, sizeof (h));
+    return h;
+}
+
+static int pack_entry_comparator (const void *item1, const void *item2)
+{
+    return memcmp (item1, item2, BLOBREF_MAX_DIGEST_SIZE);
+}
+
+static void pack_entry_destructor (void **item)
+{
+    if (item) {
+        free (*item);
+        *item = NULL;
+    }
+}
+
+static uint64_t record_size (struct packdb *db, uint32_t size)
+{
+    return sizeof (struct pack_record_hdr) + db->hash_size + size;
+}
+
+static int segment_path (struct packdb *db,
+                         uint32_t id,
+                         const char *suffix,
+                         char *buf,
+                         size_t bufsize)
+{
+    if (snprintf (buf,
+                  bufsize,
+                  "%s/%08x.%s",
+                  db->path,
+                  (unsigned int)id,
+                  suffix) >= bufsize) {
+        errno = EOVERFLOW;
+        return -1;
+    }
+    return 0;
+}
+
+static ssize_t pread_all (int fd, void *buf, size_t len, off_t offset)
+{
+    size_t count = 0;
+    ssize_t n;
+
+    while (count < len) {
+        if ((n = pread (fd, (char *)buf + count, len - count, offset + count))
+            < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        if (n == 0)
+            break;
+        count += n;
+    }
+    return count;
+}
+
+static int pwrite_all (int fd, const void *buf, size_t len, off_t offset)
+{
+    size_t count = 0;
+    ssize_t n;
+
+    while (count < len) {
+        if ((n = pwrite (fd,
+                         (const char *)buf + count,
+                         len - count,
+                         offset + count)) < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        count += n;
+    }
+    return 0;
+}
+
+static void segment_destroy (struct segment *seg)
+{
+    if (seg) {
+        int saved_errno = errno;
+        if (seg->fd >= 0)
+            (void)close (seg->fd);
+        free (seg);
+        errno = saved_errno;
+    }
+}
+
+static struct segment *segment_open (struct packdb *db, uint32_t id)
+{
+    char path[1024];
+    struct segment *seg;
+    struct stat sb;
+
+    if (segment_path (db, id, "pack", path, sizeof (path)) < 0)
+        return NULL;
+    if (!(seg = calloc (1, sizeof (*seg))))
+        return NULL;
+    seg->id = id;
+    if ((seg->fd = open (path, O_RDWR | O_CREAT | O_CLOEXEC, 0666)) < 0
+        || fstat (seg->fd, &sb) < 0)
+        goto error;
+    seg->size = sb.st_size;
+    return seg;
+error:
+    segment_destroy (seg);
+    return NULL;
+}
+
+static int segment_append_list (struct packdb *db, struct segment *seg)
+{
+    struct segment **segs;
+
+    if (!(segs = realloc (db->segs, sizeof (segs[0]) * (db->nsegs + 1))))
+        return -1;
+    segs[db->nsegs++] = seg;
+    db->segs = segs;
+    return 0;
+}
+
+static struct segment *active_segment (struct packdb *db)
+{
+    return db->segs[db->nsegs - 1];
+}
+
+static void pack_key (struct packdb *db, const void *hash, uint8_t *key)
+{
+    memset (key, 0, BLOBREF_MAX_DIGEST_SIZE);
+    memcpy (key, hash, db->hash_size);
+}
+
+/* Apply one record to the in-memory index during replay or append.
+ */
+static int apply_record (struct packdb *db,
+                         struct segment *seg,
+                         uint32_t type,
+                         const void *hash,
+                         uint64_t offset,
+                         uint32_t size)
+{
+    uint8_t key[BLOBREF_MAX_DIGEST_SIZE];
+    struct pack_entry *e;
+
+    pack_key (db, hash, key);
+    e = zhashx_lookup (db->index, key);
+    if (e) {
+        e->seg->live -= record_size (db, e->size);
+        if (type == PACK_RECORD_DELETE) {
+            zhashx_delete (db->index, key);
+            return 0;
+        }
+    }
+    else {
+        if (type == PACK_RECORD_DELETE)
+            return 0;
+        if (!(e = calloc (1, sizeof (*e))))
+            return -1;
+        memcpy (e->hash, key, sizeof (e->hash));
+        if (zhashx_insert (db->index, e->hash, e) < 0) {
+            free (e);
+            errno = EEXIST;
+            return -1;
+        }
+    }
+    e->seg = seg;
+    e->offset = offset;
+    e->size = size;
+    seg->live += record_size (db, size);
+    return 0;
+}
+
+/* Load the index file for 'seg', if any.  On success, set *covered to the
+ * number of segment bytes described by it.  A missing, stale, or damaged
+ * index is not an error - the segment is simply scanned from the start.
+ */
+static int load_index (struct packdb *db,
+                       struct segment *seg,
+                       uint64_t *covered)
+{
+    char path[1024];
+    struct pack_index_hdr hdr;
+    size_t entsize = sizeof (struct pack_index_entry) + db->hash_size;
+    uint8_t *buf = NULL;
+    int fd = -1;
+    uint32_t i;
+
+    *covered = 0;
+    if (segment_path (db, seg->id, "idx", path, sizeof (path)) < 0
+        || (fd = open (path, O_RDONLY | O_CLOEXEC)) < 0)
+        return 0;
+    if (pread_all (fd, &hdr, sizeof (hdr), 0) != sizeof (hdr)
+        || hdr.magic != PACK_INDEX_MAGIC
+        || hdr.version != PACK_INDEX_VERSION
+        || hdr.hash_size != db->hash_size
+        || hdr.covered > seg->size)
+        goto out;
+    if (!(buf = malloc (entsize * hdr.count + 1)))
+        goto nomem;
+    if (pread_all (fd, buf, entsize * hdr.count, sizeof (hdr))
+        != entsize * hdr.count)
+        goto out;
+    for (i = 0; i < hdr.count; i++) {
+        struct pack_index_entry ent;
+        uint8_t *p = buf + entsize * i;
+
+        memcpy (&ent, p, sizeof (ent));
+        if (ent.offset + record_size (db, ent.size) > hdr.covered)
+            goto out;
+    }
+    for (i = 0; i < hdr.count; i++) {
+        struct pack_index_entry ent;
+        uint8_t *p = buf + entsize * i;
+
+        memcpy (&ent, p, sizeof (ent));
+        if (apply_record (db,
+                          seg,
+                          ent.type,
+                          p + sizeof (ent),
+                          ent.offset,
+                          ent.size) < 0)
+            goto nomem;
+    }
+    *covered = hdr.covered;
+out:
+    free (buf);
+    (void)close (fd);
+    return 0;
+nomem:
+    ERRNO_SAFE_WRAP (free, buf);
+    ERRNO_SAFE_WRAP (close, fd);
+    return -1;
+}
+
+/* Read the record header and digest at 'offset' in 'seg'.
+ * Returns 1 on success, 0 if there is no complete, valid record there.
+ */
+static int read_record (struct packdb *db,
+                        struct segment *seg,
+                        uint64_t offset,
+                        struct pack_record_hdr *hdr,
+                        uint8_t *hash)
+{
+    if (offset + sizeof (*hdr) > seg->size
+        || pread_all (seg->fd, hdr, sizeof (*hdr), offset) != sizeof (*hdr)
+        || hdr->magic != PACK_RECORD_MAGIC
+        || hdr->hash_size != db->hash_size
+        || (hdr->type != PACK_RECORD_BLOB && hdr->type != PACK_RECORD_DELETE)
+        || offset + record_size (db, hdr->size) > seg->size
+        || pread_all (seg->fd,
+                      hash,
+                      db->hash_size,
+                      offset + sizeof (*hdr)) != db->hash_size)
+        return 0;
+    return 1;
+}
+
+/* Replay records of 'seg' not covered by its index.  Anything after the
+ * last complete record is the result of an interrupted write.  It is
+ * truncated so that appends to the active segment start at a clean offset.
+ */
+static int scan_segment (struct packdb *db, struct segment *seg)
+{
+    uint64_t offset;
+    struct pack_record_hdr hdr;
+    uint8_t hash[BLOBREF_MAX_DIGEST_SIZE];
+
+    if (load_index (db, seg, &offset) < 0)
+        return -1;
+    while (read_record (db, seg, offset, &hdr, hash)) {
+        if (apply_record (db, seg, hdr.type, hash, offset, hdr.size) < 0)
+            return -1;
+        offset += record_size (db, hdr.size);
+    }
+    if (offset < seg->size) {
+        if (ftruncate (seg->fd, offset) < 0)
+            return -1;
+        seg->size = offset;
+    }
+    return 0;
+}
+
+/* Write an index file covering all of 'seg'.  The index is written to a
+ * temporary file, flushed, and renamed into place so a reader never sees it
+ * partially written, even after a crash.
+ */
+static int write_index (struct packdb *db, struct segment *seg)
+{
+    char path[1024];
+    char tmp[1024];
+    struct pack_index_hdr hdr = {
+        .magic = PACK_INDEX_MAGIC,
+        .version = PACK_INDEX_VERSION,
+        .hash_size = db->hash_size,
+        .covered = 0,
+    };
+    struct pack_record_hdr rhdr;
+    uint8_t hash[BLOBREF_MAX_DIGEST_SIZE];
+    size_t entsize = sizeof (struct pack_index_entry) + db->hash_size;
+    uint64_t offset = 0;
+    int fd = -1;
+
+    if (segment_path (db, seg->id, "idx", path, sizeof (path)) < 0
+        || snprintf (tmp, sizeof (tmp), "%s.tmp", path) >= sizeof (tmp))
+        return -1;
+    if ((fd = open (tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666)) < 0)
+        return -1;
+    while (read_record (db, seg, offset, &rhdr, hash)) {
+        struct pack_index_entry ent = {
+            .type = rhdr.type,
+            .size = rhdr.size,
+            .offset = offset,
+        };
+        uint8_t buf[sizeof (ent) + BLOBREF_MAX_DIGEST_SIZE];
+
+        memcpy (buf, &ent, sizeof (ent));
+        memcpy (buf + sizeof (ent), hash, db->hash_size);
+        if (pwrite_all (fd,
+                        buf,
+                        entsize,
+                        sizeof (hdr) + entsize * hdr.count) < 0)
+            goto error;
+        hdr.count++;
+        offset += record_size (db, rhdr.size);
+    }
+    hdr.covered = offset;
+    if (pwrite_all (fd, &hdr, sizeof (hdr), 0) < 0
+        || fdatasync (fd) < 0)
+        goto error;
+    if (close (fd) < 0) {
+        fd = -1;
+        goto error;
+    }
+    if (rename (tmp, path) < 0) {
+        ERRNO_SAFE_WRAP (unlink, tmp);
+        return -1;
+    }
+    return 0;
+error:
+    if (fd >= 0)
+        ERRNO_SAFE_WRAP (close, fd);
+    ERRNO_SAFE_WRAP (unlink, tmp);
+    return -1;
+}
+
+/* Seal the active segment and start a new one.
+ */
+static int roll_segment (struct packdb *db)
+{
+    struct segment *active = active_segment (db);
+    struct segment *seg;
+
+    (void)write_index (db, active); // an index is an optimization
+    if (!(seg = segment_open (db, active->id + 1)))
+        return -1;
+    if (segment_append_list (db, seg) < 0) {
+        segment_destroy (seg);
+        return -1;
+    }
+    return 0;
+}
+
+/* Append a record to the active segment, starting a new segment first
+ * if necessary.  On success, return the segment and offset of the record.
+ */
+static int append_record (struct packdb *db,
+                          uint32_t type,
+                          const void *hash,
+                          const void *data,
+                          uint32_t size,
+                          struct segment **segp,
+                          uint64_t *offsetp)
+{
+    struct segment *seg = active_segment (db);
+    struct pack_record_hdr hdr = {
+        .magic = PACK_RECORD_MAGIC,
+        .type = type,
+        .hash_size = db->hash_size,
+        .size = size,
+    };
+    uint64_t offset;
+
+    if (seg->size > 0
+        && seg->size + record_size (db, size) > db->segment_size) {
+        if (roll_segment (db) < 0)
+            return -1;
+        seg = active_segment (db);
+    }
+    offset = seg->size;
+    if (pwrite_all (seg->fd, &hdr, sizeof (hdr), offset) < 0
+        || pwrite_all (seg->fd,
+                       hash,
+                       db->hash_size,
+                       offset + sizeof (hdr)) < 0
+        || pwrite_all (seg->fd,
+                       data,
+                       size,
+                       offset + sizeof (hdr) + db->hash_size) < 0) {
+        ERRNO_SAFE_WRAP (ftruncate, seg->fd, offset);
+        return -1;
+    }
+    seg->size += record_size (db, size);
+    *segp = seg;
+    *offsetp = offset;
+    return 0;
+}
+
+static int check_hash_size (struct packdb *db, int hash_size)
+{
+    if (!db || hash_size != db->hash_size) {
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+int packdb_get (struct packdb *db,
+                const void *hash,
+                int hash_size,
+                void **datap,
+                size_t *sizep)
+{
+    uint8_t key[BLOBREF_MAX_DIGEST_SIZE];
+    struct pack_entry *e;
+    void *data;
+    off_t offset;
+
+    if (check_hash_size (db, hash_size) < 0 || !datap || !sizep) {
+        errno = EINVAL;
+        return -1;
+    }
+    pack_key (db, hash, key);
+    if (!(e = zhashx_lookup (db->index, key))) {
+        errno = ENOENT;
+        return -1;
+    }
+    if (!(data = malloc (e->size + 1)))
+        return -1;
+    offset = e->offset + sizeof (struct pack_record_hdr) + db->hash_size;
+    if (pread_all (e->seg->fd, data, e->size, offset) != e->size) {
+        ERRNO_SAFE_WRAP (free, data);
+        errno = EIO;
+        return -1;
+    }
+    *datap = data;
+    *sizep = e->size;
+    return 0;
+}
+
+int packdb_has (struct packdb *db, const void *hash, int hash_size)
+{
+    uint8_t key[BLOBREF_MAX_DIGEST_SIZE];
+
+    if (check_hash_size (db, hash_size) < 0)
+        return -1;
+    pack_key (db, hash, key);
+    return zhashx_lookup (db->index, key) ? 1 : 0;
+}
+
+int packdb_put (struct packdb *db,
+                const void *hash,
+                int hash_size,
+                const void *data,
+                size_t size)
+{
+    uint8_t key[BLOBREF_MAX_DIGEST_SIZE];
+    struct segment *seg;
+    uint64_t offset;
+
+    if (check_hash_size (db, hash_size) < 0)
+        return -1;
+    if (size > UINT32_MAX) {
+        errno = EFBIG;
+        return -1;
+    }
+    pack_key (db, hash, key);
+    if (zhashx_lookup (db->index, key))
+        return 0;
+    if (append_record (db,
+                       PACK_RECORD_BLOB,
+                       hash,
+                       data,
+                       size,
+                       &seg,
+                       &offset) < 0)
+        return -1;
+    return apply_record (db, seg, PACK_RECORD_BLOB, hash, offset, size);
+}
+
+int packdb_delete (struct packdb *db, const void *hash, int hash_size)
+{
+    uint8_t key[BLOBREF_MAX_DIGEST_SIZE];
+    struct segment *seg;
+    uint64_t offset;
+
+    if (check_hash_size (db, hash_size) < 0)
+        return -1;
+    pack_key (db, hash, key);
+    if (!zhashx_lookup (db->index, key)) {
+        errno = ENOENT;
+        return -1;
+    }
+    if (append_record (db,
+                       PACK_RECORD_DELETE,
+                       hash,
+                       NULL,
+                       0,
+                       &seg,
+                       &offset) < 0)
+        return -1;
+    return apply_record (db, seg, PACK_RECORD_DELETE, hash, offset, 0);
+}
+
+int packdb_hashes (struct packdb *db, void **hashesp, int *countp)
+{
+    struct pack_entry *e;
+    uint8_t *hashes;
+    int count = 0;
+
+    if (!db || !hashesp || !countp) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(hashes = malloc (zhashx_size (db->index) * db->hash_size + 1)))
+        return -1;
+    e = zhashx_first (db->index);
+    while (e) {
+        memcpy (hashes + count++ * db->hash_size, e->hash, db->hash_size);
+        e = zhashx_next (db->index);
+    }
+    *hashesp = hashes;
+    *countp = count;
+    return 0;
+}
+
+/* Copy live records out of 'seg' into the active segment, starting at
+ * '*offsetp' and examining at most 'max_records' records.  '*offsetp' is
+ * advanced past the records that were handled.
+ * Returns 1 if the end of 'seg' was reached, 0 if records remain, or -1
+ * on failure with errno set.
+ */
+static int compact_records (struct packdb *db,
+                            struct segment *seg,
+                            uint64_t *offsetp,
+                            int max_records)
+{
+    uint64_t offset = *offsetp;
+    struct pack_record_hdr hdr;
+    uint8_t hash[BLOBREF_MAX_DIGEST_SIZE];
+    bool older_segments = (db->segs[0] != seg);
+    int count = 0;
+
+    while (read_record (db, seg, offset, &hdr, hash)) {
+        uint8_t key[BLOBREF_MAX_DIGEST_SIZE];
+        struct pack_entry *e;
+        struct segment *newseg;
+        uint64_t newoffset;
+
+        if (count++ == max_records)
+            return 0;
+        pack_key (db, hash, key);
+        e = zhashx_lookup (db->index, key);
+        if (hdr.type == PACK_RECORD_BLOB) {
+            if (e && e->seg == seg && e->offset == offset) {
+                void *data;
+                size_t size;
+
+                if (packdb_get (db, hash, db->hash_size, &data, &size) < 0)
+                    return -1;
+                if (append_record (db,
+                                   PACK_RECORD_BLOB,
+                                   hash,
+                                   data,
+                                   size,
+                                   &newseg,
+                                   &newoffset) < 0) {
+                    ERRNO_SAFE_WRAP (free, data);
+                    return -1;
+                }
+                free (data);
+                if (apply_record (db,
+                                  newseg,
+                                  PACK_RECORD_BLOB,
+                                  hash,
+                                  newoffset,
+                                  size) < 0)
+                    return -1;
+            }
+        }
+        else if (!e && older_segments) {
+            if (append_record (db,
+                               PACK_RECORD_DELETE,
+                               hash,
+                               NULL,
+                               0,
+                               &newseg,
+                               &newoffset) < 0)
+                return -1;
+        }
+        offset += record_size (db, hdr.size);
+        *offsetp = offset;
+    }
+    return 1;
+}
+
+static int sync_dir (const char *path)
+{
+    int fd;
+
+    if ((fd = open (path, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) < 0)
+        return -1;
+    if (fsync (fd) < 0) {
+        ERRNO_SAFE_WRAP (close, fd);
+        return -1;
+    }
+    return close (fd);
+}
+
+/* Make the records copied by compaction durable before the segment they
+ * were copied from is removed.  Segments sealed since compaction began
+ * already have a flushed index (see roll_segment()), so only their data
+ * is flushed here.  The index of the active segment is rewritten to cover
+ * the copied records.  Finally the directory is flushed so any segment
+ * and index files created along the way survive a crash.
+ */
+static int compact_sync (struct packdb *db)
+{
+    struct segment *active = active_segment (db);
+    int i;
+
+    for (i = 0; i < db->nsegs; i++) {
+        if (db->segs[i]->id >= db->compact_dest_id
+            && fdatasync (db->segs[i]->fd) < 0)
+            return -1;
+    }
+    if (write_index (db, active) < 0
+        || sync_dir (db->path) < 0)
+        return -1;
+    return 0;
+}
+
+static int segment_remove (struct packdb *db, struct segment *seg)
+{
+    char path[1024];
+    int i;
+
+    for (i = 0; i < db->nsegs; i++) {
+        if (db->segs[i] == seg)
+            break;
+    }
+    if (i == db->nsegs) {
+        errno = ENOENT;
+        return -1;
+    }
+    memmove (&db->segs[i],
+             &db->segs[i + 1],
+             sizeof (db->segs[0]) * (db->nsegs - i - 1));
+    db->nsegs--;
+    if (segment_path (db, seg->id, "idx", path, sizeof (path)) == 0)
+        (void)unlink (path);
+    if (segment_path (db, seg->id, "pack", path, sizeof (path)) == 0)
+        (void)unlink (path);
+    segment_destroy (seg);
+    return 0;
+}
+
+int packdb_compact (struct packdb *db,
+                    double min_live_ratio,
+                    int max_records)
+{
+    struct segment *victim = db ? db->compact_seg : NULL;
+    int rc;
+    int i;
+
+    if (!db || max_records < 1) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!victim) {
+        double victim_ratio = min_live_ratio;
+
+        for (i = 0; i < db->nsegs - 1; i++) { // skip active segment
+            struct segment *seg = db->segs[i];
+            double ratio = seg->size > 0 ? (double)seg->live / seg->size : 0;
+
+            if (ratio < victim_ratio) {
+                victim = seg;
+                victim_ratio = ratio;
+            }
+        }
+        if (!victim)
+            return 0;
+        db->compact_seg = victim;
+        db->compact_offset = 0;
+        db->compact_dest_id = active_segment (db)->id;
+    }
+    if ((rc = compact_records (db,
+                               victim,
+                               &db->compact_offset,
+                               max_records)) < 0)
+        return -1;
+    if (rc == 0)
+        return 1;
+    if (victim->live > 0) {
+        errno = EIO; // all live records should have been moved
+        return -1;
+    }
+    if (compact_sync (db) < 0)
+        return -1;
+    db->compact_seg = NULL;
+    if (segment_remove (db, victim) < 0)
+        return -1;
+    db->compactions++;
+    return 1;
+}
+
+void packdb_get_stats (struct packdb *db, struct packdb_stats *stats)
+{
+    int i;
+
+    memset (stats, 0, sizeof (*stats));
+    if (db) {
+        stats->object_count = zhashx_size (db->index);
+        stats->segment_count = db->nsegs;
+        stats->compactions = db->compactions;
+        for (i = 0; i < db->nsegs; i++) {
+            stats->total_bytes += db->segs[i]->size;
+            stats->live_bytes += db->segs[i]->live;
+        }
+    }
+}
+
+static int id_compare (const void *a, const void *b)
+{
+    uint32_t id1 = *(const uint32_t *)a;
+    uint32_t id2 = *(const uint32_t *)b;
+
+    return id1 < id2 ? -1 : id1 > id2 ? 1 : 0;
+}
+
+/* Find existing segment ids in db->path and return them sorted.
+ */
+static int list_segments (struct packdb *db, uint32_t **idsp, int *countp)
+{
+    DIR *dir;
+    struct dirent *dent;
+    uint32_t *ids = NULL;
+    int count = 0;
+
+    if (!(dir = opendir (db->path)))
+        return -1;
+    while ((dent = readdir (dir))) {
+        unsigned int id;
+        char suffix[8];
+        uint32_t *tmp;
+
+        if (sscanf (dent->d_name, "%8x.%5s", &id, suffix) != 2
+            || !streq (suffix, "pack")
+            || strlen (dent->d_name) != 13)
+            continue;
+        if (!(tmp = realloc (ids, sizeof (ids[0]) * (count + 1)))) {
+            ERRNO_SAFE_WRAP (free, ids);
+            ERRNO_SAFE_WRAP (closedir, dir);
+            return -1;
+        }
+        ids = tmp;
+        ids[count++] = id;
+    }
+    (void)closedir (dir);
+    if (count > 0)
+        qsort (ids, count, sizeof (ids[0]), id_compare);
+    *idsp = ids;
+    *countp = count;
+    return 0;
+}
+
+void packdb_close (struct packdb *db)
+{
+    if (db) {
+        int saved_errno = errno;
+        int i;
+
+        if (db->nsegs > 0)
+            (void)write_index (db, active_segment (db));
+        for (i = 0; i < db->nsegs; i++)
+            segment_destroy (db->segs[i]);
+        free (db->segs);
+        zhashx_destroy (&db->index);
+        free (db->path);
+        free (db);
+        errno = saved_errno;
+    }
+}
+
+struct packdb *packdb_open (const char *path,
+                            int hash_size,
+                            uint64_t segment_size)
+{
+    struct packdb *db;
+    uint32_t *ids = NULL;
+    int count = 0;
+    int i;
+
+    if (!path
+        || hash_size < 1
+        || hash_size > BLOBREF_MAX_DIGEST_SIZE
+        || segment_size == 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(db = calloc (1, sizeof (*db))))
+        return NULL;
+    db->hash_size = hash_size;
+    db->segment_size = segment_size;
+    if (!(db->path = strdup (path))
+        || !(db->index = zhashx_new ()))
+        goto nomem;
+    zhashx_set_destructor (db->index, pack_entry_destructor);
+    zhashx_set_key_hasher (db->index, pack_entry_hasher);
+    zhashx_set_key_comparator (db->index, pack_entry_comparator);
+    zhashx_set_key_destructor (db->index, NULL); // key is part of entry
+    zhashx_set_key_duplicator (db->index, NULL); // key is part of entry
+
+    if (mkdir (path, 0700) < 0 && errno != EEXIST)
+        goto error;
+    if (list_segments (db, &ids, &count) < 0)
+        goto error;
+    for (i = 0; i < count; i++) {
+        struct segment *seg;
+
+        if (!(seg = segment_open (db, ids[i])))
+            goto error;
+        if (segment_append_list (db, seg) < 0) {
+            segment_destroy (seg);
+            goto error;
+        }
+        if (scan_segment (db, seg) < 0)
+            goto error;
+    }
+    if (db->nsegs == 0) {
+        struct segment *seg;
+
+        if (!(seg = segment_open (db, 0)))
+            goto error;
+        if (segment_append_list (db, seg) < 0) {
+            segment_destroy (seg);
+            goto error;
+        }
+    }
+    free (ids);
+    return db;
+nomem:
+    errno = ENOMEM;
+error:
+    ERRNO_SAFE_WRAP (free, ids);
+    packdb_close (db);
+    return NULL;
+}
+
+/*
+ * vi:ts=4 sw=4 expandtab
+ */
@@ -0,0 +1,97 @@
+/************************************************************\
+ * Copyright 2026 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _CONTENT_FILES_PACKDB_H
+#define _CONTENT_FILES_PACKDB_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+struct packdb_stats {
+    int object_count;           // number of live blobs
+    int segment_count;          // number of segment files
+    uint64_t total_bytes;       // size of all segment files
+    uint64_t live_bytes;        // bytes occupied by live blob records
+    int compactions;            // segments compacted since open
+};
+
+/* Open packfile store in directory 'path', creating it if necessary.
+ * The in-memory index is rebuilt from segment index files, if present,
+ * and by scanning any segment content they do not cover.  A partially
+ * written record at the end of the last segment is truncated.
+ * New segments are started when the current one would exceed
+ * 'segment_size' bytes.
+ * Returns store on success, or NULL on failure with errno set.
+ */
+struct packdb *packdb_open (const char *path,
+                            int hash_size,
+                            uint64_t segment_size);
+
+/* Write an index file for the active segment and close the store.
+ */
+void packdb_close (struct packdb *db);
+
+/* Look up blob by 'hash'.  On success, 'datap' and 'sizep' are assigned
+ * the contents and size and 0 is returned (*datap must be freed).
+ * On failure, -1 is returned with errno set (ENOENT if not found).
+ */
+int packdb_get (struct packdb *db,
+                const void *hash,
+                int hash_size,
+                void **datap,
+                size_t *sizep);
+
+/* Check whether blob with digest 'hash' is stored, without reading it.
+ * Returns 1 if present, 0 if not, or -1 on failure with errno set.
+ */
+int packdb_has (struct packdb *db, const void *hash, int hash_size);
+
+/* Append blob 'data' of length 'size' with digest 'hash' to the store.
+ * If the blob is already present, this is a no-op.
+ * Returns 0 on success, -1 on failure with errno set.
+ */
+int packdb_put (struct packdb *db,
+                const void *hash,
+                int hash_size,
+                const void *data,
+                size_t size);
+
+/* Remove blob with digest 'hash'.  A deletion record is appended so the
+ * removal persists, and the space is reclaimed by packdb_compact().
+ * Returns 0 on success, -1 on failure with errno set (ENOENT if not found).
+ */
+int packdb_delete (struct packdb *db, const void *hash, int hash_size);
+
+/* Get the digests of all stored blobs, concatenated in an array of
+ * 'countp' elements assigned to 'hashesp' (in no particular order).
+ * The caller must free the array.
+ * Returns 0 on success, -1 on failure with errno set.
+ */
+int packdb_hashes (struct packdb *db, void **hashesp, int *countp);
+
+/* Rewrite the live records of the sparsest sealed segment whose ratio of
+ * live to total bytes is below 'min_live_ratio' into the active segment,
+ * then flush the copies to disk and remove it.  At most 'max_records'
+ * records are examined per call, and a segment in progress is resumed by
+ * the next call, so call repeatedly while it returns 1.
+ * Returns 1 if progress was made, 0 if there was nothing to do,
+ * or -1 on failure with errno set.
+ */
+int packdb_compact (struct packdb *db,
+                    double min_live_ratio,
+                    int max_records);
+
+void packdb_get_stats (struct packdb *db, struct packdb_stats *stats);
+
+#endif /* !_CONTENT_FILES_PACKDB_H */
+
+/*
+ * vi:ts=4 sw=4 expandtab
+ */
@@ -0,0 +1,337 @@
+/************************************************************\
+ * Copyright 2026 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/modules/content-files/packdb.h"
+#include "src/common/libutil/blobref.h"
+#include "src/common/libutil/unlink_recursive.h"
+
+#define BLOB_SIZE 1000
+
+static int make_blob (int n, char *buf, void *hash)
+{
+    memset (buf, 'a' + n % 26, BLOB_SIZE);
+    snprintf (buf, BLOB_SIZE, "blob %d", n);
+    return blobref_hash_raw ("sha1", buf, BLOB_SIZE, hash, 32);
+}
+
+static bool check_blob (struct packdb *db, int n)
+{
+    char buf[BLOB_SIZE];
+    char hash[32];
+    int hash_size = make_blob (n, buf, hash);
+    void *data;
+    size_t size;
+    bool match;
+
+    if (packdb_get (db, hash, hash_size, &data, &size) < 0)
+        return false;
+    match = (size == BLOB_SIZE && memcmp (data, buf, size) == 0);
+    free (data);
+    return match;
+}
+
+static bool check_absent (struct packdb *db, int n)
+{
+    char buf[BLOB_SIZE];
+    char hash[32];
+    int hash_size = make_blob (n, buf, hash);
+    void *data;
+    size_t size;
+
+    errno = 0;
+    return (packdb_get (db, hash, hash_size, &data, &size) < 0
+            && errno == ENOENT);
+}
+
+static int put_blob (struct packdb *db, int n)
+{
+    char buf[BLOB_SIZE];
+    char hash[32];
+    int hash_size = make_blob (n, buf, hash);
+
+    return packdb_put (db, hash, hash_size, buf, BLOB_SIZE);
+}
+
+static int delete_blob (struct packdb *db, int n)
+{
+    char buf[BLOB_SIZE];
+    char hash[32];
+    int hash_size = make_blob (n, buf, hash);
+
+    return packdb_delete (db, hash, hash_size);
+}
+
+static int has_blob (struct packdb *db, int n)
+{
+    char buf[BLOB_SIZE];
+    char hash[32];
+    int hash_size = make_blob (n, buf, hash);
+
+    return packdb_has (db, hash, hash_size);
+}
+
+static int count_hashes (struct packdb *db)
+{
+    void *hashes;
+    int count;
+
+    if (packdb_hashes (db, &hashes, &count) < 0)
+        return -1;
+    free (hashes);
+    return count;
+}
+
+void test_badargs (const char *dir)
+{
+    struct packdb *db;
+    char hash[32] = { 0 };
+    void *data;
+    size_t size;
+
+    errno = 0;
+    ok (packdb_open (NULL, 20, 4096) == NULL && errno == EINVAL,
+        "packdb_open path=NULL fails with EINVAL");
+    errno = 0;
+    ok (packdb_open (dir, 0, 4096) == NULL && errno == EINVAL,
+        "packdb_open hash_size=0 fails with EINVAL");
+    errno = 0;
+    ok (packdb_open (dir, 20, 0) == NULL && errno == EINVAL,
+        "packdb_open segment_size=0 fails with EINVAL");
+
+    if (!(db = packdb_open (dir, 20, 4096)))
+        BAIL_OUT ("packdb_open failed");
+    errno = 0;
+    ok (packdb_get (db, hash, 19, &data, &size) < 0 && errno == EINVAL,
+        "packdb_get with wrong hash size fails with EINVAL");
+    errno = 0;
+    ok (packdb_put (db, hash, 19, "x", 1) < 0 && errno == EINVAL,
+        "packdb_put with wrong hash size fails with EINVAL");
+    errno = 0;
+    ok (packdb_has (db, hash, 19) < 0 && errno == EINVAL,
+        "packdb_has with wrong hash size fails with EINVAL");
+    errno = 0;
+    ok (packdb_get (db, hash, 20, &data, &size) < 0 && errno == ENOENT,
+        "packdb_get unknown hash fails with ENOENT");
+    errno = 0;
+    ok (packdb_delete (db, hash, 20) < 0 && errno == ENOENT,
+        "packdb_delete unknown hash fails with ENOENT");
+    errno = 0;
+    ok (packdb_compact (db, 0.5, 0) < 0 && errno == EINVAL,
+        "packdb_compact max_records=0 fails with EINVAL");
+    packdb_close (db);
+}
+
+void test_simple (const char *dir)
+{
+    struct packdb *db;
+    struct packdb_stats stats;
+    int i;
+    bool failed;
+
+    if (!(db = packdb_open (dir, 20, 8192)))
+        BAIL_OUT ("packdb_open failed");
+
+    failed = false;
+    for (i = 0; i < 32; i++) {
+        if (put_blob (db, i) < 0)
+            failed = true;
+    }
+    ok (!failed,
+        "packdb_put stored 32 blobs");
+    ok (put_blob (db, 0) == 0,
+        "packdb_put of a duplicate blob works");
+    packdb_get_stats (db, &stats);
+    ok (stats.object_count == 32,
+        "object_count is 32");
+    ok (stats.segment_count > 1,
+        "blobs were spread over %d segments", stats.segment_count);
+    ok (stats.live_bytes == stats.total_bytes,
+        "all bytes are live");
+
+    failed = false;
+    for (i = 0; i < 32; i++) {
+        if (!check_blob (db, i))
+            failed = true;
+    }
+    ok (!failed,
+        "packdb_get returned all blobs");
+
+    ok (has_blob (db, 3) == 1,
+        "packdb_has returns 1 for a stored blob");
+    ok (delete_blob (db, 3) == 0,
+        "packdb_delete works");
+    ok (check_absent (db, 3),
+        "deleted blob is not found");
+    ok (has_blob (db, 3) == 0,
+        "packdb_has returns 0 for a deleted blob");
+    ok (count_hashes (db) == 31,
+        "packdb_hashes returns 31 digests");
+    packdb_close (db);
+
+    if (!(db = packdb_open (dir, 20, 8192)))
+        BAIL_OUT ("packdb_open failed");
+    packdb_get_stats (db, &stats);
+    ok (stats.object_count == 31,
+        "reopen: object_count is 31");
+    failed = false;
+    for (i = 0; i < 32; i++) {
+        if (i == 3 ? !check_absent (db, i) : !check_blob (db, i))
+            failed = true;
+    }
+    ok (!failed,
+        "reopen: all blobs are intact and deleted blob stays deleted");
+    packdb_close (db);
+}
+
+void test_compact (const char *dir)
+{
+    struct packdb *db;
+    struct packdb_stats stats;
+    struct packdb_stats stats2;
+    int i;
+    bool failed;
+
+    if (!(db = packdb_open (dir, 20, 8192)))
+        BAIL_OUT ("packdb_open failed");
+
+    ok (packdb_compact (db, 0.5, 4) == 0,
+        "packdb_compact does nothing when segments are mostly live");
+
+    for (i = 0; i < 24; i++) {
+        if (i != 3) // already deleted
+            (void)delete_blob (db, i);
+    }
+    packdb_get_stats (db, &stats);
+    ok (stats.object_count == 8,
+        "deleted all but 8 blobs");
+
+    ok (packdb_compact (db, 0.5, 1) == 1,
+        "packdb_compact handled one record of a sparse segment");
+    packdb_get_stats (db, &stats2);
+    ok (stats2.compactions == 0,
+        "no segment was removed yet");
+    ok (put_blob (db, 32) == 0 && check_blob (db, 32),
+        "a blob can be stored while a segment is being compacted");
+    ok (delete_blob (db, 32) == 0 && check_absent (db, 32),
+        "and deleted");
+
+    while ((i = packdb_compact (db, 0.5, 4)) > 0)
+        ;
+    ok (i == 0,
+        "packdb_compact ran until there was nothing more to do");
+    packdb_get_stats (db, &stats2);
+    ok (stats2.compactions > 0 && stats2.total_bytes < stats.total_bytes,
+        "%d segments were compacted, reclaiming %ju bytes",
+        stats2.compactions,
+        (uintmax_t)(stats.total_bytes - stats2.total_bytes));
+    ok (stats2.object_count == 8,
+        "object_count is still 8");
+    packdb_close (db);
+
+    if (!(db = packdb_open (dir, 20, 8192)))
+        BAIL_OUT ("packdb_open failed");
+    failed = false;
+    for (i = 0; i < 32; i++) {
+        if (i < 24 ? !check_absent (db, i) : !check_blob (db, i))
+            failed = true;
+    }
+    ok (!failed && check_absent (db, 32),
+        "reopen: compacted store has the expected content");
+    packdb_close (db);
+}
+
+/* Simulate a crash in the middle of an append by writing junk at the end
+ * of the last segment.
+ */
+void test_torn_write (const char *dir)
+{
+    struct packdb *db;
+    char path[1024];
+    char junk[] = "partial record";
+    int fd;
+    int i;
+    bool failed;
+
+    if (!(db = packdb_open (dir, 20, 8192)))
+        BAIL_OUT ("packdb_open failed");
+    if (put_blob (db, 100) < 0)
+        BAIL_OUT ("packdb_put failed");
+    packdb_close (db);
+
+    snprintf (path, sizeof (path), "%s/%08x.pack", dir, 0x100);
+    if ((fd = open (path, O_WRONLY | O_CREAT, 0666)) < 0
+        || write (fd, junk, sizeof (junk)) < 0
+        || close (fd) < 0)
+        BAIL_OUT ("could not create damaged segment");
+
+    db = packdb_open (dir, 20, 8192);
+    ok (db != NULL,
+        "packdb_open works with a partial record at the end");
+    failed = false;
+    for (i = 24; i < 32; i++) {
+        if (!check_blob (db, i))
+            failed = true;
+    }
+    ok (!failed && check_blob (db, 100),
+        "previously stored blobs are intact");
+    ok (put_blob (db, 101) == 0 && check_blob (db, 101),
+        "a new blob can be stored and retrieved");
+    packdb_close (db);
+
+    db = packdb_open (dir, 20, 8192);
+    ok (db != NULL && check_blob (db, 101),
+        "reopen: the new blob is intact");
+    packdb_close (db);
+}
+
+int main (int argc, char *argv[])
+{
+    char dir[1024];
+    const char *tmp = getenv ("TMPDIR");
+
+    plan (NO_PLAN);
+
+    if (!tmp)
+        tmp = "/tmp";
+    if (snprintf (dir, sizeof (dir), "%s/packdb.XXXXXX", tmp) >= sizeof (dir))
+        BAIL_OUT ("internal buffer overflow");
+    if (!mkdtemp (dir))
+        BAIL_OUT ("mkdtemp failed");
+    diag ("mkdir %s", dir);
+
+    test_badargs (dir);
+    test_simple (dir);
+    test_compact (dir);
+    test_torn_write (dir);
+
+    if (unlink_recursive (dir) < 0)
+        BAIL_OUT ("unlink_recursive failed");
+
+    done_testing ();
+    return (0);
+}
+
+// vi: ts=4 sw=4 expandtab
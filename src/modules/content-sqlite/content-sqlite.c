@@ -28,6 +28,8 @@
 #include "src/common/libutil/errno_safe.h"
 #include "src/common/libutil/tstat.h"
 #include "src/common/libutil/monotime.h"
+#include "src/common/libutil/fsd.h"
+#include "src/common/libutil/bloom.h"
 
 #include "src/common/libcontent/content-util.h"
 #include "ccan/str/str.h"
@@ -35,6 +37,15 @@
 const size_t lzo_buf_chunksize = 1024*1024;
 const size_t compression_threshold = 256; /* compress blobs >= this size */
 
+/* Stores are grouped into one sqlite transaction and acknowledged together
+ * when the transaction commits.  With a batch window of zero, the batch is
+ * committed as soon as no more requests are queued on the handle.  Otherwise
+ * it is committed when the window expires.  In either case, the batch is
+ * committed early once it reaches STORE_BATCH_LIMIT blobs.
+ */
+const double default_batch_window = 0.;
+#define STORE_BATCH_LIMIT 256
+
 const char *sql_create_table = "CREATE TABLE if not exists objects("
                                "  hash BLOB PRIMARY KEY,"
                                "  size INT,"
@@ -45,6 +56,28 @@ const char *sql_load = "SELECT object,size FROM objects"
 const char *sql_store = "INSERT INTO objects (hash,size,object) "
                         "  values (?1, ?2, ?3)";
 const char *sql_objects_count = "SELECT count(1) FROM objects";
+const char *sql_has = "SELECT 1 FROM objects"
+                      "  WHERE hash = ?1 LIMIT 1";
+const char *sql_scan = "SELECT hash FROM objects"
+                       "  WHERE hash > ?1 ORDER BY hash LIMIT ?2";
+const char *sql_objsize = "SELECT length(object) FROM objects"
+                          "  WHERE hash = ?1 LIMIT 1";
+const char *sql_remove = "DELETE FROM objects WHERE hash = ?1";
+
+/* Existence probes (content-backing.has) are answered from a bloom filter
+ * of stored hashes when possible, so that a batch of digests that are
+ * mostly absent costs no database lookups.  The filter is populated at
+ * startup by scanning the objects table FILTER_SCAN_CHUNK rows at a time
+ * from an idle watcher, and is only consulted once the scan is complete.
+ * It is rebuilt at twice the size if the object count outgrows it.
+ */
+const size_t filter_min_capacity = 1024*1024;
+const double filter_fp_rate = 0.01;
+#define FILTER_SCAN_CHUNK 4096
+
+/* Maximum number of hashes returned by one content-backing.list request.
+ */
+#define LIST_LIMIT 1024
 
 const char *sql_create_table_checkpt = "CREATE TABLE if not exists checkpt("
                                        "  key TEXT UNIQUE,"
@@ -58,6 +91,34 @@ const char *sql_checkpt_put = "REPLACE INTO checkpt (key,value) "
 struct content_stats {
     tstat_t load;
     tstat_t store;
+    tstat_t commit;
+    tstat_t batch_size;
+    int64_t removed_count;
+    int64_t removed_bytes;
+};
+
+struct store_request {
+    const flux_msg_t *msg;
+    uint8_t hash[BLOBREF_MAX_DIGEST_SIZE];
+    int hash_size;
+};
+
+struct store_batch {
+    struct store_request req[STORE_BATCH_LIMIT];
+    int count;
+    bool in_transaction;
+    double window;
+    flux_watcher_t *check_w;
+    flux_watcher_t *idle_w;
+    flux_watcher_t *timer_w;
+};
+
+struct hash_filter {
+    struct bloom *bloom;
+    bool ready;                     // scan is complete
+    uint8_t cursor[BLOBREF_MAX_DIGEST_SIZE]; // last hash scanned
+    int cursor_size;
+    flux_watcher_t *idle_w;
 };
 
 struct content_sqlite {
@@ -66,6 +127,10 @@ struct content_sqlite {
     sqlite3 *db;
     sqlite3_stmt *load_stmt;
     sqlite3_stmt *store_stmt;
+    sqlite3_stmt *has_stmt;
+    sqlite3_stmt *scan_stmt;
+    sqlite3_stmt *objsize_stmt;
+    sqlite3_stmt *remove_stmt;
     sqlite3_stmt *checkpt_get_stmt;
     sqlite3_stmt *checkpt_put_stmt;
     flux_t *h;
@@ -74,6 +139,8 @@ struct content_sqlite {
     size_t lzo_bufsize;
     void *lzo_buf;
     struct content_stats stats;
+    struct store_batch batch;
+    struct hash_filter filter;
     char *journal_mode;
     char *synchronous;
     bool truncate;
@@ -298,6 +365,170 @@ error:
     return -1;
 }
 
+/* Check whether blob with 'hash' is stored.
+ * Returns 1 if present, 0 if not, or -1 on error with errno set.
+ */
+static int content_sqlite_has (struct content_sqlite *ctx,
+                               const void *hash,
+                               int hash_size)
+{
+    int rc;
+
+    if (sqlite3_bind_text (ctx->has_stmt,
+                           1,
+                           (char *)hash,
+                           hash_size,
+                           SQLITE_STATIC) != SQLITE_OK) {
+        log_sqlite_error (ctx, "has: binding key");
+        set_errno_from_sqlite_error (ctx);
+        goto error;
+    }
+    rc = sqlite3_step (ctx->has_stmt);
+    if (rc != SQLITE_ROW && rc != SQLITE_DONE) {
+        log_sqlite_error (ctx, "has: executing stmt");
+        set_errno_from_sqlite_error (ctx);
+        goto error;
+    }
+    sqlite3_reset (ctx->has_stmt);
+    return rc == SQLITE_ROW ? 1 : 0;
+error:
+    ERRNO_SAFE_WRAP (sqlite3_reset, ctx->has_stmt);
+    return -1;
+}
+
+/* (Re-)create the hash filter with room for at least twice 'count' hashes
+ * and start scanning the objects table to populate it.
+ */
+static int filter_reset (struct content_sqlite *ctx, size_t count)
+{
+    struct bloom *bloom;
+    size_t capacity = count * 2;
+
+    if (capacity < filter_min_capacity)
+        capacity = filter_min_capacity;
+    if (!(bloom = bloom_create (capacity, filter_fp_rate)))
+        return -1;
+    bloom_destroy (ctx->filter.bloom);
+    ctx->filter.bloom = bloom;
+    ctx->filter.ready = false;
+    ctx->filter.cursor_size = 0;
+    flux_watcher_start (ctx->filter.idle_w);
+    return 0;
+}
+
+static void filter_add (struct content_sqlite *ctx,
+                        const void *hash,
+                        int hash_size)
+{
+    if (!ctx->filter.bloom)
+        return;
+    bloom_add (ctx->filter.bloom, hash, hash_size);
+    if (bloom_count (ctx->filter.bloom) > bloom_capacity (ctx->filter.bloom)) {
+        if (filter_reset (ctx, bloom_count (ctx->filter.bloom)) < 0)
+            flux_log_error (ctx->h, "error resizing hash filter");
+    }
+}
+
+/* Add the next FILTER_SCAN_CHUNK hashes (in key order) to the filter.
+ * The filter is ready once a short chunk is read.  On error, the filter
+ * is abandoned and all probes go to the database.
+ */
+static void filter_scan_cb (flux_reactor_t *r,
+                            flux_watcher_t *w,
+                            int revents,
+                            void *arg)
+{
+    struct content_sqlite *ctx = arg;
+    int count = 0;
+    int rc;
+
+    if (sqlite3_bind_text (ctx->scan_stmt,
+                           1,
+                           (char *)ctx->filter.cursor,
+                           ctx->filter.cursor_size,
+                           SQLITE_TRANSIENT) != SQLITE_OK
+        || sqlite3_bind_int (ctx->scan_stmt,
+                             2,
+                             FILTER_SCAN_CHUNK) != SQLITE_OK) {
+        log_sqlite_error (ctx, "filter scan: binding parameters");
+        goto error;
+    }
+    while ((rc = sqlite3_step (ctx->scan_stmt)) == SQLITE_ROW) {
+        const void *hash = sqlite3_column_blob (ctx->scan_stmt, 0);
+        int hash_size = sqlite3_column_bytes (ctx->scan_stmt, 0);
+
+        if (hash_size != ctx->hash_size)
+            continue;
+        bloom_add (ctx->filter.bloom, hash, hash_size);
+        memcpy (ctx->filter.cursor, hash, hash_size);
+        ctx->filter.cursor_size = hash_size;
+        count++;
+    }
+    if (rc != SQLITE_DONE) {
+        log_sqlite_error (ctx, "filter scan: executing stmt");
+        goto error;
+    }
+    sqlite3_reset (ctx->scan_stmt);
+    if (count < FILTER_SCAN_CHUNK) {
+        ctx->filter.ready = true;
+        flux_watcher_stop (w);
+        flux_log (ctx->h,
+                  LOG_DEBUG,
+                  "hash filter ready (%zu objects, %zu bytes)",
+                  bloom_count (ctx->filter.bloom),
+                  bloom_size (ctx->filter.bloom));
+    }
+    return;
+error:
+    sqlite3_reset (ctx->scan_stmt);
+    flux_watcher_stop (w);
+    bloom_destroy (ctx->filter.bloom);
+    ctx->filter.bloom = NULL;
+    ctx->filter.ready = false;
+}
+
+static void has_cb (flux_t *h,
+                    flux_msg_handler_t *mh,
+                    const flux_msg_t *msg,
+                    void *arg)
+{
+    struct content_sqlite *ctx = arg;
+    const uint8_t *hashes;
+    size_t size;
+    char *result = NULL;
+    int count;
+    int i;
+
+    if (flux_request_decode_raw (msg, NULL, (const void **)&hashes, &size) < 0)
+        goto error;
+    if (size == 0 || size % ctx->hash_size != 0) {
+        errno = EPROTO;
+        goto error;
+    }
+    count = size / ctx->hash_size;
+    if (!(result = calloc (1, count)))
+        goto error;
+    for (i = 0; i < count; i++) {
+        const uint8_t *hash = hashes + i * ctx->hash_size;
+        int rc;
+
+        if (ctx->filter.ready
+            && !bloom_test (ctx->filter.bloom, hash, ctx->hash_size))
+            continue;
+        if ((rc = content_sqlite_has (ctx, hash, ctx->hash_size)) < 0)
+            goto error;
+        result[i] = rc;
+    }
+    if (flux_respond_raw (h, msg, result, count) < 0)
+        flux_log_error (h, "has: flux_respond_raw");
+    free (result);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "has: flux_respond_error");
+    free (result);
+}
+
 static void load_cb (flux_t *h,
                      flux_msg_handler_t *mh,
                      const flux_msg_t *msg,
@@ -332,6 +563,137 @@ error:
         flux_log_error (h, "load: flux_respond_error");
 }
 
+/* Open a transaction for the current batch, if not already open.
+ */
+static int store_batch_begin (struct content_sqlite *ctx)
+{
+    if (!ctx->batch.in_transaction) {
+        if (sqlite3_exec (ctx->db, "BEGIN", NULL, NULL, NULL) != SQLITE_OK) {
+            log_sqlite_error (ctx, "store: beginning transaction");
+            set_errno_from_sqlite_error (ctx);
+            return -1;
+        }
+        ctx->batch.in_transaction = true;
+    }
+    return 0;
+}
+
+/* Respond to all requests in the batch, with the stored blobref hash if
+ * errnum is zero, otherwise with an error.  Then reset the batch.
+ */
+static void store_batch_respond (struct content_sqlite *ctx, int errnum)
+{
+    int i;
+
+    for (i = 0; i < ctx->batch.count; i++) {
+        struct store_request *req = &ctx->batch.req[i];
+        if (errnum == 0) {
+            if (flux_respond_raw (ctx->h,
+                                  req->msg,
+                                  req->hash,
+                                  req->hash_size) < 0)
+                flux_log_error (ctx->h, "store: flux_respond_raw");
+        }
+        else {
+            if (flux_respond_error (ctx->h, req->msg, errnum, NULL) < 0)
+                flux_log_error (ctx->h, "store: flux_respond_error");
+        }
+        flux_msg_decref (req->msg);
+        req->msg = NULL;
+    }
+    ctx->batch.count = 0;
+    ctx->batch.in_transaction = false;
+    flux_watcher_stop (ctx->batch.check_w);
+    flux_watcher_stop (ctx->batch.idle_w);
+    flux_watcher_stop (ctx->batch.timer_w);
+}
+
+/* Commit the open transaction, if any, and respond to the batch.
+ * If the commit fails, the transaction is rolled back and all stores
+ * in the batch fail.
+ */
+static void store_batch_commit (struct content_sqlite *ctx)
+{
+    struct timespec t0;
+    int errnum = 0;
+
+    if (!ctx->batch.in_transaction)
+        return;
+    monotime (&t0);
+    if (sqlite3_exec (ctx->db, "COMMIT", NULL, NULL, NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "store: committing transaction");
+        set_errno_from_sqlite_error (ctx);
+        errnum = errno;
+        if (!sqlite3_get_autocommit (ctx->db)
+            && sqlite3_exec (ctx->db,
+                             "ROLLBACK",
+                             NULL,
+                             NULL,
+                             NULL) != SQLITE_OK)
+            log_sqlite_error (ctx, "store: rolling back transaction");
+    }
+    else {
+        tstat_push (&ctx->stats.commit, monotime_since (t0));
+        tstat_push (&ctx->stats.batch_size, ctx->batch.count);
+    }
+    store_batch_respond (ctx, errnum);
+}
+
+/* A failed statement may cause sqlite to roll back the open transaction
+ * (e.g. SQLITE_FULL), taking the uncommitted stores of the batch with it.
+ * Detect that case and fail the batch.
+ */
+static void store_batch_check_rollback (struct content_sqlite *ctx)
+{
+    if (ctx->batch.in_transaction && sqlite3_get_autocommit (ctx->db)) {
+        int saved_errno = errno;
+        flux_log (ctx->h, LOG_ERR, "store: transaction was rolled back");
+        store_batch_respond (ctx, saved_errno);
+        errno = saved_errno;
+    }
+}
+
+/* Arrange for the batch to be committed later.
+ */
+static void store_batch_arm (struct content_sqlite *ctx)
+{
+    if (ctx->batch.window > 0.) {
+        if (!flux_watcher_is_active (ctx->batch.timer_w)) {
+            flux_timer_watcher_reset (ctx->batch.timer_w,
+                                      ctx->batch.window,
+                                      0.);
+            flux_watcher_start (ctx->batch.timer_w);
+        }
+    }
+    else {
+        flux_watcher_start (ctx->batch.check_w);
+        flux_watcher_start (ctx->batch.idle_w); // keep reactor from blocking
+    }
+}
+
+static void store_batch_check_cb (flux_reactor_t *r,
+                                  flux_watcher_t *w,
+                                  int revents,
+                                  void *arg)
+{
+    struct content_sqlite *ctx = arg;
+
+    /* Let the batch grow while more requests are waiting to be handled.
+     */
+    if ((flux_pollevents (ctx->h) & FLUX_POLLIN))
+        return;
+    store_batch_commit (ctx);
+}
+
+static void store_batch_timer_cb (flux_reactor_t *r,
+                                  flux_watcher_t *w,
+                                  int revents,
+                                  void *arg)
+{
+    struct content_sqlite *ctx = arg;
+    store_batch_commit (ctx);
+}
+
 void store_cb (flux_t *h,
                flux_msg_handler_t *mh,
                const flux_msg_t *msg,
@@ -343,27 +705,211 @@ void store_cb (flux_t *h,
     uint8_t hash[BLOBREF_MAX_DIGEST_SIZE];
     int hash_size;
     struct timespec t0;
+    struct store_request *req;
 
     if (flux_request_decode_raw (msg, NULL, &data, &size) < 0) {
         flux_log_error (h, "store: request decode failed");
         goto error;
     }
+    if (store_batch_begin (ctx) < 0)
+        goto error;
     monotime (&t0);
     if ((hash_size = content_sqlite_store (ctx,
                                            data,
                                            size,
                                            hash,
-                                           sizeof (hash))) < 0)
+                                           sizeof (hash))) < 0) {
+        store_batch_check_rollback (ctx);
+        if (ctx->batch.in_transaction)
+            store_batch_arm (ctx);
         goto error;
+    }
     tstat_push (&ctx->stats.store, monotime_since (t0));
-    if (flux_respond_raw (h, msg, hash, hash_size) < 0)
-        flux_log_error (h, "store: flux_respond_raw");
+    filter_add (ctx, hash, hash_size);
+
+    req = &ctx->batch.req[ctx->batch.count++];
+    req->msg = flux_msg_incref (msg);
+    memcpy (req->hash, hash, hash_size);
+    req->hash_size = hash_size;
+    if (ctx->batch.count == STORE_BATCH_LIMIT)
+        store_batch_commit (ctx);
+    else
+        store_batch_arm (ctx);
     return;
 error:
     if (flux_respond_error (h, msg, errno, NULL) < 0)
         flux_log_error (h, "store: flux_respond_error");
 }
 
+/* Handle a content-backing.list request from the content garbage collector.
+ * The raw request payload is a hash digest cursor, or empty to start from
+ * the beginning.  The raw response payload is the digests of up to
+ * LIST_LIMIT stored blobs that follow the cursor in key order, or empty
+ * when there are no more.
+ */
+static void list_cb (flux_t *h,
+                     flux_msg_handler_t *mh,
+                     const flux_msg_t *msg,
+                     void *arg)
+{
+    struct content_sqlite *ctx = arg;
+    const void *cursor;
+    size_t cursor_size;
+    uint8_t *result = NULL;
+    int count = 0;
+    int rc;
+
+    if (flux_request_decode_raw (msg, NULL, &cursor, &cursor_size) < 0)
+        goto error;
+    if (cursor_size != 0 && cursor_size != ctx->hash_size) {
+        errno = EPROTO;
+        goto error;
+    }
+    if (!(result = malloc (LIST_LIMIT * ctx->hash_size)))
+        goto error;
+    if (sqlite3_bind_text (ctx->scan_stmt,
+                           1,
+                           cursor_size > 0 ? cursor : "",
+                           cursor_size,
+                           SQLITE_STATIC) != SQLITE_OK
+        || sqlite3_bind_int (ctx->scan_stmt, 2, LIST_LIMIT) != SQLITE_OK) {
+        log_sqlite_error (ctx, "list: binding parameters");
+        set_errno_from_sqlite_error (ctx);
+        goto error_reset;
+    }
+    while ((rc = sqlite3_step (ctx->scan_stmt)) == SQLITE_ROW) {
+        const void *hash = sqlite3_column_blob (ctx->scan_stmt, 0);
+
+        if (sqlite3_column_bytes (ctx->scan_stmt, 0) != ctx->hash_size)
+            continue;
+        memcpy (result + count++ * ctx->hash_size, hash, ctx->hash_size);
+    }
+    if (rc != SQLITE_DONE) {
+        log_sqlite_error (ctx, "list: executing stmt");
+        set_errno_from_sqlite_error (ctx);
+        goto error_reset;
+    }
+    sqlite3_reset (ctx->scan_stmt);
+    if (flux_respond_raw (h, msg, result, count * ctx->hash_size) < 0)
+        flux_log_error (h, "list: flux_respond_raw");
+    free (result);
+    return;
+error_reset:
+    ERRNO_SAFE_WRAP (sqlite3_reset, ctx->scan_stmt);
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "list: flux_respond_error");
+    free (result);
+}
+
+/* Delete blob with 'hash'.  On success, set 'bytes' to the size of the
+ * deleted record (0 if the blob was not found) and return 0.
+ * Returns -1 on error with errno set.
+ */
+static int content_sqlite_remove (struct content_sqlite *ctx,
+                                  const void *hash,
+                                  int hash_size,
+                                  int64_t *bytes)
+{
+    if (sqlite3_bind_text (ctx->objsize_stmt,
+                           1,
+                           (char *)hash,
+                           hash_size,
+                           SQLITE_STATIC) != SQLITE_OK
+        || sqlite3_bind_text (ctx->remove_stmt,
+                              1,
+                              (char *)hash,
+                              hash_size,
+                              SQLITE_STATIC) != SQLITE_OK) {
+        log_sqlite_error (ctx, "remove: binding key");
+        set_errno_from_sqlite_error (ctx);
+        goto error;
+    }
+    *bytes = 0;
+    if (sqlite3_step (ctx->objsize_stmt) == SQLITE_ROW)
+        *bytes = sqlite3_column_int64 (ctx->objsize_stmt, 0) + hash_size;
+    sqlite3_reset (ctx->objsize_stmt);
+    if (sqlite3_step (ctx->remove_stmt) != SQLITE_DONE) {
+        log_sqlite_error (ctx, "remove: executing stmt");
+        set_errno_from_sqlite_error (ctx);
+        goto error;
+    }
+    sqlite3_reset (ctx->remove_stmt);
+    return 0;
+error:
+    ERRNO_SAFE_WRAP (sqlite3_reset, ctx->objsize_stmt);
+    ERRNO_SAFE_WRAP (sqlite3_reset, ctx->remove_stmt);
+    return -1;
+}
+
+/* Handle a content-backing.remove request from the content garbage
+ * collector.  The raw request payload is an array of hash digests.
+ * Blobs are deleted in one transaction.  The response reports the number
+ * of blobs and bytes that were removed.
+ */
+static void remove_cb (flux_t *h,
+                       flux_msg_handler_t *mh,
+                       const flux_msg_t *msg,
+                       void *arg)
+{
+    struct content_sqlite *ctx = arg;
+    const uint8_t *hashes;
+    size_t size;
+    int count = 0;
+    int64_t total = 0;
+    int i;
+
+    if (flux_request_decode_raw (msg, NULL, (const void **)&hashes, &size) < 0)
+        goto error;
+    if (size % ctx->hash_size != 0) {
+        errno = EPROTO;
+        goto error;
+    }
+    store_batch_commit (ctx);
+    if (sqlite3_exec (ctx->db, "BEGIN", NULL, NULL, NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "remove: beginning transaction");
+        set_errno_from_sqlite_error (ctx);
+        goto error;
+    }
+    for (i = 0; i < size / ctx->hash_size; i++) {
+        int64_t bytes;
+
+        if (content_sqlite_remove (ctx,
+                                   hashes + i * ctx->hash_size,
+                                   ctx->hash_size,
+                                   &bytes) < 0)
+            goto error_rollback;
+        if (bytes > 0) {
+            count++;
+            total += bytes;
+        }
+    }
+    if (sqlite3_exec (ctx->db, "COMMIT", NULL, NULL, NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "remove: committing transaction");
+        set_errno_from_sqlite_error (ctx);
+        goto error_rollback;
+    }
+    ctx->stats.removed_count += count;
+    ctx->stats.removed_bytes += total;
+    if (flux_respond_pack (h,
+                           msg,
+                           "{s:i s:I}",
+                           "count", count,
+                           "bytes", (json_int_t)total) < 0)
+        flux_log_error (h, "remove: flux_respond_pack");
+    return;
+error_rollback:
+    if (!sqlite3_get_autocommit (ctx->db)) {
+        int saved_errno = errno;
+        if (sqlite3_exec (ctx->db, "ROLLBACK", NULL, NULL, NULL) != SQLITE_OK)
+            log_sqlite_error (ctx, "remove: rolling back transaction");
+        errno = saved_errno;
+    }
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "remove: flux_respond_error");
+}
+
 void checkpoint_get_cb (flux_t *h,
                         flux_msg_handler_t *mh,
                         const flux_msg_t *msg,
@@ -445,6 +991,9 @@ void checkpoint_put_cb (flux_t *h,
                              "value",
                              &o) < 0)
         goto error;
+    /* Ensure blobs referenced by the checkpoint are committed first.
+     */
+    store_batch_commit (ctx);
     if (!(value = json_dumps (o, JSON_COMPACT))) {
         errstr = "failed to encode checkpoint value";
         errno = EINVAL;
@@ -498,6 +1047,22 @@ static void content_sqlite_closedb (struct content_sqlite *ctx)
             if (sqlite3_finalize (ctx->load_stmt) != SQLITE_OK)
                 log_sqlite_error (ctx, "sqlite_finalize load_stmt");
         }
+        if (ctx->has_stmt) {
+            if (sqlite3_finalize (ctx->has_stmt) != SQLITE_OK)
+                log_sqlite_error (ctx, "sqlite_finalize has_stmt");
+        }
+        if (ctx->scan_stmt) {
+            if (sqlite3_finalize (ctx->scan_stmt) != SQLITE_OK)
+                log_sqlite_error (ctx, "sqlite_finalize scan_stmt");
+        }
+        if (ctx->objsize_stmt) {
+            if (sqlite3_finalize (ctx->objsize_stmt) != SQLITE_OK)
+                log_sqlite_error (ctx, "sqlite_finalize objsize_stmt");
+        }
+        if (ctx->remove_stmt) {
+            if (sqlite3_finalize (ctx->remove_stmt) != SQLITE_OK)
+                log_sqlite_error (ctx, "sqlite_finalize remove_stmt");
+        }
         if (ctx->checkpt_get_stmt) {
             if (sqlite3_finalize (ctx->checkpt_get_stmt) != SQLITE_OK)
                 log_sqlite_error (ctx, "sqlite_finalize checkpt_get_stmt");
@@ -578,6 +1143,8 @@ void stats_get_cb (flux_t *h,
     const char *errmsg = NULL;
     json_t *load_time = NULL;
     json_t *store_time = NULL;
+    json_t *commit_time = NULL;
+    json_t *batch_size = NULL;
 
     if (sqlite3_exec (ctx->db,
                       sql_objects_count,
@@ -589,28 +1156,49 @@ void stats_get_cb (flux_t *h,
         goto error;
     }
     if (!(load_time = pack_tstat (&ctx->stats.load))
-        || !(store_time = pack_tstat (&ctx->stats.store)))
+        || !(store_time = pack_tstat (&ctx->stats.store))
+        || !(commit_time = pack_tstat (&ctx->stats.commit))
+        || !(batch_size = pack_tstat (&ctx->stats.batch_size)))
         goto error;
     if (flux_respond_pack (h,
                            msg,
-                           "{s:i s:I s:I s:O s:O s:{s:s s:s}}",
+                           "{s:i s:I s:I s:O s:O s:O s:O"
+                           " s:{s:b s:I s:I}"
+                           " s:{s:I s:I}"
+                           " s:{s:s s:s s:f}}",
                            "object_count", count,
                            "dbfile_size", get_file_size (ctx->dbfile),
                            "dbfile_free", get_fs_free (ctx->dbfile),
                            "load_time", load_time,
                            "store_time", store_time,
+                           "commit_time", commit_time,
+                           "batch_size", batch_size,
+                           "filter",
+                             "ready", ctx->filter.ready,
+                             "count", (json_int_t)(ctx->filter.bloom
+                                 ? bloom_count (ctx->filter.bloom) : 0),
+                             "bytes", (json_int_t)(ctx->filter.bloom
+                                 ? bloom_size (ctx->filter.bloom) : 0),
+                           "removed",
+                             "count", (json_int_t)ctx->stats.removed_count,
+                             "bytes", (json_int_t)ctx->stats.removed_bytes,
                            "config",
                              "journal_mode", ctx->journal_mode,
-                             "synchronous", ctx->synchronous) < 0)
+                             "synchronous", ctx->synchronous,
+                             "batch_window", ctx->batch.window) < 0)
         flux_log_error (h, "error responding to stats-get request");
     json_decref (load_time);
     json_decref (store_time);
+    json_decref (commit_time);
+    json_decref (batch_size);
     return;
 error:
     if (flux_respond_error (h, msg, errno, errmsg) < 0)
         flux_log_error (h, "error responding to stats-get request");
     json_decref (load_time);
     json_decref (store_time);
+    json_decref (commit_time);
+    json_decref (batch_size);
 }
 
 /* Open the database file ctx->dbfile and set up the database.
@@ -694,6 +1282,38 @@ static int content_sqlite_opendb (struct content_sqlite *ctx, bool truncate)
         log_sqlite_error (ctx, "preparing store stmt");
         goto error;
     }
+    if (sqlite3_prepare_v2 (ctx->db,
+                            sql_has,
+                            -1,
+                            &ctx->has_stmt,
+                            NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "preparing has stmt");
+        goto error;
+    }
+    if (sqlite3_prepare_v2 (ctx->db,
+                            sql_scan,
+                            -1,
+                            &ctx->scan_stmt,
+                            NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "preparing scan stmt");
+        goto error;
+    }
+    if (sqlite3_prepare_v2 (ctx->db,
+                            sql_objsize,
+                            -1,
+                            &ctx->objsize_stmt,
+                            NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "preparing objsize stmt");
+        goto error;
+    }
+    if (sqlite3_prepare_v2 (ctx->db,
+                            sql_remove,
+                            -1,
+                            &ctx->remove_stmt,
+                            NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "preparing remove stmt");
+        goto error;
+    }
     if (sqlite3_prepare_v2 (ctx->db,
                             sql_checkpt_get,
                             -1,
@@ -720,11 +1340,16 @@ static int content_sqlite_opendb (struct content_sqlite *ctx, bool truncate)
     }
     flux_log (ctx->h,
               LOG_DEBUG,
-              "%s (%d objects) journal_mode=%s synchronous=%s",
+              "%s (%d objects) journal_mode=%s synchronous=%s batch_window=%gs",
               ctx->dbfile,
               count,
               ctx->journal_mode,
-              ctx->synchronous);
+              ctx->synchronous,
+              ctx->batch.window);
+    if (filter_reset (ctx, count) < 0) {
+        flux_log_error (ctx->h, "error creating hash filter");
+        goto error;
+    }
     return 0;
 error:
     set_errno_from_sqlite_error (ctx);
@@ -736,6 +1361,11 @@ static void content_sqlite_destroy (struct content_sqlite *ctx)
     if (ctx) {
         int saved_errno = errno;
         flux_msg_handler_delvec (ctx->handlers);
+        flux_watcher_destroy (ctx->batch.check_w);
+        flux_watcher_destroy (ctx->batch.idle_w);
+        flux_watcher_destroy (ctx->batch.timer_w);
+        flux_watcher_destroy (ctx->filter.idle_w);
+        bloom_destroy (ctx->filter.bloom);
         free (ctx->dbfile);
         free (ctx->lzo_buf);
         free (ctx->hashfun);
@@ -749,6 +1379,9 @@ static void content_sqlite_destroy (struct content_sqlite *ctx)
 static const struct flux_msg_handler_spec htab[] = {
     { FLUX_MSGTYPE_REQUEST, "content-backing.load",    load_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "content-backing.store",   store_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "content-backing.has",     has_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "content-backing.list",    list_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "content-backing.remove",  remove_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "content-backing.checkpoint-get",
                             checkpoint_get_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "content-backing.checkpoint-put",
@@ -760,6 +1393,7 @@ static const struct flux_msg_handler_spec htab[] = {
 
 static struct content_sqlite *content_sqlite_create (flux_t *h)
 {
+    flux_reactor_t *r = flux_get_reactor (h);
     struct content_sqlite *ctx;
     const char *dbdir;
     const char *s;
@@ -768,6 +1402,20 @@ static struct content_sqlite *content_sqlite_create (flux_t *h)
         return NULL;
     if (!(ctx->lzo_buf = calloc (1, lzo_buf_chunksize)))
         goto error;
+    ctx->batch.window = default_batch_window;
+    if (!(ctx->batch.check_w = flux_check_watcher_create (r,
+                                                          store_batch_check_cb,
+                                                          ctx))
+        || !(ctx->batch.idle_w = flux_idle_watcher_create (r, NULL, NULL))
+        || !(ctx->batch.timer_w = flux_timer_watcher_create (r,
+                                                             0.,
+                                                             0.,
+                                                             store_batch_timer_cb,
+                                                             ctx))
+        || !(ctx->filter.idle_w = flux_idle_watcher_create (r,
+                                                            filter_scan_cb,
+                                                            ctx)))
+        goto error;
     ctx->lzo_bufsize = lzo_buf_chunksize;
     ctx->h = h;
     if (set_config (&ctx->journal_mode, "WAL") < 0)
@@ -848,19 +1496,34 @@ static bool synchronous_valid (const char *s)
     return true;
 }
 
+static int parse_batch_window (struct content_sqlite *ctx, const char *s)
+{
+    double window;
+
+    if (fsd_parse_duration (s, &window) < 0) {
+        flux_log (ctx->h, LOG_ERR, "invalid batch_window specified");
+        errno = EINVAL;
+        return -1;
+    }
+    ctx->batch.window = window;
+    return 0;
+}
+
 static int process_config (struct content_sqlite *ctx,
                            const flux_conf_t *conf)
 {
     flux_error_t error;
     const char *journal_mode = NULL;
     const char *synchronous = NULL;
+    const char *batch_window = NULL;
 
     if (flux_conf_unpack (conf,
                           &error,
-                          "{s?{s?s s?s}}",
+                          "{s?{s?s s?s s?s}}",
                           "content-sqlite",
                             "journal_mode", &journal_mode,
-                            "synchronous", &synchronous) < 0) {
+                            "synchronous", &synchronous,
+                            "batch_window", &batch_window) < 0) {
         flux_log_error (ctx->h, "%s", error.text);
         return -1;
     }
@@ -882,6 +1545,10 @@ static int process_config (struct content_sqlite *ctx,
         if (set_config (&ctx->synchronous, synchronous) < 0)
             return -1;
     }
+    if (batch_window) {
+        if (parse_batch_window (ctx, batch_window) < 0)
+            return -1;
+    }
     return 0;
 }
 
@@ -910,6 +1577,10 @@ static int process_args (struct content_sqlite *ctx,
             if (set_config (&ctx->synchronous, argv[i] + 12) < 0)
                 return -1;
         }
+        else if (strstarts (argv[i], "batch_window=")) {
+            if (parse_batch_window (ctx, argv[i] + 13) < 0)
+                return -1;
+        }
         else if (streq ("truncate", argv[i])) {
             *truncate = true;
         }
@@ -950,6 +1621,7 @@ int mod_main (flux_t *h, int argc, char **argv)
 done_unreg:
     (void)content_unregister_backing_store (h);
 done:
+    store_batch_commit (ctx);
     content_sqlite_closedb (ctx);
     content_sqlite_destroy (ctx);
     return rc;
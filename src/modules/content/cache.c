@@ -23,12 +23,15 @@
 #include "src/common/libutil/blobref.h"
 #include "src/common/libutil/iterators.h"
 #include "src/common/libutil/log.h"
+#include "src/common/libutil/fsd.h"
 #include "src/common/libcontent/content.h"
 #include "ccan/str/str.h"
 
 #include "cache.h"
 #include "checkpoint.h"
 #include "mmap.h"
+#include "hashpool.h"
+#include "gc.h"
 
 /* A periodic callback purges the cache of least recently used entries.
  * The callback is synchronized with the instance heartbeat, with a
@@ -41,6 +44,17 @@ static const char *default_hash = "sha1";
 static const uint32_t default_cache_purge_target_size = 1024*1024*16;
 static const uint32_t default_cache_purge_old_entry = 10; // seconds
 
+/* Valid, clean entries are evicted as soon as the cache exceeds
+ * 'cache-size-limit' bytes, excluding mmapped entries.  Set to 0 to disable
+ * and rely only on the periodic purge.
+ */
+static const uint32_t default_cache_size_limit = 1024*1024*256;
+
+/* Maximum share of the cache size limit that may be occupied by entries
+ * on the frequently used list.
+ */
+static const double frequent_fraction = 0.75;
+
 /* Raise the max blob size value to 1GB so that large KVS values
  * (including KVS directories) can be supported while the KVS transitions
  * to the RFC 11 treeobj data representation.
@@ -50,6 +64,24 @@ static const uint32_t default_blob_size_limit = 1048576*1024;
 
 static const uint32_t default_flush_batch_limit = 256;
 
+/* Blobs of at least 'hash_threshold' bytes are hashed by a pool of
+ * 'hash_threads' worker threads, created on demand, instead of inline
+ * in the store request handler.  Set hash_threads to 0 to disable.
+ */
+static const uint32_t default_hash_threshold = 256*1024;
+static const uint32_t default_hash_threads = 2;
+
+/* Periodic garbage collection of the backing store (rank 0) is disabled
+ * unless 'gc_period' is set.  Collections started by the timer examine at
+ * most 'gc_rate' blobs per second.
+ */
+static const uint32_t default_gc_rate = 10000;
+
+/* A content.load-batch request starts loads for at most this many
+ * entries beyond the one it is waiting on.
+ */
+static const int load_batch_prefetch = 64;
+
 /* Hash digests are used as zhashx keys.  The digest size needs to be
  * available to zhashx comparator so make this global.
  */
@@ -72,6 +104,7 @@ struct cache_entry {
     uint8_t load_pending:1;
     uint8_t store_pending:1;
     uint8_t mmapped:1;
+    uint8_t frequent:1;             // entry is on the lru_frequent list
     struct msgstack *load_requests;
     struct msgstack *store_requests;
     double lastused;
@@ -79,6 +112,15 @@ struct cache_entry {
     struct list_node list;
 };
 
+struct load_batch {
+    const flux_msg_t *msg;
+    const uint8_t *hashes;          // digests in request payload
+    int count;
+    int next;                       // index of next digest to respond to
+    int prefetch;                   // index of next digest to prefetch
+    struct list_node list;
+};
+
 struct content_cache {
     flux_t *h;
     flux_reactor_t *reactor;
@@ -92,6 +134,7 @@ struct content_cache {
     struct msgstack *flush_requests;
 
     struct list_head lru;           // LRU is for valid, clean entries only
+    struct list_head lru_frequent;  //   (accessed more than once)
     struct list_head flush;         // dirties queued due to batch limit
 
     uint32_t blob_size_limit;
@@ -101,17 +144,37 @@ struct content_cache {
 
     uint32_t purge_target_size;
     uint32_t purge_old_entry;
+    uint32_t size_limit;
+
+    uint32_t hash_threshold;
+    uint32_t hash_threads;
+    struct hashpool *hashpool;
+
+    struct list_head load_batches;  // active content.load-batch requests
 
     uint64_t acct_size;             // total size of all cache entries
+    uint64_t acct_mmapped_size;     // size of mmapped entries
+    uint64_t acct_frequent_size;    // size of entries on lru_frequent
+    uint64_t acct_hits;             // load requests satisfied from cache
+    uint64_t acct_misses;           // load requests that were not
+    uint64_t acct_evictions;        // entries evicted due to size_limit
     uint32_t acct_valid;            // count of valid cache entries
     uint32_t acct_dirty;            // count of dirty cache entries
 
+    double gc_period;
+    uint32_t gc_rate;
+
     struct content_checkpoint *checkpoint;
     struct content_mmap *mmap;
+    struct content_gc *gc;
 };
 
 static void flush_respond (struct content_cache *cache);
 static int cache_flush (struct content_cache *cache);
+static void load_batch_resume (struct content_cache *cache,
+                               struct cache_entry *e,
+                               int errnum,
+                               const char *errmsg);
 
 static int msgstack_push (struct msgstack **msp, const flux_msg_t *msg)
 {
@@ -240,6 +303,61 @@ static struct cache_entry *cache_entry_create (const void *hash)
     return e;
 }
 
+/* Clean entries are kept on two LRU lists in the style of a segmented LRU,
+ * which makes the cache resistant to scans.  An entry starts out on the
+ * probationary 'lru' list and is promoted to 'lru_frequent' when it is
+ * accessed again.  Eviction takes from the tail of 'lru' first, so a one-time
+ * pass over many blobs (e.g. flux dump) cannot push out the working set.
+ * 'lru_frequent' may hold at most frequent_fraction of the size limit.
+ * Its overflow is demoted to the head of 'lru'.
+ */
+static void lru_insert (struct content_cache *cache, struct cache_entry *e)
+{
+    e->frequent = 0;
+    list_add (&cache->lru, &e->list);
+    e->lastused = flux_reactor_now (cache->reactor);
+}
+
+static void lru_demote (struct content_cache *cache, struct cache_entry *e)
+{
+    list_del_from (&cache->lru_frequent, &e->list);
+    cache->acct_frequent_size -= e->len;
+    e->frequent = 0;
+    list_add (&cache->lru, &e->list);
+}
+
+static void lru_touch (struct content_cache *cache, struct cache_entry *e)
+{
+    list_del (&e->list);
+    if (!e->frequent) {
+        e->frequent = 1;
+        cache->acct_frequent_size += e->len;
+    }
+    list_add (&cache->lru_frequent, &e->list);
+    e->lastused = flux_reactor_now (cache->reactor);
+
+    if (cache->size_limit > 0) {
+        uint64_t max = cache->size_limit * frequent_fraction;
+        struct cache_entry *victim;
+
+        while (cache->acct_frequent_size > max
+               && (victim = list_tail (&cache->lru_frequent,
+                                       struct cache_entry,
+                                       list))
+               && victim != e)
+            lru_demote (cache, victim);
+    }
+}
+
+static void lru_remove (struct content_cache *cache, struct cache_entry *e)
+{
+    list_del (&e->list);
+    if (e->frequent) {
+        cache->acct_frequent_size -= e->len;
+        e->frequent = 0;
+    }
+}
+
 static void cache_entry_dirty_clear (struct content_cache *cache,
                                      struct cache_entry *e)
 {
@@ -248,8 +366,7 @@ static void cache_entry_dirty_clear (struct content_cache *cache,
         e->dirty = 0;
 
         assert (e->valid);
-        list_add (&cache->lru, &e->list);
-        e->lastused = flux_reactor_now (cache->reactor);
+        lru_insert (cache, e);
 
         request_list_respond_raw (&e->store_requests,
                                   cache->h,
@@ -300,11 +417,8 @@ static struct cache_entry *cache_entry_lookup (struct content_cache *cache,
     if (!(e = zhashx_lookup (cache->entries, hash)))
         return NULL;
 
-    if (e->valid && !e->dirty) {
-        list_del_from (&cache->lru, &e->list);
-        list_add (&cache->lru, &e->list);
-        e->lastused = flux_reactor_now (cache->reactor);
-    }
+    if (e->valid && !e->dirty)
+        lru_touch (cache, e);
 
     return e;
 }
@@ -317,14 +431,51 @@ static void cache_entry_remove (struct content_cache *cache,
     assert (e->load_requests == NULL);
     assert (e->store_requests == NULL);
     assert (!e->dirty);
-    list_del (&e->list);
+    lru_remove (cache, e);
     if (e->valid) {
         cache->acct_size -= e->len;
         cache->acct_valid--;
+        if (e->mmapped)
+            cache->acct_mmapped_size -= e->len;
     }
     zhashx_delete (cache->entries, e->hash);
 }
 
+static bool cache_over_limit (struct content_cache *cache)
+{
+    return (cache->size_limit > 0
+            && cache->acct_size - cache->acct_mmapped_size > cache->size_limit);
+}
+
+static void cache_evict_from (struct content_cache *cache,
+                              struct list_head *list)
+{
+    struct cache_entry *e = NULL;
+    struct cache_entry *next;
+
+    list_for_each_rev_safe (list, e, next, list) {
+        if (!cache_over_limit (cache))
+            break;
+        if (e->mmapped || e->load_pending || e->store_pending)
+            continue;
+        assert (e->valid);
+        assert (!e->dirty);
+        cache_entry_remove (cache, e);
+        cache->acct_evictions++;
+    }
+}
+
+/* Evict clean entries until the cache is within its size limit,
+ * least valuable first.
+ */
+static void cache_evict (struct content_cache *cache)
+{
+    if (cache_over_limit (cache))
+        cache_evict_from (cache, &cache->lru);
+    if (cache_over_limit (cache))
+        cache_evict_from (cache, &cache->lru_frequent);
+}
+
 /* Load operation
  *
  * If a cache entry is already present and valid, response is immediate.
@@ -342,6 +493,7 @@ static void cache_load_continuation (flux_future_t *f, void *arg)
     struct cache_entry *e = flux_future_aux_get (f, "entry");
     const flux_msg_t *msg;
     const char *errmsg = NULL;
+    int errnum;
 
     e->load_pending = 0;
     if (flux_future_get (f, (const void **)&msg) < 0) {
@@ -369,23 +521,26 @@ static void cache_load_continuation (flux_future_t *f, void *arg)
             e->ephemeral = 1;
         cache->acct_valid++;
         cache->acct_size += e->len;
-        list_add (&cache->lru, &e->list);
-        e->lastused = flux_reactor_now (cache->reactor);
+        lru_insert (cache, e);
         request_list_respond_raw (&e->load_requests,
                                   cache->h,
                                   e->ephemeral ? FLUX_MSGFLAG_USER1 : 0,
                                   e->data,
                                   e->len,
                                   "load");
+        load_batch_resume (cache, e, 0, NULL);
     }
     flux_future_destroy (f);
+    cache_evict (cache);
     return;
 error:
+    errnum = errno;
     request_list_respond_error (&e->load_requests,
                                 cache->h,
-                                errno,
+                                errnum,
                                 errmsg,
                                 "load");
+    load_batch_resume (cache, e, errnum, errmsg);
     cache_entry_remove (cache, e);
     flux_future_destroy (f);
 }
@@ -410,24 +565,26 @@ static int cache_load (struct content_cache *cache, struct cache_entry *e)
     return 0;
 }
 
-static void content_load_request (flux_t *h,
-                                  flux_msg_handler_t *mh,
-                                  const flux_msg_t *msg,
-                                  void *arg)
+/* Look up the cache entry for 'hash', creating it if necessary.
+ * On rank 0, a new entry is filled from an mmapped region if possible.
+ * If the entry is not valid, a load is started (if not already pending).
+ * If 'account' is true, count the lookup as a cache hit or miss.
+ * Returns entry on success, or NULL with errno set on failure.
+ */
+static struct cache_entry *cache_entry_load (struct content_cache *cache,
+                                             const void *hash,
+                                             int hash_size,
+                                             bool account)
 {
-    struct content_cache *cache = arg;
-    const void *hash;
-    size_t hash_size;
     struct cache_entry *e;
-    const char *errmsg = NULL;
 
-    if (flux_request_decode_raw (msg, NULL, &hash, &hash_size) < 0)
-        goto error;
-    if (hash_size != content_hash_size) {
-        errno = EPROTO;
-        goto error;
+    if ((e = cache_entry_lookup (cache, hash, hash_size)) && e->valid) {
+        if (account)
+            cache->acct_hits++;
     }
-    if (!(e = cache_entry_lookup (cache, hash, hash_size))) {
+    else if (account)
+        cache->acct_misses++;
+    if (!e) {
         struct content_region *region = NULL;
         const void *data = NULL;
         int len = 0;
@@ -440,12 +597,12 @@ static void content_load_request (flux_t *h,
                                                  &len);
             if (!region && !cache->backing) {
                 errno = ENOENT;
-                goto error;
+                return NULL;
             }
         }
         if (!(e = cache_entry_insert (cache, hash, hash_size))) {
-            flux_log_error (h, "content load");
-            goto error;
+            flux_log_error (cache->h, "content load");
+            return NULL;
         }
         if (region) {
             e->data_container = content_mmap_region_incref (region);
@@ -456,49 +613,370 @@ static void content_load_request (flux_t *h,
             e->mmapped = 1;
             cache->acct_valid++;
             cache->acct_size += e->len;
-            list_add (&cache->lru, &e->list);
-            e->lastused = flux_reactor_now (cache->reactor);
+            cache->acct_mmapped_size += e->len;
+            lru_insert (cache, e);
         }
     }
     if (!e->valid) {
         if (cache_load (cache, e) < 0)
-            goto error;
-        if (msgstack_push (&e->load_requests, msg) < 0) {
-            flux_log_error (h, "content load");
-            goto error;
-        }
-        return; /* RPC continuation will respond to msg */
+            return NULL;
     }
-    if (e->valid && e->mmapped) { // rank 0 only
+    return e;
+}
+
+/* Respond to load request 'msg' with the content of valid entry 'e'.
+ * The response has FLUX_MSGFLAG_USER1 set to represent the ephemeral flag.
+ * Returns 0 on success, or -1 with errno set (and *errmsg possibly set)
+ * if the entry is mmapped and no longer matches its hash.
+ */
+static int cache_entry_respond (struct content_cache *cache,
+                                const flux_msg_t *msg,
+                                struct cache_entry *e,
+                                const char **errmsg)
+{
+    flux_msg_t *response;
+
+    if (e->mmapped) { // rank 0 only
         if (!content_mmap_validate (e->data_container,
                                     e->hash,
                                     content_hash_size,
                                     e->data,
                                     e->len)) {
-            errmsg = "mapped file content has changed";
+            *errmsg = "mapped file content has changed";
             errno = EINVAL;
-            goto error;
+            return -1;
         }
     }
-
-    /* Send load response with FLUX_MSGFLAG_USER1 representing the
-     * ephemeral flag, if set.
-     */
-    flux_msg_t *response;
     if (!(response = flux_response_derive (msg, 0))
         || flux_msg_set_payload (response, e->data, e->len) < 0
         || (e->ephemeral
             && flux_msg_set_flag (response, FLUX_MSGFLAG_USER1) < 0)
-        || flux_send (h, response, 0) < 0) {
-        flux_log_error (h, "content load: error sending response");
+        || flux_send (cache->h, response, 0) < 0) {
+        flux_log_error (cache->h, "content load: error sending response");
     }
     flux_msg_decref (response);
+    return 0;
+}
+
+static void content_load_request (flux_t *h,
+                                  flux_msg_handler_t *mh,
+                                  const flux_msg_t *msg,
+                                  void *arg)
+{
+    struct content_cache *cache = arg;
+    const void *hash;
+    size_t hash_size;
+    struct cache_entry *e;
+    const char *errmsg = NULL;
+
+    if (flux_request_decode_raw (msg, NULL, &hash, &hash_size) < 0)
+        goto error;
+    if (hash_size != content_hash_size) {
+        errno = EPROTO;
+        goto error;
+    }
+    if (!(e = cache_entry_load (cache, hash, hash_size, true)))
+        goto error;
+    if (!e->valid) {
+        if (msgstack_push (&e->load_requests, msg) < 0) {
+            flux_log_error (h, "content load");
+            goto error;
+        }
+        return; /* RPC continuation will respond to msg */
+    }
+    if (cache_entry_respond (cache, msg, e, &errmsg) < 0)
+        goto error;
     return;
 error:
     if (flux_respond_error (h, msg, errno, errmsg) < 0)
         flux_log_error (h, "content load: flux_respond_error");
 }
 
+/* Batch load operation
+ *
+ * A content.load-batch request carries an array of hash digests.  It is a
+ * streaming RPC: one response is sent per digest, in request order, then
+ * the stream is terminated with ENODATA.  An error loading any blob
+ * terminates the stream with that error.
+ *
+ * Responses are sent in order as entries become valid.  While waiting on
+ * the next entry, loads are started for up to 'load_batch_prefetch'
+ * subsequent entries so that misses are resolved concurrently rather than
+ * one round trip at a time.  Loads are shared with other requests in the
+ * usual way.  A batch holds no entry references, so prefetched entries may
+ * be evicted before they are sent, in which case they are simply reloaded.
+ */
+
+static void load_batch_destroy (struct load_batch *b)
+{
+    if (b) {
+        int saved_errno = errno;
+        list_del (&b->list);
+        flux_msg_decref (b->msg);
+        free (b);
+        errno = saved_errno;
+    }
+}
+
+static const void *load_batch_hash (struct load_batch *b, int index)
+{
+    return b->hashes + index * content_hash_size;
+}
+
+/* Respond to as many digests as possible, then prefetch.
+ * The batch is destroyed when the stream is terminated.
+ */
+static void load_batch_run (struct content_cache *cache, struct load_batch *b)
+{
+    struct cache_entry *e;
+    const char *errmsg = NULL;
+
+    while (b->next < b->count) {
+        if (!(e = cache_entry_load (cache,
+                                    load_batch_hash (b, b->next),
+                                    content_hash_size,
+                                    b->next >= b->prefetch)))
+            goto error;
+        if (!e->valid)
+            break;
+        if (cache_entry_respond (cache, b->msg, e, &errmsg) < 0)
+            goto error;
+        b->next++;
+    }
+    if (b->next == b->count) {
+        errno = ENODATA;
+        goto error;
+    }
+    if (b->prefetch <= b->next)
+        b->prefetch = b->next + 1;
+    while (b->prefetch < b->count
+           && b->prefetch - b->next <= load_batch_prefetch) {
+        /* Errors are reported if/when the digest becomes next in line.
+         */
+        (void)cache_entry_load (cache,
+                                load_batch_hash (b, b->prefetch),
+                                content_hash_size,
+                                true);
+        b->prefetch++;
+    }
+    return;
+error:
+    if (flux_respond_error (cache->h, b->msg, errno, errmsg) < 0)
+        flux_log_error (cache->h, "content load-batch: flux_respond_error");
+    load_batch_destroy (b);
+}
+
+/* Entry 'e' was loaded (errnum == 0) or failed to load.
+ * Resume batches that are waiting on it.
+ */
+static void load_batch_resume (struct content_cache *cache,
+                               struct cache_entry *e,
+                               int errnum,
+                               const char *errmsg)
+{
+    struct load_batch *b;
+    struct load_batch *next;
+
+    list_for_each_safe (&cache->load_batches, b, next, list) {
+        if (memcmp (load_batch_hash (b, b->next),
+                    e->hash,
+                    content_hash_size) != 0)
+            continue;
+        if (errnum == 0)
+            load_batch_run (cache, b);
+        else {
+            if (flux_respond_error (cache->h, b->msg, errnum, errmsg) < 0)
+                flux_log_error (cache->h,
+                                "content load-batch: flux_respond_error");
+            load_batch_destroy (b);
+        }
+    }
+}
+
+static void content_load_batch_request (flux_t *h,
+                                        flux_msg_handler_t *mh,
+                                        const flux_msg_t *msg,
+                                        void *arg)
+{
+    struct content_cache *cache = arg;
+    const void *data;
+    size_t size;
+    struct load_batch *b;
+
+    if (flux_request_decode_raw (msg, NULL, &data, &size) < 0)
+        goto error;
+    if (!flux_msg_is_streaming (msg)
+        || size == 0
+        || size % content_hash_size != 0) {
+        errno = EPROTO;
+        goto error;
+    }
+    if (!(b = calloc (1, sizeof (*b))))
+        goto error;
+    b->msg = flux_msg_incref (msg);
+    b->hashes = data;
+    b->count = size / content_hash_size;
+    list_node_init (&b->list);
+    list_add_tail (&cache->load_batches, &b->list);
+    load_batch_run (cache, b);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "content load-batch: flux_respond_error");
+}
+
+static void content_disconnect_request (flux_t *h,
+                                        flux_msg_handler_t *mh,
+                                        const flux_msg_t *msg,
+                                        void *arg)
+{
+    struct content_cache *cache = arg;
+    struct load_batch *b;
+    struct load_batch *next;
+
+    list_for_each_safe (&cache->load_batches, b, next, list) {
+        if (flux_disconnect_match (msg, b->msg))
+            load_batch_destroy (b);
+    }
+}
+
+/* Existence probe
+ *
+ * A content.has request carries an array of hash digests.  The response
+ * is an array of bytes in digest order, set to 1 if the blob is known to
+ * be stored and 0 if it is not.  A valid entry counts as stored unless it
+ * is ephemeral, since an ephemeral blob (e.g. mmapped on rank 0) is not
+ * destined for the backing store.  Digests that are not answered by this
+ * cache are forwarded in one request to the next level of TBON, or on
+ * rank 0, to the content-backing service if one is loaded.  A backing
+ * store that does not implement the probe (ENOSYS) is treated as holding
+ * none of them.  The probe does not affect the LRU or hit/miss accounting.
+ */
+
+struct has_request {
+    const flux_msg_t *msg;
+    char *result;
+    int count;
+    int *missing;                   // indices of forwarded digests
+    int missing_count;
+};
+
+static void has_request_destroy (struct has_request *hr)
+{
+    if (hr) {
+        int saved_errno = errno;
+        flux_msg_decref (hr->msg);
+        free (hr->result);
+        free (hr->missing);
+        free (hr);
+        errno = saved_errno;
+    }
+}
+
+static void cache_has_continuation (flux_future_t *f, void *arg)
+{
+    struct content_cache *cache = arg;
+    struct has_request *hr = flux_future_aux_get (f, "request");
+    const char *result;
+    int count;
+    int i;
+
+    if (content_has_get (f, &result, &count) < 0) {
+        if (errno != ENOSYS)
+            goto error;
+    }
+    else {
+        if (count != hr->missing_count) {
+            errno = EPROTO;
+            goto error;
+        }
+        for (i = 0; i < count; i++)
+            hr->result[hr->missing[i]] = result[i] ? 1 : 0;
+    }
+    if (flux_respond_raw (cache->h, hr->msg, hr->result, hr->count) < 0)
+        flux_log_error (cache->h, "content has: flux_respond_raw");
+    flux_future_destroy (f);
+    return;
+error:
+    if (flux_respond_error (cache->h,
+                            hr->msg,
+                            errno,
+                            flux_future_error_string (f)) < 0)
+        flux_log_error (cache->h, "content has: flux_respond_error");
+    flux_future_destroy (f);
+}
+
+static void content_has_request (flux_t *h,
+                                 flux_msg_handler_t *mh,
+                                 const flux_msg_t *msg,
+                                 void *arg)
+{
+    struct content_cache *cache = arg;
+    const uint8_t *hashes;
+    size_t size;
+    struct has_request *hr = NULL;
+    uint8_t *fwd = NULL;
+    flux_future_t *f = NULL;
+    int flags = CONTENT_FLAG_UPSTREAM;
+    int i;
+
+    if (flux_request_decode_raw (msg, NULL, (const void **)&hashes, &size) < 0)
+        goto error;
+    if (size == 0 || size % content_hash_size != 0) {
+        errno = EPROTO;
+        goto error;
+    }
+    if (!(hr = calloc (1, sizeof (*hr)))
+        || !(hr->result = calloc (1, size / content_hash_size))
+        || !(hr->missing = calloc (size / content_hash_size, sizeof (int)))
+        || !(fwd = malloc (size)))
+        goto error;
+    hr->count = size / content_hash_size;
+    for (i = 0; i < hr->count; i++) {
+        const uint8_t *hash = hashes + i * content_hash_size;
+        struct cache_entry *e = zhashx_lookup (cache->entries, hash);
+
+        content_gc_has (cache->gc, hash);
+        if (e && e->valid && !e->ephemeral)
+            hr->result[i] = 1;
+        else {
+            memcpy (fwd + hr->missing_count * content_hash_size,
+                    hash,
+                    content_hash_size);
+            hr->missing[hr->missing_count++] = i;
+        }
+    }
+    if (hr->missing_count == 0 || (cache->rank == 0 && !cache->backing)) {
+        if (flux_respond_raw (h, msg, hr->result, hr->count) < 0)
+            flux_log_error (h, "content has: flux_respond_raw");
+        goto done;
+    }
+    if (cache->rank == 0)
+        flags = CONTENT_FLAG_CACHE_BYPASS;
+    if (!(f = content_has_byhash (h,
+                                  fwd,
+                                  hr->missing_count * content_hash_size,
+                                  flags))
+        || flux_future_aux_set (f,
+                                "request",
+                                hr,
+                                (flux_free_f)has_request_destroy) < 0)
+        goto error;
+    hr->msg = flux_msg_incref (msg);
+    hr = NULL; // owned by future now
+    if (flux_future_then (f, -1., cache_has_continuation, cache) < 0)
+        goto error;
+    free (fwd);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "content has: flux_respond_error");
+done:
+    flux_future_destroy (f);
+    has_request_destroy (hr);
+    free (fwd);
+}
+
 /* Store operation
  *
  * If a cache entry is already valid and not dirty, response is immediate.
@@ -564,6 +1042,7 @@ static void cache_store_continuation (flux_future_t *f, void *arg)
     /* clear flush errno if backing store functional/recovered */
     cache->flush_errno = 0;
     flux_future_destroy (f);
+    cache_evict (cache);
     cache_resume_flush (cache);
     return;
 error:
@@ -623,35 +1102,26 @@ static int cache_store (struct content_cache *cache, struct cache_entry *e)
     return 0;
 }
 
-static void content_store_request (flux_t *h,
-                                   flux_msg_handler_t *mh,
-                                   const flux_msg_t *msg,
-                                   void *arg)
+/* Finish a store request once the hash digest of its payload is known.
+ */
+static void cache_store_hashed (struct content_cache *cache,
+                                const flux_msg_t *msg,
+                                const void *data,
+                                size_t len,
+                                const void *hash,
+                                int hash_size)
 {
-    struct content_cache *cache = arg;
-    const void *data;
-    size_t len;
+    flux_t *h = cache->h;
     struct cache_entry *e = NULL;
-    uint8_t hash[BLOBREF_MAX_DIGEST_SIZE];
-    int hash_size;
 
-    if (flux_request_decode_raw (msg, NULL, &data, &len) < 0)
-        goto error;
-    if (len > cache->blob_size_limit) {
-        errno = EFBIG;
-        goto error;
-    }
-    if ((hash_size = blobref_hash_raw (cache->hash_name,
-                                       data,
-                                       len,
-                                       hash,
-                                       sizeof (hash))) < 0)
-        goto error;
     /* If existing entry has the ephemeral bit set, remove it and let it be
      * replaced with a new entry.  N.B. it can be assumed that an entry with
      * the ephemeral bit set is valid and not dirty.
+     * Use zhashx_lookup() rather than cache_entry_lookup(): a store is not
+     * a use of the blob, so it should not promote the entry on the LRU.
      */
-    if ((e = cache_entry_lookup (cache, hash, hash_size))
+    if (hash_size == content_hash_size
+        && (e = zhashx_lookup (cache->entries, hash))
         && e->ephemeral) {
         cache_entry_remove (cache, e);
         e = NULL;
@@ -681,7 +1151,12 @@ static void content_store_request (flux_t *h,
                                   e->data,
                                   e->len,
                                   "load");
+        load_batch_resume (cache, e, 0, NULL);
     }
+    /* A store of a blob that is already cached may still be a new
+     * reference to it, so the collector must hear about every store.
+     */
+    content_gc_stored (cache->gc, e->hash, e->data, e->len);
     if (e->dirty) {
         if (cache->rank > 0 || cache->backing) {
             if (cache_store (cache, e) < 0)
@@ -701,6 +1176,110 @@ static void content_store_request (flux_t *h,
     }
     if (flux_respond_raw (h, msg, hash, hash_size) < 0)
         flux_log_error (h, "content store: flux_respond_raw");
+    cache_evict (cache);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "content store: flux_respond_error");
+}
+
+struct store_hash_request {
+    struct content_cache *cache;
+    const flux_msg_t *msg;
+};
+
+/* hashpool completion callback for a large blob.
+ */
+static void store_hash_continuation (const void *hash,
+                                     int hash_size,
+                                     int errnum,
+                                     void *arg)
+{
+    struct store_hash_request *req = arg;
+    struct content_cache *cache = req->cache;
+    const void *data;
+    size_t len;
+
+    if (errnum != 0) {
+        errno = errnum;
+        goto error;
+    }
+    if (flux_request_decode_raw (req->msg, NULL, &data, &len) < 0)
+        goto error;
+    cache_store_hashed (cache, req->msg, data, len, hash, hash_size);
+    flux_msg_decref (req->msg);
+    free (req);
+    return;
+error:
+    if (flux_respond_error (cache->h, req->msg, errno, NULL) < 0)
+        flux_log_error (cache->h, "content store: flux_respond_error");
+    flux_msg_decref (req->msg);
+    free (req);
+}
+
+/* Hand off a large blob to the hashpool, creating the pool if needed.
+ * The message holds the blob data until the digest is ready.
+ */
+static int cache_store_hash_async (struct content_cache *cache,
+                                   const flux_msg_t *msg,
+                                   const void *data,
+                                   size_t len)
+{
+    struct store_hash_request *req;
+
+    if (!cache->hashpool) {
+        if (!(cache->hashpool = hashpool_create (cache->reactor,
+                                                 cache->hash_name,
+                                                 cache->hash_threads))) {
+            flux_log_error (cache->h, "content store: hashpool_create");
+            return -1;
+        }
+    }
+    if (!(req = calloc (1, sizeof (*req))))
+        return -1;
+    req->cache = cache;
+    req->msg = flux_msg_incref (msg);
+    if (hashpool_submit (cache->hashpool,
+                         data,
+                         len,
+                         store_hash_continuation,
+                         req) < 0) {
+        flux_msg_decref (req->msg);
+        free (req);
+        return -1;
+    }
+    return 0;
+}
+
+static void content_store_request (flux_t *h,
+                                   flux_msg_handler_t *mh,
+                                   const flux_msg_t *msg,
+                                   void *arg)
+{
+    struct content_cache *cache = arg;
+    const void *data;
+    size_t len;
+    uint8_t hash[BLOBREF_MAX_DIGEST_SIZE];
+    int hash_size;
+
+    if (flux_request_decode_raw (msg, NULL, &data, &len) < 0)
+        goto error;
+    if (len > cache->blob_size_limit) {
+        errno = EFBIG;
+        goto error;
+    }
+    if (cache->hash_threads > 0 && len >= cache->hash_threshold) {
+        if (cache_store_hash_async (cache, msg, data, len) < 0)
+            goto error;
+        return; /* store_hash_continuation() will respond to msg */
+    }
+    if ((hash_size = blobref_hash_raw (cache->hash_name,
+                                       data,
+                                       len,
+                                       hash,
+                                       sizeof (hash))) < 0)
+        goto error;
+    cache_store_hashed (cache, msg, data, len, hash, hash_size);
     return;
 error:
     if (flux_respond_error (h, msg, errno, NULL) < 0)
@@ -844,6 +1423,9 @@ static void content_dropcache_request (flux_t *h,
     list_for_each_safe (&cache->lru, e, next, list) {
         cache_entry_remove (cache, e);
     }
+    list_for_each_safe (&cache->lru_frequent, e, next, list) {
+        cache_entry_remove (cache, e);
+    }
 
     flux_log (h, LOG_DEBUG, "content dropcache %d/%d",
               orig_size - (int)zhashx_size (cache->entries), orig_size);
@@ -861,18 +1443,29 @@ static void content_stats_request (flux_t *h,
 {
     struct content_cache *cache = arg;
     json_t *o = content_mmap_get_stats (cache->mmap);
+    json_t *hp = cache->hashpool ? hashpool_get_stats (cache->hashpool) : NULL;
+    json_t *gc = content_gc_get_stats (cache->gc);
 
     if (flux_respond_pack (h,
                            msg,
-                           "{s:i s:i s:i s:I s:i s:O}",
+                           "{s:i s:i s:i s:I s:I s:I s:I s:I s:I s:i s:O s:O s:O}",
                            "count", zhashx_size (cache->entries),
                            "valid", cache->acct_valid,
                            "dirty", cache->acct_dirty,
                            "size", cache->acct_size,
+                           "size-limit", (json_int_t)cache->size_limit,
+                           "frequent-size", cache->acct_frequent_size,
+                           "hits", cache->acct_hits,
+                           "misses", cache->acct_misses,
+                           "evictions", cache->acct_evictions,
                            "flush-batch-count", cache->flush_batch_count,
-                           "mmap", o ? o : json_null ()) < 0)
+                           "mmap", o ? o : json_null (),
+                           "hashpool", hp ? hp : json_null (),
+                           "gc", gc ? gc : json_null ()) < 0)
         flux_log_error (h, "content stats");
     json_decref (o);
+    json_decref (hp);
+    json_decref (gc);
 }
 
 /* Handle request to store all dirty entries.  The store requests are batched
@@ -943,13 +1536,14 @@ error:
 /* Heartbeat drives periodic cache purge
  */
 
-static void cache_purge (struct content_cache *cache)
+static void cache_purge_from (struct content_cache *cache,
+                              struct list_head *list)
 {
     double now = flux_reactor_now (cache->reactor);
     struct cache_entry *e = NULL;
     struct cache_entry *next;
 
-    list_for_each_rev_safe (&cache->lru, e, next, list) {
+    list_for_each_rev_safe (list, e, next, list) {
         if (cache->acct_size <= cache->purge_target_size
             || now - e->lastused < cache->purge_old_entry)
             break;
@@ -959,6 +1553,12 @@ static void cache_purge (struct content_cache *cache)
     }
 }
 
+static void cache_purge (struct content_cache *cache)
+{
+    cache_purge_from (cache, &cache->lru);
+    cache_purge_from (cache, &cache->lru_frequent);
+}
+
 static void update_stats (struct content_cache *cache)
 {
     flux_stats_gauge_set (cache->h, "content-cache.count",
@@ -990,6 +1590,32 @@ bool content_cache_backing_loaded (struct content_cache *cache)
     return cache->backing;
 }
 
+bool content_cache_contains (struct content_cache *cache,
+                             const void *hash,
+                             int hash_size)
+{
+    if (hash_size != content_hash_size)
+        return false;
+    return zhashx_lookup (cache->entries, hash) ? true : false;
+}
+
+bool content_cache_peek (struct content_cache *cache,
+                         const void *hash,
+                         int hash_size,
+                         const void **data,
+                         size_t *len)
+{
+    struct cache_entry *e;
+
+    if (hash_size != content_hash_size
+        || !(e = zhashx_lookup (cache->entries, hash))
+        || !e->valid)
+        return false;
+    *data = e->data;
+    *len = e->len;
+    return true;
+}
+
 /* Initialization
  */
 
@@ -1000,12 +1626,30 @@ static const struct flux_msg_handler_spec htab[] = {
         content_load_request,
         0
     },
+    {
+        FLUX_MSGTYPE_REQUEST,
+        "content.load-batch",
+        content_load_batch_request,
+        0
+    },
+    {
+        FLUX_MSGTYPE_REQUEST,
+        "content.has",
+        content_has_request,
+        0
+    },
     {
         FLUX_MSGTYPE_REQUEST,
         "content.store",
         content_store_request,
         0
     },
+    {
+        FLUX_MSGTYPE_REQUEST,
+        "content.disconnect",
+        content_disconnect_request,
+        0
+    },
     {
         FLUX_MSGTYPE_REQUEST,
         "content.unregister-backing",
@@ -1103,6 +1747,40 @@ int parse_args (struct content_cache *cache, int argc, char **argv)
             }
             cache->blob_size_limit = val;
         }
+        else if (strstarts (argv[i], "cache-size-limit=")) {
+            if (parse_u32 (argv[i] + 17, &val) < 0) {
+                flux_log (cache->h, LOG_ERR, "error parsing %s", argv[i]);
+                return -1;
+            }
+            cache->size_limit = val;
+        }
+        else if (strstarts (argv[i], "hash-threshold=")) {
+            if (parse_u32 (argv[i] + 15, &val) < 0) {
+                flux_log (cache->h, LOG_ERR, "error parsing %s", argv[i]);
+                return -1;
+            }
+            cache->hash_threshold = val;
+        }
+        else if (strstarts (argv[i], "hash-threads=")) {
+            if (parse_u32 (argv[i] + 13, &val) < 0) {
+                flux_log (cache->h, LOG_ERR, "error parsing %s", argv[i]);
+                return -1;
+            }
+            cache->hash_threads = val;
+        }
+        else if (strstarts (argv[i], "gc-period=")) {
+            if (fsd_parse_duration (argv[i] + 10, &cache->gc_period) < 0) {
+                flux_log (cache->h, LOG_ERR, "error parsing %s", argv[i]);
+                return -1;
+            }
+        }
+        else if (strstarts (argv[i], "gc-rate=")) {
+            if (parse_u32 (argv[i] + 8, &val) < 0 || val == 0) {
+                flux_log (cache->h, LOG_ERR, "error parsing %s", argv[i]);
+                return -1;
+            }
+            cache->gc_rate = val;
+        }
         else {
             flux_log (cache->h, LOG_ERR, "unknown module option: %s", argv[i]);
             return -1;
@@ -1115,6 +1793,12 @@ void content_cache_destroy (struct content_cache *cache)
 {
     if (cache) {
         int saved_errno = errno;
+        struct load_batch *b;
+
+        content_gc_destroy (cache->gc);
+        hashpool_destroy (cache->hashpool);
+        while ((b = list_top (&cache->load_batches, struct load_batch, list)))
+            load_batch_destroy (b);
         flux_future_destroy (cache->f_sync);
         flux_msg_handler_delvec (cache->handlers);
         free (cache->backing_name);
@@ -1134,6 +1818,7 @@ struct content_cache *content_cache_create (flux_t *h, int argc, char **argv)
 
     if (!(cache = calloc (1, sizeof (*cache))))
         return NULL;
+    list_head_init (&cache->load_batches);
     if (!(cache->entries = zhashx_new ()))
         goto nomem;
     cache->h = h;
@@ -1150,6 +1835,10 @@ struct content_cache *content_cache_create (flux_t *h, int argc, char **argv)
     cache->flush_batch_limit = default_flush_batch_limit;
     cache->purge_target_size = default_cache_purge_target_size;
     cache->purge_old_entry = default_cache_purge_old_entry;
+    cache->size_limit = default_cache_size_limit;
+    cache->hash_threshold = default_hash_threshold;
+    cache->hash_threads = default_hash_threads;
+    cache->gc_rate = default_gc_rate;
     /* Some tunables may be set on the module command line (mainly for test).
      */
     if (parse_args (cache, argc, argv) < 0) {
@@ -1160,6 +1849,7 @@ struct content_cache *content_cache_create (flux_t *h, int argc, char **argv)
         goto error;
 
     list_head_init (&cache->lru);
+    list_head_init (&cache->lru_frequent);
     list_head_init (&cache->flush);
 
     if (flux_get_rank (h, &cache->rank) < 0)
@@ -1174,6 +1864,12 @@ struct content_cache *content_cache_create (flux_t *h, int argc, char **argv)
                                                  cache->hash_name,
                                                  content_hash_size)))
             goto error;
+        if (!(cache->gc = content_gc_create (h,
+                                             cache,
+                                             content_hash_size,
+                                             cache->gc_period,
+                                             cache->gc_rate)))
+            goto error;
     }
     if (flux_msg_handler_addvec (h, htab, cache, &cache->handlers) < 0)
         goto error;
@@ -17,6 +17,21 @@ struct content_cache *content_cache_create (flux_t *h, int argc, char **argv);
 void content_cache_destroy (struct content_cache *cache);
 bool content_cache_backing_loaded (struct content_cache *cache);
 
+/* Return true if blob 'hash' has an entry in the cache, valid or not.
+ */
+bool content_cache_contains (struct content_cache *cache,
+                             const void *hash,
+                             int hash_size);
+
+/* Get the data of blob 'hash' if it has a valid cache entry, without
+ * affecting its position in the LRU.  Return false if not cached.
+ */
+bool content_cache_peek (struct content_cache *cache,
+                         const void *hash,
+                         int hash_size,
+                         const void **data,
+                         size_t *len);
+
 #endif /* !_CONTENT_CACHE_H */
 
 /*
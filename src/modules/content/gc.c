@@ -0,0 +1,961 @@
+/************************************************************\
+ * Copyright 2026 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* gc.c - mark and sweep garbage collection of the content backing store
+ *
+ * A collection proceeds in three phases:
+ *
+ * roots:
+ * The rootref of the KVS checkpoint is fetched from the backing store,
+ * and if the KVS is loaded, the current rootref of each namespace.
+ * The roots are fetched again once marking is done, and marking resumes
+ * from any that changed, before the sweep begins.
+ *
+ * mark:
+ * Starting from the roots, directory blobs are loaded and parsed, and
+ * all blobrefs reachable from them are added to the live set.  Blobs are
+ * read from the cache if present, otherwise directly from the backing
+ * store so the cache is not disturbed.
+ *
+ * sweep:
+ * The backing store is listed in pages with content-backing.list, and
+ * blobs that are not live are deleted with content-backing.remove.
+ *
+ * Blobs stored while a collection is in progress are added to the live set,
+ * whether or not the rank 0 cache already holds them, and blobs that have
+ * an entry in the rank 0 cache are never removed, so content that the KVS
+ * is in the middle of committing survives, and the cache never holds a
+ * clean entry for a blob that is no longer on the backing store.
+ *
+ * Blobs named in a content.has request during a collection are added to
+ * the live set too, present or not, since a client such as flux-restore(1)
+ * does not store a blob it is told is present, but may link it.  They are
+ * marked before the request is forwarded to the backing store, so either
+ * the sweep sees the mark, or its remove reaches the backing store first
+ * and the blob is reported missing.
+ *
+ * A commit may also link blobs it does not store, e.g. a value written
+ * again after it was unlinked, which the KVS does not store again while
+ * it is still in its cache, or a valref or dirref written directly.  Such
+ * blobs are reached through a new directory, so directories stored during
+ * a collection are scanned as if reached by mark.  Before the sweep
+ * begins, the KVS is told that blobs are being removed, and from then on
+ * it stores a blob again when linking it rather than trusting its cache
+ * (see kvs.gc-sweep), so a blob removed by the sweep cannot be linked
+ * without being stored again, even after the collection.  The root of each
+ * setroot and namespace-created event received during the collection is
+ * marked as well, in case it was not stored (e.g. a namespace created
+ * with an existing rootref).  If any of these adds work while a sweep page
+ * is being listed, the page is listed again once marking catches up.
+ *
+ * As described in flux-content(1), content that is not linked into the
+ * KVS and was stored before the collection started is reclaimed.
+ *
+ * Periodic (online) collections are rate limited to 'rate' blobs per
+ * second, counting both blobs loaded during mark and blobs examined during
+ * sweep.  A collection requested with content.gc (flux content gc) runs
+ * at full speed, and a periodic one in progress is sped up to match.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <flux/core.h>
+#include <jansson.h>
+
+#include "src/common/libczmqcontainers/czmq_containers.h"
+#include "src/common/libkvs/treeobj.h"
+#include "src/common/libkvs/kvs_checkpoint.h"
+#include "src/common/libutil/blobref.h"
+#include "src/common/libcontent/content.h"
+
+#include "gc.h"
+
+/* Maximum number of concurrent blob loads during mark.
+ */
+static const int max_outstanding = 16;
+
+/* The rate limit budget is refilled each tick.
+ */
+static const double tick_period = 0.1;
+
+enum gc_state {
+    GC_IDLE,
+    GC_ROOTS,
+    GC_MARK,
+    GC_SWEEP,
+};
+
+struct content_gc {
+    flux_t *h;
+    struct content_cache *cache;
+    flux_msg_handler_t **handlers;
+    double period;
+    double rate;
+    flux_watcher_t *period_w;
+    flux_watcher_t *tick_w;
+
+    enum gc_state state;
+    bool remarked;                  // roots were fetched again after mark
+    bool subscribed;                // subscribed to KVS root events
+    bool kvs_sweep;                 // KVS was told that blobs are removed
+    bool unlimited;                 // ignore rate limit
+    double budget;                  // blobs that may be examined this tick
+    zhashx_t *live;                 // reachable or recently stored digests
+    zlistx_t *pending;              // dir blob digests waiting to be loaded
+    zlistx_t *futures;              // RPCs in flight
+    uint8_t cursor[BLOBREF_MAX_DIGEST_SIZE]; // sweep position
+    int cursor_size;
+    struct flux_msglist *requests;  // content.gc requests awaiting result
+    double t_start;
+
+    int cycle_scanned;              // blobs examined during sweep
+    int cycle_count;                // blobs removed
+    int64_t cycle_bytes;            // bytes removed
+    int cycle_dangling;             // unresolvable references
+
+    int runs;
+    int failures;
+    int64_t total_count;
+    int64_t total_bytes;
+    double last_duration;
+    int last_live;
+};
+
+static int gc_hash_size;
+static char live_marker;
+
+static void gc_pump (struct content_gc *gc);
+static int gc_fetch_roots (struct content_gc *gc);
+
+static size_t digest_hasher (const void *key)
+{
+    size_t h;
+    memcpy (&h, key, sizeof (h));
+    return h;
+}
+
+static int digest_comparator (const void *item1, const void *item2)
+{
+    return memcmp (item1, item2, gc_hash_size);
+}
+
+static void *digest_duplicator (const void *item)
+{
+    void *cpy;
+    if ((cpy = malloc (gc_hash_size)))
+        memcpy (cpy, item, gc_hash_size);
+    return cpy;
+}
+
+static void digest_destructor (void **item)
+{
+    if (item) {
+        free (*item);
+        *item = NULL;
+    }
+}
+
+static void future_destructor (void **item)
+{
+    if (item) {
+        flux_future_destroy (*item);
+        *item = NULL;
+    }
+}
+
+/* Track RPC 'f' so it can be abandoned if the collection is aborted.
+ */
+static int gc_track (struct content_gc *gc,
+                     flux_future_t *f,
+                     flux_continuation_f cb)
+{
+    void *handle;
+
+    if (!(handle = zlistx_add_end (gc->futures, f)))
+        return -1;
+    if (flux_future_aux_set (f, "gc::handle", handle, NULL) < 0
+        || flux_future_then (f, -1., cb, gc) < 0) {
+        zlistx_detach (gc->futures, handle);
+        return -1;
+    }
+    return 0;
+}
+
+/* Stop tracking and destroy 'f'.
+ */
+static void gc_untrack (struct content_gc *gc, flux_future_t *f)
+{
+    zlistx_delete (gc->futures, flux_future_aux_get (f, "gc::handle"));
+}
+
+static int gc_outstanding (struct content_gc *gc)
+{
+    return zlistx_size (gc->futures);
+}
+
+/* Tell the KVS whether blobs are being removed, so that it stores a blob
+ * again when linking it instead of assuming that a blob in its cache is
+ * still stored.  The sweep waits for the response to 'active', so any
+ * directory the KVS stored before it handled the request, which might
+ * link a blob without storing it, has been scanned before blobs are
+ * removed.
+ */
+static flux_future_t *gc_kvs_sweep (struct content_gc *gc, bool active)
+{
+    flux_future_t *f;
+
+    if (!(f = flux_rpc_pack (gc->h,
+                             "kvs.gc-sweep",
+                             FLUX_NODEID_ANY,
+                             active ? 0 : FLUX_RPC_NORESPONSE,
+                             "{s:b}",
+                             "active", active)))
+        return NULL;
+    gc->kvs_sweep = active;
+    return f;
+}
+
+static void gc_reset (struct content_gc *gc)
+{
+    if (gc->kvs_sweep)
+        flux_future_destroy (gc_kvs_sweep (gc, false));
+    if (gc->subscribed) {
+        flux_future_t *f;
+
+        f = flux_event_unsubscribe_ex (gc->h,
+                                       "kvs.namespace-",
+                                       FLUX_RPC_NORESPONSE);
+        flux_future_destroy (f);
+        gc->subscribed = false;
+    }
+    zlistx_purge (gc->futures);
+    zlistx_purge (gc->pending);
+    zhashx_purge (gc->live);
+    flux_watcher_stop (gc->tick_w);
+    gc->state = GC_IDLE;
+    gc->unlimited = false;
+}
+
+static void gc_respond_error (struct content_gc *gc,
+                              int errnum,
+                              const char *errmsg)
+{
+    const flux_msg_t *msg;
+
+    while ((msg = flux_msglist_pop (gc->requests))) {
+        if (flux_respond_error (gc->h, msg, errnum, errmsg) < 0)
+            flux_log_error (gc->h, "gc: error responding to gc request");
+        flux_msg_decref (msg);
+    }
+}
+
+static void gc_abort (struct content_gc *gc, int errnum, const char *fmt, ...)
+{
+    char buf[256];
+    va_list ap;
+
+    va_start (ap, fmt);
+    (void)vsnprintf (buf, sizeof (buf), fmt, ap);
+    va_end (ap);
+
+    flux_log (gc->h, LOG_ERR, "gc: %s: %s", buf, strerror (errnum));
+    gc->failures++;
+    gc_respond_error (gc, errnum, buf);
+    gc_reset (gc);
+}
+
+static void gc_finish (struct content_gc *gc)
+{
+    const flux_msg_t *msg;
+    double duration = flux_reactor_now (flux_get_reactor (gc->h))
+                      - gc->t_start;
+
+    gc->runs++;
+    gc->total_count += gc->cycle_count;
+    gc->total_bytes += gc->cycle_bytes;
+    gc->last_duration = duration;
+    gc->last_live = zhashx_size (gc->live);
+    flux_log (gc->h,
+              gc->cycle_count > 0 ? LOG_INFO : LOG_DEBUG,
+              "gc: reclaimed %d blobs (%jd bytes) of %d in %.3fs",
+              gc->cycle_count,
+              (intmax_t)gc->cycle_bytes,
+              gc->cycle_scanned,
+              duration);
+    if (gc->cycle_dangling > 0) {
+        flux_log (gc->h,
+                  LOG_WARNING,
+                  "gc: %d referenced blobs could not be found",
+                  gc->cycle_dangling);
+    }
+    while ((msg = flux_msglist_pop (gc->requests))) {
+        if (flux_respond_pack (gc->h,
+                               msg,
+                               "{s:i s:I s:i s:i s:f}",
+                               "count", gc->cycle_count,
+                               "bytes", (json_int_t)gc->cycle_bytes,
+                               "scanned", gc->cycle_scanned,
+                               "live", gc->last_live,
+                               "duration", duration) < 0)
+            flux_log_error (gc->h, "gc: error responding to gc request");
+        flux_msg_decref (msg);
+    }
+    gc_reset (gc);
+}
+
+/* Add 'hash' to the live set.  If it refers to a directory, queue it
+ * to be loaded and scanned.
+ */
+static int gc_mark_hash (struct content_gc *gc, const void *hash, bool dir)
+{
+    if (zhashx_lookup (gc->live, hash))
+        return 0;
+    if (zhashx_insert (gc->live, hash, &live_marker) < 0
+        || (dir && !zlistx_add_end (gc->pending, (void *)hash))) {
+        errno = ENOMEM;
+        return -1;
+    }
+    return 0;
+}
+
+static int gc_mark_blobref (struct content_gc *gc, const char *blobref, bool dir)
+{
+    uint8_t hash[BLOBREF_MAX_DIGEST_SIZE];
+
+    if (blobref_strtohash (blobref, hash, sizeof (hash)) != gc_hash_size) {
+        errno = EINVAL;
+        return -1;
+    }
+    return gc_mark_hash (gc, hash, dir);
+}
+
+static int gc_mark_treeobj (struct content_gc *gc, json_t *obj)
+{
+    if (treeobj_is_dir (obj) || treeobj_is_hdir (obj)) {
+        json_t *data = treeobj_get_data (obj);
+        const char *name;
+        json_t *entry;
+
+        json_object_foreach (data, name, entry) {
+            if (gc_mark_treeobj (gc, entry) < 0)
+                return -1;
+        }
+    }
+    else if (treeobj_is_dirref (obj) || treeobj_is_valref (obj)) {
+        int count = treeobj_get_count (obj);
+        bool dir = treeobj_is_dirref (obj);
+
+        for (int i = 0; i < count; i++) {
+            const char *blobref = treeobj_get_blobref (obj, i);
+
+            if (!blobref || gc_mark_blobref (gc, blobref, dir) < 0)
+                return -1;
+        }
+    }
+    return 0;
+}
+
+static int gc_mark_dir (struct content_gc *gc, const void *data, size_t len)
+{
+    json_t *obj;
+    int rc;
+
+    if (!(obj = treeobj_decodeb (data, len)))
+        return -1;
+    rc = gc_mark_treeobj (gc, obj);
+    json_decref (obj);
+    return rc;
+}
+
+/* Scan a blob stored during the collection for references, in case it is
+ * a directory that links blobs that were not reachable from the roots.
+ * A blob that does not decode as a KVS object is a value and is skipped.
+ */
+static int gc_mark_stored (struct content_gc *gc, const void *data, size_t len)
+{
+    const char prefix[] = "{\"data\":"; // treeobj_encode() sorts keys
+    json_t *obj;
+    int rc;
+
+    if (len < sizeof (prefix) - 1
+        || memcmp (data, prefix, sizeof (prefix) - 1) != 0
+        || !(obj = treeobj_decodeb (data, len)))
+        return 0;
+    rc = gc_mark_treeobj (gc, obj);
+    json_decref (obj);
+    return rc;
+}
+
+static void gc_kvs_sweep_continuation (flux_future_t *f, void *arg)
+{
+    struct content_gc *gc = arg;
+
+    if (flux_future_get (f, NULL) < 0 && errno != ENOSYS) {
+        gc_abort (gc, errno, "error notifying KVS of sweep");
+        return;
+    }
+    gc_untrack (gc, f);
+    gc_pump (gc);
+}
+
+static void gc_subscribe_continuation (flux_future_t *f, void *arg)
+{
+    struct content_gc *gc = arg;
+
+    if (flux_future_get (f, NULL) < 0) {
+        gc_abort (gc, errno, "error subscribing to KVS root events");
+        return;
+    }
+    gc_untrack (gc, f);
+    gc_pump (gc);
+}
+
+static void gc_root_continuation (flux_future_t *f, void *arg)
+{
+    struct content_gc *gc = arg;
+    const char *blobref;
+    int rc;
+
+    if (flux_future_aux_get (f, "gc::checkpoint")) {
+        if ((rc = kvs_checkpoint_lookup_get_rootref (f, &blobref)) < 0
+            && errno == ENOENT)
+            goto done; // no checkpoint yet
+    }
+    else
+        rc = flux_kvs_getroot_get_blobref (f, &blobref);
+    if (rc < 0) {
+        gc_abort (gc, errno, "error fetching root");
+        return;
+    }
+    if (gc_mark_blobref (gc, blobref, true) < 0) {
+        gc_abort (gc, errno, "error marking root %s", blobref);
+        return;
+    }
+done:
+    gc_untrack (gc, f);
+    gc_pump (gc);
+}
+
+static void gc_namespace_continuation (flux_future_t *f, void *arg)
+{
+    struct content_gc *gc = arg;
+    json_t *namespaces;
+    size_t index;
+    json_t *entry;
+
+    if (flux_rpc_get_unpack (f, "{s:o}", "namespaces", &namespaces) < 0) {
+        if (errno == ENOSYS) // kvs is not loaded
+            goto done;
+        gc_abort (gc, errno, "error listing KVS namespaces");
+        return;
+    }
+    json_array_foreach (namespaces, index, entry) {
+        const char *ns;
+        flux_future_t *f2;
+
+        if (json_unpack (entry, "{s:s}", "namespace", &ns) < 0) {
+            gc_abort (gc, EPROTO, "error decoding KVS namespace list");
+            return;
+        }
+        if (!(f2 = flux_kvs_getroot (gc->h, ns, 0))
+            || gc_track (gc, f2, gc_root_continuation) < 0) {
+            flux_future_destroy (f2);
+            gc_abort (gc, errno, "error fetching root of namespace %s", ns);
+            return;
+        }
+    }
+done:
+    gc_untrack (gc, f);
+    gc_pump (gc);
+}
+
+static void gc_load_continuation (flux_future_t *f, void *arg)
+{
+    struct content_gc *gc = arg;
+    const void *data;
+    size_t len;
+
+    if (content_load_get (f, &data, &len) < 0) {
+        if (errno == ENOENT) {
+            gc->cycle_dangling++;
+            goto done;
+        }
+        gc_abort (gc, errno, "error loading directory");
+        return;
+    }
+    if (gc_mark_dir (gc, data, len) < 0) {
+        gc_abort (gc, errno, "error scanning directory");
+        return;
+    }
+done:
+    gc_untrack (gc, f);
+    gc_pump (gc);
+}
+
+static void gc_remove_continuation (flux_future_t *f, void *arg)
+{
+    struct content_gc *gc = arg;
+    int count;
+    json_int_t bytes;
+
+    if (flux_rpc_get_unpack (f, "{s:i s:I}", "count", &count, "bytes", &bytes)
+        < 0) {
+        gc_abort (gc, errno, "error removing blobs");
+        return;
+    }
+    gc->cycle_count += count;
+    gc->cycle_bytes += bytes;
+    gc_untrack (gc, f);
+    gc_pump (gc);
+}
+
+static void gc_list_continuation (flux_future_t *f, void *arg)
+{
+    struct content_gc *gc = arg;
+    const uint8_t *hashes;
+    size_t size;
+    uint8_t *unused = NULL;
+    int count;
+    int n = 0;
+
+    if (flux_rpc_get_raw (f, (const void **)&hashes, &size) < 0) {
+        if (errno == ENOSYS)
+            gc_abort (gc, errno, "backing store does not support gc");
+        else
+            gc_abort (gc, errno, "error listing backing store");
+        return;
+    }
+    if (size % gc_hash_size != 0) {
+        gc_abort (gc, EPROTO, "error listing backing store");
+        return;
+    }
+    /* Blobs stored or roots published while the page was being listed
+     * may have added to the live set things that are still to be scanned.
+     * Let marking catch up, then list the page again.
+     */
+    if (zlistx_size (gc->pending) > 0 || gc_outstanding (gc) > 1) {
+        gc_untrack (gc, f);
+        gc_pump (gc);
+        return;
+    }
+    if ((count = size / gc_hash_size) == 0) {
+        gc_untrack (gc, f);
+        gc_finish (gc);
+        return;
+    }
+    if (!(unused = malloc (size))) {
+        gc_abort (gc, ENOMEM, "error listing backing store");
+        return;
+    }
+    for (int i = 0; i < count; i++) {
+        const uint8_t *hash = hashes + i * gc_hash_size;
+
+        if (zhashx_lookup (gc->live, hash)
+            || content_cache_contains (gc->cache, hash, gc_hash_size))
+            continue;
+        memcpy (unused + n++ * gc_hash_size, hash, gc_hash_size);
+    }
+    memcpy (gc->cursor, hashes + (count - 1) * gc_hash_size, gc_hash_size);
+    gc->cursor_size = gc_hash_size;
+    gc->cycle_scanned += count;
+    gc->budget -= count;
+    gc_untrack (gc, f);
+
+    /* N.B. the remove request is sent before this callback returns, so it
+     * reaches the backing store ahead of any store the cache might send
+     * on behalf of a new reference to one of these blobs.
+     */
+    if (n > 0) {
+        flux_future_t *f2;
+
+        if (!(f2 = flux_rpc_raw (gc->h,
+                                 "content-backing.remove",
+                                 unused,
+                                 n * gc_hash_size,
+                                 0,
+                                 0))
+            || gc_track (gc, f2, gc_remove_continuation) < 0) {
+            flux_future_destroy (f2);
+            gc_abort (gc, errno, "error removing blobs");
+            goto done;
+        }
+    }
+    gc_pump (gc);
+done:
+    free (unused);
+}
+
+static bool gc_throttled (struct content_gc *gc)
+{
+    return !gc->unlimited && gc->budget <= 0;
+}
+
+/* Advance the collection as far as outstanding RPCs and the rate limit
+ * allow.
+ */
+static void gc_pump (struct content_gc *gc)
+{
+    flux_future_t *f;
+
+    if (gc->state == GC_ROOTS) {
+        if (gc_outstanding (gc) > 0)
+            return;
+        gc->state = GC_MARK;
+    }
+    if (gc->state == GC_MARK || gc->state == GC_SWEEP) {
+        void *hash;
+
+        while (gc_outstanding (gc) < max_outstanding
+               && !gc_throttled (gc)
+               && (hash = zlistx_first (gc->pending))) {
+            const void *data;
+            size_t len;
+
+            gc->budget--;
+            if (content_cache_peek (gc->cache,
+                                    hash,
+                                    gc_hash_size,
+                                    &data,
+                                    &len)) {
+                int rc = gc_mark_dir (gc, data, len);
+                zlistx_delete (gc->pending, zlistx_cursor (gc->pending));
+                if (rc < 0) {
+                    gc_abort (gc, errno, "error scanning directory");
+                    return;
+                }
+                continue;
+            }
+            if (!(f = content_load_byhash (gc->h,
+                                           hash,
+                                           gc_hash_size,
+                                           CONTENT_FLAG_CACHE_BYPASS))
+                || gc_track (gc, f, gc_load_continuation) < 0) {
+                flux_future_destroy (f);
+                gc_abort (gc, errno, "error loading directory");
+                return;
+            }
+            zlistx_delete (gc->pending, zlistx_cursor (gc->pending));
+        }
+        if (gc_outstanding (gc) > 0 || zlistx_size (gc->pending) > 0)
+            return;
+    }
+    if (gc->state == GC_MARK) {
+        /* Catch roots that were published without being stored while
+         * the first round of marking was in progress.
+         */
+        if (!gc->remarked) {
+            gc->remarked = true;
+            gc->state = GC_ROOTS;
+            if (gc_fetch_roots (gc) < 0)
+                gc_abort (gc, errno, "error fetching roots");
+            return;
+        }
+        gc->state = GC_SWEEP;
+        gc->cursor_size = 0;
+        if (!(f = gc_kvs_sweep (gc, true))
+            || gc_track (gc, f, gc_kvs_sweep_continuation) < 0) {
+            flux_future_destroy (f);
+            gc_abort (gc, errno, "error notifying KVS of sweep");
+        }
+        return;
+    }
+    if (gc->state == GC_SWEEP) {
+        if (gc_throttled (gc))
+            return;
+        if (!(f = flux_rpc_raw (gc->h,
+                                "content-backing.list",
+                                gc->cursor,
+                                gc->cursor_size,
+                                0,
+                                0))
+            || gc_track (gc, f, gc_list_continuation) < 0) {
+            flux_future_destroy (f);
+            gc_abort (gc, errno, "error listing backing store");
+            return;
+        }
+    }
+}
+
+static void gc_tick_cb (flux_reactor_t *r,
+                        flux_watcher_t *w,
+                        int revents,
+                        void *arg)
+{
+    struct content_gc *gc = arg;
+
+    if (gc->budget < 0)
+        gc->budget += gc->rate * tick_period;
+    else
+        gc->budget = gc->rate * tick_period;
+    gc_pump (gc);
+}
+
+/* Fetch the KVS checkpoint rootref and the rootref of each namespace.
+ */
+static int gc_fetch_roots (struct content_gc *gc)
+{
+    flux_future_t *f;
+
+    if (!(f = kvs_checkpoint_lookup (gc->h,
+                                     NULL,
+                                     KVS_CHECKPOINT_FLAG_CACHE_BYPASS))
+        || flux_future_aux_set (f, "gc::checkpoint", gc, NULL) < 0
+        || gc_track (gc, f, gc_root_continuation) < 0)
+        goto error;
+    if (!(f = flux_rpc (gc->h, "kvs.namespace-list", NULL, 0, 0))
+        || gc_track (gc, f, gc_namespace_continuation) < 0)
+        goto error;
+    return 0;
+error:
+    flux_future_destroy (f);
+    return -1;
+}
+
+static int gc_start (struct content_gc *gc, bool unlimited)
+{
+    flux_future_t *f;
+
+    if (gc->state != GC_IDLE) {
+        if (unlimited && !gc->unlimited) {
+            gc->unlimited = true;
+            flux_watcher_stop (gc->tick_w);
+            gc_pump (gc);
+        }
+        return 0;
+    }
+    if (!content_cache_backing_loaded (gc->cache)) {
+        errno = ENOSYS;
+        return -1;
+    }
+    gc->state = GC_ROOTS;
+    gc->remarked = false;
+    gc->unlimited = unlimited;
+    gc->budget = gc->rate * tick_period;
+    gc->t_start = flux_reactor_now (flux_get_reactor (gc->h));
+    gc->cycle_scanned = 0;
+    gc->cycle_count = 0;
+    gc->cycle_bytes = 0;
+    gc->cycle_dangling = 0;
+    if (!unlimited)
+        flux_watcher_start (gc->tick_w);
+
+    /* Subscribe before fetching the roots, so that a root published
+     * after they are fetched is seen in a setroot event.
+     */
+    if (!(f = flux_event_subscribe_ex (gc->h, "kvs.namespace-", 0))
+        || gc_track (gc, f, gc_subscribe_continuation) < 0) {
+        flux_future_destroy (f);
+        goto error;
+    }
+    gc->subscribed = true;
+    if (gc_fetch_roots (gc) < 0)
+        goto error;
+    return 0;
+error:
+    gc_reset (gc);
+    return -1;
+}
+
+static void gc_period_cb (flux_reactor_t *r,
+                          flux_watcher_t *w,
+                          int revents,
+                          void *arg)
+{
+    struct content_gc *gc = arg;
+
+    if (gc->state == GC_IDLE && content_cache_backing_loaded (gc->cache)) {
+        if (gc_start (gc, false) < 0)
+            flux_log_error (gc->h, "gc: error starting collection");
+    }
+}
+
+/* Handle a content.gc request.  Start a collection (or speed up the one
+ * in progress) and respond when it completes.
+ */
+static void content_gc_request (flux_t *h,
+                                flux_msg_handler_t *mh,
+                                const flux_msg_t *msg,
+                                void *arg)
+{
+    struct content_gc *gc = arg;
+    const char *errmsg = NULL;
+
+    if (flux_request_decode (msg, NULL, NULL) < 0)
+        goto error;
+    if (gc_start (gc, true) < 0) {
+        if (errno == ENOSYS)
+            errmsg = "content backing store is not active";
+        goto error;
+    }
+    if (flux_msglist_append (gc->requests, msg) < 0)
+        goto error;
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, errmsg) < 0)
+        flux_log_error (h, "gc: error responding to gc request");
+}
+
+json_t *content_gc_get_stats (struct content_gc *gc)
+{
+    json_t *o;
+    const char *state[] = { "idle", "roots", "mark", "sweep" };
+
+    if (!gc)
+        return NULL;
+    if (!(o = json_pack ("{s:s s:f s:f s:i s:i s:I s:I s:f s:i}",
+                         "state", state[gc->state],
+                         "period", gc->period,
+                         "rate", gc->rate,
+                         "runs", gc->runs,
+                         "failures", gc->failures,
+                         "count", (json_int_t)gc->total_count,
+                         "bytes", (json_int_t)gc->total_bytes,
+                         "last-duration", gc->last_duration,
+                         "last-live", gc->last_live)))
+        errno = ENOMEM;
+    return o;
+}
+
+void content_gc_stored (struct content_gc *gc,
+                        const void *hash,
+                        const void *data,
+                        size_t len)
+{
+    if (!gc || gc->state == GC_IDLE || zhashx_lookup (gc->live, hash))
+        return;
+    if (zhashx_insert (gc->live, hash, &live_marker) < 0) {
+        gc_abort (gc, ENOMEM, "error marking stored blob");
+        return;
+    }
+    if (gc_mark_stored (gc, data, len) < 0) {
+        gc_abort (gc, errno, "error scanning stored directory");
+        return;
+    }
+    if (zlistx_size (gc->pending) > 0)
+        gc_pump (gc);
+}
+
+void content_gc_has (struct content_gc *gc, const void *hash)
+{
+    if (!gc || gc->state == GC_IDLE)
+        return;
+    if (gc_mark_hash (gc, hash, false) < 0)
+        gc_abort (gc, errno, "error marking blob");
+}
+
+/* Handle a KVS setroot or namespace-created event during a collection.
+ * Mark the new root in case it was not stored during the collection.
+ */
+static void gc_root_event (flux_t *h,
+                           flux_msg_handler_t *mh,
+                           const flux_msg_t *msg,
+                           void *arg)
+{
+    struct content_gc *gc = arg;
+    const char *blobref;
+
+    if (gc->state == GC_IDLE)
+        return;
+    if (flux_event_unpack (msg, NULL, "{s:s}", "rootref", &blobref) < 0) {
+        gc_abort (gc, errno, "error decoding KVS root event");
+        return;
+    }
+    if (gc_mark_blobref (gc, blobref, true) < 0) {
+        gc_abort (gc, errno, "error marking root %s", blobref);
+        return;
+    }
+    gc_pump (gc);
+}
+
+static const struct flux_msg_handler_spec htab[] = {
+    { FLUX_MSGTYPE_REQUEST, "content.gc", content_gc_request, 0 },
+    { FLUX_MSGTYPE_EVENT, "kvs.namespace-*-setroot", gc_root_event, 0 },
+    { FLUX_MSGTYPE_EVENT, "kvs.namespace-*-created", gc_root_event, 0 },
+    FLUX_MSGHANDLER_TABLE_END,
+};
+
+void content_gc_destroy (struct content_gc *gc)
+{
+    if (gc) {
+        int saved_errno = errno;
+        flux_msg_handler_delvec (gc->handlers);
+        if (gc->kvs_sweep)
+            flux_future_destroy (gc_kvs_sweep (gc, false));
+        if (gc->requests) {
+            gc_respond_error (gc, ENOSYS, "content module is unloading");
+            flux_msglist_destroy (gc->requests);
+        }
+        flux_watcher_destroy (gc->period_w);
+        flux_watcher_destroy (gc->tick_w);
+        zlistx_destroy (&gc->futures);
+        zlistx_destroy (&gc->pending);
+        zhashx_destroy (&gc->live);
+        free (gc);
+        errno = saved_errno;
+    }
+}
+
+struct content_gc *content_gc_create (flux_t *h,
+                                      struct content_cache *cache,
+                                      int hash_size,
+                                      double period,
+                                      double rate)
+{
+    struct content_gc *gc;
+    flux_reactor_t *r = flux_get_reactor (h);
+
+    if (!(gc = calloc (1, sizeof (*gc))))
+        return NULL;
+    gc->h = h;
+    gc->cache = cache;
+    gc->period = period;
+    gc->rate = rate;
+    gc_hash_size = hash_size;
+    if (!(gc->live = zhashx_new ())
+        || !(gc->pending = zlistx_new ())
+        || !(gc->futures = zlistx_new ())
+        || !(gc->requests = flux_msglist_create ()))
+        goto nomem;
+    zhashx_set_key_hasher (gc->live, digest_hasher);
+    zhashx_set_key_comparator (gc->live, digest_comparator);
+    zhashx_set_key_duplicator (gc->live, digest_duplicator);
+    zhashx_set_key_destructor (gc->live, digest_destructor);
+    zlistx_set_duplicator (gc->pending, digest_duplicator);
+    zlistx_set_destructor (gc->pending, digest_destructor);
+    zlistx_set_destructor (gc->futures, future_destructor);
+    if (!(gc->tick_w = flux_timer_watcher_create (r,
+                                                  tick_period,
+                                                  tick_period,
+                                                  gc_tick_cb,
+                                                  gc)))
+        goto error;
+    if (period > 0) {
+        if (!(gc->period_w = flux_timer_watcher_create (r,
+                                                        period,
+                                                        period,
+                                                        gc_period_cb,
+                                                        gc)))
+            goto error;
+        flux_watcher_start (gc->period_w);
+    }
+    if (flux_msg_handler_addvec (h, htab, gc, &gc->handlers) < 0)
+        goto error;
+    return gc;
+nomem:
+    errno = ENOMEM;
+error:
+    content_gc_destroy (gc);
+    return NULL;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
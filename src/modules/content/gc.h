@@ -0,0 +1,52 @@
+/************************************************************\
+ * Copyright 2026 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _CONTENT_GC_H
+#define _CONTENT_GC_H 1
+
+#include <jansson.h>
+
+#include "cache.h"
+
+/* Create the backing store garbage collector (rank 0 only).
+ * If 'period' is greater than zero, a collection is started every
+ * 'period' seconds, examining at most 'rate' blobs per second.
+ * Collections requested with content.gc run without a rate limit.
+ */
+struct content_gc *content_gc_create (flux_t *h,
+                                      struct content_cache *cache,
+                                      int hash_size,
+                                      double period,
+                                      double rate);
+void content_gc_destroy (struct content_gc *gc);
+
+/* Inform the collector that blob 'hash' with content 'data' was stored,
+ * so that neither it nor any blob it references as a KVS directory is
+ * collected by a collection in progress.  Call this for every store,
+ * including those of blobs already in the cache.
+ */
+void content_gc_stored (struct content_gc *gc,
+                        const void *hash,
+                        const void *data,
+                        size_t len);
+
+/* Inform the collector that blob 'hash' was named in a content.has
+ * request, so that it is not collected by a collection in progress if
+ * the requestor links it.  Call this before forwarding the request.
+ */
+void content_gc_has (struct content_gc *gc, const void *hash);
+
+json_t *content_gc_get_stats (struct content_gc *gc);
+
+#endif /* !_CONTENT_GC_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,285 @@
+/************************************************************\
+ * Copyright 2026 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* hashpool.c - compute blob hash digests in worker threads
+ *
+ * Hashing a large blob inline in a content.store request handler stalls
+ * all other message handling in the broker for the duration.  The hashpool
+ * lets the content-cache hand large blobs to a small set of worker threads
+ * instead.
+ *
+ * Work items are placed on the 'pending' list, protected by 'lock', and a
+ * worker is signaled with 'cond'.  When a worker finishes, it moves the item
+ * to the 'done' list and writes to an eventfd(2) that is watched by the
+ * reactor.  The reactor-side handler drains the 'done' list and calls the
+ * completion callbacks, so callbacks never run in a worker thread.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <jansson.h>
+#include <flux/core.h>
+
+#include "src/common/libccan/ccan/list/list.h"
+#include "src/common/libutil/blobref.h"
+#include "src/common/libutil/monotime.h"
+#include "src/common/libutil/tstat.h"
+
+#include "hashpool.h"
+
+struct hashjob {
+    const void *data;
+    size_t len;
+    hashpool_f cb;
+    void *arg;
+    uint8_t hash[BLOBREF_MAX_DIGEST_SIZE];
+    int hash_size;
+    int errnum;
+    struct list_node list;
+};
+
+struct hashpool {
+    char *hash_name;
+    int nthreads;
+    pthread_t *threads;
+    int started;                    // number of threads started
+
+    pthread_mutex_t lock;           // protects everything below
+    pthread_cond_t cond;
+    struct list_head pending;       // submitted, not yet picked up
+    struct list_head done;          // hashed, awaiting callback
+    bool shutdown;
+    int queue_depth;                // submitted jobs not yet hashed
+    int queue_depth_max;
+    tstat_t hash_time;
+
+    int pollfd;
+    flux_watcher_t *w;
+};
+
+static void *hashpool_thread (void *arg)
+{
+    struct hashpool *hp = arg;
+    struct hashjob *job;
+    struct timespec t0;
+    double elapsed;
+
+    pthread_mutex_lock (&hp->lock);
+    for (;;) {
+        while (!hp->shutdown && list_empty (&hp->pending))
+            pthread_cond_wait (&hp->cond, &hp->lock);
+        if (hp->shutdown)
+            break;
+        job = list_pop (&hp->pending, struct hashjob, list);
+        pthread_mutex_unlock (&hp->lock);
+
+        monotime (&t0);
+        if ((job->hash_size = blobref_hash_raw (hp->hash_name,
+                                                job->data,
+                                                job->len,
+                                                job->hash,
+                                                sizeof (job->hash))) < 0)
+            job->errnum = errno;
+        elapsed = monotime_since (t0);
+
+        pthread_mutex_lock (&hp->lock);
+        list_add_tail (&hp->done, &job->list);
+        hp->queue_depth--;
+        tstat_push (&hp->hash_time, elapsed);
+        pthread_mutex_unlock (&hp->lock);
+
+        uint64_t one = 1;
+        if (write (hp->pollfd, &one, sizeof (one)) < 0) {
+            /* EAGAIN means the counter is saturated - a wakeup is pending.
+             */
+        }
+        pthread_mutex_lock (&hp->lock);
+    }
+    pthread_mutex_unlock (&hp->lock);
+    return NULL;
+}
+
+/* Run completion callbacks for finished jobs.  If 'cancel' is true,
+ * jobs that were never picked up by a worker are completed with ECANCELED.
+ * The lists are detached under the lock so callbacks may submit new work.
+ */
+static void hashpool_complete (struct hashpool *hp, bool cancel)
+{
+    struct list_head done;
+    struct hashjob *job;
+
+    list_head_init (&done);
+    pthread_mutex_lock (&hp->lock);
+    list_append_list (&done, &hp->done);
+    if (cancel) {
+        list_for_each (&hp->pending, job, list)
+            job->errnum = ECANCELED;
+        list_append_list (&done, &hp->pending);
+        hp->queue_depth = 0;
+    }
+    pthread_mutex_unlock (&hp->lock);
+
+    while ((job = list_pop (&done, struct hashjob, list))) {
+        job->cb (job->hash, job->hash_size, job->errnum, job->arg);
+        free (job);
+    }
+}
+
+static void hashpool_cb (flux_reactor_t *r,
+                         flux_watcher_t *w,
+                         int revents,
+                         void *arg)
+{
+    struct hashpool *hp = arg;
+    uint64_t count;
+
+    if (read (hp->pollfd, &count, sizeof (count)) < 0) {
+        /* EAGAIN - spurious wakeup, nothing to do
+         */
+    }
+    hashpool_complete (hp, false);
+}
+
+int hashpool_submit (struct hashpool *hp,
+                     const void *data,
+                     size_t len,
+                     hashpool_f cb,
+                     void *arg)
+{
+    struct hashjob *job;
+
+    if (!hp || !cb) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(job = calloc (1, sizeof (*job))))
+        return -1;
+    job->data = data;
+    job->len = len;
+    job->cb = cb;
+    job->arg = arg;
+    list_node_init (&job->list);
+
+    pthread_mutex_lock (&hp->lock);
+    list_add_tail (&hp->pending, &job->list);
+    if (++hp->queue_depth > hp->queue_depth_max)
+        hp->queue_depth_max = hp->queue_depth;
+    pthread_cond_signal (&hp->cond);
+    pthread_mutex_unlock (&hp->lock);
+    return 0;
+}
+
+json_t *hashpool_get_stats (struct hashpool *hp)
+{
+    json_t *o;
+
+    if (!hp) {
+        errno = EINVAL;
+        return NULL;
+    }
+    pthread_mutex_lock (&hp->lock);
+    o = json_pack ("{s:i s:i s:i s:{s:i s:f s:f s:f s:f}}",
+                   "threads", hp->nthreads,
+                   "queue-depth", hp->queue_depth,
+                   "queue-depth-max", hp->queue_depth_max,
+                   "hash-time",
+                     "count", tstat_count (&hp->hash_time),
+                     "min", tstat_min (&hp->hash_time),
+                     "max", tstat_max (&hp->hash_time),
+                     "mean", tstat_mean (&hp->hash_time),
+                     "stddev", tstat_stddev (&hp->hash_time));
+    pthread_mutex_unlock (&hp->lock);
+    if (!o)
+        errno = ENOMEM;
+    return o;
+}
+
+void hashpool_destroy (struct hashpool *hp)
+{
+    if (hp) {
+        int saved_errno = errno;
+        int i;
+
+        pthread_mutex_lock (&hp->lock);
+        hp->shutdown = true;
+        pthread_cond_broadcast (&hp->cond);
+        pthread_mutex_unlock (&hp->lock);
+        for (i = 0; i < hp->started; i++)
+            (void)pthread_join (hp->threads[i], NULL);
+        /* Threads are gone.  Finish what was done, cancel the rest.
+         */
+        hashpool_complete (hp, true);
+
+        flux_watcher_destroy (hp->w);
+        if (hp->pollfd >= 0)
+            (void)close (hp->pollfd);
+        pthread_cond_destroy (&hp->cond);
+        pthread_mutex_destroy (&hp->lock);
+        free (hp->threads);
+        free (hp->hash_name);
+        free (hp);
+        errno = saved_errno;
+    }
+}
+
+struct hashpool *hashpool_create (flux_reactor_t *r,
+                                  const char *hash_name,
+                                  int nthreads)
+{
+    struct hashpool *hp;
+    int e;
+
+    if (!r || !hash_name || nthreads < 1) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (blobref_validate_hashtype (hash_name) < 0)
+        return NULL;
+    if (!(hp = calloc (1, sizeof (*hp))))
+        return NULL;
+    hp->pollfd = -1;
+    pthread_mutex_init (&hp->lock, NULL);
+    pthread_cond_init (&hp->cond, NULL);
+    list_head_init (&hp->pending);
+    list_head_init (&hp->done);
+    hp->nthreads = nthreads;
+    if (!(hp->hash_name = strdup (hash_name))
+        || !(hp->threads = calloc (nthreads, sizeof (hp->threads[0]))))
+        goto error;
+    if ((hp->pollfd = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0)
+        goto error;
+    if (!(hp->w = flux_fd_watcher_create (r,
+                                          hp->pollfd,
+                                          FLUX_POLLIN,
+                                          hashpool_cb,
+                                          hp)))
+        goto error;
+    flux_watcher_start (hp->w);
+    for (hp->started = 0; hp->started < nthreads; hp->started++) {
+        if ((e = pthread_create (&hp->threads[hp->started],
+                                 NULL,
+                                 hashpool_thread,
+                                 hp))) {
+            errno = e;
+            goto error;
+        }
+    }
+    return hp;
+error:
+    hashpool_destroy (hp);
+    return NULL;
+}
+
+// vi:ts=4 sw=4 expandtab
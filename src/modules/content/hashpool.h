@@ -0,0 +1,45 @@
+/************************************************************\
+ * Copyright 2026 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _CONTENT_HASHPOOL_H
+#define _CONTENT_HASHPOOL_H 1
+
+#include <jansson.h>
+#include <flux/core.h>
+
+/* Completion callback, called from the reactor thread.
+ * On success, 'errnum' is zero and 'hash' contains the digest.
+ * If the pool is destroyed with work outstanding, the callback is
+ * called with errnum=ECANCELED.
+ */
+typedef void (*hashpool_f)(const void *hash,
+                           int hash_size,
+                           int errnum,
+                           void *arg);
+
+struct hashpool *hashpool_create (flux_reactor_t *r,
+                                  const char *hash_name,
+                                  int nthreads);
+void hashpool_destroy (struct hashpool *hp);
+
+/* Queue 'data' to be hashed by a worker thread.  'data' must remain
+ * valid until the callback is called.
+ */
+int hashpool_submit (struct hashpool *hp,
+                     const void *data,
+                     size_t len,
+                     hashpool_f cb,
+                     void *arg);
+
+json_t *hashpool_get_stats (struct hashpool *hp);
+
+#endif /* !_CONTENT_HASHPOOL_H */
+
+// vi:ts=4 sw=4 expandtab
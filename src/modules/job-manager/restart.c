@@ -19,6 +19,7 @@
 #include "src/common/libjob/idf58.h"
 #include "src/common/libutil/fluid.h"
 #include "src/common/libutil/errprintf.h"
+#include "src/common/libutil/errno_safe.h"
 #include "src/common/libczmqcontainers/czmq_containers.h"
 
 #include "job.h"
@@ -47,89 +48,148 @@ int restart_count_char (const char *s, char c)
     return count;
 }
 
-static flux_future_t *lookup_job_data (flux_t *h,
-                                       flux_jobid_t id,
-                                       const char *key)
+/* Jobs found while walking the job directory are looked up in chunks of
+ * this many, with one kvs.lookup-batch request for the eventlog, jobspec,
+ * and R of every job in the chunk.  Restart then costs one round trip per
+ * chunk rather than one per job, and the keys of a chunk are read from the
+ * same KVS snapshot.
+ */
+#define RESTART_CHUNK_JOBS 256
+
+static const char *job_data_names[] = { "eventlog", "jobspec", "R" };
+#define JOB_DATA_COUNT 3
+
+struct restart_chunk {
+    flux_t *h;
+    int dirskip;
+    restart_map_f cb;
+    void *arg;
+    int count;
+    flux_jobid_t id[RESTART_CHUNK_JOBS];
+    char *key[RESTART_CHUNK_JOBS];      // job directory, for lost+found
+};
+
+static void restart_chunk_clear (struct restart_chunk *chunk)
 {
-    char path[64];
-    flux_future_t *f;
+    for (int i = 0; i < chunk->count; i++)
+        free (chunk->key[i]);
+    chunk->count = 0;
+}
+
+static flux_future_t *lookup_chunk_data (struct restart_chunk *chunk)
+{
+    int count = chunk->count * JOB_DATA_COUNT;
+    char (*path)[64];
+    const char **keys;
+    flux_future_t *f = NULL;
 
-    if (flux_job_kvs_key (path, sizeof (path), id, key) < 0
-        || !(f = flux_kvs_lookup (h, NULL, 0, path)))
-        return NULL;
+    if (!(path = calloc (count, sizeof (path[0])))
+        || !(keys = calloc (count, sizeof (keys[0]))))
+        goto done;
+    for (int i = 0; i < count; i++) {
+        if (flux_job_kvs_key (path[i],
+                              sizeof (path[i]),
+                              chunk->id[i / JOB_DATA_COUNT],
+                              job_data_names[i % JOB_DATA_COUNT]) < 0)
+            goto done;
+        keys[i] = path[i];
+    }
+    f = flux_kvs_lookup_batch (chunk->h, NULL, 0, keys, count);
+done:
+    ERRNO_SAFE_WRAP (free, keys);
+    ERRNO_SAFE_WRAP (free, path);
     return f;
 }
 
-static const char *lookup_job_data_get (flux_future_t *f,
-                                        flux_error_t *error)
+/* Copy the value from the current batch response to 'result' and
+ * advance to the next response.  Return -1 with 'fatal' set if the batch
+ * request itself failed, or with 'fatal' clear if only this key failed.
+ */
+static int lookup_job_data_next (flux_future_t *f,
+                                 char **result,
+                                 flux_error_t *error,
+                                 bool *fatal)
 {
-    const char *result;
+    const char *s;
+    int rc = -1;
 
-    if (flux_kvs_lookup_get (f, &result) < 0) {
+    *result = NULL;
+    if (flux_rpc_get (f, NULL) < 0) {
+        errprintf (error, "lookup job data: %s", strerror (errno));
+        *fatal = true;
+        return -1;
+    }
+    if (flux_kvs_lookup_get (f, &s) < 0) {
         errprintf (error,
                    "lookup %s: %s",
                    flux_kvs_lookup_get_key (f),
                    strerror (errno));
-        return NULL;
+        *fatal = false;
+        goto done;
     }
-    return result;
+    if (s && !(*result = strdup (s))) {
+        errprintf (error,
+                   "lookup %s: out of memory",
+                   flux_kvs_lookup_get_key (f));
+        *fatal = true;
+        goto done;
+    }
+    rc = 0;
+done:
+    flux_future_reset (f);
+    return rc;
 }
 
-static struct job *lookup_job (flux_t *h,
+/* Create job 'id' from the next JOB_DATA_COUNT responses in 'f'.
+ * All of them are consumed, unless the batch request failed.
+ */
+static struct job *lookup_job (flux_future_t *f,
                                flux_jobid_t id,
                                flux_error_t *error,
                                bool *fatal)
 {
-    flux_future_t *f1 = NULL;
-    flux_future_t *f2 = NULL;
-    flux_future_t *f3 = NULL;
-    const char *eventlog;
-    const char *jobspec;
-    const char *R;
+    char *data[JOB_DATA_COUNT] = { NULL };
+    flux_error_t e[JOB_DATA_COUNT];
+    bool failed[JOB_DATA_COUNT] = { false };
     struct job *job = NULL;
-    flux_error_t e;
+    flux_error_t replay_error;
 
-    if (!(f1 = lookup_job_data (h, id, "eventlog"))
-        || !(f2 = lookup_job_data (h, id, "jobspec"))
-        || !(f3 = lookup_job_data (h, id, "R"))) {
-        errprintf (error,
-                   "cannot send lookup requests for job %s: %s",
-                   idf58 (id),
-                   strerror (errno));
-        *fatal = true;
-        goto done;
-    }
-    if (!(eventlog = lookup_job_data_get (f1, error))) {
+    for (int i = 0; i < JOB_DATA_COUNT; i++) {
         *fatal = false;
-        goto done;
-    }
-    if (!(jobspec = lookup_job_data_get (f2, error))) {
-        *fatal = false;
-        goto done;
+        if (lookup_job_data_next (f, &data[i], &e[i], fatal) < 0) {
+            if (*fatal) {
+                errprintf (error, "%s", e[i].text);
+                goto done;
+            }
+            failed[i] = true;
+        }
     }
-    /* Ignore error if this returns NULL, since R is only available
-     * after resources have been allocated.
+    /* Ignore a missing R, since R is only available after resources
+     * have been allocated.
      */
-    R = lookup_job_data_get (f3, NULL);
+    for (int i = 0; i < JOB_DATA_COUNT - 1; i++) {
+        if (failed[i]) {
+            errprintf (error, "%s", e[i].text);
+            goto done;
+        }
+    }
 
     /* Treat these errors as non-fatal to avoid a nuisance on restart.
      * See also: flux-framework/flux-core#6123
      */
     if (!(job = job_create_from_eventlog (id,
-                                          eventlog,
-                                          jobspec,
-                                          R,
-                                          &e))) {
+                                          data[0],
+                                          data[1],
+                                          data[2],
+                                          &replay_error))) {
         errprintf (error,
-                   "replay %s: %s",
-                   flux_kvs_lookup_get_key (f1),
-                   e.text);
-        *fatal = false;
+                   "replay job %s eventlog: %s",
+                   idf58 (id),
+                   replay_error.text);
     }
 done:
-    flux_future_destroy (f1);
-    flux_future_destroy (f2);
-    flux_future_destroy (f3);
+    for (int i = 0; i < JOB_DATA_COUNT; i++)
+        free (data[i]);
     return job;
 }
 
@@ -154,62 +214,106 @@ static void move_to_lost_found (flux_t *h, const char *key, flux_jobid_t id)
     flux_future_destroy (f);
 }
 
-/* Create a 'struct job' from the KVS, using synchronous KVS RPCs.
- * Return 1 on success, 0 on non-fatal error, or -1 on a fatal error,
- * where a fatal error will prevent flux from starting.
+/* Create a 'struct job' for each job in 'chunk' from the KVS, using
+ * synchronous KVS RPCs, and pass it to the map callback.
+ * Return the number of jobs created, or -1 on a fatal error, where a
+ * fatal error will prevent flux from starting.
+ */
+static int restart_chunk_flush (struct restart_chunk *chunk,
+                                flux_error_t *error)
+{
+    flux_future_t *f;
+    int count = 0;
+    int rc = -1;
+
+    if (chunk->count == 0)
+        return 0;
+    if (!(f = lookup_chunk_data (chunk))) {
+        errprintf (error,
+                   "cannot send lookup request for %d jobs: %s",
+                   chunk->count,
+                   strerror (errno));
+        goto done;
+    }
+    for (int i = 0; i < chunk->count; i++) {
+        flux_jobid_t id = chunk->id[i];
+        flux_error_t lookup_error;
+        struct job *job;
+        bool fatal = false;
+
+        if (!(job = lookup_job (f, id, &lookup_error, &fatal))) {
+            if (fatal) {
+                errprintf (error, "%s", lookup_error.text);
+                goto done;
+            }
+            move_to_lost_found (chunk->h, chunk->key[i], id);
+            flux_log (chunk->h,
+                      LOG_ERR,
+                      "job %s not replayed: %s",
+                      idf58 (id),
+                      lookup_error.text);
+            continue;
+        }
+        if (chunk->cb (job, chunk->arg, error) < 0) {
+            job_decref (job);
+            goto done;
+        }
+        job_decref (job);
+        count++;
+    }
+    rc = count;
+done:
+    /* Consume any remaining responses, up to the ENODATA that
+     * terminates the stream, so the matchtag is not leaked.
+     */
+    while (f && flux_rpc_get (f, NULL) == 0)
+        flux_future_reset (f);
+    flux_future_destroy (f);
+    restart_chunk_clear (chunk);
+    return rc;
+}
+
+/* Add the job whose directory is 'key' to 'chunk', flushing the chunk
+ * if it is full.  Return the number of jobs created by the flush,
+ * or -1 on a fatal error.
  */
-static int depthfirst_map_one (flux_t *h,
+static int depthfirst_map_one (struct restart_chunk *chunk,
                                const char *key,
-                               int dirskip,
-                               restart_map_f cb,
-                               void *arg,
                                flux_error_t *error)
 {
     flux_jobid_t id;
-    struct job *job = NULL;
-    int rc = -1;
 
-    if (strlen (key) <= dirskip) {
-        errprintf (error, "internal error key=%s dirskip=%d", key, dirskip);
+    if (strlen (key) <= chunk->dirskip) {
+        errprintf (error,
+                   "internal error key=%s dirskip=%d",
+                   key,
+                   chunk->dirskip);
         errno = EINVAL;
         return -1;
     }
-    if (fluid_decode (key + dirskip + 1, &id, FLUID_STRING_DOTHEX) < 0) {
-        errprintf (error, "could not decode %s to job ID", key + dirskip + 1);
+    if (fluid_decode (key + chunk->dirskip + 1,
+                      &id,
+                      FLUID_STRING_DOTHEX) < 0) {
+        errprintf (error,
+                   "could not decode %s to job ID",
+                   key + chunk->dirskip + 1);
         return -1;
     }
-
-    flux_error_t lookup_error;
-    bool fatal = false;
-    if (!(job = lookup_job (h, id, &lookup_error, &fatal))) {
-        if (fatal) {
-            errprintf (error, "%s", lookup_error.text);
-            return -1;
-        }
-        move_to_lost_found (h, key, id);
-        flux_log (h,
-                  LOG_ERR,
-                  "job %s not replayed: %s",
-                  idf58 (id),
-                  lookup_error.text);
-        return 0;
+    if (!(chunk->key[chunk->count] = strdup (key))) {
+        errprintf (error, "out of memory");
+        return -1;
     }
-
-    if (cb (job, arg, error) < 0)
-        goto done;
-    rc = 1;
-done:
-    job_decref (job);
-    return rc;
+    chunk->id[chunk->count++] = id;
+    if (chunk->count < RESTART_CHUNK_JOBS)
+        return 0;
+    return restart_chunk_flush (chunk, error);
 }
 
-static int depthfirst_map (flux_t *h,
+static int depthfirst_map (struct restart_chunk *chunk,
                            const char *key,
-                           int dirskip,
-                           restart_map_f cb,
-                           void *arg,
                            flux_error_t *error)
 {
+    flux_t *h = chunk->h;
     flux_future_t *f;
     const flux_kvsdir_t *dir;
     flux_kvsitr_t *itr;
@@ -218,7 +322,7 @@ static int depthfirst_map (flux_t *h,
     int count = 0;
     int rc = -1;
 
-    path_level = restart_count_char (key + dirskip, '.');
+    path_level = restart_count_char (key + chunk->dirskip, '.');
     if (!(f = flux_kvs_lookup (h, NULL, FLUX_KVS_READDIR, key))) {
         errprintf (error,
                    "cannot send lookup request for %s: %s",
@@ -258,9 +362,9 @@ static int depthfirst_map (flux_t *h,
             goto done_destroyitr;
         }
         if (path_level == 3) // orig 'key' = .A.B.C, thus 'nkey' is complete
-            n = depthfirst_map_one (h, nkey, dirskip, cb, arg, error);
+            n = depthfirst_map_one (chunk, nkey, error);
         else
-            n = depthfirst_map (h, nkey, dirskip, cb, arg, error);
+            n = depthfirst_map (chunk, nkey, error);
         if (n < 0) {
             int saved_errno = errno;
             free (nkey);
@@ -382,18 +486,31 @@ int restart_from_kvs (struct job_manager *ctx)
 {
     const char *dirname = "job";
     int dirskip = strlen (dirname);
+    struct restart_chunk *chunk;
     int count;
     struct job *job;
     flux_error_t error;
 
     /* Load any active jobs present in the KVS at startup.
      */
-    count = depthfirst_map (ctx->h,
-                            dirname,
-                            dirskip,
-                            restart_map_cb,
-                            ctx,
-                            &error);
+    if (!(chunk = calloc (1, sizeof (*chunk)))) {
+        flux_log_error (ctx->h, "restart: could not allocate lookup chunk");
+        return -1;
+    }
+    chunk->h = ctx->h;
+    chunk->dirskip = dirskip;
+    chunk->cb = restart_map_cb;
+    chunk->arg = ctx;
+    if ((count = depthfirst_map (chunk, dirname, &error)) >= 0) {
+        int n;
+
+        if ((n = restart_chunk_flush (chunk, &error)) < 0)
+            count = -1;
+        else
+            count += n;
+    }
+    restart_chunk_clear (chunk);
+    free (chunk);
     if (count < 0) {
         flux_log (ctx->h, LOG_ERR, "restart failed: %s", error.text);
         return -1;
@@ -23,6 +23,7 @@
 #include "src/common/libutil/blobref.h"
 #include "src/common/libcontent/content.h"
 #include "src/common/libutil/errprintf.h"
+#include "ccan/str/str.h"
 
 /* State for one watcher */
 struct watcher {
@@ -39,6 +40,7 @@ struct watcher {
     char *key;                  // lookup key
     int flags;                  // kvs_lookup flags
     zlist_t *lookups;           // list of futures, in commit order
+    int notify_pending;         // shared lookups yet to notify watcher
     zlist_t *loads;             // list of futures, content loads in ref order
 
     struct ns_monitor *nsm;     // back pointer for removal
@@ -47,6 +49,10 @@ struct watcher {
     int prev_start_index;       // previous start index loaded
     int prev_end_index;         // previous end index loaded
     int loaded_blob_count;      // number of indices loaded (for FLUX_KVS_STREAM)
+    json_t *refs;               // blobrefs loaded, by index
+    size_t *offsets;            // byte offset in value of each blob in refs
+    int offsets_size;           // allocated length of offsets
+    size_t sent_bytes;          // bytes of value sent
     void *handle;               // zlistx_t handle
 };
 
@@ -74,6 +80,18 @@ struct ns_monitor {
     char *topic;                // topic string for subscription
     bool subscribed;            // subscription active
     flux_future_t *getrootf;    // initial getroot future
+    zhash_t *lookups;           // lookup futures in flight, by lookup_id()
+};
+
+/* A lookup RPC in flight.  Watchers of the same key with the same flags
+ * and credentials share one lookup per root sequence number.  The future
+ * is referenced by nsm->lookups until it is fulfilled, and by each
+ * watcher until the watcher has handled the response.
+ */
+struct lookup {
+    struct ns_monitor *nsm;     // back-pointer to namespace
+    char *id;                   // hash key for nsm->lookups
+    zlist_t *watchers;          // watchers to notify on fulfillment
 };
 
 /* Module state.
@@ -82,6 +100,10 @@ struct watch_ctx {
     flux_t *h;
     flux_msg_handler_t **handlers;
     zhash_t *namespaces;        // hash of monitored namespaces
+    char *hash_name;            // content.hash
+    int inline_appends;         // appends sent from setroot event data
+    int lookups;                // lookup RPCs sent
+    int shared_lookups;         // watcher lookups that joined another's RPC
 };
 
 static void watcher_destroy (struct watcher *w)
@@ -103,6 +125,8 @@ static void watcher_destroy (struct watcher *w)
             zlist_destroy (&w->loads);
         }
         json_decref (w->prev);
+        json_decref (w->refs);
+        free (w->offsets);
         free (w);
         errno = saved_errno;
     }
@@ -125,6 +149,8 @@ static struct watcher *watcher_create (const flux_msg_t *msg,
         goto error_nomem;
     if (!(w->loads = zlist_new ()))
         goto error_nomem;
+    if (!(w->refs = json_array ()))
+        goto error_nomem;
     w->flags = flags;
     w->rootseq = -1;
     return w;
@@ -164,12 +190,43 @@ static struct commit *commit_create (const char *rootref,
     return commit;
 }
 
+static void lookup_destroy (struct lookup *l)
+{
+    if (l) {
+        int saved_errno = errno;
+        zlist_destroy (&l->watchers);
+        free (l->id);
+        free (l);
+        errno = saved_errno;
+    }
+}
+
+static struct lookup *lookup_create (struct ns_monitor *nsm, const char *id)
+{
+    struct lookup *l;
+
+    if (!(l = calloc (1, sizeof (*l))))
+        return NULL;
+    l->nsm = nsm;
+    if (!(l->id = strdup (id)))
+        goto error;
+    if (!(l->watchers = zlist_new ())) {
+        errno = ENOMEM;
+        goto error;
+    }
+    return l;
+error:
+    lookup_destroy (l);
+    return NULL;
+}
+
 static void namespace_destroy (struct ns_monitor *nsm)
 {
     if (nsm) {
         int saved_errno = errno;
         commit_destroy (nsm->commit);
         zlistx_destroy (&nsm->watchers);
+        zhash_destroy (&nsm->lookups);
         if (nsm->subscribed)
             (void)flux_event_unsubscribe (nsm->ctx->h, nsm->topic);
         free (nsm->topic);
@@ -198,6 +255,8 @@ static struct ns_monitor *namespace_create (struct watch_ctx *ctx,
     if (!(nsm->watchers = zlistx_new ()))
         goto error;
     zlistx_set_destructor (nsm->watchers, watcher_destructor);
+    if (!(nsm->lookups = zhash_new ()))
+        goto error;
     if (!(nsm->ns_name = strdup (ns)))
         goto error;
     /* We are subscribing to the kvs.namespace-<NS> substring.
@@ -243,8 +302,13 @@ static bool key_match (json_t *o, const char *key)
 
 static void watcher_cleanup (struct ns_monitor *nsm, struct watcher *w)
 {
-    /* wait for all in flight lookups to complete before destroying watcher */
-    if (zlist_size (w->lookups) == 0 && zlist_size (w->loads) == 0)
+    /* wait for all in flight lookups to complete before destroying
+     * watcher, including shared lookups whose responses were already
+     * handled but which have not yet notified this watcher.
+     */
+    if (zlist_size (w->lookups) == 0
+        && zlist_size (w->loads) == 0
+        && w->notify_pending == 0)
         zlistx_delete (nsm->watchers, w->handle);
     /* if nsm->getrootf, destroy when getroot_continuation completes */
     if (zlistx_size (nsm->watchers) == 0
@@ -252,20 +316,57 @@ static void watcher_cleanup (struct ns_monitor *nsm, struct watcher *w)
         zhash_delete (nsm->ctx->namespaces, nsm->ns_name);
 }
 
+/* Record that blob 'index' of the watched value begins at byte 'offset'.
+ */
+static int set_offset (struct watcher *w, int index, size_t offset)
+{
+    if (index >= w->offsets_size) {
+        int size = w->offsets_size ? w->offsets_size : 64;
+        size_t *offsets;
+
+        while (size <= index)
+            size *= 2;
+        if (!(offsets = realloc (w->offsets, size * sizeof (*offsets))))
+            return -1;
+        w->offsets = offsets;
+        w->offsets_size = size;
+    }
+    w->offsets[index] = offset;
+    return 0;
+}
+
+/* Loads complete in index order, so the offset of blob 'index' has been
+ * set by the time it is loaded.  If the KVS compacted the valref, a blob
+ * may hold data that has already been sent from the blobs it replaced.
+ * Only respond with the part that has not been sent.
+ */
 static void handle_load_response (flux_future_t *f, struct watcher *w)
 {
     flux_t *h = flux_future_get_flux (f);
+    int index = (intptr_t)flux_future_aux_get (f, "index") - 1;
     const void *data;
     size_t size;
+    size_t offset;
+    size_t skip = 0;
     flux_error_t err;
 
     if (content_load_get (f, &data, &size) < 0) {
         errprintf (&err, "failed to load content data");
         goto error_respond;
     }
+    offset = index > 0 ? w->offsets[index] : 0;
+    if (set_offset (w, index + 1, offset + size) < 0) {
+        errprintf (&err, "out of memory");
+        goto error_respond;
+    }
+    if (w->sent_bytes > offset) {
+        skip = w->sent_bytes - offset;
+        if (skip >= size)
+            return;
+    }
 
     if (!w->mute) {
-        json_t *val = treeobj_create_val (data, size);
+        json_t *val = treeobj_create_val ((char *)data + skip, size - skip);
         if (!val) {
             errprintf (&err, "failed to create treeobj value");
             goto error_respond;
@@ -277,6 +378,7 @@ static void handle_load_response (flux_future_t *f, struct watcher *w)
             json_decref (val);
             goto finished;
         }
+        w->sent_bytes = offset + size;
         w->loaded_blob_count++;
         w->responded = true;
     }
@@ -331,11 +433,15 @@ static void load_continuation (flux_future_t *f, void *arg)
         watcher_cleanup (nsm, w);
 }
 
-static flux_future_t *load_ref (flux_t *h, struct watcher *w, const char *ref)
+static flux_future_t *load_ref (flux_t *h,
+                                struct watcher *w,
+                                const char *ref,
+                                int index)
 {
     flux_future_t *f = NULL;
 
     if (!(f = content_load_byblobref (h, ref, 0))
+        || flux_future_aux_set (f, "index", (void *)(intptr_t)(index + 1), NULL)
         || flux_future_then (f, -1., load_continuation, w) < 0)
         goto error;
     if (zlist_append (w->loads, f) < 0) {
@@ -358,17 +464,79 @@ static int load_range (flux_t *h,
 {
     int i;
 
+    while (json_array_size (w->refs) > start_index) {
+        if (json_array_remove (w->refs, json_array_size (w->refs) - 1) < 0)
+            return -1;
+    }
     for (i = start_index; i <= end_index; i++) {
         flux_future_t *f;
         const char *ref = treeobj_get_blobref (val, i);
         if (!ref)
             return -1;
-        if (!(f = load_ref (h, w, ref)))
+        if (json_array_size (w->refs) == i
+            && json_array_append_new (w->refs, json_string (ref)) < 0)
+            return -1;
+        if (!(f = load_ref (h, w, ref, i)))
             return -1;
     }
     return 0;
 }
 
+/* A 'val' is sent to the watcher without a load.  Record its size, so
+ * that it is not sent again when it becomes the first blob of a valref.
+ */
+static int val_sent (struct watcher *w, json_t *val)
+{
+    void *data;
+    size_t len;
+
+    if (treeobj_decode_val (val, &data, &len) < 0)
+        return -1;
+    free (data);
+    if (set_offset (w, 1, len) < 0)
+        return -1;
+    w->sent_bytes = len;
+    return 0;
+}
+
+/* Load the blobs of valref 'val' that have not been sent to the
+ * watcher.  Normally these are the blobs after the last one sent.  If
+ * the KVS compacted the valref, blobs that were sent may have been
+ * replaced, so load from the first blob that differs from those loaded
+ * before.  handle_load_response() skips the data that was already sent.
+ */
+static int load_appended (flux_t *h,
+                          struct watcher *w,
+                          json_t *val,
+                          flux_error_t *errp)
+{
+    int count = treeobj_get_count (val);
+    int start;
+
+    for (start = 0; start <= w->prev_end_index && start < count; start++) {
+        const char *ref = json_string_value (json_array_get (w->refs, start));
+        if (!ref || !streq (ref, treeobj_get_blobref (val, start)))
+            break;
+    }
+    if (start == count) {
+        if (count == w->prev_end_index + 1)
+            return 0;
+        errprintf (errp, "key watched with WATCH_APPEND shortened");
+        errno = EINVAL;
+        return -1;
+    }
+    w->prev_start_index = start;
+    w->prev_end_index = count - 1;
+    if (load_range (h, w, start, count - 1, val) < 0) {
+        errprintf (errp,
+                   "error sending request for content blobs [%d:%d]",
+                   start,
+                   count - 1);
+        return -1;
+    }
+    return 0;
+}
+
 static int handle_initial_response (flux_t *h,
                                     struct watcher *w,
                                     json_t *val,
@@ -393,6 +561,10 @@ static int handle_initial_response (flux_t *h,
             w->index_valid = true;
             w->prev_start_index = 0;
             w->prev_end_index = 0;
+            if (val_sent (w, val) < 0) {
+                errprintf (&err, "failed to decode value");
+                goto error_respond;
+            }
             /* since this is a val object, we can just return it */
             w->loaded_blob_count++;
             goto out;
@@ -515,6 +687,10 @@ static int handle_append_response (flux_t *h,
             w->index_valid = true;
             w->prev_start_index = 0;
             w->prev_end_index = 0;
+            if (val_sent (w, val) < 0) {
+                errprintf (&err, "failed to decode value");
+                goto error_respond;
+            }
             /* since this is a val object, we can just return it */
             if (flux_respond_pack (h, w->request, "{ s:O }", "val", val) < 0) {
                 flux_log_error (h,
@@ -533,38 +709,26 @@ static int handle_append_response (flux_t *h,
              * returned to the caller.
              */
             if (w->index_valid) {
-                int new_end_index;
                 if (w->flags & FLUX_KVS_STREAM)
                     goto out;
-                new_end_index = treeobj_get_count (val) - 1;
-                if (new_end_index > w->prev_end_index) {
-                    w->prev_start_index = w->prev_end_index + 1;
-                    w->prev_end_index = new_end_index;
-                }
-                else if (new_end_index < w->prev_end_index) {
-                    errprintf (&err, "key watched with WATCH_APPEND truncated");
-                    errno = EINVAL;
+                if (load_appended (h, w, val, &err) < 0)
                     goto error_respond;
-                }
-                else
-                    goto out;
             }
             else {
                 w->index_valid = true;
                 w->prev_start_index = 0;
                 w->prev_end_index = treeobj_get_count (val) - 1;
-            }
-
-            if (load_range (h,
-                            w,
-                            w->prev_start_index,
-                            w->prev_end_index,
-                            val) < 0) {
-                errprintf (&err,
-                           "error sending request for content blobs [%d:%d]",
-                           w->prev_start_index,
-                           w->prev_end_index);
-                goto error_respond;
+                if (load_range (h,
+                                w,
+                                w->prev_start_index,
+                                w->prev_end_index,
+                                val) < 0) {
+                    errprintf (&err,
+                               "error sending request for content blobs [%d:%d]",
+                               w->prev_start_index,
+                               w->prev_end_index);
+                    goto error_respond;
+                }
             }
         }
         else {
@@ -586,34 +750,14 @@ static int handle_append_response (flux_t *h,
     }
     else {
         if (treeobj_is_valref (val)) {
-            int new_end_index;
             if (!w->index_valid) {
                 errno = EPROTO;
                 goto error_respond;
             }
             if (w->flags & FLUX_KVS_STREAM)
                 goto out;
-            new_end_index = treeobj_get_count (val) - 1;
-            if (new_end_index > w->prev_end_index) {
-                w->prev_start_index = w->prev_end_index + 1;
-                w->prev_end_index = new_end_index;
-            }
-            else if (new_end_index < w->prev_end_index) {
-                errprintf (&err, "key watched with WATCH_APPEND shortened");
-                errno = EINVAL;
+            if (load_appended (h, w, val, &err) < 0)
                 goto error_respond;
-            }
-            else
-                goto out;
-
-            if (load_range (h,
-                            w,
-                            w->prev_start_index,
-                            w->prev_end_index,
-                            val) < 0) {
-                errprintf (&err, "error loading reference");
-                goto error_respond;
-            }
         }
         else {
             /* If we're streaming, we don't care that the treeobject
@@ -784,14 +928,14 @@ finished:
     w->finished = true;
 }
 
-/* One lookup has completed.
+/* One of the watcher's lookups has completed.
  * Pop ready futures off w->lookups and send responses, until
  * the list is empty, or a non-ready future is encountered.
  */
-static void lookup_continuation (flux_future_t *f, void *arg)
+static void watcher_lookup_ready (struct watcher *w)
 {
-    struct watcher *w = arg;
     struct ns_monitor *nsm = w->nsm;
+    flux_future_t *f;
 
     while ((f = zlist_first (w->lookups)) && flux_future_is_ready (f)) {
         f = zlist_pop (w->lookups);
@@ -812,6 +956,24 @@ static void lookup_continuation (flux_future_t *f, void *arg)
         watcher_cleanup (nsm, w);
 }
 
+/* A lookup has completed.  Notify all watchers that share it.
+ * Hold a reference on 'f' while doing so, since it is released by
+ * nsm->lookups and by each watcher as its response is handled.
+ */
+static void lookup_continuation (flux_future_t *f, void *arg)
+{
+    struct lookup *l = arg;
+    struct watcher *w;
+
+    flux_future_incref (f);
+    zhash_delete (l->nsm->lookups, l->id);
+    while ((w = zlist_pop (l->watchers))) {
+        w->notify_pending--;
+        watcher_lookup_ready (w);
+    }
+    flux_future_destroy (f);
+}
+
 /* Like flux_kvs_lookupat() except:
  * - targets kvs.lookup-plus, so root_ref & root_seq are available in
  *   response
@@ -885,28 +1047,189 @@ error:
     return NULL;
 }
 
+/* Identify the lookup that lookupat() would send for watcher 'w' at the
+ * current root, so that watchers with an identical request share it.
+ * The initial lookup is not tied to a root, so it is never shared.
+ */
+static char *lookup_id (struct ns_monitor *nsm, struct watcher *w)
+{
+    char *id;
+    int n;
+
+    if (!w->initial_rpc_sent)
+        n = asprintf (&id, "initial.%p", (void *)w);
+    else
+        n = asprintf (&id,
+                      "%d.%d.%ju.%ju.%s",
+                      nsm->commit->rootseq,
+                      w->flags,
+                      (uintmax_t)w->cred.userid,
+                      (uintmax_t)w->cred.rolemask,
+                      w->key);
+    if (n < 0) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return id;
+}
+
+/* Look up the watched key at the current root.  If another watcher has
+ * already sent an identical lookup, share its response.
+ */
 static int process_lookup_response (struct ns_monitor *nsm, struct watcher *w)
 {
+    char *id;
     flux_future_t *f;
-    if (!(f = lookupat (nsm->ctx->h,
-                        w,
-                        nsm->commit->rootref,
-                        nsm->commit->rootseq,
-                        nsm->ns_name))) {
-        flux_log_error (nsm->ctx->h, "%s: lookupat", __FUNCTION__);
+    struct lookup *l;
+    int rc = -1;
+
+    if (!(id = lookup_id (nsm, w)))
         return -1;
+    if ((f = zhash_lookup (nsm->lookups, id))) {
+        l = flux_future_aux_get (f, "lookup");
+        nsm->ctx->shared_lookups++;
+    }
+    else {
+        if (!(f = lookupat (nsm->ctx->h,
+                            w,
+                            nsm->commit->rootref,
+                            nsm->commit->rootseq,
+                            nsm->ns_name))) {
+            flux_log_error (nsm->ctx->h, "%s: lookupat", __FUNCTION__);
+            goto done;
+        }
+        if (!(l = lookup_create (nsm, id))
+            || flux_future_aux_set (f,
+                                    "lookup",
+                                    l,
+                                    (flux_free_f)lookup_destroy) < 0) {
+            lookup_destroy (l);
+            flux_future_destroy (f);
+            goto done;
+        }
+        if (flux_future_then (f, -1., lookup_continuation, l) < 0) {
+            flux_future_destroy (f);
+            goto done;
+        }
+        if (zhash_insert (nsm->lookups, id, f) < 0) {
+            flux_future_destroy (f);
+            errno = EEXIST;
+            goto done;
+        }
+        zhash_freefn (nsm->lookups, id, (zhash_free_fn *)flux_future_destroy);
+        nsm->ctx->lookups++;
+    }
+    if (zlist_append (l->watchers, w) < 0) {
+        errno = ENOMEM;
+        goto done;
     }
     if (zlist_append (w->lookups, f) < 0) {
-        flux_future_destroy (f);
+        zlist_remove (l->watchers, w);
         errno = ENOMEM;
-        return -1;
+        goto done;
     }
-    if (flux_future_then (f, -1., lookup_continuation, w) < 0) {
-        flux_future_destroy (f);
-        return -1;
+    flux_future_incref (f);
+    w->notify_pending++;
+    w->rootseq = nsm->commit->rootseq;
+    rc = 0;
+done:
+    free (id);
+    return rc;
+}
+
+/* The KVS may include the values appended to a key in the setroot
+ * event that announces the commit (see setroot_event_keys() in kvs.c).
+ * If so, respond to a FLUX_KVS_WATCH_APPEND watcher directly from the
+ * event, rather than looking up the key and loading the new blobs.
+ * This is only possible if no lookups or loads are in flight for the
+ * watcher, and the inlined values immediately follow the last blob
+ * sent.  The blobrefs of the values are computed so that a later
+ * compaction of the valref can be detected (see load_appended()).
+ * Return 1 if responses were sent, 0 if the caller should fall back to
+ * a lookup, or -1 on error.
+ */
+static int watcher_respond_inline (struct ns_monitor *nsm, struct watcher *w)
+{
+    json_t *o;
+    json_t *append;
+    json_t *val;
+    json_t *refs;
+    size_t *sizes;
+    size_t index;
+    int count;
+    int rc = -1;
+
+    if (!(w->flags & FLUX_KVS_WATCH_APPEND)
+        || (w->flags & FLUX_KVS_WATCH_FULL)
+        || (w->flags & FLUX_KVS_STREAM)
+        || !w->responded
+        || !w->index_valid
+        || w->rootseq == -1
+        || nsm->commit->rootseq <= w->initial_rootseq
+        || zlist_size (w->lookups) > 0
+        || zlist_size (w->loads) > 0
+        || !nsm->commit->keys
+        || !(o = json_object_get (nsm->commit->keys, w->key))
+        || json_unpack (o, "{s:i s:o}", "count", &count, "append", &append) < 0
+        || !json_is_array (append)
+        || count - (int)json_array_size (append) != w->prev_end_index + 1
+        || json_array_size (w->refs) != w->prev_end_index + 1)
+        return 0;
+    json_array_foreach (append, index, val) {
+        if (!treeobj_is_val (val))
+            return 0;
     }
+    if (!(refs = json_array ())
+        || !(sizes = calloc (json_array_size (append) + 1, sizeof (*sizes)))) {
+        json_decref (refs);
+        return 0;
+    }
+    json_array_foreach (append, index, val) {
+        char ref[BLOBREF_MAX_STRING_SIZE];
+        void *data;
+
+        if (treeobj_decode_val (val, &data, &sizes[index]) < 0)
+            goto fallback;
+        if (blobref_hash (nsm->ctx->hash_name,
+                          data,
+                          sizes[index],
+                          ref,
+                          sizeof (ref)) < 0) {
+            free (data);
+            goto fallback;
+        }
+        free (data);
+        if (json_array_append_new (refs, json_string (ref)) < 0)
+            goto fallback;
+    }
+    json_array_foreach (append, index, val) {
+        if (flux_respond_pack (nsm->ctx->h,
+                               w->request,
+                               "{ s:O }",
+                               "val", val) < 0) {
+            flux_log_error (nsm->ctx->h,
+                            "%s: failed to respond to kvs-watch.lookup",
+                            __FUNCTION__);
+            goto done;
+        }
+        w->sent_bytes += sizes[index];
+        if (set_offset (w, w->prev_end_index + index + 2, w->sent_bytes) < 0)
+            goto done;
+    }
+    if (json_array_extend (w->refs, refs) < 0)
+        goto done;
+    w->prev_start_index = w->prev_end_index + 1;
+    w->prev_end_index = count - 1;
     w->rootseq = nsm->commit->rootseq;
-    return 0;
+    nsm->ctx->inline_appends += json_array_size (append);
+    rc = 1;
+done:
+    json_decref (refs);
+    free (sizes);
+    return rc;
+fallback:
+    rc = 0;
+    goto done;
 }
 
 /* Respond to watcher request, if appropriate.
@@ -976,7 +1299,13 @@ static void watcher_respond (struct ns_monitor *nsm, struct watcher *w)
     if (w->rootseq == -1
         || (w->flags & FLUX_KVS_WATCH_FULL)
         || key_match (nsm->commit->keys, w->key)) {
-        if (process_lookup_response (nsm, w) < 0)
+        int rc;
+
+        if ((rc = watcher_respond_inline (nsm, w)) < 0) {
+            w->finished = true;
+            goto finished;
+        }
+        if (rc == 0 && process_lookup_response (nsm, w) < 0)
             goto error_respond;
     }
     return;
@@ -1400,9 +1729,12 @@ static void stats_cb (flux_t *h,
     }
     if (flux_respond_pack (h,
                            msg,
-                           "{s:i s:i s:O}",
+                           "{s:i s:i s:i s:i s:i s:O}",
                            "watchers", watchers,
                            "namespace-count", (int)zhash_size (ctx->namespaces),
+                           "inline-appends", ctx->inline_appends,
+                           "lookups", ctx->lookups,
+                           "shared-lookups", ctx->shared_lookups,
                            "namespaces", stats) < 0)
         flux_log_error (h,
                         "%s: failed to respond to kvs-watch.stats-get",
@@ -1462,6 +1794,7 @@ static void watch_ctx_destroy (struct watch_ctx *ctx)
         int saved_errno = errno;
         zhash_destroy (&ctx->namespaces);
         flux_msg_handler_delvec (ctx->handlers);
+        free (ctx->hash_name);
         free (ctx);
         errno = saved_errno;
     }
@@ -1470,9 +1803,16 @@ static void watch_ctx_destroy (struct watch_ctx *ctx)
 static struct watch_ctx *watch_ctx_create (flux_t *h)
 {
     struct watch_ctx *ctx = calloc (1, sizeof (*ctx));
+    const char *s;
+
     if (!ctx)
         return NULL;
     ctx->h = h;
+    if (!(s = flux_attr_get (h, "content.hash"))
+        || !(ctx->hash_name = strdup (s))) {
+        flux_log_error (h, "getattr content.hash");
+        goto error;
+    }
     if (flux_msg_handler_addvec (h, htab, ctx, &ctx->handlers) < 0)
         goto error;
     if (!(ctx->namespaces = zhash_new ()))
@@ -47,14 +47,17 @@ struct cache_entry {
     void *data;             /* value raw data */
     int len;
     json_t *o;              /* value treeobj object */
+    size_t osize;           /* estimated memory used by 'o' */
     double lastuse_time;    /* time of last use for cache expiry */
     bool valid;             /* flag indicating if raw data or treeobj
                              * set, don't use data == NULL as test, as
                              * zero length data can be valid */
     bool dirty;
+    bool unverified;        /* blob may have been removed by content gc */
     int errnum;
     char *blobref;
     int refcount;
+    struct cache *cache;    /* set when inserted in a cache */
     struct list_node entries_node;
     struct list_head *notdirty_list;
     struct list_node notdirty_node;
@@ -67,8 +70,12 @@ struct cache {
     double fake_time;       /* -1. for invalid */
     zhashx_t *zhx;
     /* entries_list is for fast iteration through entries, faster than
-     * using zhashx iterators or zhashx_keys() */
+     * using zhashx iterators or zhashx_keys().  It is kept in most
+     * recently used order for cache_trim(). */
     struct list_head entries_list;
+    size_t bytes;           /* raw data + decoded treeobjs of entries */
+    size_t max_bytes;       /* 0 for no limit */
+    bool gc_sweep;          /* content gc is removing blobs */
     /* list of entries with notdirty & valid waitqueue's with messages
      * on them.  These lists are used to avoid excess iteration
      * through zhx */
@@ -127,6 +134,7 @@ int cache_entry_set_dirty (struct cache_entry *entry, bool val)
             entry->dirty = true;
         else if (!val && entry->dirty) {
             entry->dirty = false;
+            entry->unverified = false;
             if (entry->waitlist_notdirty) {
                 if (wait_runqueue (entry->waitlist_notdirty) < 0) {
                     /* set back dirty bit to orig */
@@ -142,6 +150,15 @@ int cache_entry_set_dirty (struct cache_entry *entry, bool val)
     return -1;
 }
 
+bool cache_entry_get_stored (struct cache_entry *entry)
+{
+    if (!entry || !entry->valid)
+        return false;
+    if (entry->dirty)
+        return true;
+    return !entry->unverified && !(entry->cache && entry->cache->gc_sweep);
+}
+
 int cache_entry_clear_dirty (struct cache_entry *entry)
 {
     if (entry && entry->valid) {
@@ -221,6 +238,8 @@ int cache_entry_set_raw (struct cache_entry *entry, const void *data, int len)
     entry->data = cpy;
     entry->len = len;
     entry->valid = true;
+    if (entry->cache)
+        entry->cache->bytes += len;
     if (entry->waitlist_valid) {
         if (wait_runqueue (entry->waitlist_valid) < 0)
             goto reset_invalid;
@@ -229,6 +248,8 @@ int cache_entry_set_raw (struct cache_entry *entry, const void *data, int len)
     }
     return 0;
 reset_invalid:
+    if (entry->cache)
+        entry->cache->bytes -= len;
     free (entry->data);
     entry->data = NULL;
     entry->len = 0;
@@ -286,17 +307,80 @@ int cache_entry_set_errnum_on_notdirty (struct cache_entry *entry, int errnum)
     return 0;
 }
 
+/* Estimate the heap memory used by a decoded json object, so that it
+ * counts against the cache byte limit along with the raw data it was
+ * decoded from.  The per-value costs approximate jansson's allocations
+ * plus malloc overhead.  Decoded treeobjs are typically several times
+ * the size of their encoding.
+ */
+static size_t json_memsize (json_t *o)
+{
+    size_t size = 0;
+
+    switch (json_typeof (o)) {
+        case JSON_OBJECT: {
+            const char *key;
+            json_t *value;
+
+            size = 96 + json_object_size (o) * 16; // header, buckets
+            json_object_foreach (o, key, value)
+                size += 64 + strlen (key) + json_memsize (value);
+            break;
+        }
+        case JSON_ARRAY: {
+            size_t index;
+            json_t *value;
+
+            size = 64 + json_array_size (o) * sizeof (json_t *);
+            json_array_foreach (o, index, value)
+                size += json_memsize (value);
+            break;
+        }
+        case JSON_STRING:
+            size = 64 + json_string_length (o);
+            break;
+        case JSON_INTEGER:
+        case JSON_REAL:
+            size = 32;
+            break;
+        default: // true, false, null are singletons
+            break;
+    }
+    return size;
+}
+
+static void set_treeobj (struct cache_entry *entry, json_t *o)
+{
+    entry->o = o;
+    entry->osize = json_memsize (o);
+    if (entry->cache)
+        entry->cache->bytes += entry->osize;
+}
+
 const json_t *cache_entry_get_treeobj (struct cache_entry *entry)
 {
     if (!entry || !entry->valid || !entry->data)
         return NULL;
     if (!entry->o) {
-        if (!(entry->o = treeobj_decodeb (entry->data, entry->len)))
+        json_t *o;
+        if (!(o = treeobj_decodeb (entry->data, entry->len)))
             return NULL;
+        set_treeobj (entry, o);
     }
     return entry->o;
 }
 
+int cache_entry_attach_treeobj (struct cache_entry *entry, json_t *o)
+{
+    if (!entry || !entry->valid || !entry->data || !o) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!entry->o)
+        set_treeobj (entry, json_incref (o));
+    return 0;
+}
+
 void cache_entry_destroy (void *arg)
 {
     struct cache_entry *entry = arg;
@@ -363,8 +447,12 @@ struct cache_entry *cache_lookup (struct cache *cache, const char *ref)
 {
     struct cache_entry *entry = zhashx_lookup (cache->zhx, ref);
     double current_time = cache_now (cache);
-    if (entry && current_time > entry->lastuse_time)
-        entry->lastuse_time = current_time;
+    if (entry) {
+        if (current_time > entry->lastuse_time)
+            entry->lastuse_time = current_time;
+        list_del (&entry->entries_node);
+        list_add (&cache->entries_list, &entry->entries_node);
+    }
     return entry;
 }
 
@@ -375,6 +463,9 @@ int cache_insert (struct cache *cache, struct cache_entry *entry)
     if (cache && entry) {
         rc = zhashx_insert (cache->zhx, entry->blobref, entry);
         list_add (&cache->entries_list, &entry->entries_node);
+        entry->cache = cache;
+        if (entry->valid)
+            cache->bytes += entry->len + entry->osize;
         entry->notdirty_list = &cache->notdirty_list;
         entry->valid_list = &cache->valid_list;
         if (entry->waitlist_notdirty
@@ -388,6 +479,16 @@ int cache_insert (struct cache *cache, struct cache_entry *entry)
     return 0;
 }
 
+/* Remove 'entry' from the cache and destroy it.
+ */
+static void cache_unlink (struct cache *cache, struct cache_entry *entry)
+{
+    if (entry->valid)
+        cache->bytes -= entry->len + entry->osize;
+    list_del (&entry->entries_node);
+    zhashx_delete (cache->zhx, entry->blobref);
+}
+
 int cache_remove_entry (struct cache *cache, const char *ref)
 {
     struct cache_entry *entry = zhashx_lookup (cache->zhx, ref);
@@ -398,8 +499,7 @@ int cache_remove_entry (struct cache *cache, const char *ref)
             || !wait_queue_length (entry->waitlist_notdirty))
         && (!entry->waitlist_valid
             || !wait_queue_length (entry->waitlist_valid))) {
-        list_del (&entry->entries_node);
-        zhashx_delete (cache->zhx, ref);
+        cache_unlink (cache, entry);
         return 1;
     }
     return 0;
@@ -431,14 +531,61 @@ int cache_expire_entries (struct cache *cache, double thresh)
             && cache_entry_get_valid (entry)
             && !entry->refcount
             && (thresh == 0. || cache_entry_age (entry, cache) > thresh)) {
-                list_del (&entry->entries_node);
-                zhashx_delete (cache->zhx, entry->blobref);
+                cache_unlink (cache, entry);
                 count++;
         }
     }
     return count;
 }
 
+void cache_set_max_bytes (struct cache *cache, size_t max_bytes)
+{
+    cache->max_bytes = max_bytes;
+}
+
+bool cache_over_limit (struct cache *cache)
+{
+    return cache->max_bytes > 0 && cache->bytes > cache->max_bytes;
+}
+
+int cache_trim (struct cache *cache)
+{
+    struct cache_entry *entry = NULL;
+    struct cache_entry *prev = NULL;
+    int count = 0;
+
+    list_for_each_rev_safe (&cache->entries_list, entry, prev, entries_node) {
+        if (!cache_over_limit (cache))
+            break;
+        if (!cache_entry_get_dirty (entry)
+            && cache_entry_get_valid (entry)
+            && !entry->refcount) {
+            cache_unlink (cache, entry);
+            count++;
+        }
+    }
+    return count;
+}
+
+void cache_set_gc_sweep (struct cache *cache, bool active)
+{
+    if (cache) {
+        if (cache->gc_sweep && !active) {
+            struct cache_entry *entry;
+
+            list_for_each (&cache->entries_list, entry, entries_node)
+                entry->unverified = true;
+        }
+        cache->gc_sweep = active;
+    }
+}
+
+size_t cache_get_bytes (struct cache *cache)
+{
+    return cache->bytes;
+}
+
+
 int cache_get_stats (struct cache *cache,
                      tstat_t *ts,
                      int *sizep,
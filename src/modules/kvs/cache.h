@@ -41,6 +41,12 @@ bool cache_entry_get_valid (struct cache_entry *entry);
 bool cache_entry_get_dirty (struct cache_entry *entry);
 int cache_entry_set_dirty (struct cache_entry *entry, bool val);
 
+/* Return true if the entry's blob is known to be held by the content
+ * store, or a store RPC is in progress, so that it may be linked without
+ * storing it again.  See cache_set_gc_sweep().
+ */
+bool cache_entry_get_stored (struct cache_entry *entry);
+
 /* cache_entry_clear_dirty() is similar to calling
  * cache_entry_set_dirty(entry,false), but it will not set the dirty bit
  * to false if there are waiters for notdirty
@@ -93,6 +99,14 @@ int cache_entry_set_raw (struct cache_entry *entry, const void *data, int len);
 
 const json_t *cache_entry_get_treeobj (struct cache_entry *entry);
 
+/* Give a valid entry the treeobj 'o' decoded from its raw data, e.g.
+ * the object the raw data was just encoded from, so that
+ * cache_entry_get_treeobj() need not decode it.  Takes a reference on
+ * 'o', which must not be modified afterwards.  If the entry already
+ * has a treeobj, this is a no-op.  Returns -1 on error, 0 on success.
+ */
+int cache_entry_attach_treeobj (struct cache_entry *entry, json_t *o);
+
 /* in the event of a load or store RPC error, inform the cache to set
  * an error on all waiters of a type on a cache entry.
  */
@@ -146,6 +160,40 @@ int cache_count_entries (struct cache *cache);
  */
 int cache_expire_entries (struct cache *cache, double max_age);
 
+/* Limit the memory held by the cache to 'max_bytes', counting the raw
+ * data of valid entries plus an estimate of their decoded treeobjs,
+ * if any.  Evicting an entry frees both.  The limit is
+ * enforced by cache_trim(), not on insert, so that entries are not
+ * removed out from under a caller that is using them without a
+ * reference.  A limit of 0 (the default) means no limit.
+ */
+void cache_set_max_bytes (struct cache *cache, size_t max_bytes);
+
+/* Return true if the cache holds more than its byte limit.
+ */
+bool cache_over_limit (struct cache *cache);
+
+/* Remove least recently used entries that are not dirty, not
+ * incomplete, and not referenced, until the cache is within its byte
+ * limit.  Returns the number of entries removed.
+ */
+int cache_trim (struct cache *cache);
+
+/* Content garbage collection may remove blobs that are in the cache.
+ * While 'active' is true, cache_entry_get_stored() returns false for
+ * entries that are not dirty.  On a true->false transition, every entry
+ * in the cache is marked as possibly removed, and cache_entry_get_stored()
+ * returns false for it until it is stored again, i.e. its dirty bit is
+ * set and then cleared with cache_entry_set_dirty().
+ */
+void cache_set_gc_sweep (struct cache *cache, bool active);
+
+/* Return the memory counted against the byte limit: the raw data size
+ * of all valid entries in the cache, plus the estimated size of their
+ * decoded treeobjs.
+ */
+size_t cache_get_bytes (struct cache *cache);
+
 /* Obtain statistics on the cache.
  * Returns -1 on error, 0 on success
  */
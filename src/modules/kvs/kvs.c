@@ -19,6 +19,7 @@
 #include <libgen.h>
 #include <unistd.h>
 #include <stdbool.h>
+#include <limits.h>
 #include <sys/time.h>
 #include <flux/core.h>
 #include <jansson.h>
@@ -28,6 +29,7 @@
 #include "src/common/libutil/blobref.h"
 #include "src/common/libutil/monotime.h"
 #include "src/common/libutil/tstat.h"
+#include "src/common/libutil/hist.h"
 #include "src/common/libutil/timestamp.h"
 #include "src/common/libutil/errprintf.h"
 #include "src/common/libkvs/treeobj.h"
@@ -36,6 +38,7 @@
 #include "src/common/libkvs/kvs_util_private.h"
 #include "src/common/libcontent/content.h"
 #include "src/common/libutil/fsd.h"
+#include "src/common/libutil/parse_size.h"
 #include "src/common/librouter/msg_hash.h"
 
 #include "waitqueue.h"
@@ -68,12 +71,19 @@ struct kvs_ctx {
     struct cache *cache;    /* blobref => cache_entry */
     kvsroot_mgr_t *krm;
     int faults;                 /* for kvs.stats-get, etc. */
+    int evictions;              /* for kvs.stats-get, etc. */
     flux_t *h;
     uint32_t rank;
     flux_watcher_t *prep_w;
     flux_watcher_t *idle_w;
     flux_watcher_t *check_w;
+    flux_watcher_t *trim_w;
     int transaction_merge;
+    int dir_shard_threshold;
+    int transaction_pipeline;
+    int setroot_inline_max;     /* max appended bytes in setroot event */
+    int valref_compact;         /* compact valrefs with this many blobs */
+    uint64_t cache_max_bytes;   /* 0 for no limit */
     bool events_init;            /* flag */
     char *hash_name;
     unsigned int seq;           /* for commit transactions */
@@ -99,6 +109,10 @@ static void transaction_check_cb (flux_reactor_t *r,
                                   flux_watcher_t *w,
                                   int revents,
                                   void *arg);
+static void cache_trim_cb (flux_reactor_t *r,
+                           flux_watcher_t *w,
+                           int revents,
+                           void *arg);
 static void start_root_remove (struct kvs_ctx *ctx, const char *ns);
 static void work_queue_check_append (struct kvs_ctx *ctx,
                                      struct kvsroot *root);
@@ -116,6 +130,7 @@ static void kvs_ctx_destroy (struct kvs_ctx *ctx)
         flux_watcher_destroy (ctx->prep_w);
         flux_watcher_destroy (ctx->check_w);
         flux_watcher_destroy (ctx->idle_w);
+        flux_watcher_destroy (ctx->trim_w);
         kvs_checkpoint_destroy (ctx->kcp);
         free (ctx->hash_name);
         zhashx_destroy (&ctx->requests);
@@ -157,6 +172,12 @@ static struct kvs_ctx *kvs_ctx_create (flux_t *h)
     }
     if (!(ctx->cache = cache_create (r)))
         goto error;
+    /* Trim the cache to its size limit outside of any message
+     * handler, so entries in use without a reference are not removed.
+     */
+    if (!(ctx->trim_w = flux_check_watcher_create (r, cache_trim_cb, ctx)))
+        goto error;
+    flux_watcher_start (ctx->trim_w);
     if (!(ctx->krm = kvsroot_mgr_create (ctx->h, ctx)))
         goto error;
     if (flux_get_rank (ctx->h, &ctx->rank) < 0)
@@ -182,6 +203,9 @@ static struct kvs_ctx *kvs_ctx_create (flux_t *h)
             goto error;
     }
     ctx->transaction_merge = 1;
+    ctx->transaction_pipeline = 4;
+    ctx->setroot_inline_max = 4096;
+    ctx->valref_compact = 1024;
     if (!(ctx->requests = msg_hash_create (MSG_HASH_TYPE_UUID_MATCHTAG)))
         goto error;
     list_head_init (&ctx->work_queue);
@@ -191,10 +215,45 @@ error:
     return NULL;
 }
 
+static struct kvsroot *create_root (struct kvs_ctx *ctx,
+                                     const char *ns,
+                                     uint32_t owner,
+                                     int flags)
+{
+    struct kvsroot *root;
+
+    if (!(root = kvsroot_mgr_create_root (ctx->krm,
+                                          ctx->cache,
+                                          ctx->hash_name,
+                                          ns,
+                                          owner,
+                                          flags)))
+        return NULL;
+    kvstxn_mgr_set_dir_shard_threshold (root->ktm, ctx->dir_shard_threshold);
+    kvstxn_mgr_set_pipeline_depth (root->ktm, ctx->transaction_pipeline);
+    kvstxn_mgr_set_valref_compact (root->ktm, ctx->valref_compact);
+    return root;
+}
+
 /*
  * event subscribe/unsubscribe
  */
 
+static void event_subscribe_completion (flux_future_t *f, void *arg)
+{
+    struct kvs_ctx *ctx = arg;
+    const char *ns = flux_future_aux_get (f, "namespace");
+
+    /* Without events, the root would never be updated, so drop it and
+     * let the next request fetch it again.
+     */
+    if (flux_future_get (f, NULL) < 0) {
+        flux_log_error (ctx->h, "error subscribing to %s events", ns);
+        start_root_remove (ctx, ns);
+    }
+    flux_future_destroy (f);
+}
+
 static int event_subscribe (struct kvs_ctx *ctx, const char *ns)
 {
     char *topic = NULL;
@@ -219,6 +278,13 @@ static int event_subscribe (struct kvs_ctx *ctx, const char *ns)
      * flux_event_subscribe() function.
      *
      * See issue #2779 for more information.
+     *
+     * The per-namespace subscription on rank != 0 is made without
+     * waiting for the broker's response, so that the KVS does not block
+     * on a round trip to the broker for each namespace it accesses.  The
+     * broker handles this module's subscribe and unsubscribe requests in
+     * order.  The window in which a setroot event may be missed is the
+     * same either way: it opens when rank 0 responds to kvs.getroot.
      */
 
     /* do not want to subscribe to events that are not within our
@@ -250,11 +316,25 @@ static int event_subscribe (struct kvs_ctx *ctx, const char *ns)
     }
 
     if (ctx->rank != 0) {
+        flux_future_t *f;
+        char *cpy;
+
         if (asprintf (&topic, "kvs.namespace-%s", ns) < 0)
             goto cleanup;
 
-        if (flux_event_subscribe (ctx->h, topic) < 0) {
-            flux_log_error (ctx->h, "flux_event_subscribe");
+        if (!(f = flux_event_subscribe_ex (ctx->h, topic, 0))) {
+            flux_log_error (ctx->h, "flux_event_subscribe_ex");
+            goto cleanup;
+        }
+        if (!(cpy = strdup (ns))
+            || flux_future_aux_set (f, "namespace", cpy, free) < 0) {
+            free (cpy);
+            flux_future_destroy (f);
+            goto cleanup;
+        }
+        if (flux_future_then (f, -1., event_subscribe_completion, ctx) < 0) {
+            flux_log_error (ctx->h, "flux_future_then");
+            flux_future_destroy (f);
             goto cleanup;
         }
     }
@@ -270,14 +350,21 @@ static int event_unsubscribe (struct kvs_ctx *ctx, const char *ns)
     char *topic = NULL;
     int rc = -1;
 
+    /* Don't wait for a response, see event_subscribe().
+     */
     if (ctx->rank != 0) {
+        flux_future_t *f;
+
         if (asprintf (&topic, "kvs.namespace-%s", ns) < 0)
             goto cleanup;
 
-        if (flux_event_unsubscribe (ctx->h, topic) < 0) {
-            flux_log_error (ctx->h, "flux_event_subscribe");
+        if (!(f = flux_event_unsubscribe_ex (ctx->h,
+                                             topic,
+                                             FLUX_RPC_NORESPONSE))) {
+            flux_log_error (ctx->h, "flux_event_unsubscribe_ex");
             goto cleanup;
         }
+        flux_future_destroy (f);
     }
 
     rc = 0;
@@ -351,13 +438,8 @@ static void getroot_completion (flux_future_t *f, void *arg)
      * response.  Not relevant if namespace in process of being removed. */
     if (!(root = kvsroot_mgr_lookup_root (ctx->krm, ns))) {
 
-        if (!(root = kvsroot_mgr_create_root (ctx->krm,
-                                              ctx->cache,
-                                              ctx->hash_name,
-                                              ns,
-                                              owner,
-                                              flags))) {
-            flux_log_error (ctx->h, "%s: kvsroot_mgr_create_root", __FUNCTION__);
+        if (!(root = create_root (ctx, ns, owner, flags))) {
+            flux_log_error (ctx->h, "%s: create_root", __FUNCTION__);
             goto error;
         }
 
@@ -403,7 +485,8 @@ static int getroot_request_send (struct kvs_ctx *ctx,
                                  const char *ns,
                                  flux_msg_handler_t *mh,
                                  const flux_msg_t *msg,
-                                 lookup_t *lh)
+                                 const char *aux_name,
+                                 void *aux)
 {
     flux_future_t *f = NULL;
     flux_msg_t *msgcpy = NULL;
@@ -422,8 +505,8 @@ static int getroot_request_send (struct kvs_ctx *ctx,
         goto error;
     }
 
-    if (lh
-        && flux_msg_aux_set (msgcpy, "lookup_handle", lh, NULL) < 0) {
+    if (aux_name
+        && flux_msg_aux_set (msgcpy, aux_name, aux, NULL) < 0) {
         flux_log_error (ctx->h, "%s: flux_msg_aux_set", __FUNCTION__);
         goto error;
     }
@@ -450,7 +533,8 @@ static struct kvsroot *getroot (struct kvs_ctx *ctx,
                                 const char *ns,
                                 flux_msg_handler_t *mh,
                                 const flux_msg_t *msg,
-                                lookup_t *lh,
+                                const char *aux_name,
+                                void *aux,
                                 bool *stall)
 {
     struct kvsroot *root;
@@ -463,7 +547,7 @@ static struct kvsroot *getroot (struct kvs_ctx *ctx,
             return NULL;
         }
         else {
-            if (getroot_request_send (ctx, ns, mh, msg, lh) < 0) {
+            if (getroot_request_send (ctx, ns, mh, msg, aux_name, aux) < 0) {
                 flux_log_error (ctx->h, "getroot_request_send");
                 return NULL;
             }
@@ -569,6 +653,40 @@ error:
     return -1;
 }
 
+/* Create an incomplete cache entry for 'ref' and send a request to
+ * load it from the content store.
+ */
+static struct cache_entry *load_entry_create (struct kvs_ctx *ctx,
+                                              const char *ref)
+{
+    struct cache_entry *entry;
+    int saved_errno;
+    __attribute__((unused)) int ret;
+
+    if (!(entry = cache_entry_create (ref))) {
+        flux_log_error (ctx->h, "%s: cache_entry_create", __FUNCTION__);
+        return NULL;
+    }
+    if (cache_insert (ctx->cache, entry) < 0) {
+        flux_log_error (ctx->h, "%s: cache_insert", __FUNCTION__);
+        cache_entry_destroy (entry);
+        return NULL;
+    }
+    if (content_load_request_send (ctx, ref) < 0) {
+        saved_errno = errno;
+        flux_log_error (ctx->h,
+                        "%s: content_load_request_send",
+                        __FUNCTION__);
+        /* cache entry just created, should always work */
+        ret = cache_remove_entry (ctx->cache, ref);
+        assert (ret == 1);
+        errno = saved_errno;
+        return NULL;
+    }
+    ctx->faults++;
+    return entry;
+}
+
 /* Return 0 on success, -1 on error.  Set stall variable appropriately
  */
 static int load (struct kvs_ctx *ctx,
@@ -577,35 +695,14 @@ static int load (struct kvs_ctx *ctx,
                  bool *stall)
 {
     struct cache_entry *entry = cache_lookup (ctx->cache, ref);
-    int saved_errno;
-    __attribute__((unused)) int ret;
 
     assert (wait != NULL);
 
     /* Create an incomplete hash entry if none found.
      */
     if (!entry) {
-        if (!(entry = cache_entry_create (ref))) {
-            flux_log_error (ctx->h, "%s: cache_entry_create", __FUNCTION__);
-            return -1;
-        }
-        if (cache_insert (ctx->cache, entry) < 0) {
-            flux_log_error (ctx->h, "%s: cache_insert", __FUNCTION__);
-            cache_entry_destroy (entry);
+        if (!(entry = load_entry_create (ctx, ref)))
             return -1;
-        }
-        if (content_load_request_send (ctx, ref) < 0) {
-            saved_errno = errno;
-            flux_log_error (ctx->h,
-                            "%s: content_load_request_send",
-                            __FUNCTION__);
-            /* cache entry just created, should always work */
-            ret = cache_remove_entry (ctx->cache, ref);
-            assert (ret == 1);
-            errno = saved_errno;
-            return -1;
-        }
-        ctx->faults++;
     }
     /* If hash entry is incomplete (either created above or earlier),
      * arrange to stall caller.
@@ -761,6 +858,19 @@ error:
     return rc;
 }
 
+/* Load a blob that valref compaction skipped into the cache, so that
+ * a later append can compact it.  Nothing waits on the load.
+ */
+static int kvstxn_compact_load_cb (kvstxn_t *kt, const char *ref, void *data)
+{
+    struct kvs_ctx *ctx = data;
+
+    if (!cache_lookup (ctx->cache, ref)
+        && !load_entry_create (ctx, ref))
+        return -1;
+    return 0;
+}
+
 static int kvstxn_load_cb (kvstxn_t *kt, const char *ref, void *data)
 {
     struct kvs_cb_data *cbd = data;
@@ -811,6 +921,8 @@ static int kvstxn_cache_cb (kvstxn_t *kt, struct cache_entry *entry, void *data)
         kvstxn_cleanup_dirty_cache_entry (kt, entry);
         return -1;
     }
+    if (streq (kvstxn_get_namespace (kt), KVS_PRIMARY_NAMESPACE))
+        kvs_checkpoint_add_bytes (cbd->ctx->kcp, storedatalen);
     if (cache_entry_wait_notdirty (entry, cbd->wait) < 0) {
         cbd->errnum = errno;
         flux_log_error (cbd->ctx->h, "cache_entry_wait_notdirty");
@@ -868,6 +980,142 @@ done:
     return rc;
 }
 
+/* Return the number of blobs in the valref at 'key' under the current
+ * root, or -1 if the key is not a valref or cannot be looked up without
+ * loading content.
+ */
+static int valref_count (struct kvs_ctx *ctx,
+                         struct kvsroot *root,
+                         const char *key)
+{
+    struct flux_msg_cred cred = {
+        .userid = root->owner,
+        .rolemask = FLUX_ROLE_OWNER,
+    };
+    lookup_t *lh;
+    json_t *val = NULL;
+    int count = -1;
+
+    if (!(lh = lookup_create (ctx->cache,
+                              ctx->krm,
+                              root->ns_name,
+                              root->ref,
+                              root->seq,
+                              key,
+                              cred,
+                              FLUX_KVS_TREEOBJ,
+                              ctx->h)))
+        return -1;
+    if (lookup (lh) == LOOKUP_PROCESS_FINISHED
+        && (val = lookup_get_value (lh))
+        && treeobj_is_valref (val))
+        count = treeobj_get_count (val);
+    json_decref (val);
+    lookup_destroy (lh);
+    return count;
+}
+
+/* Build the "keys" object for a setroot event.  For keys that were only
+ * appended to by this transaction, the appended values are included so
+ * that kvs-watch can respond to FLUX_KVS_WATCH_APPEND watchers without
+ * looking up the key and loading the new blobs from the content store.
+ * Such a key maps to { "count":i, "append":[val,...] }, where count is
+ * the number of blobs in the key's valref after the commit, and the
+ * vals are the trailing blobs in order.  Other keys map to null.  The
+ * total size of inlined data is limited by ctx->setroot_inline_max.
+ */
+static json_t *setroot_event_keys (struct kvs_ctx *ctx,
+                                   struct kvsroot *root,
+                                   kvstxn_t *kt)
+{
+    json_t *keys = kvstxn_get_keys (kt);
+    json_t *appends = NULL;
+    json_t *cpy = NULL;
+    json_t *op;
+    json_t *a;
+    size_t index;
+    const char *key;
+    size_t total = 0;
+
+    if (ctx->setroot_inline_max == 0)
+        return json_incref (keys);
+
+    /* Collect the values appended to each key, or false if the key was
+     * modified in some other way.
+     */
+    if (!(appends = json_object ()))
+        goto nomem;
+    json_array_foreach (kvstxn_get_ops (kt), index, op) {
+        json_t *dirent;
+        char *key_norm;
+        int flags;
+        int rc;
+
+        if (json_unpack (op,
+                         "{s:s s:i s:o}",
+                         "key", &key,
+                         "flags", &flags,
+                         "dirent", &dirent) < 0
+            || !(key_norm = kvs_util_normalize_key (key, NULL)))
+            goto error;
+        a = json_object_get (appends, key_norm);
+        if (!(flags & FLUX_KVS_APPEND) || !treeobj_is_val (dirent))
+            rc = json_object_set_new (appends, key_norm, json_false ());
+        else if (!a) {
+            rc = -1;
+            if ((a = json_array ())) {
+                if ((rc = json_object_set_new (appends, key_norm, a)) == 0)
+                    rc = json_array_append (a, dirent);
+            }
+        }
+        else if (json_is_array (a))
+            rc = json_array_append (a, dirent);
+        else
+            rc = 0;
+        free (key_norm);
+        if (rc < 0)
+            goto nomem;
+    }
+
+    if (!(cpy = json_copy (keys)))
+        goto nomem;
+    json_object_foreach (appends, key, a) {
+        json_t *o;
+        json_t *val;
+        size_t size = 0;
+        int count;
+
+        if (!json_is_array (a))
+            continue;
+        json_array_foreach (a, index, val)
+            size += json_string_length (json_object_get (val, "data"));
+        if (total + size > ctx->setroot_inline_max)
+            continue;
+        /* The appended blobs must be the last ones in the valref.  A
+         * key that did not previously exist is stored as a val, and is
+         * left for kvs-watch to look up.
+         */
+        count = valref_count (ctx, root, key);
+        if (count < 0 || count < json_array_size (a))
+            continue;
+        if (!(o = json_pack ("{s:i s:O}", "count", count, "append", a))
+            || json_object_set_new (cpy, key, o) < 0) {
+            json_decref (o);
+            goto nomem;
+        }
+        total += size;
+    }
+    json_decref (appends);
+    return cpy;
+nomem:
+    errno = ENOMEM;
+error:
+    flux_log_error (ctx->h, "%s", __FUNCTION__);
+    json_decref (appends);
+    json_decref (cpy);
+    return json_incref (keys);
+}
+
 static int error_event_send (struct kvs_ctx *ctx,
                              const char *ns,
                              json_t *names,
@@ -959,6 +1207,21 @@ static void work_queue_check_append (struct kvs_ctx *ctx, struct kvsroot *root)
         work_queue_append (ctx, root);
 }
 
+static void kvstxn_record_stats (struct kvsroot *root, kvstxn_t *kt)
+{
+    struct kvstxn_timing t;
+
+    kvstxn_get_timing (kt, &t);
+    hist_push (&root->stats.commit_latency, t.age * 1000.);
+    hist_push (&root->stats.commit_load, t.load * 1000.);
+    hist_push (&root->stats.commit_store, t.store * 1000.);
+    hist_push (&root->stats.commit_sync, t.sync * 1000.);
+    hist_push (&root->stats.commit_pipeline, t.pipeline * 1000.);
+    hist_push (&root->stats.commit_stalls, t.stalls);
+    hist_push (&root->stats.commit_merged,
+               json_array_size (kvstxn_get_names (kt)));
+}
+
 static void kvstxn_apply_cb (flux_future_t *f, void *arg)
 {
     kvstxn_t *kt = arg;
@@ -999,9 +1262,6 @@ static void kvstxn_apply (kvstxn_t *kt)
         goto done;
     }
 
-    if ((errnum = kvstxn_get_aux_errnum (kt)))
-        goto done;
-
     if ((ret = kvstxn_process (kt,
                                root->ref,
                                root->seq)) == KVSTXN_PROCESS_ERROR) {
@@ -1009,7 +1269,11 @@ static void kvstxn_apply (kvstxn_t *kt)
         goto done;
     }
 
-    if (ret == KVSTXN_PROCESS_LOAD_MISSING_REFS) {
+    if (ret == KVSTXN_PROCESS_PIPELINE_WAIT) {
+        /* transaction ahead of this one must complete first */
+        goto stall;
+    }
+    else if (ret == KVSTXN_PROCESS_LOAD_MISSING_REFS) {
         struct kvs_cb_data cbd;
 
         if (!(wait = wait_create ((wait_cb_f)kvstxn_apply, kt))) {
@@ -1118,9 +1382,16 @@ done:
                       opcount);
         }
         if (!(internal_flags & KVSTXN_INTERNAL_FLAG_NO_PUBLISH)) {
+            json_t *keys;
+
             setroot (ctx, root, kvstxn_get_newroot_ref (kt), root->seq + 1);
-            setroot_event_send (ctx, root, names, kvstxn_get_keys (kt));
+            keys = setroot_event_keys (ctx, root, kt);
+            setroot_event_send (ctx, root, names, keys);
+            json_decref (keys);
         }
+        if (kvstxn_iter_compact_refs (kt, kvstxn_compact_load_cb, ctx) < 0)
+            flux_log_error (ctx->h, "%s: kvstxn_iter_compact_refs", __FUNCTION__);
+        kvstxn_record_stats (root, kt);
     }
     else {
         fallback = kvstxn_fallback_mergeable (kt);
@@ -1245,6 +1516,29 @@ error:
         flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
 }
 
+/* The content module on this rank tells the KVS when garbage collection
+ * starts and stops removing blobs, so that blobs in the cache are stored
+ * again when linked by a commit.  See cache_set_gc_sweep().
+ */
+static void gc_sweep_request_cb (flux_t *h,
+                                 flux_msg_handler_t *mh,
+                                 const flux_msg_t *msg,
+                                 void *arg)
+{
+    struct kvs_ctx *ctx = arg;
+    int active;
+
+    if (flux_request_unpack (msg, NULL, "{s:b}", "active", &active) < 0)
+        goto error;
+    cache_set_gc_sweep (ctx->cache, active);
+    if (flux_respond (h, msg, NULL) < 0)
+        flux_log_error (h, "%s: flux_respond", __FUNCTION__);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+}
+
 static void dropcache_event_cb (flux_t *h,
                                 flux_msg_handler_t *mh,
                                 const flux_msg_t *msg,
@@ -1310,6 +1604,17 @@ static int heartbeat_root_cb (struct kvsroot *root, void *arg)
     return 0;
 }
 
+static void cache_trim_cb (flux_reactor_t *r,
+                           flux_watcher_t *w,
+                           int revents,
+                           void *arg)
+{
+    struct kvs_ctx *ctx = arg;
+
+    if (cache_over_limit (ctx->cache))
+        ctx->evictions += cache_trim (ctx->cache);
+}
+
 static void heartbeat_sync_cb (flux_future_t *f, void *arg)
 {
     struct kvs_ctx *ctx = arg;
@@ -1345,6 +1650,19 @@ static void lookup_wait_error_cb (wait_t *w, int errnum, void *arg)
     lookup_set_aux_errnum (lh, errnum);
 }
 
+/* Lookups by root reference (no namespace) are not counted.
+ */
+static void lookup_record_stats (struct kvs_ctx *ctx, lookup_t *lh)
+{
+    const char *ns;
+    struct kvsroot *root;
+
+    if ((ns = lookup_get_namespace (lh))
+        && (root = kvsroot_mgr_lookup_root_safe (ctx->krm, ns)))
+        hist_push (&root->stats.lookup_latency,
+                   lookup_get_elapsed (lh) * 1000.);
+}
+
 static lookup_t *lookup_common (flux_t *h,
                                 flux_msg_handler_t *mh,
                                 const flux_msg_t *msg,
@@ -1439,7 +1757,7 @@ static lookup_t *lookup_common (flux_t *h,
         ns = lookup_missing_namespace (lh);
         assert (ns);
 
-        root = getroot (ctx, ns, mh, msg, lh, &stall);
+        root = getroot (ctx, ns, mh, msg, "lookup_handle", lh, &stall);
         assert (!root);
 
         if (stall)
@@ -1480,6 +1798,7 @@ static lookup_t *lookup_common (flux_t *h,
     }
     /* else lret == LOOKUP_PROCESS_FINISHED, fallthrough */
 
+    lookup_record_stats (ctx, lh);
     rc = 0;
 done:
     wait_destroy (wait);
@@ -1595,6 +1914,255 @@ error:
     request_tracking_remove (ctx, msg);
 }
 
+/* kvs.lookup-batch looks up a list of keys against a single root
+ * snapshot, chosen when the request is first processed.  One response
+ * is sent per key, in request order, carrying either the value or an
+ * error number for that key.  The stream is terminated with ENODATA.
+ * Batch state is kept in the request message aux while stalled.
+ */
+struct lookup_batch {
+    json_t *keys;
+    size_t index;               // index of next key to respond to
+    int flags;
+    char *ns;
+    char root_ref[BLOBREF_MAX_STRING_SIZE];
+    int root_seq;
+    struct flux_msg_cred cred;
+    lookup_t *lh;               // lookup of keys[index] in progress
+};
+
+static void lookup_batch_destroy (struct lookup_batch *b)
+{
+    if (b) {
+        int saved_errno = errno;
+        json_decref (b->keys);
+        free (b->ns);
+        lookup_destroy (b->lh);
+        free (b);
+        errno = saved_errno;
+    }
+}
+
+static struct lookup_batch *lookup_batch_create (struct kvs_ctx *ctx,
+                                                 flux_msg_handler_t *mh,
+                                                 const flux_msg_t *msg,
+                                                 bool *stall)
+{
+    struct lookup_batch *b;
+    struct kvsroot *root;
+    const char *ns;
+    json_t *keys;
+    int flags;
+    size_t index;
+    json_t *key;
+
+    (*stall) = false;
+
+    if (flux_request_unpack (msg,
+                             NULL,
+                             "{ s:o s:i s:s }",
+                             "keys", &keys,
+                             "flags", &flags,
+                             "namespace", &ns) < 0) {
+        flux_log_error (ctx->h, "%s: flux_request_unpack", __FUNCTION__);
+        return NULL;
+    }
+    if (!flux_msg_is_streaming (msg) || !json_is_array (keys)) {
+        errno = EPROTO;
+        return NULL;
+    }
+    json_array_foreach (keys, index, key) {
+        if (!json_is_string (key)) {
+            errno = EPROTO;
+            return NULL;
+        }
+    }
+
+    if (!(root = getroot (ctx, ns, mh, msg, NULL, NULL, stall)))
+        return NULL;
+
+    if (!(b = calloc (1, sizeof (*b))))
+        return NULL;
+    b->keys = json_incref (keys);
+    b->flags = flags;
+    if (!(b->ns = strdup (ns)))
+        goto error;
+    strcpy (b->root_ref, root->ref);
+    b->root_seq = root->seq;
+    if (flux_msg_get_cred (msg, &b->cred) < 0) {
+        flux_log_error (ctx->h, "flux_msg_get_cred");
+        goto error;
+    }
+    return b;
+error:
+    lookup_batch_destroy (b);
+    return NULL;
+}
+
+/* Look up the key at b->index.  Return 0 with the value (or NULL if the
+ * key does not exist) in 'valp', or errnum set if the lookup of this key
+ * failed.  Return -1 with stall set if the lookup must wait, or -1 with
+ * stall clear on a fatal error.
+ */
+static int lookup_batch_next (struct kvs_ctx *ctx,
+                              flux_msg_handler_t *mh,
+                              const flux_msg_t *msg,
+                              flux_msg_handler_f replay_cb,
+                              struct lookup_batch *b,
+                              json_t **valp,
+                              int *errnum,
+                              bool *stall)
+{
+    const char *key = json_string_value (json_array_get (b->keys, b->index));
+    wait_t *wait = NULL;
+    lookup_process_t lret;
+    int err;
+
+    (*stall) = false;
+    (*errnum) = 0;
+    (*valp) = NULL;
+
+    if (!b->lh) {
+        if (!(b->lh = lookup_create (ctx->cache,
+                                     ctx->krm,
+                                     b->ns,
+                                     b->root_ref,
+                                     b->root_seq,
+                                     key,
+                                     b->cred,
+                                     b->flags,
+                                     ctx->h))) {
+            (*errnum) = errno;
+            return 0;
+        }
+    }
+    else if ((err = lookup_get_aux_errnum (b->lh))) {
+        /* error in prior load(), waited for in flight rpcs to complete */
+        (*errnum) = err;
+        return 0;
+    }
+
+    lret = lookup (b->lh);
+
+    if (lret == LOOKUP_PROCESS_ERROR) {
+        (*errnum) = lookup_get_errnum (b->lh);
+        return 0;
+    }
+    else if (lret == LOOKUP_PROCESS_LOAD_MISSING_NAMESPACE) {
+        __attribute__((unused)) struct kvsroot *root;
+        const char *ns;
+
+        /* a symlink refers to a namespace not yet known on this rank */
+        ns = lookup_missing_namespace (b->lh);
+        assert (ns);
+
+        root = getroot (ctx, ns, mh, msg, "lookup_batch", b, stall);
+        assert (!root);
+
+        if (*stall)
+            return -1;
+        (*errnum) = errno;
+        return 0;
+    }
+    else if (lret == LOOKUP_PROCESS_LOAD_MISSING_REFS) {
+        struct kvs_cb_data cbd;
+
+        if (!(wait = wait_create_msg_handler (ctx->h, mh, msg, ctx, replay_cb))
+            || wait_set_error_cb (wait, lookup_wait_error_cb, b->lh) < 0
+            || wait_msg_aux_set (wait, "lookup_batch", b, NULL) < 0)
+            goto error;
+
+        cbd.ctx = ctx;
+        cbd.wait = wait;
+        cbd.errnum = 0;
+
+        if (lookup_iter_missing_refs (b->lh, lookup_load_cb, &cbd) < 0) {
+            /* rpcs already in flight, stall for them to complete */
+            if (wait_get_usecount (wait) > 0) {
+                lookup_set_aux_errnum (b->lh, cbd.errnum);
+                (*stall) = true;
+                return -1;
+            }
+            wait_destroy (wait);
+            (*errnum) = cbd.errnum;
+            return 0;
+        }
+        assert (wait_get_usecount (wait) > 0);
+        (*stall) = true;
+        return -1;
+    }
+    /* else lret == LOOKUP_PROCESS_FINISHED */
+
+    lookup_record_stats (ctx, b->lh);
+    if (!((*valp) = lookup_get_value (b->lh)))
+        (*errnum) = ENOENT;
+    return 0;
+error:
+    wait_destroy (wait);
+    return -1;
+}
+
+static void lookup_batch_request_cb (flux_t *h,
+                                     flux_msg_handler_t *mh,
+                                     const flux_msg_t *msg,
+                                     void *arg)
+{
+    struct kvs_ctx *ctx = arg;
+    struct lookup_batch *b;
+    bool stall = false;
+
+    /* if lookup_batch exists in msg as aux data, is a replay */
+    if (!(b = flux_msg_aux_get (msg, "lookup_batch"))) {
+        if (!(b = lookup_batch_create (ctx, mh, msg, &stall)))
+            goto stall_or_error;
+    }
+    while (b->index < json_array_size (b->keys)) {
+        const char *key;
+        json_t *val;
+        int errnum;
+        int rc;
+
+        if (lookup_batch_next (ctx,
+                               mh,
+                               msg,
+                               lookup_batch_request_cb,
+                               b,
+                               &val,
+                               &errnum,
+                               &stall) < 0)
+            goto stall_or_error;
+        key = json_string_value (json_array_get (b->keys, b->index));
+        if (errnum)
+            rc = flux_respond_pack (h,
+                                    msg,
+                                    "{ s:s s:i }",
+                                    "key", key,
+                                    "errno", errnum);
+        else
+            rc = flux_respond_pack (h,
+                                    msg,
+                                    "{ s:s s:O }",
+                                    "key", key,
+                                    "val", val);
+        if (rc < 0)
+            flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+        json_decref (val);
+        lookup_destroy (b->lh);
+        b->lh = NULL;
+        b->index++;
+    }
+    errno = ENODATA;
+stall_or_error:
+    if (stall) {
+        request_tracking_add (ctx, msg);
+        return;
+    }
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+    request_tracking_remove (ctx, msg);
+    lookup_batch_destroy (b);
+}
+
 
 static int finalize_transaction_req (treq_t *tr,
                                      const flux_msg_t *req,
@@ -1778,7 +2346,7 @@ static void commit_request_cb (flux_t *h,
         goto error;
     }
 
-    if (!(root = getroot (ctx, ns, mh, msg, NULL, &stall))) {
+    if (!(root = getroot (ctx, ns, mh, msg, NULL, NULL, &stall))) {
         if (stall) {
             request_tracking_add (ctx, msg);
             return;
@@ -1864,7 +2432,7 @@ static void wait_version_request_cb (flux_t *h,
         goto error;
     }
 
-    if (!(root = getroot (ctx, ns, mh, msg, NULL, &stall))) {
+    if (!(root = getroot (ctx, ns, mh, msg, NULL, NULL, &stall))) {
         if (stall) {
             request_tracking_add (ctx, msg);
             return;
@@ -1930,7 +2498,7 @@ static void getroot_request_cb (flux_t *h, flux_msg_handler_t *mh,
          * first.
          */
         bool stall = false;
-        if (!(root = getroot (ctx, ns, mh, msg, NULL, &stall))) {
+        if (!(root = getroot (ctx, ns, mh, msg, NULL, NULL, &stall))) {
             if (stall) {
                 request_tracking_add (ctx, msg);
                 return;
@@ -2097,21 +2665,60 @@ static void disconnect_request_cb (flux_t *h, flux_msg_handler_t *mh,
         flux_log_error (h, "%s: wait_destroy_msg", __FUNCTION__);
 }
 
+static json_t *get_hist_obj (hist_t *h)
+{
+    json_t *o = json_pack ("{ s:I s:I s:I s:I s:I }",
+                           "count", (json_int_t)hist_count (h),
+                           "p50", (json_int_t)hist_percentile (h, 50),
+                           "p90", (json_int_t)hist_percentile (h, 90),
+                           "p99", (json_int_t)hist_percentile (h, 99),
+                           "max", (json_int_t)hist_max (h));
+    if (!o) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return o;
+}
+
 static int stats_get_root_cb (struct kvsroot *root, void *arg)
 {
     json_t *nsstats = arg;
     json_t *s;
+    struct kvsroot_stats *st = &root->stats;
 
-    if (!(s = json_pack ("{ s:i s:i s:i s:i s:i }",
+    if (!(s = json_pack ("{ s:i s:i s:i s:i s:i s:i s:i s:i"
+                         " s:o s:o s:o s:o s:o s:o s:o s:o }",
                          "#versionwaiters",
                          zlist_size (root->wait_version_list),
                          "#no-op stores",
                          kvstxn_mgr_get_noop_stores (root->ktm),
+                         "#valref compactions",
+                         kvstxn_mgr_get_compactions (root->ktm),
+                         "#valref blobs saved",
+                         kvstxn_mgr_get_compacted_blobs (root->ktm),
+                         "#dir splices",
+                         kvstxn_mgr_get_dir_splices (root->ktm),
                          "#transactions",
                          treq_mgr_transactions_count (root->trm),
                          "#readytransactions",
                          kvstxn_mgr_ready_transaction_count (root->ktm),
-                         "store revision", root->seq))) {
+                         "store revision", root->seq,
+                         "commit latency (usec)",
+                         get_hist_obj (&st->commit_latency),
+                         "commit load stall (usec)",
+                         get_hist_obj (&st->commit_load),
+                         "commit store stall (usec)",
+                         get_hist_obj (&st->commit_store),
+                         "commit sync stall (usec)",
+                         get_hist_obj (&st->commit_sync),
+                         "commit pipeline stall (usec)",
+                         get_hist_obj (&st->commit_pipeline),
+                         "commit stalls",
+                         get_hist_obj (&st->commit_stalls),
+                         "commit merged transactions",
+                         get_hist_obj (&st->commit_merged),
+                         "lookup latency (usec)",
+                         get_hist_obj (&st->lookup_latency)))) {
         errno = ENOMEM;
         return -1;
     }
@@ -2161,12 +2768,17 @@ static void stats_get_cb (flux_t *h,
     if (!(tstats = get_tstat_obj (&ts, scale)))
         goto nomem;
 
-    if (!(cstats = json_pack ("{ s:f s:O s:i s:i s:i }",
+    if (!(cstats = json_pack ("{ s:f s:f s:f s:O s:i s:i s:i s:i }",
                               "obj size total (MiB)", (double)size/1048576,
+                              "memory total (MiB)",
+                                (double)cache_get_bytes (ctx->cache)/1048576,
+                              "memory limit (MiB)",
+                                (double)ctx->cache_max_bytes/1048576,
                               "obj size (KiB)", tstats,
                               "#obj dirty", dirty,
                               "#obj incomplete", incomplete,
-                              "#faults", ctx->faults)))
+                              "#faults", ctx->faults,
+                              "#evictions", ctx->evictions)))
         goto nomem;
 
     if (!(txncstats = get_tstat_obj (&ctx->txn_commit_stats, 1.0)))
@@ -2226,12 +2838,16 @@ error:
 static int stats_clear_root_cb (struct kvsroot *root, void *arg)
 {
     kvstxn_mgr_clear_noop_stores (root->ktm);
+    kvstxn_mgr_clear_compaction_stats (root->ktm);
+    kvstxn_mgr_clear_dir_splices (root->ktm);
+    memset (&root->stats, 0, sizeof (root->stats));
     return 0;
 }
 
 static void stats_clear (struct kvs_ctx *ctx)
 {
     ctx->faults = 0;
+    ctx->evictions = 0;
     memset (&ctx->txn_commit_stats, '\0', sizeof (ctx->txn_commit_stats));
 
     if (kvsroot_mgr_iter_roots (ctx->krm, stats_clear_root_cb, NULL) < 0)
@@ -2283,13 +2899,8 @@ static int namespace_create (struct kvs_ctx *ctx,
         return -1;
     }
 
-    if (!(root = kvsroot_mgr_create_root (ctx->krm,
-                                          ctx->cache,
-                                          ctx->hash_name,
-                                          ns,
-                                          owner,
-                                          flags))) {
-        flux_log_error (ctx->h, "%s: kvsroot_mgr_create_root", __FUNCTION__);
+    if (!(root = create_root (ctx, ns, owner, flags))) {
+        flux_log_error (ctx->h, "%s: create_root", __FUNCTION__);
         return -1;
     }
 
@@ -2555,7 +3166,7 @@ static void setroot_pause_request_cb (flux_t *h,
         goto error;
     }
 
-    if (!(root = getroot (ctx, ns, mh, msg, NULL, &stall))) {
+    if (!(root = getroot (ctx, ns, mh, msg, NULL, NULL, &stall))) {
         if (stall)
             return;
         goto error;
@@ -2620,7 +3231,7 @@ static void setroot_unpause_request_cb (flux_t *h,
         goto error;
     }
 
-    if (!(root = getroot (ctx, ns, mh, msg, NULL, &stall))) {
+    if (!(root = getroot (ctx, ns, mh, msg, NULL, NULL, &stall))) {
         if (stall)
             return;
         goto error;
@@ -2644,6 +3255,33 @@ error:
         flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
 }
 
+static int cache_config_parse (const flux_conf_t *conf,
+                               flux_error_t *errp,
+                               uint64_t *max_bytes)
+{
+    flux_error_t error;
+    const char *str = NULL;
+    uint64_t size = 0;
+
+    if (flux_conf_unpack (conf,
+                          &error,
+                          "{s?{s?s}}",
+                          "kvs",
+                            "cache-max-size", &str) < 0) {
+        errprintf (errp, "error reading config for kvs: %s", error.text);
+        return -1;
+    }
+    if (str) {
+        if (parse_size (str, &size) < 0 || size > SIZE_MAX) {
+            errprintf (errp, "invalid cache-max-size config: %s", str);
+            errno = EINVAL;
+            return -1;
+        }
+    }
+    *max_bytes = size;
+    return 0;
+}
+
 static void config_reload_cb (flux_t *h,
                               flux_msg_handler_t *mh,
                               const flux_msg_t *msg,
@@ -2653,13 +3291,17 @@ static void config_reload_cb (flux_t *h,
     const flux_conf_t *conf;
     const char *errstr = NULL;
     flux_error_t error;
+    uint64_t max_bytes;
 
     if (flux_conf_reload_decode (msg, &conf) < 0)
         goto error;
-    if (kvs_checkpoint_reload (ctx->kcp, conf, &error) < 0) {
+    if (cache_config_parse (conf, &error, &max_bytes) < 0
+        || kvs_checkpoint_reload (ctx->kcp, conf, &error) < 0) {
         errstr = error.text;
         goto error;
     }
+    ctx->cache_max_bytes = max_bytes;
+    cache_set_max_bytes (ctx->cache, max_bytes);
     if (flux_respond (h, msg, NULL) < 0)
         flux_log_error (h, "error responding to config-reload request");
     return;
@@ -2719,6 +3361,12 @@ static const struct flux_msg_handler_spec htab[] = {
         dropcache_event_cb,
         0
     },
+    {
+        FLUX_MSGTYPE_REQUEST,
+        "kvs.gc-sweep",
+        gc_sweep_request_cb,
+        0
+    },
     {
         FLUX_MSGTYPE_REQUEST,
         "kvs.disconnect",
@@ -2743,6 +3391,12 @@ static const struct flux_msg_handler_spec htab[] = {
         lookup_plus_request_cb,
         FLUX_ROLE_USER
     },
+    {
+        FLUX_MSGTYPE_REQUEST,
+        "kvs.lookup-batch",
+        lookup_batch_request_cb,
+        FLUX_ROLE_USER
+    },
     {
         FLUX_MSGTYPE_REQUEST,
         "kvs.commit",
@@ -2805,10 +3459,14 @@ static int process_config (struct kvs_ctx *ctx)
     flux_error_t error;
     if (kvs_checkpoint_config_parse (ctx->kcp,
                                      flux_get_conf (ctx->h),
-                                     &error) < 0) {
+                                     &error) < 0
+        || cache_config_parse (flux_get_conf (ctx->h),
+                               &error,
+                               &ctx->cache_max_bytes) < 0) {
         flux_log (ctx->h, LOG_ERR, "%s", error.text);
         return -1;
     }
+    cache_set_max_bytes (ctx->cache, ctx->cache_max_bytes);
     return 0;
 }
 
@@ -2826,6 +3484,63 @@ static int process_args (struct kvs_ctx *ctx, int ac, char **av)
                 return -1;
             }
         }
+        else if (strstarts (av[i], "dir-shard-threshold=")) {
+            char *endptr;
+            long threshold;
+            errno = 0;
+            threshold = strtol (av[i]+20, &endptr, 10);
+            if (errno != 0
+                || *endptr != '\0'
+                || threshold < 0
+                || threshold > INT_MAX) {
+                errno = EINVAL;
+                return -1;
+            }
+            ctx->dir_shard_threshold = threshold;
+        }
+        else if (strstarts (av[i], "transaction-pipeline=")) {
+            char *endptr;
+            long depth;
+            errno = 0;
+            depth = strtol (av[i]+21, &endptr, 10);
+            if (errno != 0
+                || *endptr != '\0'
+                || depth < 1
+                || depth > INT_MAX) {
+                errno = EINVAL;
+                return -1;
+            }
+            ctx->transaction_pipeline = depth;
+        }
+        else if (strstarts (av[i], "setroot-inline-max=")) {
+            char *endptr;
+            long size;
+            errno = 0;
+            size = strtol (av[i]+19, &endptr, 10);
+            if (errno != 0
+                || *endptr != '\0'
+                || size < 0
+                || size > INT_MAX) {
+                errno = EINVAL;
+                return -1;
+            }
+            ctx->setroot_inline_max = size;
+        }
+        else if (strstarts (av[i], "valref-compact=")) {
+            char *endptr;
+            long threshold;
+            errno = 0;
+            threshold = strtol (av[i]+15, &endptr, 10);
+            if (errno != 0
+                || *endptr != '\0'
+                || threshold < 0
+                || threshold == 1
+                || threshold > INT_MAX) {
+                errno = EINVAL;
+                return -1;
+            }
+            ctx->valref_compact = threshold;
+        }
         else {
             flux_log (ctx->h, LOG_ERR, "Unknown option `%s'", av[i]);
             errno = EINVAL;
@@ -3010,13 +3725,8 @@ int mod_main (flux_t *h, int argc, char **argv)
         if (!(root = kvsroot_mgr_lookup_root_safe (ctx->krm,
                                                    KVS_PRIMARY_NAMESPACE))) {
 
-            if (!(root = kvsroot_mgr_create_root (ctx->krm,
-                                                  ctx->cache,
-                                                  ctx->hash_name,
-                                                  KVS_PRIMARY_NAMESPACE,
-                                                  owner,
-                                                  0))) {
-                flux_log_error (h, "kvsroot_mgr_create_root");
+            if (!(root = create_root (ctx, KVS_PRIMARY_NAMESPACE, owner, 0))) {
+                flux_log_error (h, "create_root");
                 goto done;
             }
         }
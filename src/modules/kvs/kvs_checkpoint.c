@@ -21,6 +21,7 @@
 
 #include "src/common/libutil/errprintf.h"
 #include "src/common/libutil/fsd.h"
+#include "src/common/libutil/parse_size.h"
 
 #include "kvs_checkpoint.h"
 #include "kvsroot.h"
@@ -30,23 +31,29 @@ struct kvs_checkpoint {
     struct kvsroot *root_primary;
     double checkpoint_period;   /* in seconds */
     flux_watcher_t *checkpoint_w;
+    uint64_t checkpoint_bytes;  /* 0 for no limit */
+    uint64_t dirty_bytes;       /* stored since last checkpoint */
+    flux_watcher_t *bytes_w;
     kvs_checkpoint_txn_cb txn_cb;
     void *txn_cb_arg;
     int last_checkpoint_seq;
 };
 
-static int checkpoint_period_parse (const flux_conf_t *conf,
+static int checkpoint_config_parse (const flux_conf_t *conf,
                                     flux_error_t *errp,
-                                    double *checkpoint_period)
+                                    double *checkpoint_period,
+                                    uint64_t *checkpoint_bytes)
 {
     flux_error_t error;
     const char *str = NULL;
+    const char *bytes_str = NULL;
 
     if (flux_conf_unpack (conf,
                           &error,
-                          "{s?{s?s}}",
+                          "{s?{s?s s?s}}",
                           "kvs",
-                          "checkpoint-period", &str) < 0) {
+                          "checkpoint-period", &str,
+                          "checkpoint-bytes", &bytes_str) < 0) {
         errprintf (errp, "error reading config for kvs: %s", error.text);
         return -1;
     }
@@ -57,6 +64,12 @@ static int checkpoint_period_parse (const flux_conf_t *conf,
             return -1;
         }
     }
+    if (bytes_str) {
+        if (parse_size (bytes_str, checkpoint_bytes) < 0) {
+            errprintf (errp, "invalid checkpoint-bytes config: %s", bytes_str);
+            return -1;
+        }
+    }
 
     return 0;
 }
@@ -67,9 +80,14 @@ int kvs_checkpoint_config_parse (kvs_checkpoint_t *kcp,
 {
     if (kcp) {
         double checkpoint_period = kcp->checkpoint_period;
-        if (checkpoint_period_parse (conf, errp, &checkpoint_period) < 0)
+        uint64_t checkpoint_bytes = kcp->checkpoint_bytes;
+        if (checkpoint_config_parse (conf,
+                                     errp,
+                                     &checkpoint_period,
+                                     &checkpoint_bytes) < 0)
             return -1;
         kcp->checkpoint_period = checkpoint_period;
+        kcp->checkpoint_bytes = checkpoint_bytes;
     }
     return 0;
 }
@@ -80,11 +98,15 @@ int kvs_checkpoint_reload (kvs_checkpoint_t *kcp,
 {
     if (kcp) {
         double checkpoint_period = kcp->checkpoint_period;
-        if (checkpoint_period_parse (conf,
+        uint64_t checkpoint_bytes = kcp->checkpoint_bytes;
+        if (checkpoint_config_parse (conf,
                                      errp,
-                                     &checkpoint_period) < 0)
+                                     &checkpoint_period,
+                                     &checkpoint_bytes) < 0)
             return -1;
 
+        kcp->checkpoint_bytes = checkpoint_bytes;
+
         if (checkpoint_period != kcp->checkpoint_period) {
             kcp->checkpoint_period = checkpoint_period;
             flux_watcher_stop (kcp->checkpoint_w);
@@ -112,13 +134,21 @@ static void checkpoint_cb (flux_reactor_t *r,
     json_t *ops = NULL;
 
     /* if no changes to root since last checkpoint-period, do
-     * nothing */
-    if (kcp->last_checkpoint_seq == kcp->root_primary->seq)
+     * nothing.  A checkpoint triggered by checkpoint-bytes is
+     * submitted regardless, as the transaction that stored the
+     * bytes may not have updated the root yet.  The checkpoint
+     * transaction is queued behind it, so it will checkpoint the
+     * new root.
+     */
+    if (w == kcp->checkpoint_w
+        && kcp->last_checkpoint_seq == kcp->root_primary->seq)
         return;
 
     snprintf (name,
               sizeof (name),
-              "checkpoint-period.%u",
+              "%s.%u",
+              w == kcp->checkpoint_w ? "checkpoint-period"
+                                     : "checkpoint-bytes",
               kcp->root_primary->seq);
 
     if (!(ops = json_array ())) {
@@ -150,6 +180,7 @@ static void checkpoint_cb (flux_reactor_t *r,
      * checkpointing when there is no activity in the primary KVS.
      */
     kcp->last_checkpoint_seq = kcp->root_primary->seq;
+    kcp->dirty_bytes = 0;
 
 done:
     json_decref (ops);
@@ -185,6 +216,14 @@ kvs_checkpoint_t *kvs_checkpoint_create (flux_t *h,
         goto error;
 
     }
+    if (!(kcp->bytes_w = flux_timer_watcher_create (flux_get_reactor (h),
+                                                    0.,
+                                                    0.,
+                                                    checkpoint_cb,
+                                                    kcp))) {
+        flux_log_error (kcp->h, "flux_timer_watcher_create");
+        goto error;
+    }
 
     return kcp;
 
@@ -213,11 +252,25 @@ void kvs_checkpoint_start (kvs_checkpoint_t *kcp)
     }
 }
 
+void kvs_checkpoint_add_bytes (kvs_checkpoint_t *kcp, uint64_t bytes)
+{
+    if (kcp && kcp->root_primary) {
+        kcp->dirty_bytes += bytes;
+        if (kcp->checkpoint_bytes > 0
+            && kcp->dirty_bytes >= kcp->checkpoint_bytes
+            && !flux_watcher_is_active (kcp->bytes_w)) {
+            flux_timer_watcher_reset (kcp->bytes_w, 0., 0.);
+            flux_watcher_start (kcp->bytes_w);
+        }
+    }
+}
+
 void kvs_checkpoint_destroy (kvs_checkpoint_t *kcp)
 {
     if (kcp) {
         int save_errno = errno;
         flux_watcher_destroy (kcp->checkpoint_w);
+        flux_watcher_destroy (kcp->bytes_w);
         free (kcp);
         errno = save_errno;
     }
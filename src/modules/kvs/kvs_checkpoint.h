@@ -16,8 +16,10 @@
 #include "kvsroot.h"
 
 /* kvs_checkpoint will handle checkpointing for the checkpoint-period
- * configuration under the [kvs] table.  Internally the checkpoint-period
- * value and a timer are managed.
+ * and checkpoint-bytes configuration under the [kvs] table.  Internally
+ * the checkpoint-period value and a timer are managed, and a checkpoint
+ * is also made once checkpoint-bytes of data have been stored to the
+ * primary namespace since the last one.
  *
  * To avoid excess comparisons for `rank == 0` throughout KVS code,
  * most functions below are no-ops if the `kvs_checkpoint_t` argument
@@ -43,13 +45,14 @@ kvs_checkpoint_t *kvs_checkpoint_create (flux_t *h,
                                          kvs_checkpoint_txn_cb txn_cb,
                                          void *txn_cb_arg);
 
-/* update internal checkpoint_period setting as needed */
+/* update internal checkpoint_period / checkpoint_bytes settings as
+ * needed */
 int kvs_checkpoint_config_parse (kvs_checkpoint_t *kcp,
                                  const flux_conf_t *conf,
                                  flux_error_t *errp);
 
-/* update internal checkpoint_period setting as needed and restart
- * internal timers if needed
+/* update internal checkpoint_period / checkpoint_bytes settings as
+ * needed and restart internal timers if needed
  */
 int kvs_checkpoint_reload (kvs_checkpoint_t *kcp,
                            const flux_conf_t *conf,
@@ -64,6 +67,12 @@ void kvs_checkpoint_update_root_primary (kvs_checkpoint_t *kcp,
  */
 void kvs_checkpoint_start (kvs_checkpoint_t *kcp);
 
+/* account for 'bytes' of data stored to the primary namespace.  If
+ * checkpoint_bytes is exceeded, a checkpoint is submitted on the next
+ * reactor loop iteration.
+ */
+void kvs_checkpoint_add_bytes (kvs_checkpoint_t *kcp, uint64_t bytes);
+
 void kvs_checkpoint_destroy (kvs_checkpoint_t *kcp);
 
 
@@ -19,11 +19,26 @@
 #include "treq.h"
 #include "waitqueue.h"
 #include "src/common/libutil/blobref.h"
+#include "src/common/libutil/hist.h"
 #include "src/common/libccan/ccan/list/list.h"
 #include "src/common/libczmqcontainers/czmq_containers.h"
 
 typedef struct kvsroot_mgr kvsroot_mgr_t;
 
+/* Per-namespace distributions for kvs.stats-get.  Times are in usec.
+ * Commit times are for transactions as processed, i.e. after merging.
+ */
+struct kvsroot_stats {
+    hist_t commit_latency;      /* request received to new root */
+    hist_t commit_load;         /* stalled loading missing refs */
+    hist_t commit_store;        /* stalled storing dirty entries */
+    hist_t commit_sync;         /* stalled in FLUX_KVS_SYNC flush/checkpoint */
+    hist_t commit_pipeline;     /* stalled behind transactions ahead */
+    hist_t commit_stalls;       /* stalls per commit */
+    hist_t commit_merged;       /* transaction requests per commit */
+    hist_t lookup_latency;      /* request received to value found */
+};
+
 struct kvsroot {
     char *ns_name;
     bool is_primary;
@@ -39,6 +54,7 @@ struct kvsroot {
     bool setroot_pause;
     struct flux_msglist *setroot_queue;
     struct list_node work_queue_node;
+    struct kvsroot_stats stats;
 };
 
 /* return -1 on error, 0 on success, 1 on success & to stop iterating */
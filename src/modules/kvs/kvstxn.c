@@ -14,6 +14,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include <errno.h>
 #include <unistd.h>
 #include <stdbool.h>
@@ -26,6 +27,8 @@
 #include "src/common/libccan/ccan/base64/base64.h"
 #include "src/common/libutil/macros.h"
 #include "src/common/libutil/blobref.h"
+#include "src/common/libutil/errno_safe.h"
+#include "src/common/libutil/monotime.h"
 #include "src/common/libkvs/treeobj.h"
 #include "src/common/libkvs/kvs_checkpoint.h"
 #include "src/common/libkvs/kvs_commit.h"
@@ -35,11 +38,21 @@
 
 #include "kvstxn.h"
 
+/* Largest blob created by valref compaction.
+ */
+#define VALREF_COMPACT_BLOB_SIZE (1024*1024)
+
 struct kvstxn_mgr {
     struct cache *cache;
     const char *ns_name;
     const char *hash_name;
     int noop_stores;            /* for kvs.stats-get, etc.*/
+    int dir_shard_threshold;    /* shard dirs with more entries, 0=off */
+    int pipeline_depth;         /* max transactions processed at once */
+    int valref_compact;         /* compact valrefs with more blobs, 0=off */
+    int compactions;            /* for kvs.stats-get, etc. */
+    int compacted_blobs;        /* blobs removed from valrefs by compaction */
+    int dir_splices;            /* dirs encoded by treeobj_encode_update() */
     zlist_t *ready;
     flux_t *h;
     void *aux;
@@ -49,6 +62,7 @@ struct kvstxn {
     int errnum;
     int aux_errnum;
     unsigned int blocked:1;
+    unsigned int parked:1;      /* done, waiting for transactions ahead */
     json_t *ops;
     json_t *keys;
     json_t *names;
@@ -59,14 +73,21 @@ struct kvstxn {
     struct cache_entry *entry;  /* for reference counting rootdir above */
     struct cache_entry *newroot_entry;  /* for reference counting new root */
     char newroot[BLOBREF_MAX_STRING_SIZE];
+    char base[BLOBREF_MAX_STRING_SIZE]; /* root ops are applied to */
     zlist_t *missing_refs_list;
+    zlist_t *compact_refs_list;
     zlist_t *dirty_cache_entries_list;
+    zhashx_t *dir_sources;      /* copied dir -> blobref it was copied from */
     flux_future_t *f_sync_content_flush;
     flux_future_t *f_sync_checkpoint;
     bool processing;            /* kvstxn is being processed */
     bool merged;                /* kvstxn is a merger of transactions */
     bool merge_component;       /* kvstxn is member of a merger */
     kvstxn_mgr_t *ktm;
+    struct timespec t_create;   /* for kvstxn_get_timing() */
+    struct timespec t_stall;    /* start of current stall */
+    kvstxn_process_t stall;     /* current stall, or 0 if not stalled */
+    struct kvstxn_timing timing;
     /* State transitions
      *
      * INIT - perform initializations / checks
@@ -114,14 +135,35 @@ static void kvstxn_destroy (kvstxn_t *kt)
         cache_entry_decref (kt->newroot_entry);
         if (kt->missing_refs_list)
             zlist_destroy (&kt->missing_refs_list);
+        if (kt->compact_refs_list)
+            zlist_destroy (&kt->compact_refs_list);
         if (kt->dirty_cache_entries_list)
             zlist_destroy (&kt->dirty_cache_entries_list);
+        zhashx_destroy (&kt->dir_sources);
         flux_future_destroy (kt->f_sync_content_flush);
         flux_future_destroy (kt->f_sync_checkpoint);
         free (kt);
     }
 }
 
+static size_t ptr_hasher (const void *key)
+{
+    return (uintptr_t)key >> 4;
+}
+
+static int ptr_comparator (const void *item1, const void *item2)
+{
+    return item1 < item2 ? -1 : item1 > item2 ? 1 : 0;
+}
+
+static void free_wrapper (void **arg)
+{
+    if (arg) {
+        free (*arg);
+        *arg = NULL;
+    }
+}
+
 static kvstxn_t *kvstxn_create (kvstxn_mgr_t *ktm,
                                 const char *name,
                                 json_t *ops,
@@ -156,10 +198,22 @@ static kvstxn_t *kvstxn_create (kvstxn_mgr_t *ktm,
     if (!(kt->missing_refs_list = zlist_new ()))
         goto error_enomem;
     zlist_autofree (kt->missing_refs_list);
+    if (!(kt->compact_refs_list = zlist_new ()))
+        goto error_enomem;
+    zlist_autofree (kt->compact_refs_list);
     if (!(kt->dirty_cache_entries_list = zlist_new ()))
         goto error_enomem;
+    if (!(kt->dir_sources = zhashx_new ()))
+        goto error_enomem;
+    zhashx_set_key_hasher (kt->dir_sources, ptr_hasher);
+    zhashx_set_key_comparator (kt->dir_sources, ptr_comparator);
+    zhashx_set_key_duplicator (kt->dir_sources, NULL);
+    zhashx_set_key_destructor (kt->dir_sources, NULL);
+    zhashx_set_duplicator (kt->dir_sources, (zhashx_duplicator_fn *)strdup);
+    zhashx_set_destructor (kt->dir_sources, free_wrapper);
     kt->ktm = ktm;
     kt->state = KVSTXN_STATE_INIT;
+    monotime (&kt->t_create);
     return kt;
  error_enomem:
     kvstxn_destroy (kt);
@@ -167,6 +221,69 @@ static kvstxn_t *kvstxn_create (kvstxn_mgr_t *ktm,
     return NULL;
 }
 
+static void cleanup_dirty_cache_list (kvstxn_t *kt);
+
+/* Discard the results of processing 'kt', so that it can be applied
+ * to a different root.  The caller must not have loads or stores
+ * outstanding for the transaction.
+ */
+static void kvstxn_reset (kvstxn_t *kt)
+{
+    json_decref (kt->keys);
+    kt->keys = NULL;
+    json_decref (kt->rootcpy);
+    kt->rootcpy = NULL;
+    kt->rootdir = NULL;
+    cache_entry_decref (kt->entry);
+    kt->entry = NULL;
+    cache_entry_decref (kt->newroot_entry);
+    kt->newroot_entry = NULL;
+    zlist_purge (kt->missing_refs_list);
+    zlist_purge (kt->compact_refs_list);
+    zhashx_purge (kt->dir_sources);
+    cleanup_dirty_cache_list (kt);
+    flux_future_destroy (kt->f_sync_content_flush);
+    kt->f_sync_content_flush = NULL;
+    flux_future_destroy (kt->f_sync_checkpoint);
+    kt->f_sync_checkpoint = NULL;
+    kt->newroot[0] = '\0';
+    kt->base[0] = '\0';
+    kt->errnum = 0;
+    kt->aux_errnum = 0;
+    kt->blocked = 0;
+    kt->parked = 0;
+    kt->state = KVSTXN_STATE_INIT;
+}
+
+/* Return the transaction ahead of 'kt' in the ready queue, or NULL if
+ * 'kt' is first.  Components of a merged transaction are skipped.
+ */
+static kvstxn_t *kvstxn_predecessor (kvstxn_t *kt)
+{
+    kvstxn_t *prev = NULL;
+    kvstxn_t *tmp;
+
+    tmp = zlist_first (kt->ktm->ready);
+    while (tmp && tmp != kt) {
+        if (!tmp->merge_component)
+            prev = tmp;
+        tmp = zlist_next (kt->ktm->ready);
+    }
+    return prev;
+}
+
+/* Return the new root of 'kt' if it has been computed, so that the
+ * next transaction may be applied to it, otherwise NULL.
+ */
+static const char *kvstxn_pipeline_root (kvstxn_t *kt)
+{
+    if (kt->state < KVSTXN_STATE_GENERATE_KEYS
+        || kt->errnum != 0
+        || kt->aux_errnum != 0)
+        return NULL;
+    return kt->newroot;
+}
+
 int kvstxn_get_errnum (kvstxn_t *kt)
 {
     return kt->errnum;
@@ -234,6 +351,12 @@ json_t *kvstxn_get_keys (kvstxn_t *kt)
     return NULL;
 }
 
+void kvstxn_get_timing (kvstxn_t *kt, struct kvstxn_timing *t)
+{
+    *t = kt->timing;
+    t->age = monotime_since (kt->t_create);
+}
+
 /* On error we should cleanup anything on the dirty cache list
  * that has not yet been passed to the user.  Because this has not
  * been passed to the user, there should be no waiters and the
@@ -298,6 +421,105 @@ static int kvstxn_add_dirty_cache_entry (kvstxn_t *kt, struct cache_entry *entry
     return 0;
 }
 
+/* Store 'datalen' bytes of 'data' under key 'ref' in local cache.
+ * Data is still owned by the caller.
+ * Returns -1 on error, 0 on success entry already there, 1 on success
+ * entry needs to be flushed to content store
+ */
+static int store_cache_raw (kvstxn_t *kt,
+                            const void *data,
+                            size_t datalen,
+                            char *ref,
+                            int ref_len,
+                            struct cache_entry **entryp)
+{
+    struct cache_entry *entry;
+
+    if (blobref_hash (kt->ktm->hash_name, data, datalen, ref, ref_len) < 0) {
+        flux_log_error (kt->ktm->h, "%s: blobref_hash", __FUNCTION__);
+        return -1;
+    }
+    if (!(entry = cache_lookup (kt->ktm->cache, ref))) {
+        if (!(entry = cache_entry_create (ref))) {
+            flux_log_error (kt->ktm->h, "%s: cache_entry_create", __FUNCTION__);
+            return -1;
+        }
+        if (cache_insert (kt->ktm->cache, entry) < 0) {
+            cache_entry_destroy (entry);
+            flux_log_error (kt->ktm->h, "%s: cache_insert", __FUNCTION__);
+            return -1;
+        }
+    }
+    if (cache_entry_get_stored (entry)) {
+        kt->ktm->noop_stores++;
+        *entryp = entry;
+        return 0;
+    }
+    /* The blob may have been removed by content garbage collection,
+     * so store it again.
+     */
+    if (cache_entry_get_valid (entry)) {
+        if (cache_entry_set_dirty (entry, true) < 0) {
+            flux_log_error (kt->ktm->h, "%s: cache_entry_set_dirty",
+                            __FUNCTION__);
+            return -1;
+        }
+        *entryp = entry;
+        return 1;
+    }
+    if (cache_entry_set_raw (entry, data, datalen) < 0) {
+        __attribute__((unused)) int ret;
+        ret = cache_remove_entry (kt->ktm->cache, ref);
+        assert (ret == 1);
+        return -1;
+    }
+    if (cache_entry_set_dirty (entry, true) < 0) {
+        flux_log_error (kt->ktm->h, "%s: cache_entry_set_dirty",__FUNCTION__);
+        __attribute__((unused)) int ret;
+        ret = cache_remove_entry (kt->ktm->cache, ref);
+        assert (ret == 1);
+        return -1;
+    }
+    *entryp = entry;
+    return 1;
+}
+
+/* Remember that dir 'cpy' was copied from the object stored under 'ref',
+ * so that kvstxn_encode() can reuse the encoding of the original.
+ */
+static void kvstxn_set_dir_source (kvstxn_t *kt,
+                                   const json_t *cpy,
+                                   const char *ref)
+{
+    zhashx_update (kt->dir_sources, (void *)cpy, (void *)ref);
+}
+
+/* Encode treeobj 'o'.  If 'o' is a dir copied from one that is still
+ * in the cache, splice its changed entries into the original's
+ * encoding rather than encoding every entry again.
+ */
+static char *kvstxn_encode (kvstxn_t *kt, const json_t *o)
+{
+    const char *ref;
+    struct cache_entry *entry;
+    const json_t *prevobj;
+    const void *prev;
+    int prevlen;
+    char *data;
+
+    if (treeobj_is_dir (o)
+        && (ref = zhashx_lookup (kt->dir_sources, (void *)o))
+        && (entry = cache_lookup (kt->ktm->cache, ref))
+        && cache_entry_get_valid (entry)
+        && cache_entry_get_raw (entry, &prev, &prevlen) == 0
+        && (prevobj = cache_entry_get_treeobj (entry))
+        && (data = treeobj_encode_update (prev, prevlen, prevobj, o))) {
+        kt->ktm->dir_splices++;
+        return data;
+    }
+    return treeobj_encode (o);
+}
+
 /* Store object 'o' under key 'ref' in local cache.
  * Object reference is still owned by the caller.
  * 'is_raw' indicates this data is a json string w/ base64 value and
@@ -310,7 +532,6 @@ static int store_cache (kvstxn_t *kt, json_t *o,
                         bool is_raw, char *ref, int ref_len,
                         struct cache_entry **entryp)
 {
-    struct cache_entry *entry;
     int saved_errno, rc;
     const char *xdata;
     char *data = NULL;
@@ -333,48 +554,20 @@ static int store_cache (kvstxn_t *kt, json_t *o,
         }
     }
     else {
-        if (treeobj_validate (o) < 0 || !(data = treeobj_encode (o))) {
+        if (treeobj_validate (o) < 0 || !(data = kvstxn_encode (kt, o))) {
             flux_log_error (kt->ktm->h, "%s: treeobj_encode", __FUNCTION__);
             goto error;
         }
         datalen = strlen (data);
     }
-    if (blobref_hash (kt->ktm->hash_name, data, datalen, ref, ref_len) < 0) {
-        flux_log_error (kt->ktm->h, "%s: blobref_hash", __FUNCTION__);
+    if ((rc = store_cache_raw (kt, data, datalen, ref, ref_len, entryp)) < 0)
         goto error;
-    }
-    if (!(entry = cache_lookup (kt->ktm->cache, ref))) {
-        if (!(entry = cache_entry_create (ref))) {
-            flux_log_error (kt->ktm->h, "%s: cache_entry_create", __FUNCTION__);
-            goto error;
-        }
-        if (cache_insert (kt->ktm->cache, entry) < 0) {
-            cache_entry_destroy (entry);
-            flux_log_error (kt->ktm->h, "%s: cache_insert", __FUNCTION__);
-            goto error;
-        }
-    }
-    if (cache_entry_get_valid (entry)) {
-        kt->ktm->noop_stores++;
-        rc = 0;
-    }
-    else {
-        if (cache_entry_set_raw (entry, data, datalen) < 0) {
-            __attribute__((unused)) int ret;
-            ret = cache_remove_entry (kt->ktm->cache, ref);
-            assert (ret == 1);
-            goto error;
-        }
-        if (cache_entry_set_dirty (entry, true) < 0) {
-            flux_log_error (kt->ktm->h, "%s: cache_entry_set_dirty",__FUNCTION__);
-            __attribute__((unused)) int ret;
-            ret = cache_remove_entry (kt->ktm->cache, ref);
-            assert (ret == 1);
-            goto error;
-        }
-        rc = 1;
-    }
-    *entryp = entry;
+    /* Hand the new entry the object it was encoded from, so a later
+     * transaction need not decode it (the object is not modified once
+     * stored).
+     */
+    if (rc == 1 && !is_raw)
+        (void)cache_entry_attach_treeobj (*entryp, o);
     free (data);
     return rc;
 
@@ -385,11 +578,53 @@ static int store_cache (kvstxn_t *kt, json_t *o,
     return -1;
 }
 
+static int kvstxn_unroll (kvstxn_t *kt, json_t *dir, int level);
+
+/* Unroll and store dir or hdir 'obj', placing its blobref in 'ref'.
+ * A dir holding more than dir_shard_threshold entries is first split
+ * into an hdir at 'level'.
+ * Return 0 on success, -1 on error
+ */
+static int kvstxn_unroll_store (kvstxn_t *kt,
+                                json_t *obj,
+                                int level,
+                                char *ref,
+                                int ref_len)
+{
+    json_t *hdir = NULL;
+    struct cache_entry *entry;
+    int ret;
+    int rc = -1;
+
+    if (kt->ktm->dir_shard_threshold > 0
+        && level < TREEOBJ_HDIR_MAXLEVEL
+        && treeobj_is_dir (obj)
+        && treeobj_get_count (obj) > kt->ktm->dir_shard_threshold) {
+        if (!(hdir = treeobj_hdir_split (obj, level)))
+            return -1;
+        obj = hdir;
+    }
+    if (kvstxn_unroll (kt, obj, level) < 0) /* depth first */
+        goto done;
+    if ((ret = store_cache (kt, obj, false, ref, ref_len, &entry)) < 0)
+        goto done;
+    if (ret) {
+        if (kvstxn_add_dirty_cache_entry (kt, entry) < 0)
+            goto done;
+    }
+    rc = 0;
+done:
+    ERRNO_SAFE_WRAP (json_decref, hdir);
+    return rc;
+}
+
 /* Store DIRVAL objects, converting them to DIRREFs.
  * Store (large) FILEVAL objects, converting them to FILEREFs.
+ * 'dir' may be a dir or an hdir at 'level'.  The shards of an hdir
+ * are one level down, while subdirectories start over at level 0.
  * Return 0 on success, -1 on error
  */
-static int kvstxn_unroll (kvstxn_t *kt, json_t *dir)
+static int kvstxn_unroll (kvstxn_t *kt, json_t *dir, int level)
 {
     json_t *dir_entry;
     json_t *dir_data;
@@ -397,13 +632,16 @@ static int kvstxn_unroll (kvstxn_t *kt, json_t *dir)
     char ref[BLOBREF_MAX_STRING_SIZE];
     int ret;
     struct cache_entry *entry;
+    int entry_level;
     void *iter;
 
-    assert (treeobj_is_dir (dir));
+    assert (treeobj_is_dir (dir) || treeobj_is_hdir (dir));
 
     if (!(dir_data = treeobj_get_data (dir)))
         return -1;
 
+    entry_level = treeobj_is_hdir (dir) ? level + 1 : 0;
+
     iter = json_object_iter (dir_data);
 
     /* Do not use json_object_foreach(), unsafe to modify via
@@ -411,20 +649,13 @@ static int kvstxn_unroll (kvstxn_t *kt, json_t *dir)
      */
     while (iter) {
         dir_entry = json_object_iter_value (iter);
-        if (treeobj_is_dir (dir_entry)) {
-            if (kvstxn_unroll (kt, dir_entry) < 0) /* depth first */
-                return -1;
-            if ((ret = store_cache (kt,
-                                    dir_entry,
-                                    false,
-                                    ref,
-                                    sizeof (ref),
-                                    &entry)) < 0)
+        if (treeobj_is_dir (dir_entry) || treeobj_is_hdir (dir_entry)) {
+            if (kvstxn_unroll_store (kt,
+                                     dir_entry,
+                                     entry_level,
+                                     ref,
+                                     sizeof (ref)) < 0)
                 return -1;
-            if (ret) {
-                if (kvstxn_add_dirty_cache_entry (kt, entry) < 0)
-                    return -1;
-            }
             if (!(ktmp = treeobj_create_dirref (ref)))
                 return -1;
             if (json_object_iter_set_new (dir, iter, ktmp) < 0) {
@@ -493,6 +724,95 @@ static int kvstxn_val_data_to_cache (kvstxn_t *kt,
     return 0;
 }
 
+/* If valref 'entry' holds at least valref_compact blobs, merge the
+ * trailing run of blobs into one, so that readers need fewer content
+ * loads to reconstruct the value.  The run stops at a blob that would
+ * make the merged blob larger than VALREF_COMPACT_BLOB_SIZE, and is at
+ * most valref_compact blobs long.  If any blob in the run is not in
+ * the cache, compaction is skipped and the blob's reference is added to
+ * compact_refs_list, so the caller may load it in the background and a
+ * later append can compact the run.  On success, the compacted valref
+ * is returned in 'cpy', or NULL if no compaction was done.
+ */
+static int kvstxn_compact_valref (kvstxn_t *kt, json_t *entry, json_t **cpy)
+{
+    kvstxn_mgr_t *ktm = kt->ktm;
+    int count = treeobj_get_count (entry);
+    struct cache_entry *hp;
+    char ref[BLOBREF_MAX_STRING_SIZE];
+    const void *data;
+    int len;
+    size_t total = 0;
+    bool missing = false;
+    char *buf = NULL;
+    json_t *valref = NULL;
+    int start;
+    int i;
+
+    *cpy = NULL;
+    if (ktm->valref_compact == 0 || count < ktm->valref_compact)
+        return 0;
+    for (start = count; start > 0 && count - start < ktm->valref_compact;
+         start--) {
+        const char *blobref = treeobj_get_blobref (entry, start - 1);
+
+        if (!blobref)
+            return -1;
+        if (!(hp = cache_lookup (ktm->cache, blobref))
+            || !cache_entry_get_valid (hp)) {
+            if (zlist_push (kt->compact_refs_list, (void *)blobref) < 0) {
+                errno = ENOMEM;
+                return -1;
+            }
+            missing = true;
+            continue;
+        }
+        if (cache_entry_get_raw (hp, &data, &len) < 0)
+            return -1;
+        if (total + len > VALREF_COMPACT_BLOB_SIZE)
+            break;
+        total += len;
+    }
+    if (missing || count - start < 2)
+        return 0;
+
+    if (!(buf = malloc (total > 0 ? total : 1))) {
+        errno = ENOMEM;
+        return -1;
+    }
+    total = 0;
+    for (i = start; i < count; i++) {
+        hp = cache_lookup (ktm->cache, treeobj_get_blobref (entry, i));
+        if (cache_entry_get_raw (hp, &data, &len) < 0)
+            goto error;
+        if (len > 0)
+            memcpy (buf + total, data, len);
+        total += len;
+    }
+    if ((len = store_cache_raw (kt, buf, total, ref, sizeof (ref), &hp)) < 0)
+        goto error;
+    if (len == 1 && kvstxn_add_dirty_cache_entry (kt, hp) < 0)
+        goto error;
+    if (!(valref = treeobj_create_valref (NULL)))
+        goto error;
+    for (i = 0; i < start; i++) {
+        if (treeobj_append_blobref (valref,
+                                    treeobj_get_blobref (entry, i)) < 0)
+            goto error;
+    }
+    if (treeobj_append_blobref (valref, ref) < 0)
+        goto error;
+    ktm->compactions++;
+    ktm->compacted_blobs += count - start - 1;
+    free (buf);
+    *cpy = valref;
+    return 0;
+error:
+    ERRNO_SAFE_WRAP (free, buf);
+    ERRNO_SAFE_WRAP (json_decref, valref);
+    return -1;
+}
+
 static int kvstxn_append (kvstxn_t *kt,
                           json_t *dirent,
                           json_t *dir,
@@ -535,7 +855,9 @@ static int kvstxn_append (kvstxn_t *kt,
         if (kvstxn_val_data_to_cache (kt, dirent, ref, sizeof (ref)) < 0)
             return -1;
 
-        if (!(cpy = treeobj_deep_copy (entry)))
+        if (kvstxn_compact_valref (kt, entry, &cpy) < 0)
+            return -1;
+        if (!cpy && !(cpy = treeobj_deep_copy (entry)))
             return -1;
 
         if (treeobj_append_blobref (cpy, ref) < 0) {
@@ -615,6 +937,108 @@ static int kvstxn_append (kvstxn_t *kt,
     return 0;
 }
 
+/* Copy the dir or hdir referenced by 'dirref' out of the cache, so that
+ * it can be modified by this transaction.  A shallow copy is sufficient,
+ * since entries are only ever replaced in the copy, never modified.
+ * Unmodified entries remain shared with the cached object.
+ * If the object is not in the cache, set 'missing_ref' and return 0
+ * with 'cpyp' set to NULL.
+ * Return 0 on success, -1 on error with errno set.
+ */
+static int kvstxn_copy_dirref (kvstxn_t *kt,
+                               const json_t *dirref,
+                               json_t **cpyp,
+                               const char **missing_ref)
+{
+    struct cache_entry *entry;
+    const char *ref;
+    const json_t *obj;
+    int refcount;
+
+    if ((refcount = treeobj_get_count (dirref)) < 0)
+        return -1;
+    if (refcount != 1) {
+        flux_log (kt->ktm->h, LOG_ERR, "invalid dirref count: %d", refcount);
+        errno = ENOTRECOVERABLE;
+        return -1;
+    }
+    if (!(ref = treeobj_get_blobref (dirref, 0)))
+        return -1;
+    if (!(entry = cache_lookup (kt->ktm->cache, ref))
+        || !cache_entry_get_valid (entry)) {
+        *missing_ref = ref;
+        *cpyp = NULL;
+        return 0;
+    }
+    if (!(obj = cache_entry_get_treeobj (entry))
+        || (!treeobj_is_dir (obj) && !treeobj_is_hdir (obj))) {
+        errno = ENOTRECOVERABLE;
+        return -1;
+    }
+    if (!(*cpyp = treeobj_copy ((json_t *)obj)))
+        return -1;
+    kvstxn_set_dir_source (kt, *cpyp, ref);
+    return 0;
+}
+
+/* If '*dirp' is an hdir, descend to the shard that holds 'name',
+ * copying shards into the transaction on the way, and set '*dirp' to
+ * the dir shard.  If the shard does not exist, create it if 'create' is
+ * true, otherwise set '*dirp' to NULL.  If a shard is not in the cache,
+ * set 'missing_ref' and '*dirp' to NULL.
+ * Return 0 on success, -1 on error with errno set.
+ */
+static int kvstxn_hdir_resolve (kvstxn_t *kt,
+                                json_t **dirp,
+                                const char *name,
+                                bool create,
+                                const char **missing_ref)
+{
+    json_t *dir = *dirp;
+    int level = 0;
+
+    while (treeobj_is_hdir (dir)) {
+        json_t *shard;
+        int index;
+
+        if ((index = treeobj_hdir_index (name, level)) < 0) {
+            errno = ENOTRECOVERABLE;
+            return -1;
+        }
+        if (!(shard = treeobj_get_shard (dir, index))) {
+            if (!create) {
+                *dirp = NULL;
+                return 0;
+            }
+            if (!(shard = treeobj_create_dir ()))
+                return -1;
+        }
+        else if (treeobj_is_dirref (shard)) {
+            if (kvstxn_copy_dirref (kt, shard, &shard, missing_ref) < 0)
+                return -1;
+            if (!shard) {
+                *dirp = NULL;
+                return 0; /* stall */
+            }
+        }
+        else {
+            /* shard was already copied in this transaction */
+            dir = shard;
+            level++;
+            continue;
+        }
+        if (treeobj_insert_shard (dir, index, shard) < 0) {
+            ERRNO_SAFE_WRAP (json_decref, shard);
+            return -1;
+        }
+        json_decref (shard);
+        dir = shard;
+        level++;
+    }
+    *dirp = dir;
+    return 0;
+}
+
 /* link (key, dirent) into directory 'dir'.
  */
 static int kvstxn_link_dirent (kvstxn_t *kt,
@@ -652,6 +1076,17 @@ static int kvstxn_link_dirent (kvstxn_t *kt,
     while ((next = strchr (name, '.'))) {
         *next++ = '\0';
 
+        if (kvstxn_hdir_resolve (kt,
+                                 &dir,
+                                 name,
+                                 !json_is_null (dirent),
+                                 missing_ref) < 0) {
+            saved_errno = errno;
+            goto done;
+        }
+        if (!dir)
+            goto success; /* stall, or deleting a key that doesn't exist */
+
         if (!treeobj_is_dir (dir)) {
             saved_errno = ENOTRECOVERABLE;
             goto done;
@@ -672,50 +1107,20 @@ static int kvstxn_link_dirent (kvstxn_t *kt,
             }
             json_decref (subdir);
         }
-        else if (treeobj_is_dir (dir_entry)) {
+        else if (treeobj_is_dir (dir_entry) || treeobj_is_hdir (dir_entry)) {
+            /* Directories in the cache are always unrolled, so an inline
+             * dir here was created or copied earlier in this transaction
+             * and may be modified in place.
+             */
             subdir = dir_entry;
         }
         else if (treeobj_is_dirref (dir_entry)) {
-            struct cache_entry *entry;
-            const char *ref;
-            const json_t *subdirktmp;
-            int refcount;
-
-            if ((refcount = treeobj_get_count (dir_entry)) < 0) {
+            if (kvstxn_copy_dirref (kt, dir_entry, &subdir, missing_ref) < 0) {
                 saved_errno = errno;
                 goto done;
             }
-
-            if (refcount != 1) {
-                flux_log (kt->ktm->h,
-                          LOG_ERR,
-                          "invalid dirref count: %d",
-                          refcount);
-                saved_errno = ENOTRECOVERABLE;
-                goto done;
-            }
-
-            if (!(ref = treeobj_get_blobref (dir_entry, 0))) {
-                saved_errno = errno;
-                goto done;
-            }
-
-            if (!(entry = cache_lookup (kt->ktm->cache, ref))
-                || !cache_entry_get_valid (entry)) {
-                *missing_ref = ref;
+            if (!subdir)
                 goto success; /* stall */
-            }
-
-            if (!(subdirktmp = cache_entry_get_treeobj (entry))) {
-                saved_errno = ENOTRECOVERABLE;
-                goto done;
-            }
-
-            /* do not corrupt store by modifying orig. */
-            if (!(subdir = treeobj_deep_copy (subdirktmp))) {
-                saved_errno = errno;
-                goto done;
-            }
 
             /* copy from entry already in cache, assume novalidate ok */
             if (treeobj_insert_entry_novalidate (dir, name, subdir) < 0) {
@@ -781,6 +1186,20 @@ static int kvstxn_link_dirent (kvstxn_t *kt,
     /* This is the final path component of the key.  Add/modify/delete
      * it in the directory.
      */
+    if (kvstxn_hdir_resolve (kt,
+                             &dir,
+                             name,
+                             !json_is_null (dirent),
+                             missing_ref) < 0) {
+        saved_errno = errno;
+        goto done;
+    }
+    if (!dir)
+        goto success; /* stall, or deleting a key that doesn't exist */
+    if (treeobj_is_hdir (dirent)) {
+        saved_errno = EINVAL; /* hdir objects are internal to the KVS */
+        goto done;
+    }
     if (!json_is_null (dirent)) {
         if (flags & FLUX_KVS_APPEND) {
             if (kvstxn_append (kt, dirent, dir, name, append) < 0) {
@@ -871,18 +1290,10 @@ error:
     return NULL;
 }
 
-kvstxn_process_t kvstxn_process (kvstxn_t *kt,
-                                 const char *root_ref,
-                                 int root_seq)
+static kvstxn_process_t kvstxn_process_states (kvstxn_t *kt,
+                                               const char *root_ref,
+                                               int root_seq)
 {
-    /* Incase user calls kvstxn_process() again */
-    if (kt->errnum)
-        return KVSTXN_PROCESS_ERROR;
-
-    if (!kt->processing) {
-        kt->errnum = EINVAL;
-        return KVSTXN_PROCESS_ERROR;
-    }
 
     /* Only exit the loop by returning from the function */
     while (1) {
@@ -893,6 +1304,7 @@ kvstxn_process_t kvstxn_process (kvstxn_t *kt,
                 kt->errnum = EINVAL;
                 return KVSTXN_PROCESS_ERROR;
             }
+            strcpy (kt->base, root_ref);
             kt->state = KVSTXN_STATE_LOAD_ROOT;
         }
         else if (kt->state == KVSTXN_STATE_LOAD_ROOT) {
@@ -935,10 +1347,15 @@ kvstxn_process_t kvstxn_process (kvstxn_t *kt,
                 cache_entry_incref (entry);
                 kt->entry = entry;
 
-                if (!(kt->rootcpy = treeobj_deep_copy (kt->rootdir))) {
+                /* Only the directories along modified paths are
+                 * copied (see kvstxn_link_dirent()), the rest of the
+                 * tree is shared with the cache.
+                 */
+                if (!(kt->rootcpy = treeobj_copy ((json_t *)kt->rootdir))) {
                     kt->errnum = errno;
                     return KVSTXN_PROCESS_ERROR;
                 }
+                kvstxn_set_dir_source (kt, kt->rootcpy, kt->base);
 
                 kt->state = KVSTXN_STATE_APPLY_OPS;
             }
@@ -1011,11 +1428,15 @@ kvstxn_process_t kvstxn_process (kvstxn_t *kt,
                  * duplicate appends on a key.  We'll start over with a
                  * fresh rootcpy on the replay. */
                 if (append) {
+                    zlist_purge (kt->compact_refs_list);
+                    zhashx_purge (kt->dir_sources);
                     json_decref (kt->rootcpy);
-                    if (!(kt->rootcpy = treeobj_deep_copy (kt->rootdir))) {
+                    kt->rootcpy = treeobj_copy ((json_t *)kt->rootdir);
+                    if (!kt->rootcpy) {
                         kt->errnum = errno;
                         return KVSTXN_PROCESS_ERROR;
                     }
+                    kvstxn_set_dir_source (kt, kt->rootcpy, kt->base);
                 }
                 kt->blocked = 1;
                 return KVSTXN_PROCESS_LOAD_MISSING_REFS;
@@ -1034,7 +1455,7 @@ kvstxn_process_t kvstxn_process (kvstxn_t *kt,
             struct cache_entry *entry;
             int sret;
 
-            if (kvstxn_unroll (kt, kt->rootcpy) < 0)
+            if (kvstxn_unroll (kt, kt->rootcpy, 0) < 0)
                 kt->errnum = errno;
             else if ((sret = store_cache (kt,
                                           kt->rootcpy,
@@ -1059,6 +1480,7 @@ kvstxn_process_t kvstxn_process (kvstxn_t *kt,
             kt->state = KVSTXN_STATE_GENERATE_KEYS;
             json_decref (kt->rootcpy);
             kt->rootcpy = NULL;
+            zhashx_purge (kt->dir_sources);
 
             /* the cache entry for the new root has the chance to expire
              * in between the processing of dirty cache entries and the
@@ -1177,6 +1599,99 @@ kvstxn_process_t kvstxn_process (kvstxn_t *kt,
     return KVSTXN_PROCESS_ERROR;
 }
 
+/* Charge the time since kvstxn_process() last returned a stall to
+ * the phase that stalled.
+ */
+static void kvstxn_stall_end (kvstxn_t *kt)
+{
+    double t = monotime_since (kt->t_stall);
+
+    switch (kt->stall) {
+        case KVSTXN_PROCESS_LOAD_MISSING_REFS:
+            kt->timing.load += t;
+            break;
+        case KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES:
+            kt->timing.store += t;
+            break;
+        case KVSTXN_PROCESS_SYNC_CONTENT_FLUSH:
+        case KVSTXN_PROCESS_SYNC_CHECKPOINT:
+            kt->timing.sync += t;
+            break;
+        default:
+            kt->timing.pipeline += t;
+            break;
+    }
+    kt->stall = 0;
+}
+
+static kvstxn_process_t kvstxn_process_pipeline (kvstxn_t *kt,
+                                                 const char *root_ref,
+                                                 int root_seq);
+
+kvstxn_process_t kvstxn_process (kvstxn_t *kt,
+                                 const char *root_ref,
+                                 int root_seq)
+{
+    kvstxn_process_t ret;
+
+    if (!kt->processing) {
+        kt->errnum = EINVAL;
+        return KVSTXN_PROCESS_ERROR;
+    }
+    if (kt->stall)
+        kvstxn_stall_end (kt);
+    ret = kvstxn_process_pipeline (kt, root_ref, root_seq);
+    if (ret != KVSTXN_PROCESS_ERROR && ret != KVSTXN_PROCESS_FINISHED) {
+        kt->stall = ret;
+        kt->timing.stalls++;
+        monotime (&kt->t_stall);
+    }
+    return ret;
+}
+
+static kvstxn_process_t kvstxn_process_pipeline (kvstxn_t *kt,
+                                                 const char *root_ref,
+                                                 int root_seq)
+{
+    kvstxn_process_t ret;
+    kvstxn_t *prev;
+
+    /* A transaction staged behind others is applied to the new root
+     * of the transaction ahead of it.  If the root changed since this
+     * transaction was started, e.g. because the transaction ahead
+     * failed, start over.
+     */
+    if ((prev = kvstxn_predecessor (kt))) {
+        if (!(root_ref = kvstxn_pipeline_root (prev))) {
+            if (kt->state != KVSTXN_STATE_INIT)
+                kvstxn_reset (kt);
+            return KVSTXN_PROCESS_PIPELINE_WAIT;
+        }
+    }
+    if (kt->state != KVSTXN_STATE_INIT && !streq (kt->base, root_ref))
+        kvstxn_reset (kt);
+
+    if (kt->aux_errnum && !kt->errnum)
+        kt->errnum = kt->aux_errnum;
+
+    /* Incase user calls kvstxn_process() again */
+    if (kt->errnum)
+        ret = KVSTXN_PROCESS_ERROR;
+    else
+        ret = kvstxn_process_states (kt, root_ref, root_seq);
+
+    /* Transactions complete in order.  Hold the result until the
+     * transactions ahead have been removed.
+     */
+    if (prev && (ret == KVSTXN_PROCESS_ERROR
+                 || ret == KVSTXN_PROCESS_FINISHED)) {
+        kt->blocked = 0;
+        kt->parked = 1;
+        return KVSTXN_PROCESS_PIPELINE_WAIT;
+    }
+    return ret;
+}
+
 int kvstxn_iter_missing_refs (kvstxn_t *kt, kvstxn_ref_f cb, void *data)
 {
     char *ref;
@@ -1200,6 +1715,23 @@ int kvstxn_iter_missing_refs (kvstxn_t *kt, kvstxn_ref_f cb, void *data)
     return 0;
 }
 
+int kvstxn_iter_compact_refs (kvstxn_t *kt, kvstxn_ref_f cb, void *data)
+{
+    char *ref;
+
+    while ((ref = zlist_pop (kt->compact_refs_list))) {
+        if (cb (kt, ref, data) < 0) {
+            int saved_errno = errno;
+            free (ref);
+            zlist_purge (kt->compact_refs_list);
+            errno = saved_errno;
+            return -1;
+        }
+        free (ref);
+    }
+    return 0;
+}
+
 int kvstxn_iter_dirty_cache_entries (kvstxn_t *kt,
                                      kvstxn_cache_entry_f cb,
                                      void *data)
@@ -1268,6 +1800,7 @@ kvstxn_mgr_t *kvstxn_mgr_create (struct cache *cache,
         saved_errno = ENOMEM;
         goto error;
     }
+    ktm->pipeline_depth = 1;
     ktm->h = h;
     ktm->aux = aux;
     return ktm;
@@ -1320,19 +1853,63 @@ int kvstxn_mgr_add_transaction (kvstxn_mgr_t *ktm,
     return 0;
 }
 
-bool kvstxn_mgr_transaction_ready (kvstxn_mgr_t *ktm)
+/* Return the next transaction that may be processed, or NULL.  The
+ * first transaction in the ready queue may be processed unless it is
+ * blocked.  With a pipeline depth > 1, the transaction after those
+ * being processed may be started once the new root of the transaction
+ * ahead of it is known.  FLUX_KVS_SYNC transactions are only started
+ * when first, since their checkpoint sequence number depends on the
+ * current root.
+ */
+static kvstxn_t *kvstxn_mgr_next_ready (kvstxn_mgr_t *ktm)
 {
     kvstxn_t *kt;
+    kvstxn_t *prev = NULL;
+    int count = 0;
+
+    kt = zlist_first (ktm->ready);
+    while (kt) {
+        if (!kt->merge_component) {
+            if (!kt->blocked && !kt->parked) {
+                if (!prev)
+                    return kt;
+                if (count < ktm->pipeline_depth
+                    && !(kt->flags & FLUX_KVS_SYNC)
+                    && kvstxn_pipeline_root (prev))
+                    return kt;
+                return NULL;
+            }
+            prev = kt;
+            count++;
+        }
+        kt = zlist_next (ktm->ready);
+    }
+    return NULL;
+}
 
-    if ((kt = zlist_first (ktm->ready)) && !kt->blocked)
+/* Move the ready queue cursor to 'kt' and return it.
+ */
+static kvstxn_t *ready_seek (kvstxn_mgr_t *ktm, kvstxn_t *kt)
+{
+    kvstxn_t *tmp = zlist_first (ktm->ready);
+
+    while (tmp && tmp != kt)
+        tmp = zlist_next (ktm->ready);
+    return tmp;
+}
+
+bool kvstxn_mgr_transaction_ready (kvstxn_mgr_t *ktm)
+{
+    if (kvstxn_mgr_next_ready (ktm))
         return true;
     return false;
 }
 
 kvstxn_t *kvstxn_mgr_get_ready_transaction (kvstxn_mgr_t *ktm)
 {
-    if (kvstxn_mgr_transaction_ready (ktm)) {
-        kvstxn_t *kt = zlist_first (ktm->ready);
+    kvstxn_t *kt;
+
+    if ((kt = kvstxn_mgr_next_ready (ktm))) {
         kt->processing = true;
         return kt;
     }
@@ -1344,15 +1921,12 @@ void kvstxn_mgr_remove_transaction (kvstxn_mgr_t *ktm,
                                     bool fallback)
 {
     if (kt->processing) {
-        bool kvstxn_is_merged = false;
-
-        if (kt->merged)
-            kvstxn_is_merged = true;
-
-        zlist_remove (ktm->ready, kt);
+        kvstxn_t *kt_tmp;
 
-        if (kvstxn_is_merged) {
-            kvstxn_t *kt_tmp = zlist_first (ktm->ready);
+        /* components of a merged kvstxn immediately follow it */
+        if (kt->merged) {
+            ready_seek (ktm, kt);
+            kt_tmp = zlist_next (ktm->ready);
             while (kt_tmp && kt_tmp->merge_component) {
                 if (fallback) {
                     kt_tmp->merge_component = false;
@@ -1364,6 +1938,14 @@ void kvstxn_mgr_remove_transaction (kvstxn_mgr_t *ktm,
                 kt_tmp = zlist_next (ktm->ready);
             }
         }
+
+        zlist_remove (ktm->ready, kt);
+
+        /* a transaction that finished while waiting for the one
+         * ahead of it may now complete
+         */
+        if ((kt_tmp = zlist_first (ktm->ready)))
+            kt_tmp->parked = 0;
     }
 }
 
@@ -1377,19 +1959,63 @@ void kvstxn_mgr_clear_noop_stores (kvstxn_mgr_t *ktm)
     ktm->noop_stores = 0;
 }
 
+void kvstxn_mgr_set_dir_shard_threshold (kvstxn_mgr_t *ktm, int threshold)
+{
+    ktm->dir_shard_threshold = threshold > 0 ? threshold : 0;
+}
+
+void kvstxn_mgr_set_pipeline_depth (kvstxn_mgr_t *ktm, int depth)
+{
+    ktm->pipeline_depth = depth > 1 ? depth : 1;
+}
+
+void kvstxn_mgr_set_valref_compact (kvstxn_mgr_t *ktm, int threshold)
+{
+    ktm->valref_compact = threshold > 1 ? threshold : 0;
+}
+
+int kvstxn_mgr_get_compactions (kvstxn_mgr_t *ktm)
+{
+    return ktm->compactions;
+}
+
+int kvstxn_mgr_get_compacted_blobs (kvstxn_mgr_t *ktm)
+{
+    return ktm->compacted_blobs;
+}
+
+void kvstxn_mgr_clear_compaction_stats (kvstxn_mgr_t *ktm)
+{
+    ktm->compactions = 0;
+    ktm->compacted_blobs = 0;
+}
+
+int kvstxn_mgr_get_dir_splices (kvstxn_mgr_t *ktm)
+{
+    return ktm->dir_splices;
+}
+
+void kvstxn_mgr_clear_dir_splices (kvstxn_mgr_t *ktm)
+{
+    ktm->dir_splices = 0;
+}
+
 int kvstxn_mgr_ready_transaction_count (kvstxn_mgr_t *ktm)
 {
     return zlist_size (ktm->ready);
 }
 
-/* N.B. FLUX_KVS_SYNC implies FLUX_KVS_NO_MERGE, as we checkpoint
- * after the specific commit completes.  So FLUX_KVS_SYNC is
- * treated identically to FLUX_KVS_NO_MERGE in merge logic.
+/* N.B. FLUX_KVS_SYNC transactions are only merged with each other
+ * (see the flags checks below), so that queued FLUX_KVS_SYNC commits
+ * share one content flush and checkpoint, i.e. a group commit.  The
+ * checkpoint covers all of them, so none is answered before its data
+ * is durable.  Internal flags must match too, so that user commits
+ * are never merged into an unpublished internal checkpoint transaction
+ * and vice versa.
  */
 static bool kvstxn_no_merge (kvstxn_t *kt)
 {
-    if ((kt->flags & FLUX_KVS_NO_MERGE)
-        || (kt->flags & FLUX_KVS_SYNC))
+    if ((kt->flags & FLUX_KVS_NO_MERGE))
         return true;
     return false;
 }
@@ -1399,9 +2025,13 @@ static int kvstxn_merge (kvstxn_t *dest, kvstxn_t *src)
     int i, len;
 
     if (kvstxn_no_merge (src)
-        || dest->flags != src->flags)
+        || dest->flags != src->flags
+        || dest->internal_flags != src->internal_flags)
         return 0;
 
+    if (monotime_since (src->t_create) > monotime_since (dest->t_create))
+        dest->t_create = src->t_create;
+
     if ((len = json_array_size (src->names))) {
         for (i = 0; i < len; i++) {
             json_t *name;
@@ -1428,12 +2058,39 @@ static int kvstxn_merge (kvstxn_t *dest, kvstxn_t *src)
     return 1;
 }
 
+/* Insert 'kt' into the ready queue ahead of 'next'.  zlist_t cannot
+ * insert in the middle of a list, so pop the transactions ahead of
+ * 'next' and push them back afterwards.  There are at most
+ * pipeline_depth of them plus merge components.
+ */
+static int ready_insert (kvstxn_mgr_t *ktm, kvstxn_t *kt, kvstxn_t *next)
+{
+    zlist_t *ahead;
+    kvstxn_t *tmp;
+
+    if (!(ahead = zlist_new ())) {
+        errno = ENOMEM;
+        return -1;
+    }
+    while ((tmp = zlist_head (ktm->ready)) && tmp != next)
+        zlist_push (ahead, zlist_pop (ktm->ready));
+    zlist_push (ktm->ready, kt);
+    zlist_freefn (ktm->ready, kt, (zlist_free_fn *)kvstxn_destroy, false);
+    while ((tmp = zlist_pop (ahead))) {
+        zlist_push (ktm->ready, tmp);
+        zlist_freefn (ktm->ready, tmp, (zlist_free_fn *)kvstxn_destroy, false);
+    }
+    zlist_destroy (&ahead);
+    return 0;
+}
+
 /* Merge ready transactions that are mergeable, where merging consists
  * creating a new kvstxn_t, and merging the other transactions in the
  * ready queue and appending their ops/names to the new transaction.
- * After merging, push the new kvstxn_t onto the head of the ready
- * queue.  Merging can occur if the top transaction hasn't started, or
- * is still building the rootcpy, e.g. stalled walking the namespace.
+ * After merging, insert the new kvstxn_t in the ready queue ahead of
+ * the transactions it was made from.  Merging can occur if the next
+ * ready transaction hasn't started, or is still building the rootcpy,
+ * e.g. stalled walking the namespace.
  *
  * Break when an unmergeable transaction is discovered.  We do not
  * wish to merge non-adjacent transactions, as it can create
@@ -1455,7 +2112,7 @@ int kvstxn_mgr_merge_ready_transactions (kvstxn_mgr_t *ktm)
 
     /* transaction must still be in state where merged in ops can be
      * applied. */
-    first = zlist_first (ktm->ready);
+    first = kvstxn_mgr_next_ready (ktm);
     if (!first
         || first->errnum != 0
         || first->aux_errnum != 0
@@ -1464,6 +2121,7 @@ int kvstxn_mgr_merge_ready_transactions (kvstxn_mgr_t *ktm)
         || first->merged)
         return 0;
 
+    ready_seek (ktm, first);
     second = zlist_next (ktm->ready);
     if (!second
         || kvstxn_no_merge (second)
@@ -1479,7 +2137,7 @@ int kvstxn_mgr_merge_ready_transactions (kvstxn_mgr_t *ktm)
         return -1;
     new->merged = true;
 
-    nextkt = zlist_first (ktm->ready);
+    nextkt = ready_seek (ktm, first);
     do {
         int ret;
 
@@ -1497,17 +2155,15 @@ int kvstxn_mgr_merge_ready_transactions (kvstxn_mgr_t *ktm)
     /* if count is zero, checks at beginning of function are invalid */
     assert (count);
 
-    if (zlist_push (ktm->ready, new) < 0) {
+    if (ready_insert (ktm, new, first) < 0) {
         kvstxn_destroy (new);
         return -1;
     }
-    zlist_freefn (ktm->ready, new, (zlist_free_fn *)kvstxn_destroy, false);
 
-    /* first is the new merged kvstxn_t, so we want to start our loop with
-     * the second kvstxn_t
+    /* start the loop with the first of the merged transactions, which
+     * follows the new merged kvstxn_t
      */
-    nextkt = zlist_first (ktm->ready);
-    nextkt = zlist_next (ktm->ready);
+    nextkt = ready_seek (ktm, first);
     do {
         /* reset processing flag if user previously got the kvstxn_t
          */
@@ -25,6 +25,7 @@ typedef enum {
     KVSTXN_PROCESS_SYNC_CONTENT_FLUSH = 4,
     KVSTXN_PROCESS_SYNC_CHECKPOINT = 5,
     KVSTXN_PROCESS_FINISHED = 6,
+    KVSTXN_PROCESS_PIPELINE_WAIT = 7,
 } kvstxn_process_t;
 
 /* api flags, to be used with kvstxn_mgr_add_transaction()
@@ -86,6 +87,24 @@ const char *kvstxn_get_newroot_ref (kvstxn_t *kt);
  * (i.e. kvstxn_process() returns KVSTXN_PROCESS_FINISHED) */
 json_t *kvstxn_get_keys (kvstxn_t *kt);
 
+/* Time in milliseconds since the transaction was added, or for a
+ * merged transaction, since the oldest of its components was added.
+ * The remaining times are how long kvstxn_process() stalled the
+ * transaction, by reason: waiting for missing refs to load, dirty
+ * cache entries to be stored, FLUX_KVS_SYNC content flush and
+ * checkpoint, or transactions ahead of it in the pipeline.
+ */
+struct kvstxn_timing {
+    double age;
+    double load;
+    double store;
+    double sync;
+    double pipeline;
+    int stalls;
+};
+
+void kvstxn_get_timing (kvstxn_t *kt, struct kvstxn_timing *t);
+
 /* Primary transaction processing function.
  *
  * Pass in a kvstxn_t that was obtained via
@@ -98,8 +117,11 @@ json_t *kvstxn_get_keys (kvstxn_t *kt);
  * KVSTXN_PROCESS_SYNC_CONTENT_FLUSH stall & wait for future to fulfill
  * KVSTXN_PROCESS_SYNC_CHECKPOINT stall & wait for future to fulfill
  * KVSTXN_PROCESS_FINISHED all done
+ * KVSTXN_PROCESS_PIPELINE_WAIT stall until a transaction ahead of
+ * this one is removed
  *
- * on error, call kvstxn_get_errnum() to get error number
+ * on error, call kvstxn_get_errnum() to get error number.  An error
+ * set with kvstxn_set_aux_errnum() is also returned this way.
  *
  * on stall & load, call kvstxn_iter_missing_refs()
  *
@@ -112,6 +134,16 @@ json_t *kvstxn_get_keys (kvstxn_t *kt);
  *
  * on completion, call kvstxn_get_newroot_ref() to get reference to
  * new root to be stored.
+ *
+ * on pipeline wait, nothing needs to be done.  The transaction will
+ * be returned by kvstxn_mgr_get_ready_transaction() again when it
+ * can make progress.
+ *
+ * If there are transactions ahead of this one in the ready queue (see
+ * kvstxn_mgr_set_pipeline_depth()), root_ref is ignored and the
+ * transaction is applied to the new root of the transaction ahead of
+ * it.  If the root a transaction was applied to changes before it
+ * completes, it is started over.
  */
 kvstxn_process_t kvstxn_process (kvstxn_t *kt,
                                  const char *root_ref,
@@ -124,6 +156,15 @@ kvstxn_process_t kvstxn_process (kvstxn_t *kt,
  */
 int kvstxn_iter_missing_refs (kvstxn_t *kt, kvstxn_ref_f cb, void *data);
 
+/* iterate through refs of blobs that valref compaction skipped because
+ * they were not in the cache.  The caller may load them into the cache
+ * without waiting, so that a later append can compact them.  May be
+ * called in any state.
+ *
+ * return -1 in callback to break iteration
+ */
+int kvstxn_iter_compact_refs (kvstxn_t *kt, kvstxn_ref_f cb, void *data);
+
 /* on stall, iterate through all dirty cache entries that need to be
  * pushed to the content store.
  *
@@ -171,7 +212,8 @@ int kvstxn_mgr_add_transaction (kvstxn_mgr_t *ktm,
                                 int internal_flags);
 
 /* returns true if there is a transaction ready for processing and is
- * not blocked, false if not.
+ * not blocked, false if not.  With a pipeline depth > 1, this may be a
+ * transaction behind the ones already being processed.
  */
 bool kvstxn_mgr_transaction_ready (kvstxn_mgr_t *ktm);
 
@@ -203,6 +245,42 @@ void kvstxn_mgr_remove_transaction (kvstxn_mgr_t *ktm,
 int kvstxn_mgr_get_noop_stores (kvstxn_mgr_t *ktm);
 void kvstxn_mgr_clear_noop_stores (kvstxn_mgr_t *ktm);
 
+/* Directories modified by a transaction that hold more than 'threshold'
+ * entries are stored as hashed directories (hdir), so that later updates
+ * only rewrite the shard containing the modified entry.  The root
+ * directory is never sharded.  A threshold of 0 (the default) disables
+ * sharding.
+ */
+void kvstxn_mgr_set_dir_shard_threshold (kvstxn_mgr_t *ktm, int threshold);
+
+/* Allow up to 'depth' transactions to be processed at once.  A
+ * transaction may be started once the new root of the one ahead of
+ * it has been computed, while that one is still waiting on stores or
+ * loads.  Transactions still complete in order, so the root is
+ * updated in the same order as with a depth of 1 (the default).
+ * FLUX_KVS_SYNC transactions are only started when first in the
+ * queue.
+ */
+void kvstxn_mgr_set_pipeline_depth (kvstxn_mgr_t *ktm, int depth);
+
+/* When an append is made to a valref holding at least 'threshold'
+ * blobs, merge its trailing run of small blobs into one, so readers
+ * need fewer content loads.  The value itself is unchanged, but the
+ * number of blobs in the valref shrinks.  A threshold of 0 (the
+ * default) disables compaction.
+ */
+void kvstxn_mgr_set_valref_compact (kvstxn_mgr_t *ktm, int threshold);
+int kvstxn_mgr_get_compactions (kvstxn_mgr_t *ktm);
+int kvstxn_mgr_get_compacted_blobs (kvstxn_mgr_t *ktm);
+void kvstxn_mgr_clear_compaction_stats (kvstxn_mgr_t *ktm);
+
+/* Count of directories encoded by splicing their changed entries into
+ * the encoding of the directory they were copied from, instead of
+ * encoding every entry.
+ */
+int kvstxn_mgr_get_dir_splices (kvstxn_mgr_t *ktm);
+void kvstxn_mgr_clear_dir_splices (kvstxn_mgr_t *ktm);
+
 /* return count of ready transactions */
 int kvstxn_mgr_ready_transaction_count (kvstxn_mgr_t *ktm);
 
@@ -210,9 +288,10 @@ int kvstxn_mgr_ready_transaction_count (kvstxn_mgr_t *ktm);
  * kvstxn_mgr_add_transaction()), merge them into a new ready transaction
  * if they are capable of being merged.
  *
- * Callers should be cautioned to re-call
- * kvstxn_mgr_get_ready_transaction() for the new head commit as the
- * prior one has been removed.
+ * Merging starts at the transaction kvstxn_mgr_get_ready_transaction()
+ * would return, which need not be first in the queue.  Callers should
+ * be cautioned to re-call kvstxn_mgr_get_ready_transaction() for the
+ * new merged commit as the prior one has been removed.
  *
  * A merged kvstxn can be backed out if an error occurs.  See
  * kvstxn_fallback_mergeable() and kvstxn_mgr_remove_transaction()
@@ -25,6 +25,7 @@
 
 #include "src/common/libczmqcontainers/czmq_containers.h"
 #include "src/common/libutil/blobref.h"
+#include "src/common/libutil/monotime.h"
 #include "src/common/libkvs/treeobj.h"
 #include "src/common/libkvs/kvs_util_private.h"
 #include "ccan/str/str.h"
@@ -81,6 +82,7 @@ struct lookup {
      */
     const json_t *valref_missing_refs;
     const char *missing_ref;
+    json_t *missing_refs;       /* array of hdir shard refs */
 
     /* for namespace callback */
 
@@ -89,6 +91,8 @@ struct lookup {
     int errnum;                 /* errnum if error */
     int aux_errnum;
 
+    struct timespec t_create;   /* for lookup_get_elapsed() */
+
     /* API internal */
     zlist_t *levels;
     const json_t *wdirent;       /* result after walk() */
@@ -351,6 +355,57 @@ cleanup:
     return ret;
 }
 
+/* If 'dir' is an hdir, walk to the dir shard that holds 'name'.
+ * On success, '*dirp' and '*entryp' refer to the shard, or '*dirp' is
+ * NULL if the shard does not exist.
+ */
+static lookup_process_t walk_hdir (lookup_t *lh,
+                                   const json_t **dirp,
+                                   struct cache_entry **entryp,
+                                   const char *name)
+{
+    const json_t *dir = *dirp;
+    int level = 0;
+
+    while (treeobj_is_hdir (dir)) {
+        struct cache_entry *entry;
+        const json_t *shard;
+        const char *refstr;
+        int index;
+
+        if ((index = treeobj_hdir_index (name, level)) < 0) {
+            lh->errnum = ENOTRECOVERABLE;
+            return LOOKUP_PROCESS_ERROR;
+        }
+        if (!(shard = treeobj_peek_shard (dir, index))) {
+            *dirp = NULL;
+            return LOOKUP_PROCESS_FINISHED;
+        }
+        if (!treeobj_is_dirref (shard)
+            || treeobj_get_count (shard) != 1
+            || !(refstr = treeobj_get_blobref (shard, 0))) {
+            flux_log (lh->h, LOG_ERR, "invalid hdir shard");
+            lh->errnum = ENOTRECOVERABLE;
+            return LOOKUP_PROCESS_ERROR;
+        }
+        if (!(entry = cache_lookup (lh->cache, refstr))
+            || !cache_entry_get_valid (entry)) {
+            lh->missing_ref = refstr;
+            return LOOKUP_PROCESS_LOAD_MISSING_REFS;
+        }
+        if (!(dir = cache_entry_get_treeobj (entry))
+            || (!treeobj_is_dir (dir) && !treeobj_is_hdir (dir))) {
+            flux_log (lh->h, LOG_ERR, "hdir shard points to non-directory");
+            lh->errnum = ENOTRECOVERABLE;
+            return LOOKUP_PROCESS_ERROR;
+        }
+        *entryp = entry;
+        level++;
+    }
+    *dirp = dir;
+    return LOOKUP_PROCESS_FINISHED;
+}
+
 /* Get dirent of the requested path starting at the given root.
  *
  * Return true on success or error, error code is returned in ep and
@@ -411,6 +466,16 @@ static lookup_process_t walk (lookup_t *lh)
                     lh->errnum = ENOTRECOVERABLE;
                 goto error;
             }
+            if (treeobj_is_hdir (dir)
+                && !(wl->depth == 0 && wl->dirent == wl->root_dirent)) {
+                lookup_process_t hret;
+
+                hret = walk_hdir (lh, &dir, &entry, pathcomp);
+                if (hret != LOOKUP_PROCESS_FINISHED)
+                    return hret;
+                if (!dir)
+                    goto done; /* no such entry */
+            }
             if (!treeobj_is_dir (dir)) {
                 /* dirref pointed to non-dir error, special case when
                  * root_dirent is bad, is EINVAL from user.
@@ -588,6 +653,7 @@ lookup_t *lookup_create (struct cache *cache,
 
     lh->wdirent = NULL;
     lh->state = LOOKUP_STATE_INIT;
+    monotime (&lh->t_create);
 
     return lh;
 
@@ -604,6 +670,7 @@ void lookup_destroy (lookup_t *lh)
         free (lh->root_ref);
         free (lh->path);
         json_decref (lh->val);
+        json_decref (lh->missing_refs);
         free (lh->missing_namespace);
         zlist_destroy (&lh->levels);
         free (lh);
@@ -655,7 +722,16 @@ int lookup_iter_missing_refs (lookup_t *lh, lookup_ref_f cb, void *data)
         && (lh->state == LOOKUP_STATE_CHECK_ROOT
             || lh->state == LOOKUP_STATE_WALK
             || lh->state == LOOKUP_STATE_VALUE)) {
-        if (lh->valref_missing_refs) {
+        if (lh->missing_refs) {
+            size_t index;
+            json_t *o;
+
+            json_array_foreach (lh->missing_refs, index, o) {
+                if (cb (lh, json_string_value (o), data) < 0)
+                    return -1;
+            }
+        }
+        else if (lh->valref_missing_refs) {
             int refcount, i;
 
             if (!treeobj_is_valref (lh->valref_missing_refs)) {
@@ -711,6 +787,13 @@ const char *lookup_get_namespace (lookup_t *lh)
     return NULL;
 }
 
+double lookup_get_elapsed (lookup_t *lh)
+{
+    if (lh)
+        return monotime_since (lh->t_create);
+    return 0.;
+}
+
 const char *lookup_get_root_ref (lookup_t *lh)
 {
     if (lh && lh->state == LOOKUP_STATE_FINISHED)
@@ -897,6 +980,106 @@ done:
     return rc;
 }
 
+/* Gather the entries of 'hdir' into 'dir'.  Shards missing from the
+ * cache are added to lh->missing_refs so that they are loaded together.
+ * Return 0 on success, -1 on error.
+ */
+static int hdir_gather (lookup_t *lh, const json_t *hdir, json_t *dir)
+{
+    const json_t *data;
+    const char *key;
+    json_t *shard;
+
+    /* N.B. it should be safe to cast away const on 'hdir' as long as
+     * its data is not modified.
+     */
+    if (!(data = treeobj_get_data ((json_t *)hdir))) {
+        lh->errnum = errno;
+        return -1;
+    }
+    json_object_foreach ((json_t *)data, key, shard) {
+        struct cache_entry *entry;
+        const json_t *obj;
+        const char *refstr;
+
+        if (!treeobj_is_dirref (shard)
+            || treeobj_get_count (shard) != 1
+            || !(refstr = treeobj_get_blobref (shard, 0))) {
+            flux_log (lh->h, LOG_ERR, "invalid hdir shard");
+            lh->errnum = ENOTRECOVERABLE;
+            return -1;
+        }
+        if (!(entry = cache_lookup (lh->cache, refstr))
+            || !cache_entry_get_valid (entry)) {
+            json_t *o;
+            if (!(o = json_string (refstr))
+                || json_array_append_new (lh->missing_refs, o) < 0) {
+                json_decref (o);
+                lh->errnum = ENOMEM;
+                return -1;
+            }
+            continue;
+        }
+        if (!(obj = cache_entry_get_treeobj (entry))) {
+            lh->errnum = ENOTRECOVERABLE;
+            return -1;
+        }
+        if (treeobj_is_hdir (obj)) {
+            if (hdir_gather (lh, obj, dir) < 0)
+                return -1;
+        }
+        else if (treeobj_is_dir (obj)) {
+            const char *name;
+            json_t *o;
+
+            json_object_foreach (treeobj_get_data ((json_t *)obj), name, o) {
+                json_t *cpy;
+                if (!(cpy = treeobj_deep_copy (o))
+                    || treeobj_insert_entry_novalidate (dir, name, cpy) < 0) {
+                    lh->errnum = errno;
+                    json_decref (cpy);
+                    return -1;
+                }
+                json_decref (cpy);
+            }
+        }
+        else {
+            flux_log (lh->h, LOG_ERR, "hdir shard points to non-directory");
+            lh->errnum = ENOTRECOVERABLE;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* Assemble the dir object for a directory stored as an hdir.
+ * return 0 on success, -1 on failure.  On success, stall should be
+ * checked */
+static int get_hdir_value (lookup_t *lh, const json_t *hdir, bool *stall)
+{
+    json_t *dir;
+
+    if (!(lh->missing_refs = json_array ())
+        || !(dir = treeobj_create_dir ())) {
+        lh->errnum = ENOMEM;
+        return -1;
+    }
+    if (hdir_gather (lh, hdir, dir) < 0) {
+        json_decref (dir);
+        return -1;
+    }
+    if (json_array_size (lh->missing_refs) > 0) {
+        json_decref (dir);
+        (*stall) = true;
+        return 0;
+    }
+    json_decref (lh->missing_refs);
+    lh->missing_refs = NULL;
+    lh->val = dir;
+    (*stall) = false;
+    return 0;
+}
+
 lookup_process_t lookup (lookup_t *lh)
 {
     const json_t *valtmp = NULL;
@@ -1041,6 +1224,8 @@ lookup_process_t lookup (lookup_t *lh)
                 if (namespace_still_valid (lh) < 0)
                     goto error;
             }
+            json_decref (lh->missing_refs);
+            lh->missing_refs = NULL;
 
             if ((lh->flags & FLUX_KVS_TREEOBJ)) {
                 if (!(lh->val = treeobj_deep_copy (lh->wdirent))) {
@@ -1083,6 +1268,15 @@ lookup_process_t lookup (lookup_t *lh)
                     lh->errnum = ENOTRECOVERABLE;
                     goto error;
                 }
+                if (treeobj_is_hdir (valtmp)) {
+                    bool stall;
+
+                    if (get_hdir_value (lh, valtmp, &stall) < 0)
+                        goto error;
+                    if (stall)
+                        return LOOKUP_PROCESS_LOAD_MISSING_REFS;
+                    break;
+                }
                 if (!treeobj_is_dir (valtmp)) {
                     /* dirref points to not dir */
                     lh->errnum = ENOTRECOVERABLE;
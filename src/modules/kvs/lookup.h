@@ -92,6 +92,11 @@ int lookup_get_current_epoch (lookup_t *lh);
  */
 const char *lookup_get_namespace (lookup_t *lh);
 
+/* Get time in milliseconds since lookup_create(), including time
+ * stalled waiting for missing refs or namespaces.
+ */
+double lookup_get_elapsed (lookup_t *lh);
+
 /* Convenience functions to get root ref & seq used in lookup.
  * root_ref will be the root_ref passed in via lookup_create() or the
  * root_ref used from the namespace.  The root_seq is only if the
@@ -337,6 +337,34 @@ void cache_entry_raw_and_treeobj_tests (void)
     json_decref (o1);
     free (data);
     cache_entry_destroy (e);
+
+    /* test attaching the treeobj raw data was encoded from */
+
+    o1 = treeobj_create_val ("foo", 3);
+    data = treeobj_encode (o1);
+
+    ok ((e = cache_entry_create ("a-reference")) != NULL,
+        "cache_entry_create works");
+    errno = 0;
+    ok (cache_entry_attach_treeobj (e, o1) < 0 && errno == EINVAL,
+        "cache_entry_attach_treeobj fails with EINVAL on invalid entry");
+    ok (cache_entry_set_raw (e, data, strlen (data)) == 0,
+        "cache_entry_set_raw success");
+    errno = 0;
+    ok (cache_entry_attach_treeobj (e, NULL) < 0 && errno == EINVAL,
+        "cache_entry_attach_treeobj fails with EINVAL on NULL treeobj");
+    ok (cache_entry_attach_treeobj (e, o1) == 0,
+        "cache_entry_attach_treeobj success");
+    ok (cache_entry_get_treeobj (e) == o1,
+        "cache_entry_get_treeobj returns attached treeobj");
+    otest = treeobj_create_val ("foo", 3);
+    ok (cache_entry_attach_treeobj (e, otest) == 0
+        && cache_entry_get_treeobj (e) == o1,
+        "cache_entry_attach_treeobj does not replace existing treeobj");
+    json_decref (otest);
+    json_decref (o1);
+    free (data);
+    cache_entry_destroy (e);
 }
 
 void waiter_tests (void)
@@ -719,6 +747,179 @@ void cache_expiration_tests (void)
     cache_destroy (cache);
 }
 
+void cache_trim_tests (void)
+{
+    struct cache *cache;
+    struct cache_entry *e1, *e2, *e3, *e4;
+
+    ok ((cache = cache_create (NULL)) != NULL,
+        "cache_create works");
+
+    ok ((e1 = cache_entry_create ("xxx1")) != NULL
+        && cache_entry_set_raw (e1, "1234", 4) == 0
+        && cache_insert (cache, e1) == 0,
+        "inserted 4 byte entry xxx1");
+    ok ((e2 = cache_entry_create ("xxx2")) != NULL
+        && cache_insert (cache, e2) == 0
+        && cache_entry_set_raw (e2, "12345678", 8) == 0,
+        "inserted 8 byte entry xxx2, set after insert");
+    ok ((e3 = cache_entry_create ("xxx3")) != NULL
+        && cache_entry_set_raw (e3, "12", 2) == 0
+        && cache_insert (cache, e3) == 0,
+        "inserted 2 byte entry xxx3");
+    ok ((e4 = cache_entry_create ("xxx4")) != NULL
+        && cache_insert (cache, e4) == 0,
+        "inserted incomplete entry xxx4");
+    ok (cache_get_bytes (cache) == 14,
+        "cache_get_bytes returns 14");
+
+    ok (cache_over_limit (cache) == false,
+        "cache is not over limit with no limit set");
+    ok (cache_trim (cache) == 0,
+        "cache_trim removes nothing with no limit set");
+
+    cache_set_max_bytes (cache, 10);
+    ok (cache_over_limit (cache) == true,
+        "cache is over a 10 byte limit");
+
+    /* xxx1 is least recently used after lookup of xxx2, but is
+     * referenced, so xxx2 goes next.
+     */
+    ok (cache_lookup (cache, "xxx2") == e2,
+        "cache_lookup xxx2 works");
+    cache_entry_incref (e1);
+    ok (cache_entry_set_dirty (e3, true) == 0,
+        "cache_entry_set_dirty xxx3 works");
+    ok (cache_trim (cache) == 1,
+        "cache_trim removed 1 entry");
+    ok (cache_lookup (cache, "xxx2") == NULL,
+        "xxx2 was removed");
+    ok (cache_get_bytes (cache) == 6
+        && cache_count_entries (cache) == 3,
+        "cache holds 6 bytes in 3 entries");
+    ok (cache_over_limit (cache) == false,
+        "cache is within its limit");
+
+    cache_set_max_bytes (cache, 1);
+    ok (cache_trim (cache) == 0,
+        "cache_trim does not remove referenced, dirty, or incomplete entries");
+    cache_entry_decref (e1);
+    ok (cache_trim (cache) == 1
+        && cache_lookup (cache, "xxx1") == NULL,
+        "cache_trim removed xxx1 once unreferenced");
+    ok (cache_get_bytes (cache) == 2,
+        "cache_get_bytes returns 2");
+    ok (cache_remove_entry (cache, "xxx4") == 1
+        && cache_get_bytes (cache) == 2,
+        "cache_remove_entry of incomplete entry leaves bytes unchanged");
+
+    cache_destroy (cache);
+}
+
+void cache_trim_treeobj_tests (void)
+{
+    struct cache *cache;
+    struct cache_entry *e;
+    json_t *o, *val = NULL;
+    char *data;
+    int len;
+    size_t bytes;
+
+    ok ((cache = cache_create (NULL)) != NULL,
+        "cache_create works");
+
+    if (!(o = treeobj_create_dir ())
+        || !(val = treeobj_create_val ("foo", 3))
+        || treeobj_insert_entry (o, "a", val) < 0
+        || treeobj_insert_entry (o, "b", val) < 0
+        || !(data = treeobj_encode (o)))
+        BAIL_OUT ("could not create test directory");
+    json_decref (val);
+    len = strlen (data);
+    json_decref (o);
+
+    ok ((e = cache_entry_create ("xxx1")) != NULL
+        && cache_entry_set_raw (e, data, len) == 0
+        && cache_insert (cache, e) == 0
+        && cache_get_bytes (cache) == len,
+        "inserted dir entry counts only raw data");
+    ok (cache_entry_get_treeobj (e) != NULL,
+        "cache_entry_get_treeobj decodes the entry");
+    bytes = cache_get_bytes (cache);
+    ok (bytes > len,
+        "cache_get_bytes includes the decoded treeobj");
+    diag ("raw %d bytes, with treeobj %zu bytes", len, bytes);
+    ok (cache_entry_get_treeobj (e) != NULL
+        && cache_get_bytes (cache) == bytes,
+        "cache_get_bytes is unchanged by a second cache_entry_get_treeobj");
+
+    cache_set_max_bytes (cache, len);
+    ok (cache_over_limit (cache) == true,
+        "cache is over a limit equal to the raw data size");
+    ok (cache_trim (cache) == 1
+        && cache_count_entries (cache) == 0
+        && cache_get_bytes (cache) == 0,
+        "cache_trim removed the entry and all of its bytes");
+
+    free (data);
+    cache_destroy (cache);
+}
+
+void cache_gc_sweep_tests (void)
+{
+    struct cache *cache;
+    struct cache_entry *e1, *e2, *e3;
+
+    ok ((cache = cache_create (NULL)) != NULL,
+        "cache_create works");
+
+    ok ((e1 = cache_entry_create ("xxx1")) != NULL
+        && cache_insert (cache, e1) == 0,
+        "inserted invalid entry");
+    ok (cache_entry_get_stored (e1) == false,
+        "cache_entry_get_stored returns false for an invalid entry");
+    ok (cache_entry_set_raw (e1, "abc", 3) == 0
+        && cache_entry_get_stored (e1) == true,
+        "cache_entry_get_stored returns true once the entry is valid");
+
+    ok ((e2 = cache_entry_create ("xxx2")) != NULL
+        && cache_entry_set_raw (e2, "def", 3) == 0
+        && cache_entry_set_dirty (e2, true) == 0
+        && cache_insert (cache, e2) == 0,
+        "inserted dirty entry");
+
+    cache_set_gc_sweep (cache, true);
+    ok (cache_entry_get_stored (e1) == false,
+        "cache_entry_get_stored returns false for a clean entry during sweep");
+    ok (cache_entry_get_stored (e2) == true,
+        "cache_entry_get_stored returns true for a dirty entry during sweep");
+    ok (cache_entry_set_dirty (e2, false) == 0
+        && cache_entry_get_stored (e2) == false,
+        "and false once it is stored, until the sweep is over");
+
+    cache_set_gc_sweep (cache, false);
+    ok (cache_entry_get_stored (e1) == false
+        && cache_entry_get_stored (e2) == false,
+        "cache_entry_get_stored returns false after the sweep");
+    ok (cache_entry_set_dirty (e1, true) == 0
+        && cache_entry_get_stored (e1) == true
+        && cache_entry_set_dirty (e1, false) == 0
+        && cache_entry_get_stored (e1) == true,
+        "cache_entry_get_stored returns true once the entry is stored again");
+    ok (cache_entry_set_dirty (e2, true) == 0
+        && cache_entry_clear_dirty (e2) == 0
+        && cache_entry_get_stored (e2) == false,
+        "but not if its store was abandoned with cache_entry_clear_dirty");
+
+    ok ((e3 = cache_entry_create ("xxx3")) != NULL
+        && cache_entry_set_raw (e3, "ghi", 3) == 0
+        && cache_insert (cache, e3) == 0
+        && cache_entry_get_stored (e3) == true,
+        "an entry added after the sweep is stored");
+
+    cache_destroy (cache);
+}
+
 int main (int argc, char *argv[])
 {
     plan (NO_PLAN);
@@ -729,6 +930,9 @@ int main (int argc, char *argv[])
     cache_entry_raw_and_treeobj_tests ();
     waiter_tests ();
     cache_expiration_tests ();
+    cache_trim_tests ();
+    cache_trim_treeobj_tests ();
+    cache_gc_sweep_tests ();
     cache_blobref_tests ();
     cache_remove_entry_tests ();
 
@@ -606,6 +606,191 @@ void kvstxn_mgr_merge_tests (void)
 
     clear_ready_kvstxns (ktm);
 
+    /* test successful merge (FLUX_KVS_SYNC group commit) */
+
+    create_ready_kvstxn (ktm, "transaction1", "key1", "1", 0, FLUX_KVS_SYNC);
+    create_ready_kvstxn (ktm, "transaction2", "key2", "2", 0, FLUX_KVS_SYNC);
+
+    ok (kvstxn_mgr_merge_ready_transactions (ktm) == 0,
+        "kvstxn_mgr_merge_ready_transactions success");
+
+    names = json_array ();
+    json_array_append_new (names, json_string ("transaction1"));
+    json_array_append_new (names, json_string ("transaction2"));
+
+    ops = json_array ();
+    ops_append (ops, "key1", "1", 0);
+    ops_append (ops, "key2", "2", 0);
+
+    verify_ready_kvstxn (ktm,
+                         names,
+                         ops,
+                         FLUX_KVS_SYNC,
+                         0,
+                         "merged transaction (sync group)");
+
+    json_decref (names);
+    json_decref (ops);
+    ops = NULL;
+
+    clear_ready_kvstxns (ktm);
+
+    /* test that a user FLUX_KVS_SYNC transaction is not merged into
+     * internal checkpoint transactions ahead of it
+     */
+
+    create_ready_kvstxn_internal_flags (ktm,
+                                        "checkpoint1",
+                                        NULL,
+                                        NULL,
+                                        0,
+                                        FLUX_KVS_SYNC,
+                                        KVSTXN_INTERNAL_FLAG_NO_PUBLISH);
+    create_ready_kvstxn_internal_flags (ktm,
+                                        "checkpoint2",
+                                        NULL,
+                                        NULL,
+                                        0,
+                                        FLUX_KVS_SYNC,
+                                        KVSTXN_INTERNAL_FLAG_NO_PUBLISH);
+    create_ready_kvstxn (ktm, "transaction3", "key3", "3", 0, FLUX_KVS_SYNC);
+
+    ok (kvstxn_mgr_merge_ready_transactions (ktm) == 0,
+        "kvstxn_mgr_merge_ready_transactions success");
+
+    names = json_array ();
+    json_array_append_new (names, json_string ("checkpoint1"));
+    json_array_append_new (names, json_string ("checkpoint2"));
+
+    ops = json_array ();
+
+    verify_ready_kvstxn (ktm,
+                         names,
+                         ops,
+                         FLUX_KVS_SYNC,
+                         KVSTXN_INTERNAL_FLAG_NO_PUBLISH,
+                         "merged transaction (checkpoints only)");
+
+    json_decref (names);
+    json_decref (ops);
+
+    kvstxn_mgr_remove_transaction (ktm,
+                                   kvstxn_mgr_get_ready_transaction (ktm),
+                                   false);
+
+    names = json_array ();
+    json_array_append_new (names, json_string ("transaction3"));
+
+    ops = json_array ();
+    ops_append (ops, "key3", "3", 0);
+
+    verify_ready_kvstxn (ktm,
+                         names,
+                         ops,
+                         FLUX_KVS_SYNC,
+                         0,
+                         "unmerged transaction (sync after checkpoints)");
+
+    json_decref (names);
+    json_decref (ops);
+    ops = NULL;
+
+    clear_ready_kvstxns (ktm);
+
+    /* test that an internal checkpoint transaction is not merged into
+     * user FLUX_KVS_SYNC transactions ahead of it
+     */
+
+    create_ready_kvstxn (ktm, "transaction1", "key1", "1", 0, FLUX_KVS_SYNC);
+    create_ready_kvstxn (ktm, "transaction2", "key2", "2", 0, FLUX_KVS_SYNC);
+    create_ready_kvstxn_internal_flags (ktm,
+                                        "checkpoint3",
+                                        NULL,
+                                        NULL,
+                                        0,
+                                        FLUX_KVS_SYNC,
+                                        KVSTXN_INTERNAL_FLAG_NO_PUBLISH);
+
+    ok (kvstxn_mgr_merge_ready_transactions (ktm) == 0,
+        "kvstxn_mgr_merge_ready_transactions success");
+
+    names = json_array ();
+    json_array_append_new (names, json_string ("transaction1"));
+    json_array_append_new (names, json_string ("transaction2"));
+
+    ops = json_array ();
+    ops_append (ops, "key1", "1", 0);
+    ops_append (ops, "key2", "2", 0);
+
+    verify_ready_kvstxn (ktm,
+                         names,
+                         ops,
+                         FLUX_KVS_SYNC,
+                         0,
+                         "merged transaction (sync before checkpoint)");
+
+    json_decref (names);
+    json_decref (ops);
+
+    kvstxn_mgr_remove_transaction (ktm,
+                                   kvstxn_mgr_get_ready_transaction (ktm),
+                                   false);
+
+    names = json_array ();
+    json_array_append_new (names, json_string ("checkpoint3"));
+
+    ops = json_array ();
+
+    verify_ready_kvstxn (ktm,
+                         names,
+                         ops,
+                         FLUX_KVS_SYNC,
+                         KVSTXN_INTERNAL_FLAG_NO_PUBLISH,
+                         "unmerged transaction (checkpoint after sync)");
+
+    json_decref (names);
+    json_decref (ops);
+    ops = NULL;
+
+    clear_ready_kvstxns (ktm);
+
+    /* test unsuccessful merge (FLUX_KVS_SYNC with FLUX_KVS_NO_MERGE) */
+
+    create_ready_kvstxn (ktm,
+                         "transaction1",
+                         "key1",
+                         "1",
+                         0,
+                         FLUX_KVS_SYNC | FLUX_KVS_NO_MERGE);
+    create_ready_kvstxn (ktm,
+                         "transaction2",
+                         "key2",
+                         "2",
+                         0,
+                         FLUX_KVS_SYNC | FLUX_KVS_NO_MERGE);
+
+    ok (kvstxn_mgr_merge_ready_transactions (ktm) == 0,
+        "kvstxn_mgr_merge_ready_transactions success");
+
+    names = json_array ();
+    json_array_append_new (names, json_string ("transaction1"));
+
+    ops = json_array ();
+    ops_append (ops, "key1", "1", 0);
+
+    verify_ready_kvstxn (ktm,
+                         names,
+                         ops,
+                         FLUX_KVS_SYNC | FLUX_KVS_NO_MERGE,
+                         0,
+                         "unmerged transaction (sync no merge)");
+
+    json_decref (names);
+    json_decref (ops);
+    ops = NULL;
+
+    clear_ready_kvstxns (ktm);
+
     /* test unsuccessful merge - different flags */
 
     create_ready_kvstxn (ktm, "transaction1", "key1", "1", 0, 0);
@@ -1563,6 +1748,7 @@ void kvstxn_process_multiple_missing_ref (void)
     const char *newroot;
     json_t *ops = NULL;
     int count = 0;
+    struct kvstxn_timing timing;
 
     ktest_init (&cache, &krm);
 
@@ -1686,6 +1872,14 @@ void kvstxn_process_multiple_missing_ref (void)
     verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "dir2.b", "62");
     verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "dir3.c", "72");
 
+    kvstxn_get_timing (kt, &timing);
+    ok (timing.stalls == 2,
+        "kvstxn_get_timing counts a load and a store stall");
+    ok (timing.age >= timing.load + timing.store
+        && timing.load >= 0. && timing.store >= 0.
+        && timing.sync == 0. && timing.pipeline == 0.,
+        "kvstxn_get_timing returns sane stall times");
+
     kvstxn_mgr_destroy (ktm);
     ktest_finalize (cache, krm);
     json_decref (dir1);
@@ -2560,6 +2754,117 @@ void kvstxn_process_delete_test (void)
     json_decref (root);
 }
 
+/* The root copy shares unmodified entries with the cache.  Verify
+ * that applying a transaction does not alter the cached objects it
+ * was copied from.
+ */
+void kvstxn_process_cached_dirs_unmodified (void)
+{
+    struct cache *cache;
+    kvsroot_mgr_t *krm;
+    kvstxn_mgr_t *ktm;
+    kvstxn_t *kt;
+    struct cache_entry *entry;
+    const json_t *cached;
+    json_t *root;
+    json_t *dir;
+    json_t *ops;
+    char root_ref[BLOBREF_MAX_STRING_SIZE];
+    char dir_ref[BLOBREF_MAX_STRING_SIZE];
+    const char *newroot;
+
+    ktest_init (&cache, &krm);
+
+    /* This root is
+     *
+     * root_ref
+     * "dir" : dirref to dir_ref
+     * "val" : val w/ "1"
+     *
+     * dir_ref
+     * "a" : val w/ "2"
+     * "b" : val w/ "3"
+     *
+     */
+
+    dir = treeobj_create_dir ();
+    _treeobj_insert_entry_val (dir, "a", "2", 1);
+    _treeobj_insert_entry_val (dir, "b", "3", 1);
+
+    ok (treeobj_hash ("sha1", dir, dir_ref, sizeof (dir_ref)) == 0,
+        "treeobj_hash worked");
+
+    (void)cache_insert (cache, create_cache_entry_treeobj (dir_ref, dir));
+
+    root = treeobj_create_dir ();
+    _treeobj_insert_entry_dirref (root, "dir", dir_ref);
+    _treeobj_insert_entry_val (root, "val", "1", 1);
+
+    ok (treeobj_hash ("sha1", root, root_ref, sizeof (root_ref)) == 0,
+        "treeobj_hash worked");
+
+    (void)cache_insert (cache, create_cache_entry_treeobj (root_ref, root));
+
+    setup_kvsroot (krm, KVS_PRIMARY_NAMESPACE, cache, root_ref);
+
+    ok ((ktm = kvstxn_mgr_create (cache,
+                                  KVS_PRIMARY_NAMESPACE,
+                                  "sha1",
+                                  NULL,
+                                  &test_global)) != NULL,
+        "kvstxn_mgr_create works");
+
+    ops = json_array ();
+    ops_append (ops, "dir.a", "4", 0);
+    ops_append (ops, "dir.b", NULL, 0);
+    ops_append (ops, "dir.sub.c", "5", 0);
+    ops_append (ops, "dir.sub.d", "6", 0);
+    ops_append (ops, "val", "7", 0);
+
+    ok (kvstxn_mgr_add_transaction (ktm, "transaction1", ops, 0, 0) == 0,
+        "kvstxn_mgr_add_transaction works");
+    json_decref (ops);
+
+    ok ((kt = kvstxn_mgr_get_ready_transaction (ktm)) != NULL,
+        "kvstxn_mgr_get_ready_transaction returns ready kvstxn");
+
+    ok (kvstxn_process (kt, root_ref, 0) == KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES,
+        "kvstxn_process returns KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES");
+
+    ok (kvstxn_iter_dirty_cache_entries (kt, cache_noop_cb, NULL) == 0,
+        "kvstxn_iter_dirty_cache_entries works for dirty cache entries");
+
+    ok (kvstxn_process (kt, root_ref, 0) == KVSTXN_PROCESS_FINISHED,
+        "kvstxn_process returns KVSTXN_PROCESS_FINISHED");
+
+    ok ((newroot = kvstxn_get_newroot_ref (kt)) != NULL,
+        "kvstxn_get_newroot_ref returns != NULL when processing complete");
+
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "dir.a", "4");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "dir.b", NULL);
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "dir.sub.c", "5");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "dir.sub.d", "6");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "val", "7");
+
+    ok ((entry = cache_lookup (cache, root_ref)) != NULL
+        && (cached = cache_entry_get_treeobj (entry)) != NULL
+        && json_equal ((json_t *)cached, root),
+        "cached root dir was not modified");
+    ok ((entry = cache_lookup (cache, dir_ref)) != NULL
+        && (cached = cache_entry_get_treeobj (entry)) != NULL
+        && json_equal ((json_t *)cached, dir),
+        "cached subdir was not modified");
+
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, root_ref, "dir.a", "2");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, root_ref, "dir.b", "3");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, root_ref, "val", "1");
+
+    kvstxn_mgr_destroy (ktm);
+    ktest_finalize (cache, krm);
+    json_decref (dir);
+    json_decref (root);
+}
+
 void kvstxn_process_delete_nosubdir_test (void)
 {
     struct cache *cache;
@@ -3544,6 +3849,783 @@ void kvstxn_process_fallback_merge (void)
     ktest_finalize (cache, krm);
 }
 
+/* Apply 'ops' to the root at 'root_ref' and place the new root ref in
+ * 'newroot'.
+ */
+static void hdir_commit (kvstxn_mgr_t *ktm,
+                         const char *root_ref,
+                         json_t *ops,
+                         char *newroot,
+                         int newroot_len)
+{
+    kvstxn_t *kt;
+
+    ok (kvstxn_mgr_add_transaction (ktm, "hdir", ops, 0, 0) == 0,
+        "kvstxn_mgr_add_transaction works");
+    ok ((kt = kvstxn_mgr_get_ready_transaction (ktm)) != NULL,
+        "kvstxn_mgr_get_ready_transaction returns ready kvstxn");
+    ok (kvstxn_process (kt, root_ref, 0) == KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES,
+        "kvstxn_process returns KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES");
+    ok (kvstxn_iter_dirty_cache_entries (kt, cache_noop_cb, NULL) == 0,
+        "kvstxn_iter_dirty_cache_entries works for dirty cache entries");
+    ok (kvstxn_process (kt, root_ref, 0) == KVSTXN_PROCESS_FINISHED,
+        "kvstxn_process returns KVSTXN_PROCESS_FINISHED");
+    snprintf (newroot, newroot_len, "%s", kvstxn_get_newroot_ref (kt));
+    kvstxn_mgr_remove_transaction (ktm, kt, false);
+}
+
+/* Return the object referenced by dirref 'name' in the dir at 'ref'.
+ */
+static const json_t *hdir_get_dirref (struct cache *cache,
+                                      const char *ref,
+                                      const char *name)
+{
+    struct cache_entry *entry;
+    const json_t *dir;
+    const json_t *dirref;
+    const char *blobref;
+
+    if (!(entry = cache_lookup (cache, ref))
+        || !(dir = cache_entry_get_treeobj (entry))
+        || !(dirref = treeobj_peek_entry (dir, name))
+        || !treeobj_is_dirref (dirref)
+        || !(blobref = treeobj_get_blobref (dirref, 0))
+        || !(entry = cache_lookup (cache, blobref)))
+        return NULL;
+    return cache_entry_get_treeobj (entry);
+}
+
+void kvstxn_process_hdir (void)
+{
+    struct cache *cache;
+    kvsroot_mgr_t *krm;
+    kvstxn_mgr_t *ktm;
+    kvstxn_t *kt;
+    lookup_t *lh;
+    const json_t *hdir;
+    json_t *ops;
+    json_t *op;
+    json_t *o;
+    int count;
+    char root_ref[BLOBREF_MAX_STRING_SIZE];
+    char newroot[BLOBREF_MAX_STRING_SIZE];
+    char key[64];
+    char val[64];
+    struct flux_msg_cred cred = { .rolemask = FLUX_ROLE_OWNER, .userid = 0 };
+
+    cache = create_cache_with_empty_rootdir (root_ref, sizeof (root_ref));
+    ok ((krm = kvsroot_mgr_create (NULL, NULL)) != NULL,
+        "kvsroot_mgr_create works");
+
+    setup_kvsroot (krm, KVS_PRIMARY_NAMESPACE, cache, root_ref);
+
+    ok ((ktm = kvstxn_mgr_create (cache,
+                                  KVS_PRIMARY_NAMESPACE,
+                                  "sha1",
+                                  NULL,
+                                  &test_global)) != NULL,
+        "kvstxn_mgr_create works");
+
+    kvstxn_mgr_set_dir_shard_threshold (ktm, 4);
+
+    /* Create a directory with 64 entries, which is split into an hdir
+     * with shards that are split again, and a small directory that is not.
+     */
+    ops = json_array ();
+    for (int i = 0; i < 64; i++) {
+        snprintf (key, sizeof (key), "dir.key%d", i);
+        snprintf (val, sizeof (val), "%d", i);
+        ops_append (ops, key, val, 0);
+    }
+    ops_append (ops, "small.a", "1", 0);
+    ops_append (ops, "small.sub.a", "2", 0);
+    hdir_commit (ktm, root_ref, ops, newroot, sizeof (newroot));
+    json_decref (ops);
+
+    ok ((hdir = hdir_get_dirref (cache, newroot, "dir")) != NULL
+        && treeobj_is_hdir (hdir),
+        "large directory was stored as an hdir");
+    count = 0;
+    for (int i = 0; i < TREEOBJ_HDIR_FANOUT; i++) {
+        const json_t *shard = treeobj_peek_shard (hdir, i);
+        if (shard && treeobj_is_dirref (shard))
+            count++;
+    }
+    ok (count > 0 && count == treeobj_get_count (hdir),
+        "hdir shards are stored as dirrefs");
+    ok ((hdir = hdir_get_dirref (cache, newroot, "small")) != NULL
+        && treeobj_is_dir (hdir),
+        "small directory was stored as a dir");
+
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "dir.key0", "0");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "dir.key42", "42");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "dir.key63", "63");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "dir.nokey", NULL);
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "small.sub.a", "2");
+
+    ok ((lh = lookup_create (cache,
+                             krm,
+                             KVS_PRIMARY_NAMESPACE,
+                             newroot,
+                             0,
+                             "dir",
+                             cred,
+                             FLUX_KVS_READDIR,
+                             NULL)) != NULL,
+        "lookup_create dir with FLUX_KVS_READDIR");
+    ok (lookup (lh) == LOOKUP_PROCESS_FINISHED,
+        "lookup found result");
+    o = lookup_get_value (lh);
+    ok (o != NULL
+        && treeobj_is_dir (o)
+        && treeobj_get_count (o) == 64,
+        "lookup_get_value returned dir with all 64 entries");
+    ok (o != NULL
+        && treeobj_peek_entry (o, "key17") != NULL
+        && treeobj_is_val (treeobj_peek_entry (o, "key17")),
+        "assembled dir contains expected entry");
+    json_decref (o);
+    lookup_destroy (lh);
+
+    /* Update, add, and delete entries in the hdir, and add to a
+     * subdirectory of the hdir.
+     */
+    strcpy (root_ref, newroot);
+    ops = json_array ();
+    ops_append (ops, "dir.key42", "foo", 0);
+    ops_append (ops, "dir.key64", "64", 0);
+    ops_append (ops, "dir.key7", NULL, 0);
+    ops_append (ops, "dir.nokey", NULL, 0);
+    ops_append (ops, "dir.sub.a", "bar", 0);
+    hdir_commit (ktm, root_ref, ops, newroot, sizeof (newroot));
+    json_decref (ops);
+
+    ok ((hdir = hdir_get_dirref (cache, newroot, "dir")) != NULL
+        && treeobj_is_hdir (hdir),
+        "modified directory is still an hdir");
+
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "dir.key0", "0");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "dir.key42", "foo");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "dir.key64", "64");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "dir.key7", NULL);
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "dir.sub.a", "bar");
+
+    /* The previous root is unchanged.
+     */
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, root_ref, "dir.key42", "42");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, root_ref, "dir.key7", "7");
+
+    /* An hdir may not be committed by a user.
+     */
+    ops = json_array ();
+    o = treeobj_create_hdir ();
+    txn_encode_op ("dir2", 0, o, &op);
+    json_decref (o);
+    json_array_append_new (ops, op);
+    ok (kvstxn_mgr_add_transaction (ktm, "hdir", ops, 0, 0) == 0,
+        "kvstxn_mgr_add_transaction works");
+    json_decref (ops);
+    ok ((kt = kvstxn_mgr_get_ready_transaction (ktm)) != NULL,
+        "kvstxn_mgr_get_ready_transaction returns ready kvstxn");
+    ok (kvstxn_process (kt, newroot, 0) == KVSTXN_PROCESS_ERROR
+        && kvstxn_get_errnum (kt) == EINVAL,
+        "kvstxn_process fails with EINVAL on hdir dirent");
+    kvstxn_mgr_remove_transaction (ktm, kt, false);
+
+    kvstxn_mgr_destroy (ktm);
+    ktest_finalize (cache, krm);
+}
+
+/* Process 'kt' until it stalls on dirty cache entries, and
+ * pretend the stores were started.
+ */
+static void pipeline_start (kvstxn_t *kt, const char *rootref)
+{
+    ok (kvstxn_process (kt, rootref, 0) == KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES,
+        "kvstxn_process returns KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES");
+    ok (kvstxn_iter_dirty_cache_entries (kt, cache_noop_cb, NULL) == 0,
+        "kvstxn_iter_dirty_cache_entries works for dirty cache entries");
+}
+
+/* Process 'kt' to completion, returning its new root.
+ */
+static const char *pipeline_finish (kvstxn_t *kt, const char *rootref)
+{
+    ok (kvstxn_process (kt, rootref, 0) == KVSTXN_PROCESS_FINISHED,
+        "kvstxn_process returns KVSTXN_PROCESS_FINISHED");
+    return kvstxn_get_newroot_ref (kt);
+}
+
+void kvstxn_process_pipeline (void)
+{
+    struct cache *cache;
+    kvsroot_mgr_t *krm;
+    kvstxn_mgr_t *ktm;
+    kvstxn_t *kt1, *kt2, *kt3;
+    char rootref[BLOBREF_MAX_STRING_SIZE];
+    const char *newroot;
+
+    cache = create_cache_with_empty_rootdir (rootref, sizeof (rootref));
+
+    ok ((krm = kvsroot_mgr_create (NULL, NULL)) != NULL,
+        "kvsroot_mgr_create works");
+
+    setup_kvsroot (krm, KVS_PRIMARY_NAMESPACE, cache, ref_dummy);
+
+    ok ((ktm = kvstxn_mgr_create (cache,
+                                  KVS_PRIMARY_NAMESPACE,
+                                  "sha1",
+                                  NULL,
+                                  &test_global)) != NULL,
+        "kvstxn_mgr_create works");
+
+    kvstxn_mgr_set_pipeline_depth (ktm, 2);
+
+    create_ready_kvstxn (ktm, "transaction1", "key1", "1", 0, 0);
+    create_ready_kvstxn (ktm, "transaction2", "key2", "2", 0, 0);
+    create_ready_kvstxn (ktm, "transaction3", "key3", "3", 0, 0);
+
+    ok ((kt1 = kvstxn_mgr_get_ready_transaction (ktm)) != NULL,
+        "kvstxn_mgr_get_ready_transaction returns ready kvstxn");
+
+    pipeline_start (kt1, rootref);
+
+    /* transaction1 is waiting on stores, transaction2 may be started */
+    ok ((kt2 = kvstxn_mgr_get_ready_transaction (ktm)) != NULL
+        && kt2 != kt1,
+        "kvstxn_mgr_get_ready_transaction returns second kvstxn");
+
+    pipeline_start (kt2, rootref);
+
+    ok (kvstxn_mgr_get_ready_transaction (ktm) == NULL,
+        "kvstxn_mgr_get_ready_transaction returns NULL, pipeline is full");
+
+    ok (kvstxn_process (kt2, rootref, 0) == KVSTXN_PROCESS_PIPELINE_WAIT,
+        "kvstxn_process on second returns KVSTXN_PROCESS_PIPELINE_WAIT");
+
+    ok (kvstxn_mgr_transaction_ready (ktm) == false,
+        "kvstxn_mgr_transaction_ready returns false");
+
+    newroot = pipeline_finish (kt1, rootref);
+    strcpy (rootref, newroot);
+
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, rootref, "key1", "1");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, rootref, "key2", NULL);
+
+    kvstxn_mgr_remove_transaction (ktm, kt1, false);
+
+    ok (kvstxn_mgr_get_ready_transaction (ktm) == kt2,
+        "kvstxn_mgr_get_ready_transaction returns second kvstxn");
+
+    /* transaction2 was applied to the new root of transaction1 */
+    newroot = pipeline_finish (kt2, rootref);
+    strcpy (rootref, newroot);
+
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, rootref, "key1", "1");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, rootref, "key2", "2");
+
+    kvstxn_mgr_remove_transaction (ktm, kt2, false);
+
+    ok ((kt3 = kvstxn_mgr_get_ready_transaction (ktm)) != NULL,
+        "kvstxn_mgr_get_ready_transaction returns third kvstxn");
+
+    pipeline_start (kt3, rootref);
+
+    newroot = pipeline_finish (kt3, rootref);
+
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "key1", "1");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "key2", "2");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "key3", "3");
+
+    kvstxn_mgr_remove_transaction (ktm, kt3, false);
+
+    ok (kvstxn_mgr_get_ready_transaction (ktm) == NULL,
+        "kvstxn_mgr_get_ready_transaction returns NULL, no more kvstxns");
+
+    kvstxn_mgr_destroy (ktm);
+    kvsroot_mgr_destroy (krm);
+    cache_destroy (cache);
+}
+
+void kvstxn_process_pipeline_error (void)
+{
+    struct cache *cache;
+    kvsroot_mgr_t *krm;
+    kvstxn_mgr_t *ktm;
+    kvstxn_t *kt1, *kt2;
+    char rootref[BLOBREF_MAX_STRING_SIZE];
+    const char *newroot;
+
+    cache = create_cache_with_empty_rootdir (rootref, sizeof (rootref));
+
+    ok ((krm = kvsroot_mgr_create (NULL, NULL)) != NULL,
+        "kvsroot_mgr_create works");
+
+    setup_kvsroot (krm, KVS_PRIMARY_NAMESPACE, cache, ref_dummy);
+
+    ok ((ktm = kvstxn_mgr_create (cache,
+                                  KVS_PRIMARY_NAMESPACE,
+                                  "sha1",
+                                  NULL,
+                                  &test_global)) != NULL,
+        "kvstxn_mgr_create works");
+
+    kvstxn_mgr_set_pipeline_depth (ktm, 2);
+
+    create_ready_kvstxn (ktm, "transaction1", "key1", "1", 0, 0);
+    create_ready_kvstxn (ktm, "transaction2", "key2", "2", 0, 0);
+
+    ok ((kt1 = kvstxn_mgr_get_ready_transaction (ktm)) != NULL,
+        "kvstxn_mgr_get_ready_transaction returns ready kvstxn");
+
+    pipeline_start (kt1, rootref);
+
+    ok ((kt2 = kvstxn_mgr_get_ready_transaction (ktm)) != NULL,
+        "kvstxn_mgr_get_ready_transaction returns second kvstxn");
+
+    pipeline_start (kt2, rootref);
+
+    /* a store for transaction1 failed */
+    kvstxn_set_aux_errnum (kt1, EPERM);
+
+    ok (kvstxn_process (kt2, rootref, 0) == KVSTXN_PROCESS_PIPELINE_WAIT,
+        "kvstxn_process on second returns KVSTXN_PROCESS_PIPELINE_WAIT");
+
+    ok (kvstxn_process (kt1, rootref, 0) == KVSTXN_PROCESS_ERROR,
+        "kvstxn_process returns KVSTXN_PROCESS_ERROR");
+
+    ok (kvstxn_get_errnum (kt1) == EPERM,
+        "kvstxn_get_errnum returns EPERM");
+
+    kvstxn_mgr_remove_transaction (ktm, kt1, false);
+
+    ok (kvstxn_mgr_get_ready_transaction (ktm) == kt2,
+        "kvstxn_mgr_get_ready_transaction returns second kvstxn");
+
+    /* transaction2 starts over on the original root */
+    pipeline_start (kt2, rootref);
+
+    newroot = pipeline_finish (kt2, rootref);
+
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "key1", NULL);
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "key2", "2");
+
+    kvstxn_mgr_remove_transaction (ktm, kt2, false);
+
+    ok (kvstxn_mgr_get_ready_transaction (ktm) == NULL,
+        "kvstxn_mgr_get_ready_transaction returns NULL, no more kvstxns");
+
+    kvstxn_mgr_destroy (ktm);
+    kvsroot_mgr_destroy (krm);
+    cache_destroy (cache);
+}
+
+void kvstxn_process_pipeline_merge (void)
+{
+    struct cache *cache;
+    kvsroot_mgr_t *krm;
+    kvstxn_mgr_t *ktm;
+    kvstxn_t *kt1, *kt2;
+    char rootref[BLOBREF_MAX_STRING_SIZE];
+    const char *newroot;
+    json_t *names;
+
+    cache = create_cache_with_empty_rootdir (rootref, sizeof (rootref));
+
+    ok ((krm = kvsroot_mgr_create (NULL, NULL)) != NULL,
+        "kvsroot_mgr_create works");
+
+    setup_kvsroot (krm, KVS_PRIMARY_NAMESPACE, cache, ref_dummy);
+
+    ok ((ktm = kvstxn_mgr_create (cache,
+                                  KVS_PRIMARY_NAMESPACE,
+                                  "sha1",
+                                  NULL,
+                                  &test_global)) != NULL,
+        "kvstxn_mgr_create works");
+
+    kvstxn_mgr_set_pipeline_depth (ktm, 2);
+
+    create_ready_kvstxn (ktm, "transaction1", "key1", "1", 0, 0);
+    create_ready_kvstxn (ktm, "transaction2", "key2", "2", 0, 0);
+    create_ready_kvstxn (ktm, "transaction3", "key3", "3", 0, 0);
+    create_ready_kvstxn (ktm, "transaction4", "key4", "4", 0, FLUX_KVS_SYNC);
+
+    ok ((kt1 = kvstxn_mgr_get_ready_transaction (ktm)) != NULL,
+        "kvstxn_mgr_get_ready_transaction returns ready kvstxn");
+
+    pipeline_start (kt1, rootref);
+
+    /* transactions behind the one being processed are merged */
+    ok (kvstxn_mgr_merge_ready_transactions (ktm) == 0,
+        "kvstxn_mgr_merge_ready_transactions success");
+
+    ok (kvstxn_mgr_ready_transaction_count (ktm) == 5,
+        "merged kvstxn added to ready queue");
+
+    ok ((kt2 = kvstxn_mgr_get_ready_transaction (ktm)) != NULL
+        && kt2 != kt1,
+        "kvstxn_mgr_get_ready_transaction returns merged kvstxn");
+
+    names = json_pack ("[ s, s ]", "transaction2", "transaction3");
+    ok (json_equal (names, kvstxn_get_names (kt2)) == true,
+        "names match merged transaction");
+    json_decref (names);
+
+    pipeline_start (kt2, rootref);
+
+    ok (kvstxn_process (kt2, rootref, 0) == KVSTXN_PROCESS_PIPELINE_WAIT,
+        "kvstxn_process on merged returns KVSTXN_PROCESS_PIPELINE_WAIT");
+
+    newroot = pipeline_finish (kt1, rootref);
+    strcpy (rootref, newroot);
+
+    kvstxn_mgr_remove_transaction (ktm, kt1, false);
+
+    ok (kvstxn_mgr_get_ready_transaction (ktm) == kt2,
+        "kvstxn_mgr_get_ready_transaction returns merged kvstxn");
+
+    newroot = pipeline_finish (kt2, rootref);
+
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "key1", "1");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "key2", "2");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "key3", "3");
+
+    kvstxn_mgr_remove_transaction (ktm, kt2, false);
+
+    ok (kvstxn_mgr_ready_transaction_count (ktm) == 1,
+        "merged kvstxn and its components removed from ready queue");
+
+    ok ((kt1 = kvstxn_mgr_get_ready_transaction (ktm)) != NULL
+        && kvstxn_get_flags (kt1) == FLUX_KVS_SYNC,
+        "kvstxn_mgr_get_ready_transaction returns sync kvstxn");
+
+    kvstxn_mgr_destroy (ktm);
+    kvsroot_mgr_destroy (krm);
+    cache_destroy (cache);
+}
+
+void kvstxn_process_pipeline_sync (void)
+{
+    struct cache *cache;
+    kvsroot_mgr_t *krm;
+    kvstxn_mgr_t *ktm;
+    kvstxn_t *kt;
+    char rootref[BLOBREF_MAX_STRING_SIZE];
+
+    cache = create_cache_with_empty_rootdir (rootref, sizeof (rootref));
+
+    ok ((krm = kvsroot_mgr_create (NULL, NULL)) != NULL,
+        "kvsroot_mgr_create works");
+
+    setup_kvsroot (krm, KVS_PRIMARY_NAMESPACE, cache, ref_dummy);
+
+    ok ((ktm = kvstxn_mgr_create (cache,
+                                  KVS_PRIMARY_NAMESPACE,
+                                  "sha1",
+                                  NULL,
+                                  &test_global)) != NULL,
+        "kvstxn_mgr_create works");
+
+    kvstxn_mgr_set_pipeline_depth (ktm, 2);
+
+    create_ready_kvstxn (ktm, "transaction1", "key1", "1", 0, 0);
+    create_ready_kvstxn (ktm, "transaction2", "key2", "2", 0, FLUX_KVS_SYNC);
+
+    ok ((kt = kvstxn_mgr_get_ready_transaction (ktm)) != NULL,
+        "kvstxn_mgr_get_ready_transaction returns ready kvstxn");
+
+    pipeline_start (kt, rootref);
+
+    ok (kvstxn_mgr_get_ready_transaction (ktm) == NULL,
+        "kvstxn_mgr_get_ready_transaction does not start sync kvstxn early");
+
+    kvstxn_mgr_destroy (ktm);
+    kvsroot_mgr_destroy (krm);
+    cache_destroy (cache);
+}
+
+static int count_refs_cb (kvstxn_t *kt, const char *ref, void *data)
+{
+    int *count = data;
+    (*count)++;
+    return 0;
+}
+
+/* Return the number of blobs in valref 'name' in the dir at 'ref'.
+ */
+static int valref_get_count (struct cache *cache,
+                             const char *ref,
+                             const char *name)
+{
+    struct cache_entry *entry;
+    const json_t *dir;
+    const json_t *valref;
+
+    if (!(entry = cache_lookup (cache, ref))
+        || !(dir = cache_entry_get_treeobj (entry))
+        || !(valref = treeobj_peek_entry (dir, name))
+        || !treeobj_is_valref (valref))
+        return -1;
+    return treeobj_get_count (valref);
+}
+
+void kvstxn_process_valref_compact (void)
+{
+    struct cache *cache;
+    kvsroot_mgr_t *krm;
+    kvstxn_mgr_t *ktm;
+    kvstxn_t *kt;
+    json_t *root;
+    json_t *valref;
+    json_t *ops;
+    char root_ref[BLOBREF_MAX_STRING_SIZE];
+    char newroot[BLOBREF_MAX_STRING_SIZE];
+    char ref[BLOBREF_MAX_STRING_SIZE];
+    const char *blobs[] = { "A", "B", "C" };
+    int count;
+
+    ktest_init (&cache, &krm);
+
+    /* This root is
+     *
+     * root_ref
+     * "log" : valref to "A", "B", "C"
+     * "cold" : valref to "A", "X", where "X" is not in the cache
+     */
+
+    root = treeobj_create_dir ();
+    valref = treeobj_create_valref (NULL);
+    for (int i = 0; i < 3; i++) {
+        blobref_hash ("sha1", blobs[i], 1, ref, sizeof (ref));
+        (void)cache_insert (cache,
+                            create_cache_entry_raw (ref, (void *)blobs[i], 1));
+        treeobj_append_blobref (valref, ref);
+    }
+    treeobj_insert_entry (root, "log", valref);
+    json_decref (valref);
+
+    valref = treeobj_create_valref (NULL);
+    blobref_hash ("sha1", "A", 1, ref, sizeof (ref));
+    treeobj_append_blobref (valref, ref);
+    blobref_hash ("sha1", "X", 1, ref, sizeof (ref));
+    treeobj_append_blobref (valref, ref);
+    treeobj_insert_entry (root, "cold", valref);
+    json_decref (valref);
+
+    ok (treeobj_hash ("sha1", root, root_ref, sizeof (root_ref)) == 0,
+        "treeobj_hash worked");
+
+    (void)cache_insert (cache, create_cache_entry_treeobj (root_ref, root));
+
+    setup_kvsroot (krm, KVS_PRIMARY_NAMESPACE, cache, root_ref);
+
+    ok ((ktm = kvstxn_mgr_create (cache,
+                                  KVS_PRIMARY_NAMESPACE,
+                                  "sha1",
+                                  NULL,
+                                  &test_global)) != NULL,
+        "kvstxn_mgr_create works");
+
+    kvstxn_mgr_set_valref_compact (ktm, 2);
+
+    ops = json_array ();
+    ops_append (ops, "log", "D", FLUX_KVS_APPEND);
+    ops_append (ops, "cold", "Y", FLUX_KVS_APPEND);
+
+    ok (kvstxn_mgr_add_transaction (ktm, "compact", ops, 0, 0) == 0,
+        "kvstxn_mgr_add_transaction works");
+    json_decref (ops);
+
+    ok ((kt = kvstxn_mgr_get_ready_transaction (ktm)) != NULL,
+        "kvstxn_mgr_get_ready_transaction returns ready kvstxn");
+    ok (kvstxn_process (kt, root_ref, 0) == KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES,
+        "kvstxn_process returns KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES");
+    ok (kvstxn_iter_dirty_cache_entries (kt, cache_noop_cb, NULL) == 0,
+        "kvstxn_iter_dirty_cache_entries works for dirty cache entries");
+    ok (kvstxn_process (kt, root_ref, 0) == KVSTXN_PROCESS_FINISHED,
+        "kvstxn_process returns KVSTXN_PROCESS_FINISHED");
+    snprintf (newroot, sizeof (newroot), "%s", kvstxn_get_newroot_ref (kt));
+
+    count = 0;
+    ok (kvstxn_iter_compact_refs (kt, count_refs_cb, &count) == 0
+        && count == 1,
+        "kvstxn_iter_compact_refs returns the blob missing from the cache");
+
+    kvstxn_mgr_remove_transaction (ktm, kt, false);
+
+    /* The trailing run of at most 2 blobs in "log" is merged, and
+     * "cold" is not compacted.
+     */
+    ok (valref_get_count (cache, newroot, "log") == 3,
+        "log valref was compacted");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "log", "ABCD");
+    ok (valref_get_count (cache, newroot, "cold") == 3,
+        "cold valref was not compacted");
+    ok (kvstxn_mgr_get_compactions (ktm) == 1
+        && kvstxn_mgr_get_compacted_blobs (ktm) == 1,
+        "compaction stats are correct");
+
+    kvstxn_mgr_clear_compaction_stats (ktm);
+    ok (kvstxn_mgr_get_compactions (ktm) == 0
+        && kvstxn_mgr_get_compacted_blobs (ktm) == 0,
+        "kvstxn_mgr_clear_compaction_stats works");
+
+    kvstxn_mgr_destroy (ktm);
+    ktest_finalize (cache, krm);
+    json_decref (root);
+}
+
+/* Return true if the raw data of cache entry 'ref' is the same as
+ * treeobj_encode() of its treeobj.
+ */
+static bool encoding_is_canonical (struct cache *cache, const char *ref)
+{
+    struct cache_entry *entry;
+    const json_t *o;
+    const void *data;
+    int len;
+    char *s;
+    bool result;
+
+    if (!(entry = cache_lookup (cache, ref))
+        || cache_entry_get_raw (entry, &data, &len) < 0
+        || !(o = cache_entry_get_treeobj (entry))
+        || !(s = treeobj_encode (o)))
+        return false;
+    result = (strlen (s) == len && memcmp (s, data, len) == 0);
+    free (s);
+    return result;
+}
+
+/* Dirs copied from the cache are encoded by splicing their changed
+ * entries into the cached encoding.  Verify the result is the same as
+ * a full encode, including when the cached dir is the one attached by
+ * the previous transaction.
+ */
+void kvstxn_process_dir_splice (void)
+{
+    struct cache *cache;
+    kvsroot_mgr_t *krm;
+    kvstxn_mgr_t *ktm;
+    kvstxn_t *kt;
+    json_t *root;
+    json_t *dir;
+    json_t *ops;
+    const json_t *o;
+    char root_ref[BLOBREF_MAX_STRING_SIZE];
+    char dir_ref[BLOBREF_MAX_STRING_SIZE];
+    char newroot[BLOBREF_MAX_STRING_SIZE];
+    char key[2] = "a";
+
+    ktest_init (&cache, &krm);
+
+    /* This root is
+     *
+     * root_ref
+     * "dir" : dirref to dir_ref
+     * "val" : val w/ "1"
+     *
+     * dir_ref
+     * "a" - "z" : val w/ the key name
+     *
+     */
+
+    dir = treeobj_create_dir ();
+    for (key[0] = 'a'; key[0] <= 'z'; key[0]++)
+        _treeobj_insert_entry_val (dir, key, key, 1);
+
+    ok (treeobj_hash ("sha1", dir, dir_ref, sizeof (dir_ref)) == 0,
+        "treeobj_hash worked");
+
+    (void)cache_insert (cache, create_cache_entry_treeobj (dir_ref, dir));
+
+    root = treeobj_create_dir ();
+    _treeobj_insert_entry_dirref (root, "dir", dir_ref);
+    _treeobj_insert_entry_val (root, "val", "1", 1);
+
+    ok (treeobj_hash ("sha1", root, root_ref, sizeof (root_ref)) == 0,
+        "treeobj_hash worked");
+
+    (void)cache_insert (cache, create_cache_entry_treeobj (root_ref, root));
+
+    setup_kvsroot (krm, KVS_PRIMARY_NAMESPACE, cache, root_ref);
+
+    ok ((ktm = kvstxn_mgr_create (cache,
+                                  KVS_PRIMARY_NAMESPACE,
+                                  "sha1",
+                                  NULL,
+                                  &test_global)) != NULL,
+        "kvstxn_mgr_create works");
+
+    create_ready_kvstxn (ktm, "transaction1", "dir.b", "42", 0, 0);
+
+    ok ((kt = kvstxn_mgr_get_ready_transaction (ktm)) != NULL,
+        "kvstxn_mgr_get_ready_transaction returns ready kvstxn");
+    ok (kvstxn_process (kt, root_ref, 0) == KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES,
+        "kvstxn_process returns KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES");
+    ok (kvstxn_iter_dirty_cache_entries (kt, cache_noop_cb, NULL) == 0,
+        "kvstxn_iter_dirty_cache_entries works for dirty cache entries");
+    ok (kvstxn_process (kt, root_ref, 0) == KVSTXN_PROCESS_FINISHED,
+        "kvstxn_process returns KVSTXN_PROCESS_FINISHED");
+    snprintf (newroot, sizeof (newroot), "%s", kvstxn_get_newroot_ref (kt));
+    kvstxn_mgr_remove_transaction (ktm, kt, false);
+
+    ok (kvstxn_mgr_get_dir_splices (ktm) == 2,
+        "root and dir were spliced");
+    ok (encoding_is_canonical (cache, newroot),
+        "new root encoding matches treeobj_encode");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "dir.b", "42");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "dir.c", "c");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "val", "1");
+
+    /* The second transaction is applied to dirs attached to the cache
+     * by the first.
+     */
+    snprintf (root_ref, sizeof (root_ref), "%s", newroot);
+    ops = json_array ();
+    ops_append (ops, "dir.a", NULL, 0);
+    ops_append (ops, "dir.c", "43", 0);
+    ops_append (ops, "dir.zz", "44", 0);
+
+    ok (kvstxn_mgr_add_transaction (ktm, "transaction2", ops, 0, 0) == 0,
+        "kvstxn_mgr_add_transaction works");
+    json_decref (ops);
+
+    ok ((kt = kvstxn_mgr_get_ready_transaction (ktm)) != NULL,
+        "kvstxn_mgr_get_ready_transaction returns ready kvstxn");
+    ok (kvstxn_process (kt, root_ref, 0) == KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES,
+        "kvstxn_process returns KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES");
+    ok (kvstxn_iter_dirty_cache_entries (kt, cache_noop_cb, NULL) == 0,
+        "kvstxn_iter_dirty_cache_entries works for dirty cache entries");
+    ok (kvstxn_process (kt, root_ref, 0) == KVSTXN_PROCESS_FINISHED,
+        "kvstxn_process returns KVSTXN_PROCESS_FINISHED");
+    snprintf (newroot, sizeof (newroot), "%s", kvstxn_get_newroot_ref (kt));
+    kvstxn_mgr_remove_transaction (ktm, kt, false);
+
+    ok (kvstxn_mgr_get_dir_splices (ktm) == 4,
+        "root and dir were spliced again");
+    ok (encoding_is_canonical (cache, newroot),
+        "new root encoding matches treeobj_encode");
+    ok ((o = cache_entry_get_treeobj (cache_lookup (cache, newroot)))
+        && (o = treeobj_get_entry ((json_t *)o, "dir"))
+        && encoding_is_canonical (cache, treeobj_get_blobref (o, 0)),
+        "new dir encoding matches treeobj_encode");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "dir.a", NULL);
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "dir.b", "42");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "dir.c", "43");
+    verify_value (cache, krm, KVS_PRIMARY_NAMESPACE, newroot, "dir.zz", "44");
+
+    kvstxn_mgr_clear_dir_splices (ktm);
+    ok (kvstxn_mgr_get_dir_splices (ktm) == 0,
+        "kvstxn_mgr_clear_dir_splices works");
+
+    kvstxn_mgr_destroy (ktm);
+    ktest_finalize (cache, krm);
+    json_decref (dir);
+    json_decref (root);
+}
+
 int main (int argc, char *argv[])
 {
     plan (NO_PLAN);
@@ -3577,6 +4659,7 @@ int main (int argc, char *argv[])
     kvstxn_process_follow_link_namespace ();
     kvstxn_process_dirval_test ();
     kvstxn_process_delete_test ();
+    kvstxn_process_cached_dirs_unmodified ();
     kvstxn_process_delete_nosubdir_test ();
     kvstxn_process_delete_filevalinpath_test ();
     kvstxn_process_bad_dirrefs ();
@@ -3586,6 +4669,13 @@ int main (int argc, char *argv[])
     kvstxn_process_append_errors ();
     kvstxn_process_append_no_duplicate ();
     kvstxn_process_fallback_merge ();
+    kvstxn_process_hdir ();
+    kvstxn_process_pipeline ();
+    kvstxn_process_pipeline_error ();
+    kvstxn_process_pipeline_merge ();
+    kvstxn_process_pipeline_sync ();
+    kvstxn_process_valref_compact ();
+    kvstxn_process_dir_splice ();
 
     done_testing ();
     return (0);
@@ -256,6 +256,8 @@ void basic_api (void)
         "lookup_get_root_ref fails on not-completed lookup");
     ok (lookup_get_root_seq (lh) < 0,
         "lookup_get_root_seq fails on not-completed lookup");
+    ok (lookup_get_elapsed (lh) >= 0.,
+        "lookup_get_elapsed works");
 
     lookup_destroy (lh);
 
@@ -44,3 +44,41 @@ checkpoint_backing_get() {
 	o=$(checkpoint_get_msg $1)
 	jq -j -c -n ${o} | $RPC content-backing.checkpoint-get
 }
+
+# Print the concatenated raw hash digests of blobrefs.
+# Usage: blobref_digests blobref...
+blobref_digests() {
+	flux python -c "
+import sys
+for ref in sys.argv[1:]:
+    sys.stdout.buffer.write(bytes.fromhex(ref.split('-', 1)[1]))
+" "$@"
+}
+
+# Probe for blobrefs with a content.has style request to service 'topic'.
+# Prints a string of 0 (missing) or 1 (present) digits, one per blobref.
+# Usage: content_has topic blobref...
+content_has() {
+	topic=$1; shift
+	blobref_digests "$@" | $RPC -r -R $topic | od -An -tu1 | tr -d ' \n'
+}
+
+# Print a KVS directory object containing one valref that refers to blobref.
+# Usage: dir_valref blobref
+dir_valref() {
+	printf '{"data":{"a":{"data":["%s"],"type":"valref","ver":1}},"type":"dir","ver":1}' $1
+}
+
+# Store a blob that is referenced from the kvs-primary checkpoint and one
+# that is not, directly to the backing store.
+# Leaves behind gcval.ref, gcdir.ref, and gcjunk.ref.
+# Usage: gc_setup
+gc_setup() {
+	echo gcvalue-$$ >gcval.store &&
+	flux content store --bypass-cache <gcval.store >gcval.ref &&
+	dir_valref $(cat gcval.ref) >gcdir.store &&
+	flux content store --bypass-cache <gcdir.store >gcdir.ref &&
+	echo gcjunk-$$ >gcjunk.store &&
+	flux content store --bypass-cache <gcjunk.store >gcjunk.ref &&
+	checkpoint_backing_put kvs-primary $(cat gcdir.ref)
+}
@@ -0,0 +1,149 @@
+/************************************************************\
+ * Copyright 2026 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* commitbench - measure small commit cost as the KVS grows
+ *
+ * Grow the KVS by powers of 4 up to --max-keys keys.  At each size,
+ * time --count sequential single-key commits and print the mean.
+ * Keys are spread over a three level tree with --fanout entries per
+ * directory, or placed directly in the root directory if --fanout=0.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <flux/core.h>
+#include <flux/optparse.h>
+
+#include "src/common/libutil/log.h"
+#include "src/common/libutil/monotime.h"
+
+static struct optparse_option opts[] = {
+    { .name = "max-keys", .key = 'm', .has_arg = 1, .arginfo = "N",
+      .usage = "Grow the KVS to N keys (default 262144)",
+    },
+    { .name = "count", .key = 'c', .has_arg = 1, .arginfo = "N",
+      .usage = "Time N commits at each size (default 1000)",
+    },
+    { .name = "fanout", .key = 'f', .has_arg = 1, .arginfo = "N",
+      .usage = "Directory fanout, or 0 for a flat root (default 64)",
+    },
+    OPTPARSE_TABLE_END
+};
+
+#define POPULATE_BATCH 1024
+
+static int fanout;
+
+static void populate_key (char *buf, size_t size, int i)
+{
+    if (fanout == 0)
+        snprintf (buf, size, "k%d", i);
+    else
+        snprintf (buf, size, "p%d.p%d.k%d",
+                  i / (fanout * fanout),
+                  (i / fanout) % fanout,
+                  i % fanout);
+}
+
+static void commit_wait (flux_t *h, flux_kvs_txn_t *txn)
+{
+    flux_future_t *f;
+
+    if (!(f = flux_kvs_commit (h, NULL, 0, txn))
+        || flux_future_get (f, NULL) < 0)
+        log_err_exit ("flux_kvs_commit");
+    flux_future_destroy (f);
+}
+
+/* Add keys [start, end) to the KVS.
+ */
+static void populate (flux_t *h, int start, int end)
+{
+    char key[64];
+
+    while (start < end) {
+        flux_kvs_txn_t *txn;
+
+        if (!(txn = flux_kvs_txn_create ()))
+            log_err_exit ("flux_kvs_txn_create");
+        for (int n = 0; n < POPULATE_BATCH && start < end; n++, start++) {
+            populate_key (key, sizeof (key), start);
+            if (flux_kvs_txn_pack (txn, 0, key, "i", start) < 0)
+                log_err_exit ("%s", key);
+        }
+        commit_wait (h, txn);
+        flux_kvs_txn_destroy (txn);
+    }
+}
+
+/* Return mean time in milliseconds of 'count' single-key commits.
+ */
+static double measure (flux_t *h, int count)
+{
+    struct timespec t0;
+
+    monotime (&t0);
+    for (int i = 0; i < count; i++) {
+        flux_kvs_txn_t *txn;
+
+        if (!(txn = flux_kvs_txn_create ())
+            || flux_kvs_txn_pack (txn, 0, "bench.key", "i", i) < 0)
+            log_err_exit ("error creating transaction");
+        commit_wait (h, txn);
+        flux_kvs_txn_destroy (txn);
+    }
+    return monotime_since (t0) / count;
+}
+
+int main (int argc, char *argv[])
+{
+    optparse_t *p;
+    flux_t *h;
+    int max_keys;
+    int count;
+    int keys = 0;
+
+    log_init ("commitbench");
+
+    if (!(p = optparse_create ("commitbench"))
+        || optparse_add_option_table (p, opts) != OPTPARSE_SUCCESS)
+        log_msg_exit ("error setting up option parsing");
+    if (optparse_parse_args (p, argc, argv) < 0)
+        exit (1);
+    if ((max_keys = optparse_get_int (p, "max-keys", 262144)) < 0)
+        log_msg_exit ("invalid --max-keys value");
+    if ((count = optparse_get_int (p, "count", 1000)) <= 0)
+        log_msg_exit ("invalid --count value");
+    if ((fanout = optparse_get_int (p, "fanout", 64)) < 0)
+        log_msg_exit ("invalid --fanout value");
+
+    if (!(h = flux_open (NULL, 0)))
+        log_err_exit ("flux_open");
+
+    printf ("%-10s %12s\n", "KEYS", "USEC/COMMIT");
+    for (int size = 0; size <= max_keys; size = size ? size * 4 : 1024) {
+        populate (h, keys, size);
+        keys = size;
+        printf ("%-10d %12.1f\n", keys, measure (h, count) * 1000.);
+        fflush (stdout);
+    }
+
+    flux_close (h);
+    optparse_destroy (p);
+    log_fini ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,165 @@
+/************************************************************\
+ * Copyright 2026 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* commitlatency - measure commit throughput and latency percentiles
+ *
+ * Issue --count single-key commits, keeping up to --window of them in
+ * flight at once.  Print the commit rate and the distribution of time
+ * from sending each commit to receiving its response.  With --nomerge,
+ * commits are not merged by the KVS, so each one is processed as a
+ * separate transaction.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <flux/core.h>
+#include <flux/optparse.h>
+
+#include "src/common/libutil/log.h"
+#include "src/common/libutil/monotime.h"
+
+static struct optparse_option opts[] = {
+    { .name = "count", .key = 'c', .has_arg = 1, .arginfo = "N",
+      .usage = "Issue N commits (default 10000)",
+    },
+    { .name = "window", .key = 'w', .has_arg = 1, .arginfo = "N",
+      .usage = "Keep up to N commits in flight (default 64)",
+    },
+    { .name = "nomerge", .key = 'n', .has_arg = 0,
+      .usage = "Set FLUX_KVS_NO_MERGE on each commit",
+    },
+    OPTPARSE_TABLE_END
+};
+
+static flux_t *h;
+static int count;
+static int flags;
+static int sent;
+static int received;
+static struct timespec *start;
+static double *latency;
+
+static void commit_continuation (flux_future_t *f, void *arg);
+
+static void commit_send (void)
+{
+    flux_kvs_txn_t *txn;
+    flux_future_t *f;
+    char key[64];
+    int id = sent++;
+
+    snprintf (key, sizeof (key), "latency.k%d", id % 1024);
+    if (!(txn = flux_kvs_txn_create ())
+        || flux_kvs_txn_pack (txn, 0, key, "i", id) < 0)
+        log_err_exit ("error creating transaction");
+    monotime (&start[id]);
+    if (!(f = flux_kvs_commit (h, NULL, flags, txn))
+        || flux_future_then (f, -1., commit_continuation, &start[id]) < 0)
+        log_err_exit ("flux_kvs_commit");
+    flux_kvs_txn_destroy (txn);
+}
+
+static void commit_continuation (flux_future_t *f, void *arg)
+{
+    struct timespec *t0 = arg;
+
+    if (flux_future_get (f, NULL) < 0)
+        log_err_exit ("flux_kvs_commit");
+    latency[t0 - start] = monotime_since (*t0);
+    flux_future_destroy (f);
+    if (++received == count)
+        flux_reactor_stop (flux_get_reactor (h));
+    else if (sent < count)
+        commit_send ();
+}
+
+static int cmpdouble (const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+/* Return the p'th percentile of sorted latencies in microseconds.
+ */
+static double percentile (double p)
+{
+    int i = (int)(p / 100. * count + 0.5) - 1;
+
+    if (i < 0)
+        i = 0;
+    if (i >= count)
+        i = count - 1;
+    return latency[i] * 1000.;
+}
+
+int main (int argc, char *argv[])
+{
+    optparse_t *p;
+    int window;
+    struct timespec t0;
+    double elapsed;
+
+    log_init ("commitlatency");
+
+    if (!(p = optparse_create ("commitlatency"))
+        || optparse_add_option_table (p, opts) != OPTPARSE_SUCCESS)
+        log_msg_exit ("error setting up option parsing");
+    if (optparse_parse_args (p, argc, argv) < 0)
+        exit (1);
+    if ((count = optparse_get_int (p, "count", 10000)) <= 0)
+        log_msg_exit ("invalid --count value");
+    if ((window = optparse_get_int (p, "window", 64)) <= 0)
+        log_msg_exit ("invalid --window value");
+    if (optparse_hasopt (p, "nomerge"))
+        flags |= FLUX_KVS_NO_MERGE;
+
+    if (!(start = calloc (count, sizeof (start[0])))
+        || !(latency = calloc (count, sizeof (latency[0]))))
+        log_msg_exit ("out of memory");
+    if (!(h = flux_open (NULL, 0)))
+        log_err_exit ("flux_open");
+
+    monotime (&t0);
+    while (sent < count && sent < window)
+        commit_send ();
+    if (flux_reactor_run (flux_get_reactor (h), 0) < 0)
+        log_err_exit ("flux_reactor_run");
+    elapsed = monotime_since (t0);
+    if (received != count)
+        log_msg_exit ("received %d of %d responses", received, count);
+
+    qsort (latency, count, sizeof (latency[0]), cmpdouble);
+
+    printf ("%-10s %10s %10s %10s %10s %10s  (usec)\n",
+            "COMMITS", "COMMITS/S", "P50", "P90", "P99", "MAX");
+    printf ("%-10d %10.0f %10.1f %10.1f %10.1f %10.1f\n",
+            count,
+            elapsed > 0 ? count / (elapsed / 1000.) : 0.,
+            percentile (50),
+            percentile (90),
+            percentile (99),
+            latency[count - 1] * 1000.);
+
+    flux_close (h);
+    free (latency);
+    free (start);
+    optparse_destroy (p);
+    log_fini ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
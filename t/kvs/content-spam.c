@@ -44,20 +44,24 @@ int main (int ac, char *av[])
     int i, count;
     flux_future_t *f;
     flux_t *h;
-    char data[256];
+    char *data;
     int size = 256;
     const char *s;
     char *hash_type;
 
-    if (ac != 2 && ac != 3) {
-        fprintf (stderr, "Usage: content-spam N [M]\n");
+    if (ac < 2 || ac > 4) {
+        fprintf (stderr, "Usage: content-spam N [M] [SIZE]\n");
         exit (1);
     }
     count = strtoul (av[1], NULL, 10);
-    if (ac == 3)
+    if (ac >= 3)
         spam_max_inflight = strtoul (av[2], NULL, 10);
     else
         spam_max_inflight = 1;
+    if (ac == 4)
+        size = strtoul (av[3], NULL, 10);
+    if (size < 64 || !(data = calloc (1, size)))
+        log_msg_exit ("invalid blob size");
 
     if (!(h = flux_open (NULL, 0)))
         log_err_exit ("flux_open");
@@ -82,6 +86,7 @@ int main (int ac, char *av[])
             log_err ("flux_reactor_run");
     }
     flux_close (h);
+    free (data);
     exit (0);
 }
 
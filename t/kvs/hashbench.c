@@ -0,0 +1,118 @@
+/************************************************************\
+ * Copyright 2026 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* hashbench - compare blobref hash throughput across blob sizes
+ *
+ * For each blob size, hash a total of at least --total bytes with each
+ * hash type, and each available BLAKE3 kernel, and print MB/s.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <flux/optparse.h>
+
+#include "src/common/libutil/log.h"
+#include "src/common/libutil/monotime.h"
+#include "src/common/libutil/blobref.h"
+#include "src/common/libutil/blake3.h"
+#include "src/common/libutil/parse_size.h"
+
+static struct optparse_option opts[] = {
+    { .name = "total", .key = 't', .has_arg = 1, .arginfo = "SIZE",
+      .usage = "Hash at least SIZE bytes per measurement (default 256M)",
+    },
+    { .name = "max-size", .key = 'm', .has_arg = 1, .arginfo = "SIZE",
+      .usage = "Largest blob size to measure (default 16M)",
+    },
+    OPTPARSE_TABLE_END
+};
+
+static const char *blake3_impls[] = { "portable", "sse41", "avx2", "avx512" };
+
+static double measure (const char *hashtype,
+                       const void *data,
+                       size_t size,
+                       uint64_t total)
+{
+    uint8_t hash[BLOBREF_MAX_DIGEST_SIZE];
+    uint64_t count = total / size + 1;
+    struct timespec t0;
+    double ms;
+
+    monotime (&t0);
+    for (uint64_t i = 0; i < count; i++) {
+        if (blobref_hash_raw (hashtype, data, size, hash, sizeof (hash)) < 0)
+            log_err_exit ("%s", hashtype);
+    }
+    ms = monotime_since (t0);
+    return ms > 0 ? (double)(count * size) / (ms * 1000.) : 0.;
+}
+
+int main (int argc, char *argv[])
+{
+    optparse_t *p;
+    uint64_t total;
+    uint64_t max_size;
+    uint8_t *data;
+
+    log_init ("hashbench");
+
+    if (!(p = optparse_create ("hashbench"))
+        || optparse_add_option_table (p, opts) != OPTPARSE_SUCCESS)
+        log_msg_exit ("error setting up option parsing");
+    if (optparse_parse_args (p, argc, argv) < 0)
+        exit (1);
+    if (parse_size (optparse_get_str (p, "total", "256M"), &total) < 0
+        || total == 0)
+        log_msg_exit ("invalid --total value");
+    if (parse_size (optparse_get_str (p, "max-size", "16M"), &max_size) < 0
+        || max_size == 0)
+        log_msg_exit ("invalid --max-size value");
+
+    if (!(data = malloc (max_size)))
+        log_msg_exit ("out of memory");
+    for (uint64_t i = 0; i < max_size; i++)
+        data[i] = i % 251;
+
+    printf ("%-10s", "SIZE");
+    printf (" %10s %10s", "sha1", "sha256");
+    for (int i = 0; i < sizeof (blake3_impls) / sizeof (blake3_impls[0]); i++) {
+        if (blake3_set_impl (blake3_impls[i]) == 0)
+            printf (" %10s", blake3_impls[i]);
+    }
+    printf ("  (MB/s)\n");
+
+    for (uint64_t size = 64; size <= max_size; size *= 4) {
+        printf ("%-10ju", (uintmax_t)size);
+        printf (" %10.0f", measure ("sha1", data, size, total));
+        printf (" %10.0f", measure ("sha256", data, size, total));
+        for (int i = 0;
+             i < sizeof (blake3_impls) / sizeof (blake3_impls[0]);
+             i++) {
+            if (blake3_set_impl (blake3_impls[i]) == 0)
+                printf (" %10.0f", measure ("blake3", data, size, total));
+        }
+        printf ("\n");
+        fflush (stdout);
+    }
+
+    free (data);
+    optparse_destroy (p);
+    log_fini ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
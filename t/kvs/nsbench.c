@@ -0,0 +1,167 @@
+/************************************************************\
+ * Copyright 2026 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* nsbench - measure namespace create/remove throughput
+ *
+ * Create --count namespaces, write one key to each, look it up, then
+ * remove them, keeping up to --window requests in flight at once.
+ * Repeat for --rounds rounds with fresh names, and print the rate of
+ * each phase per round.  Run on a rank other than 0, the lookup phase
+ * includes the local KVS setting up each namespace it has not seen.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <flux/core.h>
+#include <flux/optparse.h>
+
+#include "src/common/libutil/log.h"
+#include "src/common/libutil/monotime.h"
+
+static struct optparse_option opts[] = {
+    { .name = "count", .key = 'c', .has_arg = 1, .arginfo = "N",
+      .usage = "Create and remove N namespaces per round (default 1000)",
+    },
+    { .name = "window", .key = 'w', .has_arg = 1, .arginfo = "N",
+      .usage = "Keep up to N requests in flight (default 32)",
+    },
+    { .name = "rounds", .key = 'r', .has_arg = 1, .arginfo = "N",
+      .usage = "Repeat N times (default 3)",
+    },
+    OPTPARSE_TABLE_END
+};
+
+enum phase { PHASE_CREATE, PHASE_PUT, PHASE_LOOKUP, PHASE_REMOVE };
+
+static flux_t *h;
+static int count;
+static int window;
+static int round_id;
+static enum phase phase;
+static int sent;
+static int received;
+
+static void continuation (flux_future_t *f, void *arg);
+
+static void send_one (void)
+{
+    flux_future_t *f = NULL;
+    flux_kvs_txn_t *txn;
+    char ns[64];
+    int id = sent++;
+
+    snprintf (ns,
+              sizeof (ns),
+              "nsbench-%d-%d-%d",
+              (int)getpid (),
+              round_id,
+              id);
+    switch (phase) {
+        case PHASE_CREATE:
+            f = flux_kvs_namespace_create (h, ns, getuid (), 0);
+            break;
+        case PHASE_PUT:
+            if (!(txn = flux_kvs_txn_create ())
+                || flux_kvs_txn_pack (txn, 0, "key", "i", round_id) < 0)
+                log_err_exit ("error creating transaction");
+            f = flux_kvs_commit (h, ns, 0, txn);
+            flux_kvs_txn_destroy (txn);
+            break;
+        case PHASE_LOOKUP:
+            f = flux_kvs_lookup (h, ns, 0, "key");
+            break;
+        case PHASE_REMOVE:
+            f = flux_kvs_namespace_remove (h, ns);
+            break;
+    }
+    if (!f || flux_future_then (f, -1., continuation, NULL) < 0)
+        log_err_exit ("%s", ns);
+}
+
+static void continuation (flux_future_t *f, void *arg)
+{
+    if (flux_future_get (f, NULL) < 0)
+        log_err_exit ("nsbench request");
+    flux_future_destroy (f);
+    if (++received == count)
+        flux_reactor_stop (flux_get_reactor (h));
+    else if (sent < count)
+        send_one ();
+}
+
+/* Run one phase over all namespaces and return its rate per second.
+ */
+static double run_phase (enum phase p)
+{
+    struct timespec t0;
+    double elapsed;
+
+    phase = p;
+    sent = received = 0;
+    monotime (&t0);
+    while (sent < count && sent < window)
+        send_one ();
+    if (flux_reactor_run (flux_get_reactor (h), 0) < 0)
+        log_err_exit ("flux_reactor_run");
+    elapsed = monotime_since (t0);
+    if (received != count)
+        log_msg_exit ("received %d of %d responses", received, count);
+    return elapsed > 0 ? count / (elapsed / 1000.) : 0.;
+}
+
+int main (int argc, char *argv[])
+{
+    optparse_t *p;
+    int rounds;
+
+    log_init ("nsbench");
+
+    if (!(p = optparse_create ("nsbench"))
+        || optparse_add_option_table (p, opts) != OPTPARSE_SUCCESS)
+        log_msg_exit ("error setting up option parsing");
+    if (optparse_parse_args (p, argc, argv) < 0)
+        exit (1);
+    if ((count = optparse_get_int (p, "count", 1000)) <= 0)
+        log_msg_exit ("invalid --count value");
+    if ((window = optparse_get_int (p, "window", 32)) <= 0)
+        log_msg_exit ("invalid --window value");
+    if ((rounds = optparse_get_int (p, "rounds", 3)) <= 0)
+        log_msg_exit ("invalid --rounds value");
+
+    if (!(h = flux_open (NULL, 0)))
+        log_err_exit ("flux_open");
+
+    printf ("%-10s %-10s %10s %10s %10s %10s\n",
+            "ROUND", "NAMESPACES",
+            "CREATE/S", "PUT/S", "LOOKUP/S", "REMOVE/S");
+    for (round_id = 0; round_id < rounds; round_id++) {
+        double create = run_phase (PHASE_CREATE);
+        double put = run_phase (PHASE_PUT);
+        double lookup = run_phase (PHASE_LOOKUP);
+        double rm = run_phase (PHASE_REMOVE);
+
+        printf ("%-10d %-10d %10.0f %10.0f %10.0f %10.0f\n",
+                round_id, count, create, put, lookup, rm);
+        fflush (stdout);
+    }
+
+    flux_close (h);
+    optparse_destroy (p);
+    log_fini ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
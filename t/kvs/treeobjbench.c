@@ -0,0 +1,136 @@
+/************************************************************\
+ * Copyright 2026 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* treeobjbench - compare full and incremental dir encoding
+ *
+ * For each dir size, replace one entry in a copy of a dir of that many
+ * vals, then encode the copy --count times with treeobj_encode() and
+ * with treeobj_encode_update(), and print the time per encode.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <jansson.h>
+#include <flux/optparse.h>
+
+#include "src/common/libutil/log.h"
+#include "src/common/libutil/monotime.h"
+#include "src/common/libkvs/treeobj.h"
+
+static struct optparse_option opts[] = {
+    { .name = "count", .key = 'c', .has_arg = 1, .arginfo = "N",
+      .usage = "Encode each dir N times (default 100)",
+    },
+    { .name = "max-entries", .key = 'm', .has_arg = 1, .arginfo = "N",
+      .usage = "Largest dir size to measure (default 65536)",
+    },
+    OPTPARSE_TABLE_END
+};
+
+static json_t *create_dir (int entries)
+{
+    json_t *dir;
+    json_t *val;
+    char key[32];
+
+    if (!(dir = treeobj_create_dir ()))
+        log_msg_exit ("treeobj_create_dir");
+    for (int i = 0; i < entries; i++) {
+        snprintf (key, sizeof (key), "key%d", i);
+        if (!(val = treeobj_create_val (key, strlen (key)))
+            || treeobj_insert_entry (dir, key, val) < 0)
+            log_msg_exit ("error creating dir");
+        json_decref (val);
+    }
+    return dir;
+}
+
+/* Return microseconds per encode of 'dir', using treeobj_encode() if
+ * 'prev' is NULL, else treeobj_encode_update().
+ */
+static double measure (const json_t *dir,
+                       const char *prev,
+                       const json_t *prevobj,
+                       int count)
+{
+    struct timespec t0;
+    char *s;
+
+    monotime (&t0);
+    for (int i = 0; i < count; i++) {
+        if (prev)
+            s = treeobj_encode_update (prev, strlen (prev), prevobj, dir);
+        else
+            s = treeobj_encode (dir);
+        if (!s)
+            log_err_exit ("encode");
+        free (s);
+    }
+    return monotime_since (t0) * 1000. / count;
+}
+
+int main (int argc, char *argv[])
+{
+    optparse_t *p;
+    int count;
+    int max_entries;
+
+    log_init ("treeobjbench");
+
+    if (!(p = optparse_create ("treeobjbench"))
+        || optparse_add_option_table (p, opts) != OPTPARSE_SUCCESS)
+        log_msg_exit ("error setting up option parsing");
+    if (optparse_parse_args (p, argc, argv) < 0)
+        exit (1);
+    if ((count = optparse_get_int (p, "count", 100)) <= 0)
+        log_msg_exit ("invalid --count value");
+    if ((max_entries = optparse_get_int (p, "max-entries", 65536)) <= 0)
+        log_msg_exit ("invalid --max-entries value");
+
+    printf ("%-10s %10s %10s %10s  (usec)\n",
+            "ENTRIES", "BYTES", "ENCODE", "UPDATE");
+
+    for (int entries = 16; entries <= max_entries; entries *= 4) {
+        json_t *prevobj = create_dir (entries);
+        json_t *dir;
+        json_t *val;
+        char *prev;
+        double full, update;
+
+        if (!(prev = treeobj_encode (prevobj))
+            || !(dir = treeobj_copy (prevobj))
+            || !(val = treeobj_create_val ("changed", 7))
+            || treeobj_insert_entry (dir, "key1", val) < 0)
+            log_msg_exit ("error updating dir");
+        json_decref (val);
+
+        full = measure (dir, NULL, NULL, count);
+        update = measure (dir, prev, prevobj, count);
+        printf ("%-10d %10zu %10.1f %10.1f\n",
+                entries, strlen (prev), full, update);
+        fflush (stdout);
+
+        json_decref (dir);
+        json_decref (prevobj);
+        free (prev);
+    }
+
+    optparse_destroy (p);
+    log_fini ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
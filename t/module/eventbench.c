@@ -0,0 +1,145 @@
+/************************************************************\
+ * Copyright 2026 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* eventbench - measure the cost of casting an event to broker modules
+ *
+ * For each payload size, copy an event once per --modules subscriber the
+ * way module_event_send() does, --count times, then destroy the copies.
+ * Compare copies that duplicate the payload, as flux_msg_copy() used to,
+ * with copies that share it.  Print the time per cast and the payload
+ * bytes duplicated per cast.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <flux/core.h>
+#include <flux/optparse.h>
+
+#include "src/common/libutil/log.h"
+#include "src/common/libutil/monotime.h"
+#include "src/common/libutil/parse_size.h"
+
+static struct optparse_option opts[] = {
+    { .name = "modules", .key = 'n', .has_arg = 1, .arginfo = "N",
+      .usage = "Cast each event to N modules (default 16)",
+    },
+    { .name = "count", .key = 'c', .has_arg = 1, .arginfo = "N",
+      .usage = "Cast N events per payload size (default 1000)",
+    },
+    { .name = "max-size", .key = 'm', .has_arg = 1, .arginfo = "SIZE",
+      .usage = "Largest payload size to measure (default 1M)",
+    },
+    OPTPARSE_TABLE_END
+};
+
+static flux_msg_t **copies;
+static int modules;
+
+static flux_msg_t *copy_duplicate (const flux_msg_t *msg)
+{
+    flux_msg_t *cpy;
+    const void *buf;
+    size_t size;
+
+    if (!(cpy = flux_msg_copy (msg, false))
+        || flux_msg_get_payload (msg, &buf, &size) < 0
+        || flux_msg_set_payload (cpy, buf, size) < 0)
+        log_err_exit ("error copying event");
+    return cpy;
+}
+
+static flux_msg_t *copy_shared (const flux_msg_t *msg)
+{
+    flux_msg_t *cpy;
+
+    if (!(cpy = flux_msg_copy (msg, true)))
+        log_err_exit ("error copying event");
+    return cpy;
+}
+
+/* Return microseconds per cast of 'msg' to all modules with 'copy'.
+ */
+static double measure (flux_msg_t *(*copy)(const flux_msg_t *msg),
+                       const flux_msg_t *msg,
+                       int count)
+{
+    struct timespec t0;
+
+    monotime (&t0);
+    for (int i = 0; i < count; i++) {
+        for (int j = 0; j < modules; j++)
+            copies[j] = copy (msg);
+        for (int j = 0; j < modules; j++)
+            flux_msg_destroy (copies[j]);
+    }
+    return monotime_since (t0) * 1000. / count;
+}
+
+int main (int argc, char *argv[])
+{
+    optparse_t *p;
+    int count;
+    uint64_t max_size;
+    char *payload;
+
+    log_init ("eventbench");
+
+    if (!(p = optparse_create ("eventbench"))
+        || optparse_add_option_table (p, opts) != OPTPARSE_SUCCESS)
+        log_msg_exit ("error setting up option parsing");
+    if (optparse_parse_args (p, argc, argv) < 0)
+        exit (1);
+    if ((modules = optparse_get_int (p, "modules", 16)) <= 0)
+        log_msg_exit ("invalid --modules value");
+    if ((count = optparse_get_int (p, "count", 1000)) <= 0)
+        log_msg_exit ("invalid --count value");
+    if (parse_size (optparse_get_str (p, "max-size", "1M"), &max_size) < 0
+        || max_size == 0)
+        log_msg_exit ("invalid --max-size value");
+
+    if (!(copies = calloc (modules, sizeof (copies[0])))
+        || !(payload = malloc (max_size)))
+        log_msg_exit ("out of memory");
+    memset (payload, 'x', max_size);
+
+    printf ("%-10s %-10s %10s %10s %12s  (usec)\n",
+            "SIZE", "MODULES", "DUPLICATE", "SHARED", "BYTES-SAVED");
+
+    for (uint64_t size = 64; size <= max_size; size *= 4) {
+        flux_msg_t *msg;
+
+        if (!(msg = flux_msg_create (FLUX_MSGTYPE_EVENT))
+            || flux_msg_set_topic (msg, "eventbench") < 0
+            || flux_msg_set_payload (msg, payload, size) < 0)
+            log_err_exit ("error creating event");
+
+        printf ("%-10ju %-10d", (uintmax_t)size, modules);
+        printf (" %10.1f", measure (copy_duplicate, msg, count));
+        printf (" %10.1f", measure (copy_shared, msg, count));
+        printf (" %12ju\n", (uintmax_t)size * modules);
+        fflush (stdout);
+
+        flux_msg_destroy (msg);
+    }
+
+    free (payload);
+    free (copies);
+    optparse_destroy (p);
+    log_fini ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
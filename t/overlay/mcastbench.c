@@ -0,0 +1,193 @@
+/************************************************************\
+ * Copyright 2026 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* mcastbench - measure overlay event fanout throughput
+ *
+ * Bind a ROUTER socket like the overlay's child socket, connect
+ * --children DEALER peers to it over inproc, and for each payload size,
+ * send --count events to every peer.  Events are sent the way
+ * overlay_mcast_child() used to, encoding the message for each peer
+ * with the peer's route pushed, and encoded once with only the route
+ * frame sent per peer.  Print events/s for each.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zmq.h>
+#include <flux/core.h>
+#include <flux/optparse.h>
+
+#include "src/common/libutil/log.h"
+#include "src/common/libutil/monotime.h"
+#include "src/common/libutil/parse_size.h"
+#include "src/common/libzmqutil/msg_zsock.h"
+#include "src/common/libzmqutil/mpart.h"
+#include "src/common/libzmqutil/sockopt.h"
+
+static struct optparse_option opts[] = {
+    { .name = "children", .key = 'n', .has_arg = 1, .arginfo = "N",
+      .usage = "Send each event to N peers (default 16)",
+    },
+    { .name = "count", .key = 'c', .has_arg = 1, .arginfo = "N",
+      .usage = "Send N events per payload size (default 1000)",
+    },
+    { .name = "max-size", .key = 'm', .has_arg = 1, .arginfo = "SIZE",
+      .usage = "Largest payload size to measure (default 1M)",
+    },
+    OPTPARSE_TABLE_END
+};
+
+static void *router;
+static void **peers;
+static char **routes;
+static int children;
+
+/* Receive and discard one message on each peer.
+ */
+static void drain (void)
+{
+    for (int i = 0; i < children; i++) {
+        zlist_t *mpart;
+
+        if (!(mpart = mpart_recv (peers[i])))
+            log_err_exit ("error receiving on peer %d", i);
+        mpart_destroy (mpart);
+    }
+}
+
+static void send_copy (flux_msg_t *msg)
+{
+    for (int i = 0; i < children; i++) {
+        if (flux_msg_route_push (msg, routes[i]) < 0
+            || zmqutil_msg_send_ex (router, msg, true) < 0)
+            log_err_exit ("error sending to peer %d", i);
+        (void)flux_msg_route_delete_last (msg);
+    }
+}
+
+static void send_shared (flux_msg_t *msg)
+{
+    zlist_t *mpart;
+
+    if (!(mpart = zmqutil_msg_encode (msg)))
+        log_err_exit ("error encoding message");
+    for (int i = 0; i < children; i++) {
+        if (zmqutil_msg_send_routed (router, routes[i], mpart, true) < 0)
+            log_err_exit ("error sending to peer %d", i);
+    }
+    mpart_destroy (mpart);
+}
+
+/* Return events per second sent to all peers with 'send'.
+ */
+static double measure (void (*send)(flux_msg_t *msg),
+                       flux_msg_t *msg,
+                       int count)
+{
+    struct timespec t0;
+    double ms;
+
+    monotime (&t0);
+    for (int i = 0; i < count; i++) {
+        send (msg);
+        drain ();
+    }
+    ms = monotime_since (t0);
+    return ms > 0 ? count / (ms / 1000.) : 0.;
+}
+
+int main (int argc, char *argv[])
+{
+    optparse_t *p;
+    const char *uri = "inproc://mcastbench";
+    void *zctx;
+    int count;
+    uint64_t max_size;
+    char *payload;
+
+    log_init ("mcastbench");
+
+    if (!(p = optparse_create ("mcastbench"))
+        || optparse_add_option_table (p, opts) != OPTPARSE_SUCCESS)
+        log_msg_exit ("error setting up option parsing");
+    if (optparse_parse_args (p, argc, argv) < 0)
+        exit (1);
+    if ((children = optparse_get_int (p, "children", 16)) <= 0)
+        log_msg_exit ("invalid --children value");
+    if ((count = optparse_get_int (p, "count", 1000)) <= 0)
+        log_msg_exit ("invalid --count value");
+    if (parse_size (optparse_get_str (p, "max-size", "1M"), &max_size) < 0
+        || max_size == 0)
+        log_msg_exit ("invalid --max-size value");
+
+    if (!(zctx = zmq_ctx_new ()))
+        log_err_exit ("zmq_ctx_new");
+    if (!(router = zmq_socket (zctx, ZMQ_ROUTER))
+        || zsetsockopt_int (router, ZMQ_LINGER, 0) < 0
+        || zsetsockopt_int (router, ZMQ_ROUTER_MANDATORY, 1) < 0
+        || zmq_bind (router, uri) < 0)
+        log_err_exit ("error binding ROUTER socket");
+    if (!(peers = calloc (children, sizeof (peers[0])))
+        || !(routes = calloc (children, sizeof (routes[0]))))
+        log_msg_exit ("out of memory");
+    for (int i = 0; i < children; i++) {
+        if (asprintf (&routes[i], "peer%d", i) < 0)
+            log_msg_exit ("out of memory");
+        if (!(peers[i] = zmq_socket (zctx, ZMQ_DEALER))
+            || zsetsockopt_int (peers[i], ZMQ_LINGER, 0) < 0
+            || zsetsockopt_str (peers[i], ZMQ_IDENTITY, routes[i]) < 0
+            || zmq_connect (peers[i], uri) < 0)
+            log_err_exit ("error connecting DEALER socket");
+    }
+    if (!(payload = malloc (max_size)))
+        log_msg_exit ("out of memory");
+    memset (payload, 'x', max_size);
+
+    printf ("%-10s %-10s %10s %10s  (events/s)\n",
+            "SIZE", "CHILDREN", "COPY", "SHARED");
+
+    for (uint64_t size = 64; size <= max_size; size *= 4) {
+        flux_msg_t *msg;
+
+        if (!(msg = flux_msg_create (FLUX_MSGTYPE_EVENT))
+            || flux_msg_set_topic (msg, "mcastbench") < 0
+            || flux_msg_set_payload (msg, payload, size) < 0)
+            log_err_exit ("error creating event");
+        flux_msg_route_enable (msg);
+
+        printf ("%-10ju %-10d", (uintmax_t)size, children);
+        printf (" %10.0f", measure (send_copy, msg, count));
+        printf (" %10.0f\n", measure (send_shared, msg, count));
+        fflush (stdout);
+
+        flux_msg_destroy (msg);
+    }
+
+    for (int i = 0; i < children; i++) {
+        zmq_close (peers[i]);
+        free (routes[i]);
+    }
+    free (routes);
+    free (peers);
+    zmq_close (router);
+    zmq_ctx_term (zctx);
+    free (payload);
+    optparse_destroy (p);
+    log_fini ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -155,6 +155,22 @@ class TestKVS(unittest.TestCase):
         # subsequent commit works
         flux.kvs.commit(self.f)
 
+    def test_api_12_get_batch(self):
+        flux.kvs.put(self.f, "batch.a", 1)
+        flux.kvs.put(self.f, "batch.b", "two")
+        flux.kvs.put(self.f, "batch.c", {"three": 3})
+        flux.kvs.commit(self.f)
+        values = flux.kvs.get_batch(
+            self.f, ["batch.c", "batch.nokey", "batch.a", "batch.b"]
+        )
+        self.assertEqual(values, [{"three": 3}, None, 1, "two"])
+        self.assertEqual(flux.kvs.get_batch(self.f, []), [])
+
+    def test_api_13_get_batch_dir(self):
+        with self.assertRaises(OSError) as ctx:
+            flux.kvs.get_batch(self.f, ["batch.a", "batch"])
+        self.assertEqual(ctx.exception.errno, errno.EISDIR)
+
     def bad_input(self, func, *args):
         with self.assertRaises(OSError) as ctx:
             func(*args)
@@ -184,6 +200,9 @@ class TestKVS(unittest.TestCase):
     def test_bad_input_08_put_symlink(self):
         self.bad_input(flux.kvs.put_symlink, self.f, "", "")
 
+    def test_bad_input_09_get_batch(self):
+        self.bad_input(flux.kvs.get_batch, self.f, ["batch.a", ""])
+
     def test_kvsdir_01_bad_init(self):
         with self.assertRaises(ValueError):
             flux.kvs.KVSDir()
@@ -194,6 +194,9 @@ test_expect_success 'store 1K blobs from all ranks using async RPC' '
 test_expect_success 'load request with empty payload fails with EPROTO(71)' '
 	${RPC} content.load 71 </dev/null
 '
+test_expect_success 'load-batch request without streaming flag fails with EPROTO(71)' '
+	${RPC} content.load-batch 71 </dev/null
+'
 test_expect_success 'register-backing request with empty payload fails with EPROTO(71)' '
 	${RPC} content.register-backing 71 </dev/null
 '
@@ -223,11 +226,92 @@ test_expect_success 'content load with no blobrefs fails' '
 	test_must_fail flux content load </dev/null
 '
 
+test_expect_success 'reload content module on rank 1 with cache-size-limit' '
+	flux exec -r 1 flux module reload content cache-size-limit=32768
+'
+test_expect_success 'store a hot blob and 64 4K scan blobs on rank 0' '
+	dd if=/dev/urandom count=1 bs=4096 >hot.store 2>/dev/null &&
+	flux content store <hot.store >hot.ref &&
+	for i in $(seq 1 64); do \
+	    dd if=/dev/urandom count=1 bs=4096 2>/dev/null \
+	        | flux content store; \
+	done >scan.refs
+'
+test_expect_success 'load the hot blob twice on rank 1' '
+	flux exec -r 1 flux content load $(cat hot.ref) >/dev/null &&
+	flux exec -r 1 flux content load $(cat hot.ref) >/dev/null
+'
+test_expect_success 'load the scan blobs on rank 1' '
+	flux exec -r 1 flux content load $(cat scan.refs) >/dev/null &&
+	flux exec -r 1 flux module stats content >scan1.json
+'
+test_expect_success 'rank 1 cache stayed within its size limit' '
+	jq -e ".\"size-limit\" == 32768" <scan1.json &&
+	jq -e ".size <= 32768" <scan1.json &&
+	jq -e ".evictions > 0" <scan1.json
+'
+test_expect_success 'hot blob survived the scan' '
+	flux exec -r 1 flux content load $(cat hot.ref) >/dev/null &&
+	flux exec -r 1 flux module stats content >scan2.json &&
+	test $(jq .hits <scan2.json) -eq $(($(jq .hits <scan1.json)+1)) &&
+	test $(jq .misses <scan2.json) -eq $(jq .misses <scan1.json)
+'
+test_expect_success 'storing a cached blob again does not promote it' '
+	dd if=/dev/urandom count=1 bs=1024 >restore.store 2>/dev/null &&
+	flux exec -r 1 sh -c "flux content store <restore.store" >/dev/null &&
+	flux exec -r 1 flux module stats content >store1.json &&
+	flux exec -r 1 sh -c "flux content store <restore.store" >/dev/null &&
+	flux exec -r 1 flux module stats content >store2.json &&
+	test $(jq .\"frequent-size\" <store2.json) \
+	    -le $(jq .\"frequent-size\" <store1.json)
+'
 test_expect_success 'remove content module' '
 	flux exec flux module remove content
 '
 test_expect_success 'module fails to load with unknown option' '
 	test_must_fail flux module load content badopt
 '
+test_expect_success 'load content module with hash-threshold=1024' '
+	flux module load content hash-threshold=1024
+'
+test_expect_success 'content stats hashpool is null before first large store' '
+	flux module stats content | jq -e ".hashpool == null"
+'
+test_expect_success 'store small and large blobs' '
+	dd if=/dev/urandom count=1 bs=64 >hp64.store 2>/dev/null &&
+	flux content store <hp64.store >hp64.hash &&
+	dd if=/dev/urandom count=4 bs=4096 >hp16k.store 2>/dev/null &&
+	flux content store <hp16k.store >hp16k.hash
+'
+test_expect_success 'large blob was hashed by the hashpool' '
+	flux module stats content >hpstats.out &&
+	jq -e ".hashpool.threads == 2" <hpstats.out &&
+	jq -e ".hashpool.\"queue-depth\" == 0" <hpstats.out &&
+	jq -e ".hashpool.\"hash-time\".count == 1" <hpstats.out
+'
+test_expect_success 'hashpool blobref matches inline hash' '
+	$BLOBREF $HASHFUN <hp16k.store >hp16k.expected &&
+	test_cmp hp16k.expected hp16k.hash
+'
+test_expect_success 'blobs can be loaded' '
+	flux content load $(cat hp64.hash) >hp64.load &&
+	test_cmp hp64.store hp64.load &&
+	flux content load $(cat hp16k.hash) >hp16k.load &&
+	test_cmp hp16k.store hp16k.load
+'
+test_expect_success 'many concurrent large stores complete' '
+	${SPAMUTIL} 256 64 2048 >/dev/null &&
+	flux module stats content >hpstats2.out &&
+	jq -e ".hashpool.\"queue-depth\" == 0" <hpstats2.out
+'
+test_expect_success 'reload content module with hash-threads=0' '
+	flux module reload -f content hash-threads=0 hash-threshold=0 &&
+	flux content store <hp16k.store >hp16k.hash2 &&
+	test_cmp hp16k.hash hp16k.hash2 &&
+	flux module stats content | jq -e ".hashpool == null"
+'
+test_expect_success 'remove content module' '
+	flux module remove content
+'
 
 test_done
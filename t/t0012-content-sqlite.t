@@ -312,6 +312,252 @@ test_expect_success 'database survives module reload' '
 	test $(flux module stats \
 	    --type int --parse object_count content-sqlite) -eq 1
 '
+test_expect_success 'stores are committed in batches' '
+	${SPAMUTIL} 1000 200 >/dev/null &&
+	flux content flush &&
+	flux module stats content-sqlite >batchstats.out &&
+	$jq -e ".batch_size.count > 0" <batchstats.out &&
+	$jq -e ".batch_size.count == .commit_time.count" <batchstats.out &&
+	$jq -e ".batch_size.count <= .store_time.count" <batchstats.out &&
+	$jq -e ".batch_size.max <= 256" <batchstats.out
+'
+test_expect_success 'reload module with batch_window=10ms' '
+	flux module reload content-sqlite batch_window=10ms &&
+	flux module stats content-sqlite >batchwin.out &&
+	$jq -e ".config.batch_window == 0.01" <batchwin.out
+'
+test_expect_success 'stores are acknowledged after the batch window' '
+	echo batchwindow >batchwin.store &&
+	flux content store --bypass-cache <batchwin.store >batchwin.hash &&
+	flux content load --bypass-cache $(cat batchwin.hash) >batchwin.load &&
+	test_cmp batchwin.store batchwin.load &&
+	test $(flux module stats \
+	    --type int --parse batch_size.count content-sqlite) -eq 1
+'
+test_expect_success 'content-backing.has reports stored and missing blobs' '
+	echo hasprobe >has.store &&
+	flux content store --bypass-cache <has.store >has.hash &&
+	MISSING=$(echo nosuchblob | $BLOBREF $(flux getattr content.hash)) &&
+	test "$(content_has content-backing.has \
+	    $(cat has.hash) $MISSING $(cat has.hash))" = "101"
+'
+test_expect_success 'content.has reports stored and missing blobs' '
+	test "$(content_has content.has $MISSING $(cat has.hash))" = "01"
+'
+test_expect_success 'content.has works from rank 1' '
+	blobref_digests $MISSING $(cat has.hash) \
+	    | flux exec -r 1 sh -c "${RPC} -r -R content.has | od -An -tu1" \
+	    | tr -d " \n" >has.rank1 &&
+	test "$(cat has.rank1)" = "01"
+'
+test_expect_success 'content-backing.has wrong size hash fails with EPROTO' '
+	echo -n xxx >badhash &&
+	$RPC content-backing.has 71 <badhash
+'
+filter_ready() {
+	flux module stats content-sqlite | $jq -e ".filter.ready == true"
+}
+test_expect_success 'hash filter becomes ready after module reload' '
+	flux module reload content-sqlite &&
+	for i in $(seq 1 50); do filter_ready && break; sleep 0.1; done &&
+	flux module stats content-sqlite >filter.out &&
+	$jq -e ".filter.ready == true" <filter.out &&
+	$jq -e ".filter.count >= .object_count" <filter.out
+'
+test_expect_success 'content-backing.has works with hash filter' '
+	test "$(content_has content-backing.has \
+	    $(cat has.hash) $MISSING)" = "10"
+'
+test_expect_success 'content-backing.list with bad cursor fails with EPROTO' '
+	$RPC content-backing.list 71 <badhash
+'
+test_expect_success 'store referenced and unreferenced blobs' '
+	gc_setup
+'
+test_expect_success 'flux content gc removes unreferenced blobs' '
+	flux content gc >gc.out &&
+	grep "^reclaimed" gc.out &&
+	test "$(content_has content-backing.has $(cat gcval.ref) \
+	    $(cat gcdir.ref) $(cat gcjunk.ref))" = "110"
+'
+test_expect_success 'referenced blobs can still be loaded' '
+	flux content load --bypass-cache $(cat gcval.ref) >gcval.load &&
+	test_cmp gcval.store gcval.load
+'
+test_expect_success 'flux module stats reports gc statistics' '
+	flux module stats content >gcstats.out &&
+	$jq -e ".gc.runs == 1 and .gc.count >= 1" <gcstats.out &&
+	flux module stats content-sqlite >sqlstats.out &&
+	$jq -e ".removed.count == $($jq .gc.count <gcstats.out)" <sqlstats.out
+'
+test_expect_success 'a second flux content gc reclaims nothing' '
+	flux content gc >gc2.out &&
+	grep "^reclaimed 0 blobs" gc2.out
+'
+test_expect_success 'create scripts for a rate limited gc instance' '
+	cat >rc1-gc <<-EOT &&
+	#!/bin/sh -e
+	flux module load content gc-period=0.5s gc-rate=50
+	flux module load content-sqlite
+	flux module load kvs
+	EOT
+	cat >rc3-gc <<-EOT &&
+	#!/bin/sh -e
+	flux module remove kvs
+	flux module remove content-sqlite
+	flux module remove content
+	EOT
+	cat >gc-relink.sh <<-"EOT" &&
+	#!/bin/sh -e
+	gc_runs() {
+	    flux module stats content | jq .gc.runs
+	}
+	gc_idle() {
+	    flux module stats content | jq -e ".gc.state == \"idle\"" >/dev/null
+	}
+	seq 1 1000 >relink.val
+	# enough directories that marking takes a couple of seconds at gc-rate
+	flux kvs put $(seq 1 100 | sed "s|.*|dir&.a=&|")
+	flux kvs put --raw relink=- <relink.val
+	flux kvs unlink relink
+	flux content flush
+	# re-link the value during a collection that started after it was
+	# unlinked, with the value blob still in the kvs cache so that it is
+	# not stored again
+	while ! gc_idle; do sleep 0.05; done
+	while gc_idle; do sleep 0.05; done
+	runs=$(gc_runs)
+	flux kvs put --raw relink=- <relink.val
+	flux content flush
+	flux content dropcache
+	while test $(gc_runs) -eq $runs; do sleep 0.1; done
+	flux kvs dropcache
+	flux content dropcache
+	flux kvs get --raw relink >relink.out
+	cmp relink.val relink.out
+	EOT
+	chmod +x rc1-gc rc3-gc gc-relink.sh
+'
+test_expect_success 'a value re-linked during a rate limited gc is kept' '
+	flux start -Sbroker.rc1_path=$(pwd)/rc1-gc \
+	    -Sbroker.rc3_path=$(pwd)/rc3-gc \
+	    ./gc-relink.sh
+'
+test_expect_success 'create scripts for gc races' '
+	cat >gc-common.sh <<-"EOT" &&
+	. $CONTENT_HELPER
+	gc_runs() {
+	    flux module stats content | jq .gc.runs
+	}
+	gc_idle() {
+	    flux module stats content | jq -e ".gc.state == \"idle\"" >/dev/null
+	}
+	# wait for a collection to start
+	gc_wait_start() {
+	    while ! gc_idle; do sleep 0.05; done
+	    while gc_idle; do sleep 0.05; done
+	}
+	# wait for the collection in progress to finish
+	gc_wait_finish() {
+	    runs=$(gc_runs)
+	    while test $(gc_runs) -eq $runs; do sleep 0.1; done
+	}
+	# enough directories that marking takes a couple of seconds at gc-rate
+	flux kvs put $(seq 1 100 | sed "s|.*|dir&.a=&|")
+	EOT
+	cat >gc-has.sh <<-"EOT" &&
+	#!/bin/sh -e
+	. ./gc-common.sh
+	echo gchas >gchas.store
+	flux content store --bypass-cache <gchas.store >gchas.ref
+	echo gcjunk >gcjunk.store
+	flux content store --bypass-cache <gcjunk.store >gcjunk.ref
+	# a blob reported present during a collection may be linked by the
+	# requestor without being stored again, so it must be kept
+	while true; do
+	    # query while marking, before the blob could have been swept
+	    while ! flux module stats content \
+	        | jq -e ".gc.state == \"mark\"" >/dev/null; do
+	        sleep 0.05
+	    done
+	    runs=$(gc_runs)
+	    has=$(content_has content.has $(cat gchas.ref))
+	    # retry if the collection ended before the query was handled
+	    if ! gc_idle && test $(gc_runs) -eq $runs; then break; fi
+	done
+	test "$has" = "1"
+	# check before the next collection, which may sweep it again
+	while test $(gc_runs) -eq $runs; do sleep 0.1; done
+	test "$(content_has content-backing.has \
+	    $(cat gchas.ref) $(cat gcjunk.ref))" = "10"
+	flux kvs put --treeobj \
+	    gchas="{\"data\":[\"$(cat gchas.ref)\"],\"type\":\"valref\",\"ver\":1}"
+	flux kvs get --raw gchas >gchas.out
+	cmp gchas.store gchas.out
+	EOT
+	cat >gc-restore.sh <<-"EOT" &&
+	#!/bin/sh -e
+	. ./gc-common.sh
+	flux kvs put $(seq 1 50 | sed "s|.*|restore.dir&.a=&|")
+	flux dump gc-restore.tar
+	flux kvs unlink -R restore
+	flux content flush
+	flux kvs dropcache
+	flux content dropcache
+	# restore finds the unlinked blobs present and links them again
+	gc_wait_start
+	flux restore --key=restored gc-restore.tar
+	gc_wait_finish
+	flux kvs dropcache
+	flux content dropcache
+	flux kvs get restored.restore.dir50.a
+	flux kvs dir -R restored >/dev/null
+	EOT
+	cat >gc-relink-swept.sh <<-"EOT" &&
+	#!/bin/sh -e
+	. ./gc-common.sh
+	seq 1 1000 >swept.val
+	flux kvs put --raw swept=- <swept.val
+	flux kvs get --treeobj swept | jq -r .data[0] >swept.ref
+	flux kvs unlink swept
+	flux content flush
+	flux content dropcache
+	# let a collection remove the value while it is in the kvs cache
+	gc_wait_start
+	gc_wait_finish
+	test "$(content_has content-backing.has $(cat swept.ref))" = "0"
+	flux kvs put --raw swept=- <swept.val
+	flux content flush
+	flux kvs dropcache
+	flux content dropcache
+	flux kvs get --raw swept >swept.out
+	cmp swept.val swept.out
+	EOT
+	chmod +x gc-has.sh gc-restore.sh gc-relink-swept.sh
+'
+test_expect_success 'a blob queried with content.has during gc is kept' '
+	CONTENT_HELPER=$SHARNESS_TEST_SRCDIR/content/content-helper.sh \
+	    RPC=$RPC flux start -Sbroker.rc1_path=$(pwd)/rc1-gc \
+	    -Sbroker.rc3_path=$(pwd)/rc3-gc \
+	    ./gc-has.sh
+'
+test_expect_success 'flux restore of unlinked content during gc works' '
+	CONTENT_HELPER=$SHARNESS_TEST_SRCDIR/content/content-helper.sh \
+	    RPC=$RPC flux start -Sbroker.rc1_path=$(pwd)/rc1-gc \
+	    -Sbroker.rc3_path=$(pwd)/rc3-gc \
+	    ./gc-restore.sh
+'
+test_expect_success 'a value removed by gc is stored again when re-linked' '
+	CONTENT_HELPER=$SHARNESS_TEST_SRCDIR/content/content-helper.sh \
+	    RPC=$RPC flux start -Sbroker.rc1_path=$(pwd)/rc1-gc \
+	    -Sbroker.rc3_path=$(pwd)/rc3-gc \
+	    ./gc-relink-swept.sh
+'
+test_expect_success 'reload module with invalid batch_window fails' '
+	flux module remove content-sqlite &&
+	test_must_fail flux module load content-sqlite batch_window=foo &&
+	flux module load content-sqlite
+'
 test_expect_success 'reload module with bad option' '
 	flux module remove content-sqlite &&
 	test_must_fail flux module load content-sqlite unknown=42
@@ -455,6 +701,11 @@ test_expect_success 'remove content-sqlite module on rank 0' '
 	flux module remove content-sqlite
 '
 
+test_expect_success 'flux content gc fails without a backing store' '
+	test_must_fail flux content gc 2>gc.err &&
+	grep "backing store is not active" gc.err
+'
+
 test_expect_success 'remove content module' '
 	flux exec flux module remove content
 '
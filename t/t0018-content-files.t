@@ -296,6 +296,99 @@ test_expect_success 'flux module stats content-files is open to guests' '
 	    flux module stats content-files >/dev/null
 '
 
+##
+# Tests of packfile mode
+##
+
+test_expect_success 'content-files module load fails with bad segment-size' '
+	flux content flush &&
+	flux module remove content-files &&
+	test_must_fail flux module load content-files pack segment-size=0 &&
+	test_must_fail flux module load content-files pack segment-size=foo
+'
+test_expect_success 'load content-files module in pack mode' '
+	flux module load content-files testing pack segment-size=1M
+'
+test_expect_success 'store/load/verify various size small blobs in pack mode' '
+	err=0 &&
+	for size in $SIZES; do \
+		if ! check_blob $size; then err=$(($err+1)); fi; \
+	done &&
+	test $err -eq 0
+'
+test_expect_success 'blobs were stored in pack segments' '
+	ls content.files/pack/*.pack >segments.out &&
+	test $(wc -l <segments.out) -gt 1
+'
+test_expect_success 'flux module stats reports pack statistics' '
+	flux module stats content-files >packstats.json &&
+	jq -e ".pack.segment_count > 1" <packstats.json &&
+	jq -e ".object_count == $(echo $SIZES | wc -w)" <packstats.json
+'
+test_expect_success 'reload content-files module in pack mode' '
+	flux module reload content-files testing pack segment-size=1M
+'
+test_expect_success 'reload/verify various size small blobs in pack mode' '
+	err=0 &&
+	for size in $SIZES; do \
+		if ! recheck_blob $size; then err=$(($err+1)); fi; \
+	done &&
+	test $err -eq 0
+'
+test_expect_success 'load of unknown blob fails with ENOENT in pack mode' '
+	dd if=/dev/zero bs=20 count=1 2>/dev/null >zerohash &&
+	test_must_fail backing_load <zerohash 2>nohash.err &&
+	grep "No such file or directory" nohash.err
+'
+test_expect_success 'content-backing.has works in pack mode' '
+	cat hash.0 zerohash hash.1024 >hashes.pack &&
+	$RPC content-backing.has <hashes.pack | od -An -tu1 | tr -d " \n" \
+	    >has.pack &&
+	test "$(cat has.pack)" = "101"
+'
+test_expect_success 'flux content gc removes unreferenced blobs in pack mode' '
+	flux module reload content-files pack segment-size=1M &&
+	gc_setup &&
+	flux content gc >gc.pack &&
+	grep "^reclaimed" gc.pack &&
+	test "$(content_has content-backing.has $(cat gcval.ref) \
+	    $(cat gcdir.ref) $(cat gcjunk.ref))" = "110" &&
+	$RPC content-backing.has <hash.1024 | od -An -tu1 | tr -d " \n" \
+	    >gchas.pack &&
+	test "$(cat gchas.pack)" = "0"
+'
+test_expect_success 'reload content-files module without pack mode' '
+	flux module reload content-files
+'
+test_expect_success 'content-backing.has works in file mode' '
+	backing_store <blob.0 >/dev/null &&
+	backing_store <blob.1024 >/dev/null &&
+	$RPC content-backing.has <hashes.pack | od -An -tu1 | tr -d " \n" \
+	    >has.files &&
+	test "$(cat has.files)" = "101"
+'
+test_expect_success 'content-backing.has with bad payload fails with EPROTO' '
+	echo -n xxx >badhash &&
+	$RPC content-backing.has 71 <badhash
+'
+test_expect_success 'flux content gc removes unreferenced blobs in file mode' '
+	gc_setup &&
+	flux content gc >gc.files &&
+	grep "^reclaimed" gc.files &&
+	test "$(content_has content-backing.has $(cat gcval.ref) \
+	    $(cat gcdir.ref) $(cat gcjunk.ref))" = "110" &&
+	$RPC content-backing.has <hash.1024 | od -An -tu1 | tr -d " \n" \
+	    >gchas.files &&
+	test "$(cat gchas.files)" = "0"
+'
+test_expect_success 'checkpoints survive flux content gc in file mode' '
+	checkpoint_backing_get foo | jq -r .value | jq -r .rootref >gcfoo.out &&
+	test -s gcfoo.out
+'
+test_expect_success 'content-backing.list with bad cursor fails with EPROTO' '
+	$RPC content-backing.list 71 <badhash
+'
+
 test_expect_success 'remove content-files module on rank 0' '
        flux content flush &&
        flux module remove content-files
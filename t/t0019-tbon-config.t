@@ -15,6 +15,106 @@ test_expect_success 'flux-start with size 2 works with tbon.zmqdebug' '
 test_expect_success 'flux-start with non-integer tbon.zmqdebug fails' '
 	test_must_fail flux start ${ARGS} -Stbon.zmqdebug=foo true
 '
+test_expect_success 'flux-start with size 4 works with tbon.batch' '
+	flux start ${ARGS} -Stbon.batch=1 -Stbon.fanout=2 -s4 \
+		flux exec -r all flux getattr rank >batch.out &&
+	test $(wc -l <batch.out) -eq 4
+'
+test_expect_success 'create ping flood script' '
+	cat >pingflood.py <<-EOF &&
+	import sys
+	import flux
+
+	# usage: pingflood.py COUNT SIZE[,SIZE...] RANK
+	# Send COUNT pings to rank 0 without waiting, cycling through the
+	# pad sizes, check every response, then print the overlay stats of
+	# RANK, which relays the pings.
+	h = flux.Flux()
+	count = int(sys.argv[1])
+	sizes = [int(size) for size in sys.argv[2].split(",")]
+	rank = int(sys.argv[3])
+	pings = []
+	for seq in range(count):
+	    pad = "x" * sizes[seq % len(sizes)]
+	    payload = {"seq": seq, "pad": pad}
+	    pings.append((seq, pad, h.rpc("broker.ping", payload, nodeid=0)))
+	# Release each future once checked: a waited-on future keeps its own
+	# reactor, and a thousand of them overwhelm libev in the client.
+	while pings:
+	    seq, pad, f = pings.pop(0)
+	    resp = f.get()
+	    if resp["seq"] != seq or resp["pad"] != pad:
+	        sys.exit(f"ping {seq} returned the wrong payload")
+	print(h.rpc("overlay.stats-get", nodeid=rank).get_str())
+	EOF
+	cat >batch-even.sh <<-EOF &&
+	#!/bin/sh
+	# flux start --wrap script: enable tbon.batch on even ranks only
+	broker=\$1
+	shift
+	test \$((\${PMI_RANK:-0} % 2)) -eq 0 && set -- -Stbon.batch=1 "\$@"
+	exec \$broker "\$@"
+	EOF
+	chmod +x batch-even.sh
+'
+# A broker handles one message from a client per reactor iteration, so
+# batches are formed by brokers that relay messages from a busy link.
+# With -Stbon.fanout=2, rank 1 relays between rank 3 and rank 0.
+test_expect_success 'messages are batched with tbon.batch' '
+	flux start ${ARGS} -Stbon.batch=1 -Stbon.fanout=2 -s4 \
+		flux exec -r 3 flux python ./pingflood.py 1024 64 1 \
+		>batchstats.out &&
+	jq -e ".\"batch-count\" > 0 and .\"batch-msg-count\" >= 2 * .\"batch-count\"" \
+		<batchstats.out
+'
+test_expect_success 'large messages interleaved with batched ones arrive intact' '
+	flux start ${ARGS} -Stbon.batch=1 -Stbon.fanout=2 -s4 \
+		flux exec -r 3 flux python ./pingflood.py 1024 64,65536 1 \
+		>batchstats2.out &&
+	jq -e ".\"batch-count\" > 0" <batchstats2.out
+'
+test_expect_success 'batches are compressed with tbon.batch and tbon.compress' '
+	flux start ${ARGS} -Stbon.batch=1 -Stbon.compress=1024 \
+		-Stbon.fanout=2 -s4 \
+		flux exec -r 3 flux python ./pingflood.py 1024 512 1 \
+		>batchstats3.out &&
+	jq -e ".\"batch-count\" > 0" <batchstats3.out &&
+	jq -e ".compress | map(select(.rank == 0 and .count > 0)) | length == 1" \
+		<batchstats3.out
+'
+# With -Stbon.fanout=2 -s6, odd rank 1 relays between rank 3 and rank 0,
+# and even rank 2 relays between rank 5 and rank 0.  Pings from rank 5
+# are batched by rank 2 on its link to rank 0 only.
+test_expect_success 'tbon.batch is used only on links where both ends set it' '
+	flux start ${ARGS} -s6 -Stbon.fanout=2 --wrap=$(pwd)/batch-even.sh \
+		sh -c "flux exec -r 3 flux python ./pingflood.py 1024 64 1 \
+		    >mixed1.out \
+		    && flux exec -r 5 flux python ./pingflood.py 1024 64 2 \
+		    >mixed2.out \
+		    && flux exec -r 5 flux python ./pingflood.py 1 64 5 \
+		    >mixed5.out" &&
+	jq -e ".\"batch-count\" == 0" <mixed1.out &&
+	jq -e ".\"batch-count\" > 0" <mixed2.out &&
+	jq -e ".\"batch-count\" == 0" <mixed5.out
+'
+test_expect_success 'flux-start with tbon.batch=2 fails' '
+	test_must_fail flux start ${ARGS} -Stbon.batch=2 true
+'
+test_expect_success 'large payloads are compressed with tbon.compress' '
+	flux start ${ARGS} -Stbon.compress=1024 -s2 \
+		flux exec -r 1 flux python -c "import flux; h = flux.Flux(); h.rpc(\"broker.ping\", {\"pad\": \"x\" * 65536}, nodeid=0).get(); print(h.rpc(\"overlay.stats-get\").get_str())" >compress.out &&
+	jq -e ".compress[0].rank == 0 and .compress[0].count > 0 and .compress[0].ratio > 1" \
+		<compress.out
+'
+test_expect_success 'events are compressed with tbon.compress' '
+	flux start ${ARGS} -Stbon.compress=1024 -s2 \
+		flux exec -r 1 flux python -c "import flux; h = flux.Flux(); h.event_subscribe(\"test.big\"); h.event_send(\"test.big\", {\"pad\": \"x\" * 65536}); assert h.event_recv().payload[\"pad\"] == \"x\" * 65536; print(h.rpc(\"overlay.stats-get\", nodeid=0).get_str())" >evcompress.out &&
+	jq -e ".compress[0].rank == 1 and .compress[0].count > 0" \
+		<evcompress.out
+'
+test_expect_success 'flux-start with negative tbon.compress fails' '
+	test_must_fail flux start ${ARGS} -Stbon.compress=-1 true
+'
 test_expect_success 'tbon.endpoint can be read' '
 	ATTR_VAL=`flux start ${ARGS} -s2 flux getattr tbon.endpoint` &&
 	echo $ATTR_VAL | grep "://"
@@ -117,6 +117,49 @@ true
 EOF
 	test_cmp expected output
 '
+test_expect_success 'kvs: get (multiple) with label' '
+	flux kvs get --label $KEY.c $KEY.a >output &&
+	cat >expected <<EOF &&
+$KEY.c=foo
+$KEY.a=42
+EOF
+	test_cmp expected output
+'
+test_expect_success 'kvs: get (multiple) with repeated key' '
+	flux kvs get $KEY.a $KEY.c $KEY.a >output &&
+	cat >expected <<EOF &&
+42
+foo
+42
+EOF
+	test_cmp expected output
+'
+test_expect_success 'kvs: get (multiple) fails on missing key after output' '
+	test_must_fail flux kvs get $KEY.a $KEY.nokey $KEY.c >output 2>err &&
+	echo 42 >expected &&
+	test_cmp expected output &&
+	grep "$KEY.nokey: No such file or directory" err
+'
+test_expect_success 'kvs: get (multiple) fails on directory' '
+	test_must_fail flux kvs get $KEY.a $KEY 2>err &&
+	grep "$KEY: Is a directory" err
+'
+test_expect_success 'kvs: get (multiple) works on rank 1' '
+	flux exec -r 1 sh -c "flux kvs wait $(flux kvs version) && \
+	    flux kvs get $KEY.f $KEY.e" >output &&
+	cat >expected <<EOF &&
+{"a":42}
+[1,3,5]
+EOF
+	test_cmp expected output
+'
+test_expect_success 'kvs: get (multiple) of many keys works' '
+	flux kvs put $(seq 1 500 | sed "s/.*/$DIR.batch.k&=&/") &&
+	flux kvs get $(seq 1 500 | sed "s/.*/$DIR.batch.k&/") >output &&
+	seq 1 500 >expected &&
+	test_cmp expected output &&
+	flux kvs unlink -R $DIR.batch
+'
 test_expect_success 'kvs: unlink (multiple)' '
 	flux kvs unlink $KEY.a $KEY.b $KEY.c $KEY.d $KEY.e $KEY.f &&
           test_must_fail flux kvs get $KEY.a &&
@@ -1254,6 +1297,13 @@ test_expect_success 'lookup request with empty payload fails with EPROTO(71)' '
 test_expect_success 'lookup-plus request with empty payload fails with EPROTO(71)' '
 	${RPC} kvs.lookup-plus 71 </dev/null
 '
+test_expect_success 'lookup-batch request with empty payload fails with EPROTO(71)' '
+	${RPC} kvs.lookup-batch 71 </dev/null
+'
+test_expect_success 'non-streaming lookup-batch request fails with EPROTO(71)' '
+	echo "{\"keys\":[\"a\"], \"flags\":0, \"namespace\":\"primary\"}" \
+	    | ${RPC} kvs.lookup-batch 71
+'
 test_expect_success 'commit request with empty payload fails with EPROTO(71)' '
 	${RPC} kvs.commit 71 </dev/null
 '
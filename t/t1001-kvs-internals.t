@@ -512,6 +512,17 @@ test_expect_success 'kvs: clear stats locally' '
 	flux module stats --parse "namespace.primary.#no-op stores" kvs | grep -q 0
 '
 
+test_expect_success 'kvs: updates to cached dirs are spliced' '
+	flux kvs put $DIR.splice.a=1 $DIR.splice.b=2 &&
+	flux module stats -c kvs &&
+	flux kvs put $DIR.splice.a=3 &&
+	test $(flux module stats --parse "namespace.primary.#dir splices" kvs) -gt 1 &&
+	test $(flux kvs get $DIR.splice.a) = 3 &&
+	test $(flux kvs get $DIR.splice.b) = 2 &&
+	flux module stats -c kvs &&
+	test $(flux module stats --parse "namespace.primary.#dir splices" kvs) -eq 0
+'
+
 test_expect_success 'kvs: clear of transaction stats works' '
         commitdata=$(flux module stats -p transaction-opcount.commit kvs) &&
         echo $commitdata | jq -e ".count == 0" &&
@@ -521,6 +532,30 @@ test_expect_success 'kvs: clear of transaction stats works' '
         echo $commitdata | jq -e ".stddev == 0.0"
 '
 
+test_expect_success 'kvs: commit and lookup latency histograms are reported' '
+	flux module stats -c kvs &&
+	flux kvs put $DIR.hist1=1 &&
+	flux kvs put $DIR.hist2=2 &&
+	flux kvs get $DIR.hist1 &&
+	flux kvs get $DIR.hist2 &&
+	flux module stats -p "namespace.primary" kvs >hist.json &&
+	jq -e ".\"commit latency (usec)\".count >= 3" hist.json &&
+	jq -e ".\"commit latency (usec)\" | .p50 <= .p99 and .p99 <= .max" \
+	    hist.json &&
+	jq -e ".\"commit store stall (usec)\".count >= 3" hist.json &&
+	jq -e ".\"commit sync stall (usec)\".max == 0" hist.json &&
+	jq -e ".\"commit merged transactions\".p50 >= 1" hist.json &&
+	jq -e ".\"lookup latency (usec)\".count >= 2" hist.json
+'
+
+test_expect_success 'kvs: clear of latency histograms works' '
+	flux module stats -c kvs &&
+	flux module stats -p "namespace.primary" kvs >hist-clear.json &&
+	jq -e ".\"commit latency (usec)\".count == 0" hist-clear.json &&
+	jq -e ".\"commit latency (usec)\".max == 0" hist-clear.json &&
+	jq -e ".\"lookup latency (usec)\".count == 0" hist-clear.json
+'
+
 test_expect_success NO_ASAN 'kvs: clear stats globally' '
 	flux kvs unlink -Rf $DIR &&
 	flux module stats -C kvs &&
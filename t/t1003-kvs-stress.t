@@ -72,6 +72,23 @@ test_expect_success 'kvs: 8 threads/rank each doing 100 put,commits in a loop, m
 		$(basename ${SHARNESS_TEST_FILE})
 '
 
+test_expect_success 'kvs: commitbench runs on a growing KVS' '
+	${FLUX_BUILD_DIR}/t/kvs/commitbench --max-keys 4096 --count 10 \
+		--fanout 16 >commitbench.out &&
+	test $(wc -l <commitbench.out) -eq 4
+'
+
+test_expect_success 'kvs: commitlatency reports pipelined commit latency' '
+	${FLUX_BUILD_DIR}/t/kvs/commitlatency --count 1000 --window 32 \
+		--nomerge >commitlatency.out &&
+	test $(wc -l <commitlatency.out) -eq 2
+'
+
+test_expect_success 'kvs: nsbench reports namespace create/remove rate' '
+	${FLUX_BUILD_DIR}/t/kvs/nsbench --count 100 --rounds 2 >nsbench.out &&
+	test $(wc -l <nsbench.out) -eq 3
+'
+
 # large dirs
 
 test_expect_success 'kvs: store 10,000 keys in one dir' '
@@ -100,6 +117,19 @@ test_expect_success 'kvs: transaction-merge disabling works' '
 	test "$OUTPUT" = "${THREADS}"
 '
 
+# transaction-pipeline option test
+test_expect_success 'kvs: transaction-pipeline rejects bad values' '
+	flux module remove kvs &&
+	test_must_fail flux module load kvs transaction-pipeline=0 &&
+	test_must_fail flux module load kvs transaction-pipeline=foo &&
+	flux module load kvs transaction-merge=0 transaction-pipeline=1
+'
+test_expect_success 'kvs: commitlatency works with pipelining disabled' '
+	${FLUX_BUILD_DIR}/t/kvs/commitlatency --count 1000 --window 32 \
+		>commitlatency-nopipeline.out &&
+	test $(wc -l <commitlatency-nopipeline.out) -eq 2
+'
+
 #
 # ensure no lingering pending requests
 #
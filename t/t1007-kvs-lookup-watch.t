@@ -46,6 +46,31 @@ test_expect_success NO_CHAIN_LINT 'kvs-watch stats reports active watcher' '
        wait $pid
 '
 
+test_expect_success NO_CHAIN_LINT 'kvs-watch shares lookups between watchers of a key' '
+	flux kvs put test.shared=0 &&
+	lookups=$(flux module stats --parse=lookups kvs-watch) &&
+	shared=$(flux module stats --parse=shared-lookups kvs-watch) &&
+	pids="" &&
+	for i in 1 2 3 4; do
+		flux kvs get --watch --count=2 test.shared >shared$i.out &
+		pids="$pids $!"
+	done &&
+	for i in 1 2 3 4; do
+		$waitfile --count=1 --timeout=10 --pattern="0" shared$i.out \
+		    || return 1
+	done &&
+	flux kvs put test.shared=1 &&
+	for pid in $pids; do
+		wait $pid || return 1
+	done &&
+	printf "0\n1\n" >shared.exp &&
+	for i in 1 2 3 4; do
+		test_cmp shared.exp shared$i.out || return 1
+	done &&
+	test $(flux module stats --parse=lookups kvs-watch) -eq $((lookups + 5)) &&
+	test $(flux module stats --parse=shared-lookups kvs-watch) -eq $((shared + 3))
+'
+
 # Check that stdin contains an integer on each line that
 # is one more than the integer on the previous line.
 test_monotonicity() {
@@ -436,6 +461,112 @@ test_expect_success NO_CHAIN_LINT 'flux kvs get: --append fails on fake append (
         test_must_fail wait $pid
 '
 
+test_expect_success NO_CHAIN_LINT 'flux kvs get: --append values are sent from setroot event' '
+        flux kvs unlink -Rf test &&
+        flux kvs put test.append.test="abc" &&
+        before=$(flux module stats --parse=inline-appends kvs-watch) &&
+        flux kvs get --watch --append --count=4 \
+                     test.append.test > append8.out 2>&1 &
+        pid=$! &&
+        $waitfile --count=1 --timeout=10 --pattern="abc" append8.out &&
+        flux kvs put --append test.append.test="d" &&
+        flux kvs put --append test.append.test="e" test.append.test="f" &&
+        wait $pid &&
+	cat >expected <<-EOF &&
+abc
+d
+e
+f
+	EOF
+        test_cmp expected append8.out &&
+        after=$(flux module stats --parse=inline-appends kvs-watch) &&
+        test $after -eq $((before + 3))
+'
+
+test_expect_success 'kvs module fails to load with bad setroot-inline-max' '
+        flux module remove kvs-watch &&
+        flux module remove kvs &&
+        test_must_fail flux module load kvs setroot-inline-max=-1 &&
+        test_must_fail flux module load kvs setroot-inline-max=foo &&
+        flux module load kvs setroot-inline-max=0 &&
+        flux module load kvs-watch
+'
+
+test_expect_success NO_CHAIN_LINT 'flux kvs get: --append works with setroot-inline-max=0' '
+        flux kvs unlink -Rf test &&
+        flux kvs put test.append.test="abc" &&
+        flux kvs get --watch --append --count=4 \
+                     test.append.test > append9.out 2>&1 &
+        pid=$! &&
+        $waitfile --count=1 --timeout=10 --pattern="abc" append9.out &&
+        flux kvs put --append test.append.test="d" &&
+        flux kvs put --append test.append.test="e" test.append.test="f" &&
+        wait $pid &&
+	cat >expected <<-EOF &&
+abc
+d
+e
+f
+	EOF
+        test_cmp expected append9.out &&
+        count=$(flux module stats --parse=inline-appends kvs-watch) &&
+        test $count -eq 0
+'
+
+test_expect_success 'reload kvs with default setroot-inline-max' '
+        flux module remove kvs-watch &&
+        flux module reload kvs &&
+        flux module load kvs-watch
+'
+
+test_expect_success 'kvs module fails to load with bad valref-compact' '
+        flux module remove kvs-watch &&
+        flux module remove kvs &&
+        test_must_fail flux module load kvs valref-compact=foo &&
+        test_must_fail flux module load kvs valref-compact=-1 &&
+        test_must_fail flux module load kvs valref-compact=1
+'
+
+test_expect_success 'load kvs with valref-compact=2 and no setroot inlining' '
+        flux module load kvs valref-compact=2 setroot-inline-max=0 &&
+        flux module load kvs-watch
+'
+
+test_expect_success NO_CHAIN_LINT 'flux kvs get: --append works across valref compaction' '
+        flux kvs unlink -Rf test &&
+        flux kvs put test.append.test="a" &&
+        flux kvs get --watch --append --count=8 \
+                     test.append.test > append10.out 2>&1 &
+        pid=$! &&
+        $waitfile --count=1 --timeout=10 --pattern="^a$" append10.out &&
+        for i in b c d e f g h; do
+                flux kvs put --append test.append.test=$i &&
+                $waitfile --count=1 --timeout=10 --pattern="^$i$" \
+                    append10.out || return 1
+        done &&
+        wait $pid &&
+        printf "%s\n" a b c d e f g h >expected &&
+        test_cmp expected append10.out
+'
+
+test_expect_success 'valref was compacted and its value is unchanged' '
+        test "$(flux kvs get test.append.test)" = "abcdefgh" &&
+        test $(flux kvs get --treeobj test.append.test \
+               | jq ".data | length") -lt 8 &&
+        compactions=$(flux module stats \
+                      --parse "namespace.primary.#valref compactions" kvs) &&
+        saved=$(flux module stats \
+                --parse "namespace.primary.#valref blobs saved" kvs) &&
+        test $compactions -gt 0 &&
+        test $saved -ge $compactions
+'
+
+test_expect_success 'reload kvs with default valref-compact' '
+        flux module remove kvs-watch &&
+        flux module reload kvs &&
+        flux module load kvs-watch
+'
+
 # full checks
 
 # in full checks, we create a directory that we will use to
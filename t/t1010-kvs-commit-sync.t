@@ -46,6 +46,32 @@ test_expect_success 'kvs: checkpoint of kvs-primary should match rootref' '
         test_cmp syncblob.out checkpoint.out
 '
 
+test_expect_success 'kvs: sync stall time is reported in stats' '
+        flux module stats -p "namespace.primary" kvs >stats.json &&
+        jq -e ".\"commit sync stall (usec)\".max > 0" stats.json &&
+        jq -e ".\"commit stalls\".max >= 2" stats.json
+'
+
+test_expect_success 'kvs: concurrent sync commits all succeed' '
+        pids="" &&
+        for i in $(seq 1 8); do
+            flux kvs put --sync group.$i=$i &
+            pids="$pids $!"
+        done &&
+        for pid in $pids; do
+            wait $pid || return 1
+        done &&
+        for i in $(seq 1 8); do
+            test $(flux kvs get group.$i) = $i || return 1
+        done
+'
+
+test_expect_success 'kvs: checkpoint of kvs-primary covers all sync commits' '
+        flux kvs getroot --blobref > root.out &&
+        checkpoint_get kvs-primary | jq -r .value.rootref > checkpoint2.out &&
+        test_cmp root.out checkpoint2.out
+'
+
 test_expect_success 'kvs: sync fails against non-primary namespace' '
         flux kvs namespace create ${TESTNAMESPACE} &&
         flux kvs put --namespace=${TESTNAMESPACE} a=10 &&
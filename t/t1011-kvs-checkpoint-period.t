@@ -156,6 +156,44 @@ test_expect_success 'kvs: checkpoint of kvs-primary should change in time (4)' '
 	test_cmp checkpoint5.out blob5.out
 '
 
+test_expect_success 'configure bad checkpoint-bytes in kvs on reload' '
+	cat >kvs.toml <<-EOF &&
+	[kvs]
+	checkpoint-period = "60m"
+	checkpoint-bytes = "1Z"
+	EOF
+	test_must_fail flux config reload
+'
+
+test_expect_success 'configure checkpoint-bytes with large checkpoint-period' '
+	cat >kvs.toml <<-EOF &&
+	[kvs]
+	checkpoint-period = "60m"
+	checkpoint-bytes = "4K"
+	EOF
+	flux config reload
+'
+
+test_expect_success 'kvs: put data to kvs smaller than checkpoint-bytes' '
+	checkpoint_get kvs-primary > checkpoint6.out &&
+	flux kvs put --blobref f=1 > blob6.out
+'
+
+test_expect_success 'kvs: checkpoint of kvs-primary should not change (4)' '
+	test_must_fail checkpoint_changed $(cat checkpoint6.out) 2
+'
+
+test_expect_success 'kvs: put data to kvs larger than checkpoint-bytes' '
+	dd if=/dev/zero bs=8192 count=1 2>/dev/null | tr "\0" "x" >large &&
+	flux kvs put --blobref g="$(cat large)" > blob7.out
+'
+
+test_expect_success 'kvs: checkpoint of kvs-primary should change in time (5)' '
+	checkpoint_changed $(cat checkpoint6.out) 5 &&
+	checkpoint_get kvs-primary > checkpoint7.out &&
+	test_cmp checkpoint7.out blob7.out
+'
+
 test_expect_success 'kvs: no pending requests at end of tests before module removal' '
 	pendingcount=$(flux module stats -p pending_requests kvs) &&
 	test $pendingcount -eq 0
@@ -0,0 +1,108 @@
+#!/bin/sh
+#
+
+test_description='Test kvs hashed directories (hdir)'
+
+. `dirname $0`/sharness.sh
+
+SIZE=2
+test_under_flux ${SIZE} kvs
+
+# put_keys DIR COUNT - put COUNT keys into DIR in one transaction
+put_keys() {
+	flux kvs put $(seq 0 $(($2 - 1)) | sed "s/.*/$1.key&=&/")
+}
+
+# object_type KEY - print the treeobj type of the object KEY refers to
+object_type() {
+	flux content load $(flux kvs get --treeobj $1 | jq -r ".data[0]") \
+	    | jq -r .type
+}
+
+test_expect_success 'kvs module fails to load with bad dir-shard-threshold' '
+	flux module remove kvs &&
+	test_must_fail flux module load kvs dir-shard-threshold=foo &&
+	test_must_fail flux module load kvs dir-shard-threshold=-1 &&
+	test_must_fail flux module load kvs dir-shard-threshold=8x
+'
+test_expect_success 'kvs module loads with dir-shard-threshold=8' '
+	flux module load kvs dir-shard-threshold=8
+'
+test_expect_success 'small directory is stored as a dir' '
+	put_keys test.small 8 &&
+	test "$(object_type test.small)" = "dir"
+'
+test_expect_success 'large directory is stored as an hdir' '
+	put_keys test.hdir 200 &&
+	test "$(object_type test.hdir)" = "hdir"
+'
+test_expect_success 'growing a small directory converts it to an hdir' '
+	flux kvs put test.small.key8=8 &&
+	test "$(object_type test.small)" = "hdir"
+'
+test_expect_success 'keys can be read from an hdir' '
+	test $(flux kvs get test.hdir.key0) = 0 &&
+	test $(flux kvs get test.hdir.key123) = 123 &&
+	test $(flux kvs get test.hdir.key199) = 199 &&
+	test_must_fail flux kvs get test.hdir.key200
+'
+test_expect_success 'keys can be read from an hdir on rank 1' '
+	VERS=$(flux kvs version) &&
+	flux exec -r 1 sh -c "flux kvs wait ${VERS} && \
+	    flux kvs get test.hdir.key42" >rank1.out &&
+	test $(cat rank1.out) = 42
+'
+test_expect_success 'flux kvs dir lists all hdir entries' '
+	flux kvs dir test.hdir >dir.out &&
+	test $(wc -l <dir.out) -eq 200 &&
+	grep "^test.hdir.key77 = 77$" dir.out
+'
+test_expect_success 'flux kvs ls lists all hdir entries' '
+	flux kvs ls -1 test.hdir >ls.out &&
+	test $(wc -l <ls.out) -eq 200
+'
+test_expect_success 'keys in an hdir can be updated and unlinked' '
+	flux kvs put test.hdir.key5=foo &&
+	flux kvs unlink test.hdir.key6 &&
+	test $(flux kvs get test.hdir.key5) = foo &&
+	test_must_fail flux kvs get test.hdir.key6 &&
+	test $(flux kvs dir test.hdir | wc -l) -eq 199
+'
+test_expect_success 'unlinking a missing key in an hdir works with -f' '
+	flux kvs unlink -f test.hdir.nokey
+'
+test_expect_success 'subdirectories of an hdir work' '
+	flux kvs put test.hdir.sub.a=1 test.hdir.sub.b=2 &&
+	test $(flux kvs get test.hdir.sub.b) = 2 &&
+	flux kvs dir -R test.hdir >dirR.out &&
+	test $(wc -l <dirR.out) -eq 201
+'
+test_expect_success 'an hdir can be copied' '
+	flux kvs copy test.hdir test.hdircopy &&
+	test $(flux kvs get test.hdircopy.key123) = 123 &&
+	test $(flux kvs dir -R test.hdircopy | wc -l) -eq 201
+'
+test_expect_success 'flux dump includes all hdir keys' '
+	flux dump hdir.tar &&
+	tar tf hdir.tar >toc &&
+	test $(grep -c "^test/hdir/" toc) -eq 201
+'
+test_expect_success 'an hdir can be unlinked recursively' '
+	flux kvs unlink -R test.hdir &&
+	test_must_fail flux kvs get --treeobj test.hdir
+'
+test_expect_success 'hdir keys survive kvs module reload' '
+	flux module reload kvs &&
+	test $(flux kvs get test.hdircopy.key199) = 199
+'
+
+#
+# ensure no lingering pending requests
+#
+
+test_expect_success 'kvs: no pending requests at end of tests' '
+	pendingcount=$(flux module stats -p pending_requests kvs) &&
+	test $pendingcount -eq 0
+'
+
+test_done
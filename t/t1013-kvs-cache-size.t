@@ -0,0 +1,75 @@
+#!/bin/sh
+#
+
+test_description='Test kvs module cache-max-size config'
+
+. `dirname $0`/sharness.sh
+
+export FLUX_CONF_DIR=$(pwd)
+SIZE=1
+test_under_flux ${SIZE} minimal
+
+# put_values COUNT - put COUNT distinct 4K values in one transaction
+put_values() {
+	flux kvs put $(for i in $(seq 1 $1); do
+		echo test.k$i=$(printf "%04096d" $i)
+	done)
+}
+
+test_expect_success 'kvs module fails to load with bad cache-max-size' '
+	cat >kvs.toml <<-EOF &&
+	[kvs]
+	cache-max-size = "1Z"
+	EOF
+	flux config reload &&
+	flux module load content &&
+	test_must_fail flux module load kvs
+'
+test_expect_success 'kvs module loads with cache-max-size=64K' '
+	cat >kvs.toml <<-EOF &&
+	[kvs]
+	cache-max-size = "64K"
+	EOF
+	flux config reload &&
+	flux module load kvs
+'
+test_expect_success 'cache size limit is reported in stats' '
+	flux module stats -p "cache.memory limit (MiB)" kvs \
+		| jq -e ". == 0.0625"
+'
+test_expect_success 'storing more than the limit evicts cache entries' '
+	put_values 100 &&
+	flux kvs put test.sync=1 &&
+	evictions=$(flux module stats -p "cache.#evictions" kvs) &&
+	test $evictions -gt 0
+'
+test_expect_success 'evicted values can be read back' '
+	test $(flux kvs get test.k1) -eq 1 &&
+	test $(flux kvs get test.k50) -eq 50 &&
+	test $(flux kvs get test.k100) -eq 100
+'
+test_expect_success 'bad cache-max-size is rejected on reload' '
+	cat >kvs.toml <<-EOF &&
+	[kvs]
+	cache-max-size = "lots"
+	EOF
+	test_must_fail flux config reload
+'
+test_expect_success 'removing cache-max-size on reload removes the limit' '
+	cat >kvs.toml <<-EOF &&
+	[kvs]
+	EOF
+	flux config reload &&
+	flux module stats -p "cache.memory limit (MiB)" kvs \
+		| jq -e ". == 0"
+'
+test_expect_success 'kvs: no pending requests at end of tests' '
+	pendingcount=$(flux module stats -p pending_requests kvs) &&
+	test $pendingcount -eq 0
+'
+test_expect_success 'remove modules' '
+	flux module remove kvs &&
+	flux module remove content
+'
+
+test_done
@@ -60,6 +60,14 @@ test_expect_success 'and max_jobid is still greater than zero' '
 	jq -e ".max_jobid > 0" <stats-nojob.out
 '
 
+test_expect_success 'restart reloads more jobs than fit in one lookup chunk' '
+	flux start -Scontent.dump=dump_many.tar \
+	    bash -c "flux submit --cc=1-300 --urgency=hold true >/dev/null" &&
+	flux start -Scontent.restore=dump_many.tar \
+	    flux jobs -n --filter=pending -o {id} >many.out &&
+	test $(wc -l <many.out) -eq 300
+'
+
 test_expect_success 'purging all jobs triggers jobid checkpoint update' '
 	flux start bash -c "flux run --env-remove=* true && \
 	    flux job purge -f --num-limit=0 && \
@@ -104,6 +104,14 @@ test_expect_success 'repeat restore with -q' '
 test_expect_success 'repeat restore with --no-cache' '
 	flux restore --no-cache --checkpoint foo.tar
 '
+test_expect_success 'repeat restore stores no blobs that are already stored' '
+	flux module stats --type int --parse store_time.count content-sqlite \
+	    >stores.before &&
+	flux restore --no-cache --checkpoint foo.tar &&
+	flux module stats --type int --parse store_time.count content-sqlite \
+	    >stores.after &&
+	test_cmp stores.before stores.after
+'
 test_expect_success 'unload content-sqlite' '
 	flux content flush &&
 	flux content dropcache &&
@@ -306,6 +314,23 @@ test_expect_success 'archive contains expected number of keys' '
 	tar tvf baddump2.tar | wc -l >baddump2.count &&
 	test_cmp origdump.count baddump2.count
 '
+test_expect_success 'create a KVS valref with many blobrefs' '
+	for i in $(seq 1 100); do \
+		flux kvs put --append many.log="line $i" || return 1; \
+	done &&
+	flux kvs get --raw many.log >many.exp
+'
+test_expect_success 'dump pipelines the valref blobs in order' '
+	flux dump -q --ignore-failed-read manydump.tar &&
+	tar xOf manydump.tar many/log >many.out &&
+	test_cmp many.exp many.out
+'
+test_expect_success 'dump --no-cache pipelines the valref blobs in order' '
+	flux content flush &&
+	flux dump -q --no-cache --ignore-failed-read manydump2.tar &&
+	tar xOf manydump2.tar many/log >many2.out &&
+	test_cmp many.exp many2.out
+'
 test_expect_success 'remove kvs module' '
 	flux module remove kvs
 '